@@ -2,92 +2,148 @@
 #include "flx_llm_chat.h"
 
 #include <api/json/flx_json.h>
-#include <iostream>
-#include <ostream>
+
+#include <algorithm>
 
 using namespace flx;
 
 void chat_snippet_source::process_changes()
 {
-  // Check if new messages have been added
-  while (chat_context->get_messages().size()-1 > last_index) {
-    flx_string snippet_slicer_prompt = "You are a text-slicing bot. You will get a message. Your job is to split it into a JSON array of paragraphs. Make a new paragraph every time the topic changes. The JSON object must have a key called 'slices' which contains the array of strings.";
-    snippet_slicer_prompt += flx_string("\n\nThe topic before this message came in was: ") + last_topic + "\n\n";
-    // --- Settings Map for Paragraph Slicing ---
-
-    // 1. Define the JSON schema for an array of strings
-    flxv_map slices_schema;
-    slices_schema["type"] = "object";
-
-    flxv_map item_property;
-    item_property["type"] = "object";
-    // each item has a key "slice" with the string text part and a key "topic" with the topic
-    item_property["properties"] = flxv_map{
-        {"slice", flxv_map{{"type", "string"}}},
-        {"topic", flxv_map{{"type", "string"}}}
-    };
-    item_property["required"] = flxv_vector{"slice", "topic"}; // Each item must have both "slice" and "topic"
-    item_property["additionalProperties"] = false;
-
-    flxv_map array_property;
-    array_property["type"] = "array";
-    array_property["description"] = "The list of semantically coherent text slices.";
-    array_property["items"] = item_property; // Each item in the array is an object with "slice" and "topic"
-
-    flxv_map properties;
-    properties["slices"] = array_property; // The object has one key: "slices"
-    slices_schema["properties"] = properties;
-    slices_schema["additionalProperties"] = false;
-
-    flxv_vector required_fields;
-    required_fields.push_back("slices");
-    slices_schema["required"] = required_fields;
-
-
-    // 2. Construct the full response_format object
-    flxv_map response_format_map;
-    response_format_map["type"] = "json_schema";
-
-    flxv_map json_schema_object;
-    json_schema_object["name"] = "paragraph_slicer";
-    json_schema_object["strict"] = true; // Ensures the output strictly follows the schema
-    json_schema_object["schema"] = slices_schema;
-
-    response_format_map["json_schema"] = json_schema_object;
-
-    // 3. Set the final settings for the API call
-    flxv_map settings;
-    // Remember to use a model compatible with structured outputs, like gpt-4o-mini
-    settings["model"] = "gpt-4o-mini";
-    settings["response_format"] = response_format_map;
-
-    // 4. Create a new chat context with the system prompt, add the last topic and the next message and generate a response
-    auto context = chat_api->create_chat_context();
-    context->set_settings(settings);
-    context->add_message(
-      chat_api->create_message(llm::message_role::SYSTEM, snippet_slicer_prompt));
-    auto message = chat_context->get_messages().at(last_index + 1)->clone();
-    last_index++;
-    message->set_role(llm::message_role::USER);
-    context->add_message(std::move(message));
-    auto response_msg = chat_api->generate_response(*context);
-
-    // 5. Get the response and parse it
-    flx_string response = response_msg->get_content();
-    std::cout << "Response from chat API: " << response.to_std() << std::endl;
-    flxv_map response_data;
-    flx_json json_handler(&response_data);
-    json_handler.parse(response);
-    flxv_vector slices = response_data["slices"];
-    for (const auto& item : slices) {
-      const flx_variant& slice_var = item.map_value().at("slice");
-      const flx_variant& topic_var = item.map_value().at("topic");
-      flx_string slice_content = slice_var.string_value();
-      flx_string topic = topic_var.string_value();
-      // Add the new snippet with the topic
-      add_snippet(snippet(flxv_map{{"topic", topic}}, std::move(slice_content)));
+  // Track messages by id: the context may drop or summarize old messages, which shifts positions
+  const auto& messages = chat_context->get_messages();
+  unsigned long long newest_id = last_id;
+  for (size_t message_index = 0; message_index < messages.size(); ++message_index) {
+    unsigned long long message_id = chat_context->get_message_id(message_index);
+    if (message_id <= last_id) {
+      continue;
+    }
+    newest_id = std::max(newest_id, message_id);
+    const llm::i_llm_message& message = *messages[message_index];
+    // System prompts and summaries are not part of the conversation
+    if (message.get_role() == llm::message_role::SYSTEM) {
+      continue;
+    }
+    // Tool call requests carry no text
+    auto content = message.get_data().find("content");
+    if (content == message.get_data().end() || !content->second.is_string()) {
+      continue;
+    }
+
+    std::vector<text_segmenter::segment> segments = segmenter.segment_message(content->second.string_value());
+    if (segments.empty()) {
+      continue;
+    }
+    flxv_map origin{{"message_index", static_cast<long long>(message_index)},
+                    {"message_id", static_cast<long long>(message_id)}};
+    if (llm_refinement && chat_api && refine_with_llm(message, segments, origin)) {
+      continue;
+    }
+    for (auto& seg : segments) {
+      flxv_map metadata = origin;
+      metadata["topic"] = seg.topic;
+      metadata["segmenter"] = "local";
+      add_snippet(snippet(std::move(metadata), std::move(seg.text)));
+    }
+    last_topic = segments.back().topic;
+  }
+  last_id = newest_id;
+}
+
+bool chat_snippet_source::refine_with_llm(const llm::i_llm_message& source_message,
+                                          const std::vector<text_segmenter::segment>& local,
+                                          const flxv_map& origin)
+{
+  flx_string snippet_slicer_prompt = "You are a text-slicing bot. You will get a message. Your job is to split it into a JSON array of paragraphs. Make a new paragraph every time the topic changes. The JSON object must have a key called 'slices' which contains the array of strings.";
+  snippet_slicer_prompt += flx_string("\n\nThe topic before this message came in was: ") + last_topic + "\n\n";
+  // The local segmentation is a starting point, the model only corrects it
+  snippet_slicer_prompt += "A fast local segmenter proposed these slices (topic: text). Keep them unless a boundary or topic is clearly wrong:\n";
+  for (const auto& seg : local) {
+    snippet_slicer_prompt += flx_string("- ") + seg.topic + ": " + seg.text + "\n";
+  }
+  // --- Settings Map for Paragraph Slicing ---
+
+  // 1. Define the JSON schema for an array of strings
+  flxv_map slices_schema;
+  slices_schema["type"] = "object";
+
+  flxv_map item_property;
+  item_property["type"] = "object";
+  // each item has a key "slice" with the string text part and a key "topic" with the topic
+  item_property["properties"] = flxv_map{
+      {"slice", flxv_map{{"type", "string"}}},
+      {"topic", flxv_map{{"type", "string"}}}
+  };
+  item_property["required"] = flxv_vector{"slice", "topic"}; // Each item must have both "slice" and "topic"
+  item_property["additionalProperties"] = false;
+
+  flxv_map array_property;
+  array_property["type"] = "array";
+  array_property["description"] = "The list of semantically coherent text slices.";
+  array_property["items"] = item_property; // Each item in the array is an object with "slice" and "topic"
+
+  flxv_map properties;
+  properties["slices"] = array_property; // The object has one key: "slices"
+  slices_schema["properties"] = properties;
+  slices_schema["additionalProperties"] = false;
+
+  flxv_vector required_fields;
+  required_fields.push_back("slices");
+  slices_schema["required"] = required_fields;
+
+
+  // 2. Construct the full response_format object
+  flxv_map response_format_map;
+  response_format_map["type"] = "json_schema";
+
+  flxv_map json_schema_object;
+  json_schema_object["name"] = "paragraph_slicer";
+  json_schema_object["strict"] = true; // Ensures the output strictly follows the schema
+  json_schema_object["schema"] = slices_schema;
+
+  response_format_map["json_schema"] = json_schema_object;
+
+  // 3. Set the final settings for the API call
+  flxv_map settings;
+  // Remember to use a model compatible with structured outputs, like gpt-4o-mini
+  settings["model"] = "gpt-4o-mini";
+  settings["response_format"] = response_format_map;
+
+  // 4. Create a new chat context with the system prompt, add the last topic and the next message and generate a response
+  auto context = chat_api->create_chat_context();
+  context->set_settings(settings);
+  context->add_message(
+    chat_api->create_message(llm::message_role::SYSTEM, snippet_slicer_prompt));
+  auto message = source_message.clone();
+  message->set_role(llm::message_role::USER);
+  context->add_message(std::move(message));
+  auto response_msg = chat_api->generate_response(*context);
+  if (!response_msg) {
+    return false;
+  }
+
+  // 5. Get the response and parse it, anything unexpected falls back to the local slices
+  flxv_map response_data;
+  flx_json json_handler(&response_data);
+  json_handler.parse(response_msg->get_content());
+  auto slices_it = response_data.find("slices");
+  if (slices_it == response_data.end() || !slices_it->second.is_vector() || slices_it->second.vector_value().empty()) {
+    return false;
+  }
+  const flxv_vector& slices = slices_it->second.vector_value();
+  for (const auto& item : slices) {
+    if (!item.is_map() || !item.map_value().count("slice") || !item.map_value().count("topic")) {
+      return false;
     }
-    const flx_variant& last_topic_var = slices.back().map_value().at("topic");
-    last_topic = last_topic_var.string_value(); // Update the last topic based on the last slice
   }
+  for (const auto& item : slices) {
+    flx_string slice_content = item.map_value().at("slice").string_value();
+    flx_string topic = item.map_value().at("topic").string_value();
+    // Add the new snippet with the topic
+    flxv_map metadata = origin;
+    metadata["topic"] = topic;
+    metadata["segmenter"] = "llm";
+    add_snippet(snippet(std::move(metadata), std::move(slice_content)));
+  }
+  last_topic = slices.back().map_value().at("topic").string_value(); // Update the last topic based on the last slice
+  return true;
 }
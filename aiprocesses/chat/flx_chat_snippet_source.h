@@ -2,18 +2,40 @@
 #define FLX_CHAT_SNIPPET_SOURCE_H
 
 #include "../snippets/flx_snippet_source.h"
+#include "../snippets/flx_text_segmenter.h"
 #include "../chat/flx_llm_chat_interfaces.h"
 #include "flx_llm_api.h"
 
 namespace flx {
+  /**
+   * Turns the messages of a chat context into topic snippets.
+   *
+   * Messages are segmented locally (flx::text_segmenter), which costs
+   * microseconds per message. With LLM refinement enabled, each message is
+   * additionally sent to the slicer model together with the local
+   * segmentation; the local result is used whenever that call fails.
+   *
+   * Progress is tracked by message id (i_llm_chat_context::get_message_id),
+   * so dropped or summarized history does not hide new messages. Snippets
+   * carry "message_id" and the position at processing time ("message_index").
+   */
   class chat_snippet_source : public snippet_source {
     std::shared_ptr<llm::i_llm_api> chat_api;
     std::shared_ptr<llm::i_llm_chat_context> chat_context;
-    size_t last_index = 0;
+    unsigned long long last_id = 0;  // newest message id already segmented
     flx_string last_topic;
+    text_segmenter segmenter;
+    bool llm_refinement = false;
+
+    bool refine_with_llm(const llm::i_llm_message& message, const std::vector<text_segmenter::segment>& local,
+                         const flxv_map& origin);
   public:
+    explicit chat_snippet_source(std::shared_ptr<llm::i_llm_chat_context> context)
+        : chat_context(std::move(context)) {}
     chat_snippet_source(std::shared_ptr<llm::i_llm_api> api, std::shared_ptr<llm::i_llm_chat_context> context)
         : chat_api(std::move(api)), chat_context(std::move(context)) {}
+    void set_llm_refinement(bool enabled) { llm_refinement = enabled; }
+    text_segmenter& get_segmenter() { return segmenter; }
     void process_changes();
   };
 }
@@ -4,9 +4,16 @@
 
 #include "../../utils/flx_variant.h"
 #include "flx_llm_chat_interfaces.h"
+#include <functional>
+#include <vector>
 
 // NEU: Alles im Namespace flx::llm gekapselt
 namespace flx::llm {
+  // Grobe Token-Schätzung für Embedding-Limits (vorsichtig: ~2 Bytes pro Token)
+  inline size_t estimate_embedding_tokens(const flx_string& text) {
+    return text.length() / 2 + 1;
+  }
+
   class i_llm_api {
   public:
     virtual ~i_llm_api() = default;
@@ -22,7 +29,48 @@ namespace flx::llm {
       const std::vector<i_llm_function*>* functions=0
       ) = 0;
 
+    // NEU: Text-Deltas einer Antwort, sobald sie eintreffen; Rückgabe false bricht ab.
+    using delta_callback = std::function<bool(const flx_string& delta)>;
+
+    // NEU: Wie generate_response, liefert den Text aber schon während der Generierung an on_delta.
+    // Standard: ganze Antwort auf einmal; APIs mit Streaming überschreiben das.
+    virtual std::unique_ptr<i_llm_message> generate_response_stream(
+      i_llm_chat_context& context,
+      const std::vector<i_llm_function*>* functions,
+      const delta_callback& on_delta)
+    {
+      auto message = generate_response(context, functions);
+      if (message && on_delta) {
+        auto it = message->get_data().find("content");
+        if (it != message->get_data().end() && it->second.is_string() && !it->second.string_value().empty()) {
+          on_delta(it->second.string_value());
+        }
+      }
+      return message;
+    }
+
     virtual bool embedding(const flx_string& text, flxv_vector& embedding) = 0;
+
+    // NEU: Mehrere Texte auf einmal, Ergebnis kompakt als float-Vektoren in Eingabereihenfolge.
+    // Standard: einzeln über embedding(); APIs mit Batch-Endpunkt überschreiben das.
+    virtual bool embedding_batch(const std::vector<flx_string>& texts, std::vector<std::vector<float>>& embeddings) {
+      embeddings.clear();
+      embeddings.reserve(texts.size());
+      for (const auto& text : texts) {
+        flxv_vector values;
+        if (!embedding(text, values)) {
+          embeddings.clear();
+          return false;
+        }
+        std::vector<float> compact;
+        compact.reserve(values.size());
+        for (auto& v : values) {
+          compact.push_back(static_cast<float>(v.to_double()));
+        }
+        embeddings.push_back(std::move(compact));
+      }
+      return true;
+    }
   };
 
 } // namespace flx::llm
@@ -29,62 +29,43 @@ namespace flx::llm {
   }
 
   void flx_llm_chat::register_function(std::shared_ptr<i_llm_function> func) {
-    if (func) {
-      available_functions[func->get_name()] = std::move(func);
-    }
+    tools.add_function(std::move(func));
   }
 
-  void flx_llm_chat::register_tool_provider(std::shared_ptr<i_llm_tool_provider> provider) {
-    if (provider) {
-      tool_providers.push_back(provider);
-    }
+  void flx_llm_chat::set_tool_execution(size_t max_parallel, std::chrono::milliseconds timeout) {
+    max_parallel_tools = max_parallel ? max_parallel : 1;
+    tool_timeout = timeout;
+    executor.reset();
   }
 
-  std::vector<i_llm_function*> flx_llm_chat::get_function_list_for_api() {
-    std::vector<i_llm_function*> funcs;
-
-    for(const auto& [name, func_ptr] : available_functions) {
-      funcs.push_back(func_ptr.get());
-    }
-
-    for(const auto& provider : tool_providers) {
-      if (provider && provider->is_available()) {
-        auto provider_tools = provider->get_available_tools();
-        funcs.insert(funcs.end(), provider_tools.begin(), provider_tools.end());
-      }
-    }
-
-    return funcs;
+  void flx_llm_chat::register_tool_provider(std::shared_ptr<i_llm_tool_provider> provider) {
+    tools.add_provider(std::move(provider));
   }
 
-  i_llm_function* flx_llm_chat::find_function(const flx_string& name) {
-    auto it = available_functions.find(name);
-    if (it != available_functions.end()) {
-      return it->second.get();
-    }
+  bool flx_llm_chat::refresh_tools() {
+    return tools.refresh();
+  }
 
-    for(const auto& provider : tool_providers) {
-      if (provider && provider->is_available()) {
-        auto tools = provider->get_available_tools();
-        for(auto* tool : tools) {
-          if (tool && tool->get_name() == name) {
-            return tool;
-          }
-        }
-      }
-    }
+  bool flx_llm_chat::chat(const flx_string& user_message, flx_string& final_response, int max_tool_calls) {
+    return run_chat(user_message, final_response, nullptr, max_tool_calls);
+  }
 
-    return nullptr;
+  bool flx_llm_chat::chat(const flx_string& user_message, flx_string& final_response,
+                          const i_llm_api::delta_callback& on_delta, int max_tool_calls) {
+    return run_chat(user_message, final_response, &on_delta, max_tool_calls);
   }
 
-  bool flx_llm_chat::chat(const flx_string& user_message, flx_string& final_response, int max_tool_calls) {
+  bool flx_llm_chat::run_chat(const flx_string& user_message, flx_string& final_response,
+                              const i_llm_api::delta_callback* on_delta, int max_tool_calls) {
     if (!context) return false;
 
     context->add_message(api->create_message(message_role::USER, user_message));
 
     for (int i = 0; i < max_tool_calls; ++i) {
-      auto functions = get_function_list_for_api();
-      auto response_message = api->generate_response(*context, &functions);
+      const auto& functions = tools.get_tools();
+      auto response_message = on_delta
+        ? api->generate_response_stream(*context, &functions, *on_delta)
+        : api->generate_response(*context, &functions);
       if (!response_message) return false;
 
       const flx_variant& data = response_message->get_data();
@@ -96,10 +77,7 @@ namespace flx::llm {
         auto it = content_map.find("tool_calls");
 
         if (it != content_map.end() && it->second.is_vector()) {
-          const flxv_vector& tool_calls_vector = it->second.vector_value();
-          for (const auto& tool_call_var : tool_calls_vector) {
-            handle_tool_call(tool_call_var);
-          }
+          handle_tool_calls(it->second.vector_value());
         }
         else if (content_map.count("content") && content_map.at("content").is_string()) {
           final_response = content_map.at("content").string_value();
@@ -115,27 +93,140 @@ namespace flx::llm {
     return true;
   }
 
-  void flx_llm_chat::handle_tool_call(const flx_variant& tool_call_data) {
-    if (!tool_call_data.is_map()) return;
+  bool flx_llm_chat::prepare_tool_call(const flx_variant& tool_call_data, tool_call_job& job) {
+    if (!tool_call_data.is_map()) return false;
 
     const flxv_map& tool_call_map = tool_call_data.map_value();
     const flxv_map& function_map = tool_call_map.at("function").map_value();
-    const flx_string& func_name = function_map.at("name").string_value();
+    job.id = tool_call_map.at("id");
+    job.name = function_map.at("name").string_value();
 
     const flx_string& args_str = function_map.at("arguments").string_value();
-    flxv_map args_map;
-    flx_json args_parser(&args_map);
+    flx_json args_parser(&job.args);
     if (!args_parser.parse(args_str)) {
+      job.result = "Error: invalid JSON arguments for tool '" + job.name + "'";
+      return true;
+    }
+
+    job.func = tools.find(job.name);
+    if (!job.func) {
+      job.result = "Error: unknown tool '" + job.name + "'";
+    }
+    return true;
+  }
+
+  void flx_llm_chat::run_tool_calls(std::vector<tool_call_job>& jobs) {
+    auto run_inline = [](tool_call_job& job) {
+      try {
+        job.result = job.func->call_cancellable(job.args, cancellation_token());
+      } catch (const std::exception& e) {
+        job.result = "Error: tool '" + job.name + "' failed: " + e.what();
+      }
+    };
+
+    size_t runnable = 0;
+    for (const auto& job : jobs) {
+      if (job.func) ++runnable;
+    }
+
+    // Ein einzelner Aufruf ohne Timeout braucht keinen Worker-Thread
+    if (max_parallel_tools <= 1 || (runnable <= 1 && tool_timeout.count() <= 0)) {
+      for (auto& job : jobs) {
+        if (job.func) run_inline(job);
+      }
       return;
     }
 
-    i_llm_function* func = find_function(func_name);
-    if (func) {
-      flx_string res = func->call(args_map);
+    if (!executor) {
+      executor = std::make_unique<tool_executor>(max_parallel_tools);
+    }
+
+    struct submitted {
+      size_t index;
+      std::shared_ptr<tool_executor::task> state;
+      cancellation_token token;
+    };
+
+    auto submit = [this, &jobs](size_t i) {
+      cancellation_token token;
+      // Eigener Besitz: sync() der Registry kann den Wrapper ersetzen,
+      // während der Aufruf noch wartet oder nach einem Timeout weiterläuft
+      std::shared_ptr<i_llm_function> func = jobs[i].func;
+      flxv_map args = jobs[i].args;
+      auto state = executor->submit([func, args, token]() {
+        return func->call_cancellable(args, token);
+      });
+      return submitted{i, std::move(state), token};
+    };
+
+    auto collect = [this, &jobs](std::vector<submitted>& running) {
+      // Alle Deadlines zählen ab submit() und laufen etwa gleichzeitig ab
+      std::vector<bool> finished(running.size());
+      for (size_t k = 0; k < running.size(); ++k) {
+        finished[k] = running[k].state->wait(tool_timeout);
+      }
+
+      // Rückwärts: wartende Aufrufe verlassen die Queue, bevor für
+      // hängende Tools Ersatz-Worker starten
+      for (size_t k = running.size(); k-- > 0;) {
+        if (!finished[k]) {
+          running[k].token.cancel();
+          executor->abandon(running[k].state);
+        }
+      }
+
+      for (size_t k = 0; k < running.size(); ++k) {
+        submitted& r = running[k];
+        tool_call_job& job = jobs[r.index];
+        if (!finished[k]) {
+          job.result = "Error: tool '" + job.name + "' timed out after " +
+                       flx_string(static_cast<long long>(tool_timeout.count())) + " ms";
+          continue;
+        }
+        std::lock_guard<std::mutex> lock(r.state->mutex);
+        if (!r.state->error.empty()) {
+          job.result = "Error: tool '" + job.name + "' failed: " + r.state->error;
+        } else {
+          job.result = r.state->result;
+        }
+      }
+    };
+
+    // Nicht parallelisierbare Tools laufen einzeln und vor dem parallelen
+    // Block, jedes mit eigenem Timeout
+    for (size_t i = 0; i < jobs.size(); ++i) {
+      if (!jobs[i].func || jobs[i].func->allows_parallel()) continue;
+      std::vector<submitted> single{submit(i)};
+      collect(single);
+    }
+
+    std::vector<submitted> running;
+    for (size_t i = 0; i < jobs.size(); ++i) {
+      if (jobs[i].func && jobs[i].func->allows_parallel()) {
+        running.push_back(submit(i));
+      }
+    }
+    collect(running);
+  }
+
+  void flx_llm_chat::handle_tool_calls(const flxv_vector& tool_calls) {
+    std::vector<tool_call_job> jobs;
+    jobs.reserve(tool_calls.size());
+    for (const auto& tool_call_var : tool_calls) {
+      tool_call_job job;
+      if (prepare_tool_call(tool_call_var, job)) {
+        jobs.push_back(std::move(job));
+      }
+    }
+
+    run_tool_calls(jobs);
+
+    // Ergebnisse in der Reihenfolge der tool_calls anhängen
+    for (auto& job : jobs) {
       flxv_map result_message_content;
       result_message_content["role"] = "tool";
-      result_message_content["content"] = res;
-      result_message_content["tool_call_id"] = tool_call_map.at("id");
+      result_message_content["content"] = job.result;
+      result_message_content["tool_call_id"] = job.id;
       context->add_message(api->create_message(result_message_content));
     }
   }
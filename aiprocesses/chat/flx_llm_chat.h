@@ -1,17 +1,22 @@
 #ifndef FLX_LLM_CHAT_H
 #define FLX_LLM_CHAT_H
 
+#include <chrono>
 #include <memory>
 #include "../../utils/flx_variant.h"
 #include "flx_llm_api.h"
-#include "flx_llm_tool_provider.h"
+#include "flx_llm_tool_executor.h"
+#include "flx_llm_tool_registry.h"
 
 namespace flx::llm {
   class flx_llm_chat {
     std::shared_ptr<i_llm_api> api;
     std::unique_ptr<i_llm_chat_context> context;
-    std::map<flx_string, std::shared_ptr<i_llm_function>> available_functions;
-    std::vector<std::shared_ptr<i_llm_tool_provider>> tool_providers;
+    tool_registry tools;
+    size_t max_parallel_tools = 4;
+    std::chrono::milliseconds tool_timeout{60000};
+    // Zuletzt deklariert: wird zuerst zerstört, solange die Funktionen noch leben
+    std::unique_ptr<tool_executor> executor;
 
   public:
     explicit flx_llm_chat(std::shared_ptr<i_llm_api> api_impl);
@@ -20,12 +25,33 @@ namespace flx::llm {
     void set_context(std::unique_ptr<i_llm_chat_context> new_context);
     void register_function(std::shared_ptr<i_llm_function> func);
     void register_tool_provider(std::shared_ptr<i_llm_tool_provider> provider);
+    // Fragt alle Provider neu ab; Tool-Liste und Schemas werden nur bei Änderungen neu aufgebaut
+    bool refresh_tools();
     bool chat(const flx_string& user_message, flx_string& final_response, int max_tool_calls = 5);
+    // Wie chat(), der Antworttext kommt aber schon während der Generierung an on_delta
+    bool chat(const flx_string& user_message, flx_string& final_response,
+              const i_llm_api::delta_callback& on_delta, int max_tool_calls = 5);
+
+    // Tool-Aufrufe einer Antwort laufen parallel (max_parallel, 1 = sequentiell);
+    // timeout gilt pro Tool ab Übergabe an den Executor, Wartezeit in der
+    // Queue eingeschlossen (0 = kein Timeout). Tools ohne allows_parallel()
+    // laufen einzeln vor den übrigen, ebenfalls mit Timeout
+    void set_tool_execution(size_t max_parallel, std::chrono::milliseconds timeout);
 
   private:
-    void handle_tool_call(const flx_variant& tool_call_data);
-    std::vector<i_llm_function*> get_function_list_for_api();
-    i_llm_function* find_function(const flx_string& name);
+    struct tool_call_job {
+      flx_variant id;
+      flx_string name;
+      std::shared_ptr<i_llm_function> func;
+      flxv_map args;
+      flx_string result;
+    };
+
+    bool run_chat(const flx_string& user_message, flx_string& final_response,
+                  const i_llm_api::delta_callback* on_delta, int max_tool_calls);
+    bool prepare_tool_call(const flx_variant& tool_call_data, tool_call_job& job);
+    void run_tool_calls(std::vector<tool_call_job>& jobs);
+    void handle_tool_calls(const flxv_vector& tool_calls);
   };
 
 }
@@ -2,6 +2,7 @@
 #define FLX_LLM_CHAT_INTERFACES_H
 
 #include "../../utils/flx_variant.h"
+#include <atomic>
 #include <memory>
 
 // NEU: Alles im Namespace flx::llm gekapselt
@@ -13,6 +14,14 @@ namespace flx::llm {
     TOOL
   };
 
+  // Kooperativer Abbruch: wird gesetzt, wenn ein Tool-Aufruf sein Timeout überschreitet
+  class cancellation_token {
+    std::shared_ptr<std::atomic<bool>> flag = std::make_shared<std::atomic<bool>>(false);
+  public:
+    void cancel() const noexcept { flag->store(true, std::memory_order_relaxed); }
+    bool is_cancelled() const noexcept { return flag->load(std::memory_order_relaxed); }
+  };
+
   class i_llm_function {
   public:
     virtual ~i_llm_function() = default;
@@ -20,6 +29,19 @@ namespace flx::llm {
     virtual flx_string get_description() const = 0;
     virtual flxv_map get_parameters() const = 0;
     virtual flx_string call(const flxv_map& in) = 0;
+
+    // Langlaufende Tools können überschreiben und token.is_cancelled() prüfen
+    virtual flx_string call_cancellable(const flxv_map& in, const cancellation_token& token) {
+      (void)token;
+      return call(in);
+    }
+
+    // false, wenn das Tool nicht gleichzeitig mit anderen Tools laufen darf
+    virtual bool allows_parallel() const { return true; }
+
+    // Optional vorab serialisierte Deklaration {"name","description","parameters"} als JSON
+    // (z.B. aus der tool_registry); nullptr = APIs serialisieren get_parameters() selbst
+    virtual const flx_string* get_schema_json() const { return nullptr; }
   };
 
   class i_llm_message {
@@ -41,6 +63,11 @@ namespace flx::llm {
     virtual void add_message(std::unique_ptr<i_llm_message> message) = 0;
     virtual const std::vector<std::unique_ptr<i_llm_message>>& get_messages() const noexcept = 0;
     virtual std::unique_ptr<i_llm_chat_context> clone() const = 0;
+
+    // Stabile, streng steigende Id der Nachricht an Position index; bleibt gleich, wenn
+    // davor Nachrichten entfernt werden, ersetzte Nachrichten bekommen eine neue Id.
+    // Kontexte, die nie Nachrichten entfernen, können die Position verwenden.
+    virtual unsigned long long get_message_id(size_t index) const { return index + 1; }
   };
 }
 
@@ -0,0 +1,261 @@
+#include "flx_llm_context_window.h"
+#include <api/json/flx_json.h>
+#include <cctype>
+
+namespace flx::llm {
+
+size_t estimate_tokens(const flx_string& text) {
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(text.c_str());
+    const size_t n = text.length();
+    auto is_letter = [](unsigned char c) { return std::isalpha(c) || c >= 0x80; };
+
+    size_t tokens = 0;
+    size_t i = 0;
+    while (i < n) {
+        unsigned char c = p[i];
+        if (c == ' ' && i + 1 < n && (is_letter(p[i + 1]) || std::isdigit(p[i + 1]))) {
+            ++i;  // leading space is part of the next word
+            continue;
+        }
+        if (is_letter(c)) {
+            size_t weight = 0;
+            while (i < n && is_letter(p[i])) {
+                weight += p[i] < 0x80 ? 1 : 2;
+                ++i;
+            }
+            tokens += 1 + (weight - 1) / 6;
+        } else if (std::isdigit(c)) {
+            size_t start = i;
+            while (i < n && std::isdigit(p[i])) ++i;
+            tokens += (i - start + 2) / 3;
+        } else if (std::isspace(c)) {
+            while (i < n && std::isspace(p[i])) ++i;
+            tokens += 1;
+        } else {
+            ++i;
+            tokens += 1;
+        }
+    }
+    return tokens;
+}
+
+bool drop_oldest_policy::apply(context_window& window, size_t target) {
+    while (window.total_tokens() > target) {
+        size_t first = window.first_droppable();
+        if (first >= window.protected_begin()) {
+            return false;
+        }
+        window.erase(first, window.group_end(first));
+    }
+    return true;
+}
+
+summarize_policy::summarize_policy(summarizer summarize)
+    : summarize_(std::move(summarize))
+{
+}
+
+bool summarize_policy::apply(context_window& window, size_t target) {
+    if (window.total_tokens() <= target) {
+        return true;
+    }
+
+    // Free the overflow plus a quarter of the target, whole groups only
+    size_t to_free = window.total_tokens() - target + target / 4;
+    size_t first = window.first_droppable();
+    size_t protect = window.protected_begin();
+    size_t last = first;
+    size_t freed = 0;
+    while (last < protect && freed < to_free) {
+        size_t end = window.group_end(last);
+        for (size_t i = last; i < end; ++i) {
+            freed += window.get_tokens(i);
+        }
+        last = end;
+    }
+
+    if (last > first && summarize_) {
+        std::vector<const i_llm_message*> old_messages;
+        for (size_t i = first; i < last; ++i) {
+            old_messages.push_back(window.get_messages()[i].get());
+        }
+        flx_string summary = summarize_(old_messages);
+        auto message = summary.empty()
+            ? nullptr
+            : window.create_message(message_role::SYSTEM, "Summary of the earlier conversation:\n" + summary);
+        if (message) {
+            window.replace(first, last, std::move(message));
+        }
+    }
+
+    drop_oldest_policy fallback;
+    return fallback.apply(window, target);
+}
+
+context_window::context_window(message_factory factory)
+    : factory_(std::move(factory))
+    , policy_(std::make_shared<drop_oldest_policy>())
+    , budget_(0)
+    , next_id_(1)
+    , total_tokens_(0)
+    , joined_count_(0)
+{
+}
+
+void context_window::set_policy(std::shared_ptr<i_context_policy> policy) {
+    policy_ = policy ? std::move(policy) : std::make_shared<drop_oldest_policy>();
+}
+
+flx_string context_window::serialize(const i_llm_message& message) {
+    // flx_json::create() only reads the map
+    flx_json json(const_cast<flxv_map*>(&message.get_data()));
+    return json.create();
+}
+
+size_t context_window::count_tokens(const i_llm_message& message) {
+    const flxv_map& data = message.get_data();
+    size_t tokens = message_overhead_tokens;
+
+    auto content = data.find("content");
+    if (content != data.end()) {
+        if (content->second.is_string()) {
+            tokens += estimate_tokens(content->second.string_value());
+        } else if (!content->second.is_null()) {
+            flxv_map wrapper;
+            wrapper["content"] = content->second;
+            flx_json json(&wrapper);
+            tokens += estimate_tokens(json.create());
+        }
+    }
+
+    auto tool_calls = data.find("tool_calls");
+    if (tool_calls != data.end() && tool_calls->second.is_vector()) {
+        for (const auto& call : tool_calls->second.vector_value()) {
+            if (!call.is_map()) continue;
+            tokens += message_overhead_tokens;
+            auto function = call.map_value().find("function");
+            if (function == call.map_value().end() || !function->second.is_map()) continue;
+            for (const char* key : {"name", "arguments"}) {
+                auto field = function->second.map_value().find(key);
+                if (field != function->second.map_value().end() && field->second.is_string()) {
+                    tokens += estimate_tokens(field->second.string_value());
+                }
+            }
+        }
+    }
+    return tokens;
+}
+
+void context_window::add(std::unique_ptr<i_llm_message> message) {
+    if (!message) {
+        return;
+    }
+    json_.push_back(serialize(*message));
+    tokens_.push_back(count_tokens(*message));
+    total_tokens_ += tokens_.back();
+    ids_.push_back(next_id_++);
+    messages_.push_back(std::move(message));
+}
+
+void context_window::replace(size_t first, size_t last, std::unique_ptr<i_llm_message> message) {
+    if (!message || first >= last || last > messages_.size()) {
+        return;
+    }
+    erase(first + 1, last);
+    total_tokens_ -= tokens_[first];
+    json_[first] = serialize(*message);
+    tokens_[first] = count_tokens(*message);
+    total_tokens_ += tokens_[first];
+    ids_[first] = next_id_++;
+    messages_[first] = std::move(message);
+    joined_.clear();
+    joined_count_ = 0;
+}
+
+void context_window::erase(size_t first, size_t last) {
+    if (last > messages_.size()) last = messages_.size();
+    if (first >= last) {
+        return;
+    }
+    for (size_t i = first; i < last; ++i) {
+        total_tokens_ -= tokens_[i];
+    }
+    messages_.erase(messages_.begin() + first, messages_.begin() + last);
+    json_.erase(json_.begin() + first, json_.begin() + last);
+    tokens_.erase(tokens_.begin() + first, tokens_.begin() + last);
+    ids_.erase(ids_.begin() + first, ids_.begin() + last);
+    joined_.clear();
+    joined_count_ = 0;
+}
+
+std::unique_ptr<i_llm_message> context_window::create_message(message_role role, const flx_string& content) const {
+    return factory_ ? factory_(role, content) : nullptr;
+}
+
+size_t context_window::first_droppable() const {
+    return !messages_.empty() && messages_[0]->get_role() == message_role::SYSTEM ? 1 : 0;
+}
+
+size_t context_window::protected_begin() const {
+    for (size_t i = messages_.size(); i > 0; --i) {
+        if (messages_[i - 1]->get_role() == message_role::USER) {
+            return i - 1;
+        }
+    }
+    return messages_.size();
+}
+
+size_t context_window::group_end(size_t begin) const {
+    size_t end = begin + 1;
+    bool opens_group = messages_[begin]->get_role() == message_role::TOOL
+        || messages_[begin]->get_data().count("tool_calls") > 0;
+    if (opens_group) {
+        while (end < messages_.size() && messages_[end]->get_role() == message_role::TOOL) {
+            ++end;
+        }
+    }
+    return end;
+}
+
+bool context_window::fit(size_t extra_tokens) {
+    if (budget_ == 0) {
+        return true;
+    }
+    size_t target = budget_ > extra_tokens ? budget_ - extra_tokens : 0;
+    if (total_tokens_ <= target) {
+        return true;
+    }
+    return policy_->apply(*this, target);
+}
+
+void context_window::append_messages_json(flx_string& out) const {
+    if (joined_count_ == 0) {
+        joined_ = "[";
+    }
+    for (size_t i = joined_count_; i < json_.size(); ++i) {
+        if (i > 0) joined_ += ",";
+        joined_ += json_[i];
+    }
+    joined_count_ = json_.size();
+    out += joined_;
+    out += "]";
+}
+
+void context_window::assign_clone(const context_window& other) {
+    factory_ = other.factory_;
+    policy_ = other.policy_;
+    budget_ = other.budget_;
+    messages_.clear();
+    for (const auto& message : other.messages_) {
+        messages_.push_back(message->clone());
+    }
+    json_ = other.json_;
+    tokens_ = other.tokens_;
+    ids_ = other.ids_;
+    next_id_ = other.next_id_;
+    total_tokens_ = other.total_tokens_;
+    joined_.clear();
+    joined_count_ = 0;
+}
+
+} // namespace flx::llm
@@ -0,0 +1,192 @@
+/**
+ * @file flx_llm_context_window.h
+ * @brief Token-budgeted message history with cached JSON serialization
+ */
+
+#ifndef FLX_LLM_CONTEXT_WINDOW_H
+#define FLX_LLM_CONTEXT_WINDOW_H
+
+#include "flx_llm_chat_interfaces.h"
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace flx::llm {
+
+/**
+ * @brief Local token estimate for chat models (no vocabulary needed)
+ *
+ * Splits the text the way BPE pre-tokenizers do (words with their leading
+ * space, digit runs, punctuation, whitespace runs) and charges one token per
+ * started 6 letters of a word, 3 digits per token and one token per
+ * punctuation character. Non-ASCII bytes count double. Errs on the high side
+ * compared to cl100k/o200k.
+ */
+size_t estimate_tokens(const flx_string& text);
+
+class context_window;
+
+/**
+ * @class i_context_policy
+ * @brief Strategy that brings a context_window back under its budget
+ */
+class i_context_policy {
+public:
+    virtual ~i_context_policy() = default;
+
+    /**
+     * @brief Shrink the history until total_tokens() <= target
+     * @return True if the target was reached
+     *
+     * Only messages in [first_droppable(), protected_begin()) may be touched:
+     * the system prompt and the current turn always stay.
+     */
+    virtual bool apply(context_window& window, size_t target) = 0;
+};
+
+/**
+ * @class drop_oldest_policy
+ * @brief Removes the oldest messages first
+ *
+ * An assistant message with tool_calls is removed together with its tool
+ * results, so the history never contains orphaned tool messages.
+ */
+class drop_oldest_policy : public i_context_policy {
+public:
+    bool apply(context_window& window, size_t target) override;
+};
+
+/**
+ * @class summarize_policy
+ * @brief Replaces the oldest messages with a summary
+ *
+ * Summarizes enough old messages to get under the target with a quarter of
+ * the budget to spare, so it does not run again on the next turn. Falls back
+ * to drop_oldest_policy if the summarizer fails (returns an empty string).
+ */
+class summarize_policy : public i_context_policy {
+public:
+    using summarizer = std::function<flx_string(const std::vector<const i_llm_message*>& messages)>;
+
+    explicit summarize_policy(summarizer summarize);
+    bool apply(context_window& window, size_t target) override;
+
+private:
+    summarizer summarize_;
+};
+
+/**
+ * @class context_window
+ * @brief Message history of a chat context
+ *
+ * Every message is serialized to JSON and token-counted once, when it is
+ * added; building a request then only joins the cached fragments, so a new
+ * turn costs the new messages instead of the whole history. Messages must
+ * not be modified after add() - use replace() instead.
+ *
+ * Each message gets a sequence id when it is added or replaced. Ids grow
+ * monotonically and survive erase()/replace() of other messages, so
+ * observers can track what they have seen by id instead of position.
+ *
+ * With a budget set, fit() applies the policy (default: drop_oldest_policy)
+ * before a request when the history plus extra tokens would not fit.
+ */
+class context_window {
+public:
+    using message_factory = std::function<std::unique_ptr<i_llm_message>(message_role role, const flx_string& content)>;
+
+    /// Tokens charged per message on top of its content (role, separators)
+    static constexpr size_t message_overhead_tokens = 4;
+
+    explicit context_window(message_factory factory = nullptr);
+
+    /**
+     * @brief Limit for history plus extra tokens passed to fit() (0 = unlimited)
+     */
+    void set_budget(size_t max_tokens) { budget_ = max_tokens; }
+    size_t get_budget() const noexcept { return budget_; }
+
+    void set_policy(std::shared_ptr<i_context_policy> policy);
+
+    void add(std::unique_ptr<i_llm_message> message);
+
+    /**
+     * @brief Replace messages [first, last) with a single message
+     */
+    void replace(size_t first, size_t last, std::unique_ptr<i_llm_message> message);
+    void replace(size_t index, std::unique_ptr<i_llm_message> message) { replace(index, index + 1, std::move(message)); }
+
+    /**
+     * @brief Remove messages [first, last)
+     */
+    void erase(size_t first, size_t last);
+
+    /**
+     * @brief Create a message of the owning API (used for summaries)
+     * @return nullptr if no factory was set
+     */
+    std::unique_ptr<i_llm_message> create_message(message_role role, const flx_string& content) const;
+
+    const std::vector<std::unique_ptr<i_llm_message>>& get_messages() const noexcept { return messages_; }
+    size_t size() const noexcept { return messages_.size(); }
+    size_t get_tokens(size_t index) const { return tokens_[index]; }
+    unsigned long long get_id(size_t index) const { return ids_[index]; }
+    size_t total_tokens() const noexcept { return total_tokens_; }
+
+    /**
+     * @brief First message a policy may remove (after the system prompt)
+     */
+    size_t first_droppable() const;
+
+    /**
+     * @brief Start of the current turn (last user message), kept by policies
+     */
+    size_t protected_begin() const;
+
+    /**
+     * @brief End of the message group starting at begin
+     *
+     * An assistant message with tool_calls forms a group with the tool
+     * results that follow it; everything else is a group of its own.
+     */
+    size_t group_end(size_t begin) const;
+
+    /**
+     * @brief Apply the policy if history + extra_tokens exceeds the budget
+     * @return False if the history still does not fit
+     */
+    bool fit(size_t extra_tokens = 0);
+
+    /**
+     * @brief Append the history as JSON array to out
+     */
+    void append_messages_json(flx_string& out) const;
+
+    /**
+     * @brief Copy messages, caches and configuration of other
+     */
+    void assign_clone(const context_window& other);
+
+private:
+    message_factory factory_;
+    std::shared_ptr<i_context_policy> policy_;
+    size_t budget_;
+
+    std::vector<std::unique_ptr<i_llm_message>> messages_;
+    std::vector<flx_string> json_;
+    std::vector<size_t> tokens_;
+    std::vector<unsigned long long> ids_;
+    unsigned long long next_id_;
+    size_t total_tokens_;
+
+    // "[m0,m1,..." for the first joined_count_ messages; extended on append
+    mutable flx_string joined_;
+    mutable size_t joined_count_;
+
+    static flx_string serialize(const i_llm_message& message);
+    static size_t count_tokens(const i_llm_message& message);
+};
+
+} // namespace flx::llm
+
+#endif // FLX_LLM_CONTEXT_WINDOW_H
@@ -0,0 +1,122 @@
+#include "flx_llm_tool_executor.h"
+#include <algorithm>
+#include <exception>
+
+namespace flx::llm {
+
+bool tool_executor::task::wait(std::chrono::milliseconds timeout) {
+    std::unique_lock<std::mutex> lock(mutex);
+    if (timeout.count() <= 0) {
+        cv.wait(lock, [this] { return done; });
+        return true;
+    }
+    return cv.wait_until(lock, submit_time + timeout, [this] { return done; });
+}
+
+tool_executor::tool_executor(size_t max_threads)
+    : max_threads_(max_threads ? max_threads : 1), pool_(std::make_shared<pool_state>()) {}
+
+tool_executor::~tool_executor() {
+    std::unique_lock<std::mutex> lock(pool_->mutex);
+    pool_->stop = true;
+    pool_->cv.notify_all();
+    pool_->exit_cv.wait(lock, [this] { return pool_->active_workers == 0; });
+}
+
+std::shared_ptr<tool_executor::task> tool_executor::submit(std::function<flx_string()> fn) {
+    auto state = std::make_shared<task>();
+    state->submit_time = clock::now();
+    {
+        std::lock_guard<std::mutex> lock(pool_->mutex);
+        pool_->queue.push_back({state, std::move(fn)});
+        start_worker_if_needed();
+    }
+    pool_->cv.notify_one();
+    return state;
+}
+
+void tool_executor::abandon(const std::shared_ptr<task>& state) {
+    std::lock_guard<std::mutex> lock(pool_->mutex);
+    std::lock_guard<std::mutex> task_lock(state->mutex);
+    if (state->done || state->abandoned) {
+        return;
+    }
+    state->abandoned = true;
+
+    if (!state->started) {
+        auto queued = std::find_if(pool_->queue.begin(), pool_->queue.end(),
+                                   [&state](const queued_task& q) { return q.state == state; });
+        if (queued != pool_->queue.end()) {
+            pool_->queue.erase(queued);
+        }
+        return;
+    }
+
+    // The worker stays with the hung tool; replace it for the rest of the queue
+    --pool_->active_workers;
+    pool_->exit_cv.notify_all();
+    start_worker_if_needed();
+    pool_->cv.notify_one();
+}
+
+void tool_executor::start_worker_if_needed() {
+    if (pool_->idle_workers < pool_->queue.size() && pool_->active_workers < max_threads_) {
+        ++pool_->active_workers;
+        std::thread(&tool_executor::worker_loop, pool_).detach();
+    }
+}
+
+void tool_executor::worker_loop(std::shared_ptr<pool_state> pool) {
+    std::unique_lock<std::mutex> lock(pool->mutex);
+    while (true) {
+        ++pool->idle_workers;
+        pool->cv.wait(lock, [&pool] { return pool->stop || !pool->queue.empty(); });
+        --pool->idle_workers;
+        if (pool->queue.empty()) {
+            break;  // stop and nothing left
+        }
+
+        queued_task next = std::move(pool->queue.front());
+        pool->queue.pop_front();
+        lock.unlock();
+
+        bool run = false;
+        {
+            std::lock_guard<std::mutex> task_lock(next.state->mutex);
+            run = !next.state->abandoned;
+            next.state->started = run;
+        }
+
+        bool retired = false;
+        if (run) {
+            flx_string result;
+            flx_string error;
+            try {
+                result = next.fn();
+            } catch (const std::exception& e) {
+                error = e.what();
+            } catch (...) {
+                error = "unknown exception";
+            }
+
+            {
+                std::lock_guard<std::mutex> task_lock(next.state->mutex);
+                next.state->result = std::move(result);
+                next.state->error = std::move(error);
+                next.state->done = true;
+                retired = next.state->abandoned;
+            }
+            next.state->cv.notify_all();
+        }
+
+        if (retired) {
+            return;  // abandon() already took this worker out of the pool
+        }
+        lock.lock();
+    }
+
+    --pool->active_workers;
+    pool->exit_cv.notify_all();
+}
+
+} // namespace flx::llm
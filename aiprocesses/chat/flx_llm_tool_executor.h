@@ -0,0 +1,106 @@
+/**
+ * @file flx_llm_tool_executor.h
+ * @brief Bounded thread pool for concurrent LLM tool calls
+ */
+
+#ifndef FLX_LLM_TOOL_EXECUTOR_H
+#define FLX_LLM_TOOL_EXECUTOR_H
+
+#include "../../utils/flx_string.h"
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace flx::llm {
+
+/**
+ * @class tool_executor
+ * @brief Runs tool calls on at most max_threads worker threads
+ *
+ * Workers are started lazily, so a chat that never calls tools costs no
+ * threads. A task that exceeds its timeout is abandoned by the caller (and
+ * its cancellation_token set by flx_llm_chat): a queued task is dropped, a
+ * running one keeps its worker until the tool returns, but that worker is
+ * retired and no longer counts against max_threads, so hung tools cannot
+ * starve later calls. Workers are detached and share the queue state with
+ * the executor; the destructor waits for the active workers only, retired
+ * ones finish (or hang) on their own.
+ */
+class tool_executor {
+public:
+    using clock = std::chrono::steady_clock;
+
+    /**
+     * @brief Shared state of one submitted task
+     */
+    struct task {
+        std::mutex mutex;
+        std::condition_variable cv;
+        bool started = false;
+        bool done = false;
+        bool abandoned = false;
+        clock::time_point submit_time;
+        flx_string result;
+        flx_string error;
+
+        /**
+         * @brief Block until the task is done or timeout has passed since submit()
+         * @param timeout Limit for queueing plus runtime (0 = none)
+         * @return True if the task finished in time
+         */
+        bool wait(std::chrono::milliseconds timeout);
+    };
+
+    explicit tool_executor(size_t max_threads = 4);
+    ~tool_executor();
+
+    tool_executor(const tool_executor&) = delete;
+    tool_executor& operator=(const tool_executor&) = delete;
+
+    /**
+     * @brief Queue fn for execution; exceptions end up in task::error
+     */
+    std::shared_ptr<task> submit(std::function<flx_string()> fn);
+
+    /**
+     * @brief Give up on a task that timed out
+     *
+     * A queued task is removed, a running one retires its worker and a new
+     * worker is started for the remaining queue. No-op for finished tasks.
+     */
+    void abandon(const std::shared_ptr<task>& state);
+
+    size_t max_threads() const { return max_threads_; }
+
+private:
+    struct queued_task {
+        std::shared_ptr<task> state;
+        std::function<flx_string()> fn;
+    };
+
+    // Outlives the executor while retired workers still run
+    struct pool_state {
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::condition_variable exit_cv;
+        std::deque<queued_task> queue;
+        size_t active_workers = 0;  // started and not retired
+        size_t idle_workers = 0;
+        bool stop = false;
+    };
+
+    // Caller holds pool->mutex
+    void start_worker_if_needed();
+    static void worker_loop(std::shared_ptr<pool_state> pool);
+
+    size_t max_threads_;
+    std::shared_ptr<pool_state> pool_;
+};
+
+} // namespace flx::llm
+
+#endif // FLX_LLM_TOOL_EXECUTOR_H
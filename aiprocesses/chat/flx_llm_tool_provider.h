@@ -10,6 +10,7 @@
 #define FLX_LLM_TOOL_PROVIDER_H
 
 #include "flx_llm_chat_interfaces.h"
+#include <cstdint>
 #include <vector>
 #include <memory>
 
@@ -44,6 +45,20 @@ public:
      */
     virtual std::vector<i_llm_function*> get_available_tools() = 0;
 
+    /**
+     * @brief Get the available tools with shared ownership
+     * @param tools Receives the same tools as get_available_tools()
+     * @return False if the provider only hands out non-owning pointers
+     *
+     * A tool call still running after the provider replaced its tool list
+     * keeps its tool alive through this ownership. Providers that return
+     * false must keep their tools alive for their own lifetime.
+     */
+    virtual bool get_shared_tools(std::vector<std::shared_ptr<i_llm_function>>& tools) {
+        (void)tools;
+        return false;
+    }
+
     /**
      * @brief Refresh tool list from source
      * @return True if refresh was successful
@@ -68,6 +83,15 @@ public:
      * For static: Always returns true
      */
     virtual bool is_available() const = 0;
+
+    /**
+     * @brief Version of the tool list
+     * @return Value that changes whenever get_available_tools() changes
+     *
+     * Lets tool_registry keep its index and cached schemas across turns.
+     * 0 means unversioned: the registry re-reads the provider every turn.
+     */
+    virtual uint64_t get_tools_version() const { return 0; }
 };
 
 /**
@@ -81,6 +105,7 @@ class manual_tool_provider : public i_llm_tool_provider {
 private:
     std::map<flx_string, std::shared_ptr<i_llm_function>> functions_;
     flx_string name_;
+    uint64_t version_ = 1;
 
 public:
     explicit manual_tool_provider(const flx_string& name = "Manual Tools")
@@ -93,6 +118,7 @@ public:
     void register_function(std::shared_ptr<i_llm_function> func) {
         if (func) {
             functions_[func->get_name()] = std::move(func);
+            ++version_;
         }
     }
 
@@ -101,7 +127,9 @@ public:
      * @param name Function name to remove
      */
     void unregister_function(const flx_string& name) {
-        functions_.erase(name);
+        if (functions_.erase(name)) {
+            ++version_;
+        }
     }
 
     /**
@@ -109,6 +137,7 @@ public:
      */
     void clear() {
         functions_.clear();
+        ++version_;
     }
 
     // i_llm_tool_provider implementation
@@ -121,6 +150,15 @@ public:
         return tools;
     }
 
+    bool get_shared_tools(std::vector<std::shared_ptr<i_llm_function>>& tools) override {
+        tools.clear();
+        tools.reserve(functions_.size());
+        for (const auto& [name, func] : functions_) {
+            tools.push_back(func);
+        }
+        return true;
+    }
+
     bool refresh_tools() override {
         // Manual tools don't need refresh
         return true;
@@ -134,6 +172,10 @@ public:
         return true;
     }
 
+    uint64_t get_tools_version() const override {
+        return version_;
+    }
+
     /**
      * @brief Get number of registered functions
      */
@@ -0,0 +1,184 @@
+#include "flx_llm_tool_registry.h"
+#include <api/json/flx_json.h>
+
+namespace flx::llm {
+
+/**
+ * @brief Forwarding wrapper that snapshots name, description and schema
+ */
+class tool_registry::cached_function final : public i_llm_function {
+    // Registered function, shared provider tool, or one aliased to its provider
+    std::shared_ptr<i_llm_function> target_;
+    flx_string name_;
+    flx_string description_;
+    flxv_map parameters_;
+    flx_string schema_json_;
+
+public:
+    explicit cached_function(std::shared_ptr<i_llm_function> target)
+        : target_(std::move(target))
+        , name_(target_->get_name())
+        , description_(target_->get_description())
+        , parameters_(target_->get_parameters())
+    {
+        flxv_map declaration;
+        declaration["name"] = name_;
+        declaration["description"] = description_;
+        declaration["parameters"] = parameters_;
+        flx_json json(&declaration);
+        schema_json_ = json.create();
+    }
+
+    flx_string get_name() const override { return name_; }
+    flx_string get_description() const override { return description_; }
+    flxv_map get_parameters() const override { return parameters_; }
+    const flx_string* get_schema_json() const override {
+        return schema_json_.empty() ? nullptr : &schema_json_;
+    }
+
+    flx_string call(const flxv_map& in) override {
+        return target_->call(in);
+    }
+    flx_string call_cancellable(const flxv_map& in, const cancellation_token& token) override {
+        return target_->call_cancellable(in, token);
+    }
+    bool allows_parallel() const override {
+        return target_->allows_parallel();
+    }
+};
+
+tool_registry::tool_registry()
+    : functions_dirty_(false)
+    , version_(0)
+{
+}
+
+tool_registry::~tool_registry() = default;
+
+void tool_registry::add_function(std::shared_ptr<i_llm_function> func) {
+    if (!func) {
+        return;
+    }
+    flx_string name = func->get_name();
+    for (auto& existing : functions_) {
+        if (existing->get_name() == name) {
+            existing = std::move(func);
+            functions_dirty_ = true;
+            return;
+        }
+    }
+    functions_.push_back(std::move(func));
+    functions_dirty_ = true;
+}
+
+void tool_registry::add_provider(std::shared_ptr<i_llm_tool_provider> provider) {
+    if (!provider) {
+        return;
+    }
+    provider_entry entry;
+    entry.provider = std::move(provider);
+    providers_.push_back(std::move(entry));
+}
+
+bool tool_registry::refresh() {
+    bool ok = true;
+    for (auto& entry : providers_) {
+        if (!entry.provider->refresh_tools()) {
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+const std::vector<i_llm_function*>& tool_registry::get_tools() {
+    sync(true);
+    return tools_;
+}
+
+std::shared_ptr<i_llm_function> tool_registry::find(const flx_string& name) {
+    // Don't reload unversioned providers here: pointers from get_tools() must stay valid
+    sync(false);
+    auto it = index_.find(name.to_std_const());
+    return it != index_.end() ? it->second : nullptr;
+}
+
+size_t tool_registry::size() {
+    return get_tools().size();
+}
+
+void tool_registry::load_provider(provider_entry& entry) {
+    entry.tools.clear();
+    if (!entry.seen_available) {
+        return;
+    }
+    std::vector<std::shared_ptr<i_llm_function>> shared;
+    if (entry.provider->get_shared_tools(shared)) {
+        for (auto& tool : shared) {
+            if (tool) {
+                entry.tools.push_back(std::make_shared<cached_function>(std::move(tool)));
+            }
+        }
+        return;
+    }
+    for (auto* tool : entry.provider->get_available_tools()) {
+        if (tool) {
+            // The provider keeps such tools for its lifetime; sharing its ownership keeps them reachable
+            entry.tools.push_back(std::make_shared<cached_function>(
+                std::shared_ptr<i_llm_function>(entry.provider, tool)));
+        }
+    }
+}
+
+void tool_registry::sync(bool reload_unversioned) {
+    bool changed = version_ == 0;
+
+    if (functions_dirty_) {
+        function_tools_.clear();
+        for (auto& func : functions_) {
+            function_tools_.push_back(std::make_shared<cached_function>(func));
+        }
+        functions_dirty_ = false;
+        changed = true;
+    }
+
+    for (auto& entry : providers_) {
+        bool available = entry.provider->is_available();
+        uint64_t tools_version = available ? entry.provider->get_tools_version() : 0;
+        bool stale = !entry.loaded
+            || available != entry.seen_available
+            || tools_version != entry.seen_version
+            || (tools_version == 0 && available && reload_unversioned);
+        if (!stale) {
+            continue;
+        }
+        entry.seen_available = available;
+        entry.seen_version = tools_version;
+        entry.loaded = true;
+        load_provider(entry);
+        changed = true;
+    }
+
+    if (!changed) {
+        return;
+    }
+
+    tools_.clear();
+    index_.clear();
+    auto add = [this](const std::shared_ptr<cached_function>& tool) {
+        // First match wins; duplicate names are not sent to the API
+        if (index_.emplace(tool->get_name().to_std_const(), tool).second) {
+            tools_.push_back(tool.get());
+        }
+    };
+    for (auto& tool : function_tools_) {
+        add(tool);
+    }
+    for (auto& entry : providers_) {
+        for (auto& tool : entry.tools) {
+            add(tool);
+        }
+    }
+    ++version_;
+}
+
+} // namespace flx::llm
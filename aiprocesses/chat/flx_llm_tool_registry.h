@@ -0,0 +1,105 @@
+/**
+ * @file flx_llm_tool_registry.h
+ * @brief Versioned tool index with cached schema serialization
+ */
+
+#ifndef FLX_LLM_TOOL_REGISTRY_H
+#define FLX_LLM_TOOL_REGISTRY_H
+
+#include "flx_llm_tool_provider.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace flx::llm {
+
+/**
+ * @class tool_registry
+ * @brief Collects directly registered functions and provider tools
+ *
+ * The tool list, the name index and the serialized schema of every tool are
+ * built once and reused across chat turns. They are rebuilt only when a
+ * provider reports a new get_tools_version(), changes availability, or a
+ * function/provider is added. Providers that stay at version 0 are treated
+ * as unversioned and re-read on every access.
+ *
+ * Tools are registry-owned wrappers that forward to the original tool.
+ * Pointers from get_tools() stay valid until the next rebuild; find()
+ * returns shared ownership, so a call still running on another thread
+ * keeps its wrapper and the tool behind it alive, even after the provider
+ * replaced its tool list (see i_llm_tool_provider::get_shared_tools()).
+ */
+class tool_registry {
+public:
+    tool_registry();
+    ~tool_registry();
+
+    tool_registry(const tool_registry&) = delete;
+    tool_registry& operator=(const tool_registry&) = delete;
+
+    /**
+     * @brief Register a single function (replaces one with the same name)
+     */
+    void add_function(std::shared_ptr<i_llm_function> func);
+
+    /**
+     * @brief Register a tool provider
+     */
+    void add_provider(std::shared_ptr<i_llm_tool_provider> provider);
+
+    /**
+     * @brief Call refresh_tools() on every provider
+     * @return True if all refreshes succeeded
+     *
+     * Cached data is only dropped for providers whose version changed.
+     */
+    bool refresh();
+
+    /**
+     * @brief All tools, directly registered functions first
+     */
+    const std::vector<i_llm_function*>& get_tools();
+
+    /**
+     * @brief Look up a tool by name
+     * @return Tool or nullptr; directly registered functions win over providers
+     */
+    std::shared_ptr<i_llm_function> find(const flx_string& name);
+
+    /**
+     * @brief Incremented on every rebuild of the tool list
+     */
+    uint64_t get_version() const { return version_; }
+
+    size_t size();
+
+private:
+    class cached_function;
+
+    struct provider_entry {
+        std::shared_ptr<i_llm_tool_provider> provider;
+        uint64_t seen_version = 0;
+        bool seen_available = false;
+        bool loaded = false;
+        std::vector<std::shared_ptr<cached_function>> tools;
+    };
+
+    std::vector<std::shared_ptr<i_llm_function>> functions_;
+    std::vector<std::shared_ptr<cached_function>> function_tools_;
+    bool functions_dirty_;
+
+    std::vector<provider_entry> providers_;
+
+    std::vector<i_llm_function*> tools_;
+    std::unordered_map<std::string, std::shared_ptr<cached_function>> index_;
+    uint64_t version_;
+
+    void sync(bool reload_unversioned);
+    static void load_provider(provider_entry& entry);
+};
+
+} // namespace flx::llm
+
+#endif // FLX_LLM_TOOL_REGISTRY_H
@@ -94,6 +94,12 @@ std::vector<i_llm_function*> mcp_tool_provider::get_available_tools() {
     return tools;
 }
 
+bool mcp_tool_provider::get_shared_tools(std::vector<std::shared_ptr<i_llm_function>>& tools) {
+    // refresh_tools() replaces adapters_ while calls may still be running
+    tools.assign(adapters_.begin(), adapters_.end());
+    return true;
+}
+
 bool mcp_tool_provider::refresh_tools() {
     if (!mcp_client_ || !mcp_client_->is_running()) {
         return false;
@@ -102,6 +108,20 @@ bool mcp_tool_provider::refresh_tools() {
     try {
         std::vector<mcp::tool> mcp_tools = mcp_client_->get_tools();
 
+        // Keep adapters (and the version) when the server reports the same tools
+        std::string signature;
+        for (const auto& mcp_tool : mcp_tools) {
+            signature += mcp_tool.name;
+            signature += '\0';
+            signature += mcp_tool.description;
+            signature += '\0';
+            signature += mcp_tool.parameters_schema.dump();
+            signature += '\n';
+        }
+        if (signature == tools_signature_) {
+            return true;
+        }
+
         adapters_.clear();
         adapters_.reserve(mcp_tools.size());
 
@@ -120,6 +140,8 @@ bool mcp_tool_provider::refresh_tools() {
             adapters_.push_back(adapter);
         }
 
+        tools_signature_ = std::move(signature);
+        ++version_;
         return true;
     }
     catch (const std::exception&) {
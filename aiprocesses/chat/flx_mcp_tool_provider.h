@@ -6,6 +6,7 @@
 #ifdef FLX_ENABLE_MCP
 
 #include <memory>
+#include <string>
 
 namespace mcp {
     class client;
@@ -40,6 +41,8 @@ class mcp_tool_provider : public i_llm_tool_provider {
     std::shared_ptr<mcp::client> mcp_client_;
     std::vector<std::shared_ptr<mcp_function_adapter>> adapters_;
     flx_string provider_name_;
+    std::string tools_signature_;
+    uint64_t version_ = 1;
 
 public:
     explicit mcp_tool_provider(
@@ -48,9 +51,11 @@ public:
     );
 
     std::vector<i_llm_function*> get_available_tools() override;
+    bool get_shared_tools(std::vector<std::shared_ptr<i_llm_function>>& tools) override;
     bool refresh_tools() override;
     flx_string get_provider_name() const override { return provider_name_; }
     bool is_available() const override;
+    uint64_t get_tools_version() const override { return version_; }
 
     size_t tool_count() const { return adapters_.size(); }
 };
@@ -0,0 +1,313 @@
+#include "flx_text_segmenter.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <unordered_set>
+
+using namespace flx;
+
+namespace {
+  // Common function words of the languages we see in chats (English, German)
+  const std::unordered_set<std::string>& stopwords()
+  {
+    static const std::unordered_set<std::string> words = {
+      "the", "and", "for", "are", "but", "not", "you", "all", "any", "can", "had", "her", "was", "one", "our",
+      "out", "has", "have", "his", "how", "its", "may", "new", "now", "see", "two", "way", "who", "did", "get",
+      "let", "she", "too", "use", "that", "with", "this", "from", "they", "will", "would", "there", "their",
+      "what", "about", "which", "when", "were", "been", "into", "than", "then", "them", "these", "those",
+      "some", "also", "just", "only", "very", "your", "more", "most", "other", "such", "each", "should",
+      "could", "does", "here", "where", "while", "because", "being", "over", "after", "before", "like",
+      "der", "die", "das", "und", "ist", "ein", "eine", "einer", "eines", "einem", "einen", "den", "dem",
+      "des", "mit", "von", "für", "auf", "aus", "bei", "nach", "sich", "nicht", "auch", "als", "wie", "wir",
+      "ihr", "sie", "sind", "war", "wird", "werden", "kann", "noch", "nur", "oder", "aber", "wenn", "dass",
+      "zum", "zur", "hat", "haben", "ich", "mir", "mich", "uns", "euch", "diese", "dieser", "dieses", "über",
+      "unter", "durch", "schon", "sehr", "hier", "dort", "bitte"
+    };
+    return words;
+  }
+
+  const std::unordered_set<std::string>& abbreviations()
+  {
+    static const std::unordered_set<std::string> words = {
+      "z.b", "d.h", "u.a", "bzw", "ca", "dr", "nr", "vgl", "usw", "evtl", "ggf", "inkl", "zzgl", "str",
+      "e.g", "i.e", "mr", "mrs", "ms", "vs", "etc", "inc", "ltd", "no", "fig", "st", "prof"
+    };
+    return words;
+  }
+
+  bool is_space(char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\f' || c == '\v'; }
+
+  // Letters, digits and all UTF-8 multi-byte sequences (umlauts etc.) form words
+  bool is_word_byte(unsigned char c) { return std::isalnum(c) || c >= 0x80; }
+
+  // Sentence may start here: upper case, digit, quote, bullet or non-ASCII
+  bool starts_sentence(unsigned char c)
+  {
+    return std::isupper(c) || std::isdigit(c) || c == '"' || c == '\'' || c == '(' || c == '-' || c == '*' || c >= 0x80;
+  }
+
+  bool is_abbreviation(const std::string& text, size_t dot)
+  {
+    size_t start = dot;
+    while (start > 0 && (std::isalpha(static_cast<unsigned char>(text[start - 1])) || text[start - 1] == '.')) {
+      --start;
+    }
+    if (start == dot) return false;
+    std::string word;
+    for (size_t i = start; i < dot; ++i) word += static_cast<char>(std::tolower(static_cast<unsigned char>(text[i])));
+    // single letters are initials ("J. Smith")
+    return word.size() == 1 || abbreviations().count(word) > 0;
+  }
+
+  // Crude stemmer: inflected forms share their first bytes
+  std::string stem(const std::string& word)
+  {
+    const size_t stem_length = 6;
+    if (word.size() <= stem_length) return word;
+    size_t cut = stem_length;
+    // never split a UTF-8 sequence
+    while (cut < word.size() && (static_cast<unsigned char>(word[cut]) & 0xC0) == 0x80) ++cut;
+    return word.substr(0, cut);
+  }
+}
+
+text_segmenter::text_segmenter() = default;
+
+text_segmenter::text_segmenter(const options& opts) : opts_(opts) {}
+
+void text_segmenter::reset()
+{
+  previous_terms_.clear();
+  previous_topic_ = flx_string();
+}
+
+std::vector<text_segmenter::sentence> text_segmenter::split_sentences(const std::string& text)
+{
+  std::vector<sentence> sentences;
+  size_t begin = 0;
+  bool paragraph_start = false;
+
+  auto emit = [&](size_t end) {
+    size_t b = begin;
+    size_t e = end;
+    while (b < e && is_space(text[b])) ++b;
+    while (e > b && is_space(text[e - 1])) --e;
+    if (b < e) {
+      sentences.push_back({b, e, paragraph_start && !sentences.empty()});
+      paragraph_start = false;
+    }
+    begin = end;
+  };
+
+  for (size_t i = 0; i < text.size(); ++i) {
+    char c = text[i];
+    if (c == '\n') {
+      // every line break ends a sentence (lists, headings), blank lines end paragraphs
+      emit(i);
+      size_t j = i + 1;
+      while (j < text.size() && is_space(text[j]) && text[j] != '\n') ++j;
+      if (j < text.size() && text[j] == '\n') {
+        paragraph_start = true;
+      }
+      continue;
+    }
+    if (c != '.' && c != '!' && c != '?') continue;
+
+    size_t end = i + 1;
+    while (end < text.size() && (text[end] == '.' || text[end] == '!' || text[end] == '?' ||
+                                 text[end] == '"' || text[end] == '\'' || text[end] == ')')) {
+      ++end;
+    }
+    if (end >= text.size()) break;
+    if (!is_space(text[end]) || text[end] == '\n') {
+      i = end - 1;
+      continue;
+    }
+    size_t next = end;
+    while (next < text.size() && is_space(text[next]) && text[next] != '\n') ++next;
+    if (next < text.size() && text[next] != '\n' && !starts_sentence(static_cast<unsigned char>(text[next]))) {
+      i = end - 1;
+      continue;
+    }
+    if (c == '.' && is_abbreviation(text, i)) {
+      i = end - 1;
+      continue;
+    }
+    emit(end);
+    i = end - 1;
+  }
+  emit(text.size());
+  return sentences;
+}
+
+void text_segmenter::add_terms(const std::string& text, size_t begin, size_t end, term_vector& terms,
+                               std::unordered_map<std::string, term_info>* info)
+{
+  size_t i = begin;
+  while (i < end) {
+    while (i < end && !is_word_byte(static_cast<unsigned char>(text[i]))) ++i;
+    size_t start = i;
+    bool has_alpha = false;
+    while (i < end && is_word_byte(static_cast<unsigned char>(text[i]))) {
+      has_alpha = has_alpha || !std::isdigit(static_cast<unsigned char>(text[i]));
+      ++i;
+    }
+    if (i - start < 3 || !has_alpha) continue;
+
+    std::string word;
+    word.reserve(i - start);
+    for (size_t k = start; k < i; ++k) word += static_cast<char>(std::tolower(static_cast<unsigned char>(text[k])));
+    if (stopwords().count(word)) continue;
+
+    std::string key = stem(word);
+    terms[key] += 1.0;
+    if (info) {
+      auto inserted = info->emplace(key, term_info());
+      term_info& ti = inserted.first->second;
+      if (inserted.second) {
+        ti.first_seen = info->size();
+        ti.surface = word;
+      }
+      ++ti.count;
+    }
+  }
+}
+
+double text_segmenter::cosine(const term_vector& a, const term_vector& b)
+{
+  if (a.empty() || b.empty()) return 0.0;
+  const term_vector& small = a.size() < b.size() ? a : b;
+  const term_vector& large = a.size() < b.size() ? b : a;
+  double dot = 0.0;
+  for (const auto& term : small) {
+    auto it = large.find(term.first);
+    if (it != large.end()) dot += term.second * it->second;
+  }
+  if (dot == 0.0) return 0.0;
+  double na = 0.0, nb = 0.0;
+  for (const auto& term : a) na += term.second * term.second;
+  for (const auto& term : b) nb += term.second * term.second;
+  return dot / std::sqrt(na * nb);
+}
+
+std::vector<size_t> text_segmenter::find_boundaries(const std::vector<term_vector>& sentence_terms,
+                                                    const std::vector<sentence>& sentences) const
+{
+  const size_t n = sentence_terms.size();
+  const size_t min_sentences = std::max<size_t>(1, opts_.min_sentences);
+  if (n < 2 * min_sentences) return {};
+
+  // similarity across gap g (between sentence g-1 and g), g = 1..n-1
+  std::vector<double> similarity(n, 0.0);
+  const size_t window = std::max<size_t>(1, opts_.window);
+  for (size_t g = 1; g < n; ++g) {
+    term_vector left, right;
+    for (size_t k = (g > window ? g - window : 0); k < g; ++k) {
+      for (const auto& t : sentence_terms[k]) left[t.first] += t.second;
+    }
+    for (size_t k = g; k < std::min(n, g + window); ++k) {
+      for (const auto& t : sentence_terms[k]) right[t.first] += t.second;
+    }
+    similarity[g] = cosine(left, right);
+  }
+
+  // depth score: how far the similarity drops below the peaks on both sides
+  std::vector<std::pair<double, size_t>> candidates;
+  double sum = 0.0, sum_sq = 0.0;
+  for (size_t g = 1; g < n; ++g) {
+    double left_peak = similarity[g];
+    for (size_t k = g; k > 1 && similarity[k - 1] >= left_peak; --k) left_peak = similarity[k - 1];
+    double right_peak = similarity[g];
+    for (size_t k = g; k + 1 < n && similarity[k + 1] >= right_peak; ++k) right_peak = similarity[k + 1];
+    double depth = (left_peak - similarity[g]) + (right_peak - similarity[g]);
+    if (sentences[g].paragraph_start) depth += opts_.paragraph_bonus;
+    sum += depth;
+    sum_sq += depth * depth;
+    candidates.emplace_back(depth, g);
+  }
+  double mean = sum / candidates.size();
+  double deviation = std::sqrt(std::max(0.0, sum_sq / candidates.size() - mean * mean));
+  // TextTiling cutoff, but never below an absolute minimum drop
+  double cutoff = std::max(opts_.min_depth, mean - deviation / 2);
+
+  std::sort(candidates.begin(), candidates.end(), [](const auto& a, const auto& b) {
+    return a.first != b.first ? a.first > b.first : a.second < b.second;
+  });
+  std::vector<size_t> boundaries;
+  for (const auto& candidate : candidates) {
+    if (candidate.first < cutoff) break;
+    size_t g = candidate.second;
+    if (g < min_sentences || n - g < min_sentences) continue;
+    bool too_close = false;
+    for (size_t b : boundaries) {
+      if ((g > b ? g - b : b - g) < min_sentences) {
+        too_close = true;
+        break;
+      }
+    }
+    if (!too_close) boundaries.push_back(g);
+  }
+  std::sort(boundaries.begin(), boundaries.end());
+  return boundaries;
+}
+
+flx_string text_segmenter::make_topic(const std::unordered_map<std::string, term_info>& info) const
+{
+  std::vector<const term_info*> terms;
+  terms.reserve(info.size());
+  for (const auto& entry : info) terms.push_back(&entry.second);
+  size_t count = std::min(opts_.topic_terms, terms.size());
+  std::partial_sort(terms.begin(), terms.begin() + count, terms.end(), [](const term_info* a, const term_info* b) {
+    return a->count != b->count ? a->count > b->count : a->first_seen < b->first_seen;
+  });
+  flx_string topic;
+  for (size_t i = 0; i < count; ++i) {
+    if (i) topic += ", ";
+    topic += terms[i]->surface;
+  }
+  return topic;
+}
+
+std::vector<text_segmenter::segment> text_segmenter::segment_message(const flx_string& message)
+{
+  const std::string& text = message.to_std_const();
+  std::vector<segment> result;
+  std::vector<sentence> sentences = split_sentences(text);
+  if (sentences.empty()) return result;
+
+  std::vector<term_vector> sentence_terms(sentences.size());
+  for (size_t i = 0; i < sentences.size(); ++i) {
+    add_terms(text, sentences[i].begin, sentences[i].end, sentence_terms[i], nullptr);
+  }
+
+  std::vector<size_t> boundaries = find_boundaries(sentence_terms, sentences);
+  boundaries.push_back(sentences.size());
+
+  size_t first = 0;
+  for (size_t boundary : boundaries) {
+    term_vector terms;
+    std::unordered_map<std::string, term_info> info;
+    add_terms(text, sentences[first].begin, sentences[boundary - 1].end, terms, &info);
+
+    segment seg;
+    seg.text = text.substr(sentences[first].begin, sentences[boundary - 1].end - sentences[first].begin);
+    if (result.empty() && !previous_terms_.empty() &&
+        cosine(previous_terms_, terms) >= opts_.continuation_similarity) {
+      seg.continues_previous = true;
+      seg.topic = previous_topic_;
+    } else {
+      seg.topic = make_topic(info);
+    }
+    result.push_back(std::move(seg));
+
+    if (boundary == sentences.size()) {
+      // a continued topic accumulates its vocabulary over messages
+      if (!result.back().continues_previous || result.size() > 1) previous_terms_.clear();
+      for (const auto& t : terms) previous_terms_[t.first] += t.second;
+      previous_topic_ = result.back().topic;
+    }
+    first = boundary;
+  }
+  return result;
+}
@@ -0,0 +1,79 @@
+#ifndef FLX_TEXT_SEGMENTER_H
+#define FLX_TEXT_SEGMENTER_H
+
+#include "../../utils/flx_string.h"
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace flx {
+  /**
+   * Local topic segmentation (TextTiling-style lexical cohesion, no model calls).
+   *
+   * A message is split into sentences, each sentence becomes a bag of stemmed
+   * content words. For every gap between sentences the cosine similarity of
+   * the surrounding windows is computed; gaps lying in a deep "valley" of
+   * similarity (and paragraph breaks, which get a bonus) become topic
+   * boundaries. Topics are labelled with the most frequent content words.
+   *
+   * Messages are fed one after another: the word vector of the last segment is
+   * kept, so the first segment of the next message can continue its topic.
+   * Cost is linear in the new message only.
+   */
+  class text_segmenter {
+  public:
+    struct options {
+      size_t window = 3;              // sentences compared on each side of a gap
+      size_t min_sentences = 2;       // minimum sentences per segment
+      double min_depth = 0.15;        // minimum similarity drop for a boundary
+      double paragraph_bonus = 0.15;  // added to the depth at blank lines
+      double continuation_similarity = 0.1;  // cross-message topic continuation
+      size_t topic_terms = 3;         // words in a topic label
+    };
+
+    struct segment {
+      flx_string text;
+      flx_string topic;
+      bool continues_previous = false;  // same topic as the end of the previous message
+    };
+
+    struct sentence {
+      size_t begin = 0;   // byte offsets in the message
+      size_t end = 0;
+      bool paragraph_start = false;
+    };
+
+    text_segmenter();
+    explicit text_segmenter(const options& opts);
+
+    // Segments the next message of the stream
+    std::vector<segment> segment_message(const flx_string& text);
+
+    // Forget the previous message (new conversation)
+    void reset();
+
+    static std::vector<sentence> split_sentences(const std::string& text);
+
+  private:
+    using term_vector = std::unordered_map<std::string, double>;
+
+    struct term_info {
+      size_t count = 0;
+      size_t first_seen = 0;
+      std::string surface;
+    };
+
+    options opts_;
+    term_vector previous_terms_;
+    flx_string previous_topic_;
+
+    static void add_terms(const std::string& text, size_t begin, size_t end, term_vector& terms,
+                          std::unordered_map<std::string, term_info>* info);
+    static double cosine(const term_vector& a, const term_vector& b);
+    std::vector<size_t> find_boundaries(const std::vector<term_vector>& sentence_terms,
+                                        const std::vector<sentence>& sentences) const;
+    flx_string make_topic(const std::unordered_map<std::string, term_info>& info) const;
+  };
+}
+
+#endif // FLX_TEXT_SEGMENTER_H
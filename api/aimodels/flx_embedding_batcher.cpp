@@ -0,0 +1,165 @@
+#include "flx_embedding_batcher.h"
+#include <algorithm>
+#include <iostream>
+
+namespace flx::llm {
+
+  embedding_batcher::embedding_batcher(i_llm_api& api)
+    : embedding_batcher(api, options())
+  {
+  }
+
+  embedding_batcher::embedding_batcher(i_llm_api& api, options opts)
+    : api_(api), options_(opts)
+  {
+    if (options_.max_inputs == 0) options_.max_inputs = 1;
+    worker_ = std::thread(&embedding_batcher::run, this);
+  }
+
+  embedding_batcher::~embedding_batcher()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    queue_cv_.notify_all();
+    if (worker_.joinable()) {
+      worker_.join();
+    }
+  }
+
+  bool embedding_batcher::embed(const flx_string& text, std::vector<float>& embedding)
+  {
+    if (text.empty()) {
+      return false;
+    }
+
+    pending_embedding entry;
+    entry.text = &text;
+    entry.result = &embedding;
+    entry.tokens = estimate_embedding_tokens(text);
+    entry.enqueued = std::chrono::steady_clock::now();
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (stop_) {
+      return false;
+    }
+    queue_.push_back(&entry);
+    queued_tokens_ += entry.tokens;
+    queue_cv_.notify_one();
+
+    done_cv_.wait(lock, [&entry] { return entry.done; });
+    return entry.success;
+  }
+
+  bool embedding_batcher::embed_all(const std::vector<flx_string>& texts, std::vector<std::vector<float>>& embeddings)
+  {
+    embeddings.assign(texts.size(), std::vector<float>());
+    for (const auto& text : texts) {
+      if (text.empty()) {
+        return false;
+      }
+    }
+
+    std::vector<pending_embedding> entries(texts.size());
+    auto now = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < texts.size(); ++i) {
+      entries[i].text = &texts[i];
+      entries[i].result = &embeddings[i];
+      entries[i].tokens = estimate_embedding_tokens(texts[i]);
+      entries[i].enqueued = now;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (stop_) {
+      return false;
+    }
+    for (auto& entry : entries) {
+      queue_.push_back(&entry);
+      queued_tokens_ += entry.tokens;
+    }
+    queue_cv_.notify_one();
+
+    done_cv_.wait(lock, [&entries] {
+      return std::all_of(entries.begin(), entries.end(), [](const pending_embedding& e) { return e.done; });
+    });
+    return std::all_of(entries.begin(), entries.end(), [](const pending_embedding& e) { return e.success; });
+  }
+
+  bool embedding_batcher::batch_ready() const
+  {
+    return queue_.size() >= options_.max_inputs || queued_tokens_ >= options_.max_tokens;
+  }
+
+  void embedding_batcher::send(const std::vector<pending_embedding*>& batch, size_t begin, size_t end)
+  {
+    std::vector<flx_string> texts;
+    texts.reserve(end - begin);
+    for (size_t i = begin; i < end; ++i) {
+      texts.push_back(*batch[i]->text);
+    }
+
+    std::vector<std::vector<float>> embeddings;
+    bool ok = false;
+    try {
+      ok = api_.embedding_batch(texts, embeddings) && embeddings.size() == texts.size();
+    } catch (const std::exception& e) {
+      std::cerr << "[embedding_batcher] Batch of " << texts.size() << " failed: " << e.what() << std::endl;
+      ok = false;
+    }
+
+    if (ok) {
+      for (size_t i = begin; i < end; ++i) {
+        *batch[i]->result = std::move(embeddings[i - begin]);
+        batch[i]->success = true;
+      }
+      return;
+    }
+    if (end - begin == 1) {
+      batch[begin]->success = false;
+      return;
+    }
+
+    // Retry the halves, so only the inputs that fail on their own are lost
+    size_t middle = begin + (end - begin) / 2;
+    send(batch, begin, middle);
+    send(batch, middle, end);
+  }
+
+  void embedding_batcher::run()
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+      queue_cv_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+      if (queue_.empty()) {
+        break; // stop_ and nothing left to send
+      }
+
+      // Wait for more callers until the oldest entry's window has passed
+      auto deadline = queue_.front()->enqueued + options_.max_wait;
+      queue_cv_.wait_until(lock, deadline, [this] { return stop_ || batch_ready(); });
+
+      std::vector<pending_embedding*> batch;
+      size_t batch_tokens = 0;
+      while (!queue_.empty() && batch.size() < options_.max_inputs) {
+        pending_embedding* next = queue_.front();
+        if (!batch.empty() && batch_tokens + next->tokens > options_.max_tokens) break;
+        batch_tokens += next->tokens;
+        queued_tokens_ -= next->tokens;
+        batch.push_back(next);
+        queue_.pop_front();
+      }
+
+      // Callers block until done, so their texts stay valid while unlocked
+      lock.unlock();
+      send(batch, 0, batch.size());
+      lock.lock();
+
+      for (auto* entry : batch) {
+        entry->done = true;
+      }
+      done_cv_.notify_all();
+    }
+  }
+
+} // namespace flx::llm
@@ -0,0 +1,77 @@
+#ifndef FLX_EMBEDDING_BATCHER_H
+#define FLX_EMBEDDING_BATCHER_H
+
+#include "../../aiprocesses/chat/flx_llm_api.h"
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace flx::llm {
+
+  /**
+   * Sammelt gleichzeitige Embedding-Anfragen mehrerer Threads für ein kurzes
+   * Zeitfenster und schickt sie als einen embedding_batch()-Aufruf.
+   *
+   * Ein Batch wird gesendet, sobald das Zeitfenster des ältesten Eintrags
+   * abgelaufen ist oder das Input-/Token-Limit erreicht ist.
+   *
+   * Scheitert ein Batch, wird er halbiert und erneut gesendet, bis die
+   * fehlerhaften Texte einzeln übrig sind: ein ungültiger Text lässt nur
+   * seinen eigenen Aufrufer scheitern. Ist die API ganz ausgefallen, kostet
+   * das bis zu 2n-1 Aufrufe für n Texte.
+   */
+  class embedding_batcher {
+  public:
+    struct options {
+      std::chrono::milliseconds max_wait{5};
+      size_t max_inputs = 256;
+      size_t max_tokens = 250000;
+    };
+
+    explicit embedding_batcher(i_llm_api& api);
+    embedding_batcher(i_llm_api& api, options opts);
+    ~embedding_batcher();
+
+    embedding_batcher(const embedding_batcher&) = delete;
+    embedding_batcher& operator=(const embedding_batcher&) = delete;
+
+    // Blockiert, bis der Batch mit diesem Text beantwortet ist
+    bool embed(const flx_string& text, std::vector<float>& embedding);
+
+    // Mehrere Texte (z.B. Abschnitte eines Dokuments) in einem Zug einreihen;
+    // true nur, wenn alle eingebettet wurden
+    bool embed_all(const std::vector<flx_string>& texts, std::vector<std::vector<float>>& embeddings);
+
+  private:
+    struct pending_embedding {
+      const flx_string* text;
+      std::vector<float>* result;
+      size_t tokens;
+      std::chrono::steady_clock::time_point enqueued;
+      bool done = false;
+      bool success = false;
+    };
+
+    void run();
+    bool batch_ready() const;
+    // Ohne Lock: setzt result und success von batch[begin, end), halbiert bei Fehlern
+    void send(const std::vector<pending_embedding*>& batch, size_t begin, size_t end);
+
+    i_llm_api& api_;
+    options options_;
+
+    std::mutex mutex_;
+    std::condition_variable queue_cv_;
+    std::condition_variable done_cv_;
+    std::deque<pending_embedding*> queue_;
+    size_t queued_tokens_ = 0;
+    bool stop_ = false;
+    std::thread worker_;
+  };
+
+} // namespace flx::llm
+
+#endif // FLX_EMBEDDING_BATCHER_H
@@ -0,0 +1,124 @@
+#include "flx_embedding_chunker.h"
+#include "../../aiprocesses/chat/flx_llm_api.h"
+#include <algorithm>
+#include <cmath>
+
+namespace flx::llm {
+
+  namespace {
+    // Umkehrung von estimate_embedding_tokens (~2 Bytes pro Token)
+    constexpr size_t bytes_per_token = 2;
+
+    bool is_space(char c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r'; }
+
+    bool is_continuation_byte(char c) { return (static_cast<unsigned char>(c) & 0xC0) == 0x80; }
+
+    size_t meta_size(const flxv_map& meta, const char* key, size_t fallback) {
+      auto it = meta.find(key);
+      if (it == meta.end()) return fallback;
+      if (it->second.is_int() && it->second.int_value() > 0) return static_cast<size_t>(it->second.int_value());
+      if (it->second.is_double() && it->second.double_value() > 0) return static_cast<size_t>(it->second.double_value());
+      return fallback;
+    }
+
+    // Letzte gute Schnittstelle in (min_end, max_end]: Absatz, Satzende, Leerraum, sonst UTF-8-Grenze
+    size_t find_cut(const std::string& text, size_t min_end, size_t max_end) {
+      for (size_t i = max_end; i > min_end + 1; --i) {
+        if (text[i - 1] == '\n' && text[i - 2] == '\n') return i;
+      }
+      for (size_t i = max_end; i > min_end + 1; --i) {
+        char p = text[i - 2];
+        if ((p == '.' || p == '!' || p == '?' || p == '\n') && is_space(text[i - 1])) return i;
+      }
+      for (size_t i = max_end; i > min_end; --i) {
+        if (is_space(text[i - 1])) return i;
+      }
+      size_t cut = max_end;
+      while (cut > min_end && is_continuation_byte(text[cut])) --cut;
+      return cut;
+    }
+  }
+
+  long_text_options long_text_options::from_meta(const flxv_map& meta, const long_text_options& defaults) {
+    long_text_options options = defaults;
+    auto strategy = meta.find("embedding_strategy");
+    if (strategy != meta.end() && strategy->second.is_string()) {
+      const flx_string& name = strategy->second.string_value();
+      if (name == "chunk") options.strategy = long_text_strategy::chunk;
+      else if (name == "summarize") options.strategy = long_text_strategy::summarize;
+      else if (name == "truncate") options.strategy = long_text_strategy::truncate;
+    }
+    options.chunk_tokens = meta_size(meta, "chunk_tokens", options.chunk_tokens);
+    options.overlap_tokens = meta_size(meta, "chunk_overlap", options.overlap_tokens);
+    auto pooling = meta.find("pooling");
+    if (pooling != meta.end() && pooling->second.is_string()) {
+      options.pooling = pooling->second.string_value() == "mean" ? pooling_mode::mean : pooling_mode::weighted;
+    }
+    return options;
+  }
+
+  std::vector<text_chunk> split_into_chunks(const flx_string& flx_text, const long_text_options& options) {
+    const std::string& text = flx_text.to_std_const();
+    const size_t n = text.size();
+    const size_t max_bytes = std::max<size_t>(16, options.chunk_tokens * bytes_per_token);
+    // Überlappung höchstens ein halber Abschnitt, sonst kein Fortschritt
+    const size_t overlap_bytes = std::min(options.overlap_tokens * bytes_per_token, max_bytes / 2);
+
+    std::vector<text_chunk> chunks;
+    if (n <= max_bytes) {
+      chunks.push_back({0, n, estimate_embedding_tokens(flx_text)});
+      return chunks;
+    }
+
+    size_t start = 0;
+    while (start < n) {
+      while (start < n && is_space(text[start])) ++start;
+      if (start >= n) break;
+
+      size_t end = n;
+      if (n - start > max_bytes) {
+        end = find_cut(text, start + max_bytes / 2, start + max_bytes);
+      }
+      size_t length = end - start;
+      chunks.push_back({start, length, length / bytes_per_token + 1});
+      if (end >= n) break;
+
+      // Nächster Abschnitt beginnt overlap_bytes vor dem Ende, an einem Wortanfang
+      size_t next = end > start + overlap_bytes ? end - overlap_bytes : end;
+      while (next < end && !is_space(text[next - 1])) ++next;
+      while (next < n && is_continuation_byte(text[next])) ++next;
+      start = next > start ? next : end;
+    }
+    return chunks;
+  }
+
+  std::vector<float> pool_embeddings(const std::vector<std::vector<float>>& embeddings,
+                                     const std::vector<text_chunk>& chunks,
+                                     pooling_mode mode) {
+    if (embeddings.empty()) return {};
+    if (embeddings.size() == 1) return embeddings[0];
+
+    const size_t dimensions = embeddings[0].size();
+    std::vector<double> sum(dimensions, 0.0);
+    for (size_t i = 0; i < embeddings.size(); ++i) {
+      if (embeddings[i].size() != dimensions) return {};
+      double weight = 1.0;
+      if (mode == pooling_mode::weighted && i < chunks.size()) {
+        weight = static_cast<double>(chunks[i].tokens);
+      }
+      for (size_t d = 0; d < dimensions; ++d) {
+        sum[d] += weight * embeddings[i][d];
+      }
+    }
+
+    double norm = 0.0;
+    for (double v : sum) norm += v * v;
+    norm = std::sqrt(norm);
+    std::vector<float> pooled(dimensions);
+    for (size_t d = 0; d < dimensions; ++d) {
+      pooled[d] = static_cast<float>(norm > 0.0 ? sum[d] / norm : 0.0);
+    }
+    return pooled;
+  }
+
+} // namespace flx::llm
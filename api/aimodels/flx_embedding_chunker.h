@@ -0,0 +1,61 @@
+#ifndef FLX_EMBEDDING_CHUNKER_H
+#define FLX_EMBEDDING_CHUNKER_H
+
+#include "../../utils/flx_string.h"
+#include "../../utils/flx_variant.h"
+#include <vector>
+
+namespace flx::llm {
+
+  // Umgang mit Texten über dem Eingabelimit des Embedding-Modells
+  enum class long_text_strategy {
+    chunk,      // überlappende Abschnitte einzeln einbetten und poolen
+    summarize,  // erst per Chat-Completion zusammenfassen (zusätzlicher Request)
+    truncate    // nur den Anfang einbetten
+  };
+
+  enum class pooling_mode {
+    mean,      // jeder Abschnitt gleich gewichtet
+    weighted   // nach Token-Anzahl gewichtet (kurzer Restabschnitt zählt weniger)
+  };
+
+  /**
+   * Einstellungen für lange Texte. Über Metadaten an der
+   * semantic_embedding-Property pro Modell wählbar:
+   *   {"embedding_strategy", "chunk" | "summarize" | "truncate"},
+   *   {"chunk_tokens", 512}, {"chunk_overlap", 64}, {"pooling", "mean" | "weighted"}
+   */
+  struct long_text_options {
+    long_text_strategy strategy = long_text_strategy::chunk;
+    size_t chunk_tokens = 3000;    // Texte darüber werden behandelt (~6000 Zeichen); Größe eines Abschnitts
+    size_t overlap_tokens = 300;   // Überlappung benachbarter Abschnitte
+    pooling_mode pooling = pooling_mode::weighted;
+
+    // Nicht gesetzte Schlüssel übernehmen defaults
+    static long_text_options from_meta(const flxv_map& meta, const long_text_options& defaults);
+    static long_text_options from_meta(const flxv_map& meta) { return from_meta(meta, long_text_options()); }
+  };
+
+  // Byte-Bereich eines Abschnitts im Originaltext
+  struct text_chunk {
+    size_t offset = 0;
+    size_t length = 0;
+    size_t tokens = 0;
+  };
+
+  /**
+   * Zerlegt einen Text in Abschnitte von höchstens chunk_tokens
+   * (Schätzung wie estimate_embedding_tokens). Geschnitten wird bevorzugt an
+   * Absatz-, Satz- oder Wortgrenzen, nie innerhalb eines UTF-8-Zeichens.
+   * Texte bis chunk_tokens ergeben genau einen Abschnitt.
+   */
+  std::vector<text_chunk> split_into_chunks(const flx_string& text, const long_text_options& options);
+
+  // Poolt Abschnitts-Vektoren zu einem L2-normierten Dokument-Vektor
+  std::vector<float> pool_embeddings(const std::vector<std::vector<float>>& embeddings,
+                                     const std::vector<text_chunk>& chunks,
+                                     pooling_mode mode);
+
+} // namespace flx::llm
+
+#endif // FLX_EMBEDDING_CHUNKER_H
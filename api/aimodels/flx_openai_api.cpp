@@ -1,9 +1,17 @@
 // openai_api.cpp
 #include "flx_openai_api.h"
 #include "../client/flx_http_request.h"
+#include "../client/flx_http_multi.h"
+#include "../client/flx_sse_parser.h"
+#include "../server/flx_metrics.h"
+#include "../json/json.hpp"
 #include <iostream>
 #include <api/json/flx_json.h>
+#include <array>
 #include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
 
 // Debug timing helper for API calls
 static auto api_debug_start = std::chrono::high_resolution_clock::now();
@@ -15,6 +23,52 @@ static void api_timestamp(const std::string& label) {
 }
 
 namespace flx::llm {
+  // Pooled keep-alive connection (default in flx_http_request), bounded time
+  // per attempt and retries for rate limits / transient upstream errors.
+  static void configure_api_request(flx_http_request& request, long timeout_ms) {
+    request.set_connect_timeout_ms(10000);
+    request.set_timeout_ms(timeout_ms);
+    request.set_retry(2, 1000);
+  }
+
+  // Decodes a base64 string of little-endian float32 values
+  static bool decode_base64_floats(const std::string& encoded, std::vector<float>& out) {
+    static const auto table = [] {
+      std::array<int8_t, 256> t{};
+      t.fill(-1);
+      const char* alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+      for (int i = 0; i < 64; ++i) t[static_cast<unsigned char>(alphabet[i])] = static_cast<int8_t>(i);
+      return t;
+    }();
+
+    std::vector<unsigned char> bytes;
+    bytes.reserve(encoded.size() / 4 * 3);
+    uint32_t buffer = 0;
+    int bits = 0;
+    for (unsigned char c : encoded) {
+      if (c == '=') break;
+      int8_t v = table[c];
+      if (v < 0) return false;
+      buffer = (buffer << 6) | static_cast<uint32_t>(v);
+      bits += 6;
+      if (bits >= 8) {
+        bits -= 8;
+        bytes.push_back(static_cast<unsigned char>((buffer >> bits) & 0xFF));
+      }
+    }
+    if (bytes.size() % sizeof(float) != 0) return false;
+
+    out.resize(bytes.size() / sizeof(float));
+    std::memcpy(out.data(), bytes.data(), bytes.size());
+    return true;
+  }
+
+  // Erster Abschnitt eines langen Textes, an einer Satz- oder Wortgrenze geschnitten
+  static flx_string leading_chunk(const flx_string& text, const long_text_options& options) {
+    text_chunk first = split_into_chunks(text, options).front();
+    return text.substr(first.offset, first.length);
+  }
+
   static flx_string role_to_string(message_role role) {
     switch (role) {
       case message_role::SYSTEM: return "system";
@@ -68,7 +122,39 @@ namespace flx::llm {
     throw std::runtime_error("Content not found or not a string in message data");
   }
 
-  openai_api::openai_api(flx_string key) : api_key(std::move(key)) {}
+  openai_chat_context::openai_chat_context()
+    : window([](message_role role, const flx_string& content) -> std::unique_ptr<i_llm_message> {
+        return std::make_unique<openai_message>(role, content);
+      })
+  {
+  }
+
+  void openai_chat_context::set_settings(const flxv_map& s)
+  {
+    settings = s;
+    auto it = settings.find("max_context_tokens");
+    if (it != settings.end() && it->second.is_int() && it->second.int_value() > 0) {
+      window.set_budget(static_cast<size_t>(it->second.int_value()));
+    }
+  }
+
+  openai_api::openai_api(flx_string key, flx_string url)
+    : api_key(std::move(key)), embedding_model("text-embedding-3-large")
+  {
+    if (url.empty()) {
+      const char* env_url = std::getenv("OPENAI_BASE_URL");
+      url = env_url && *env_url ? env_url : "https://api.openai.com/v1";
+    }
+    set_base_url(url);
+  }
+
+  void openai_api::set_base_url(const flx_string& url)
+  {
+    base_url = url;
+    while (!base_url.empty() && base_url.c_str()[base_url.length() - 1] == '/') {
+      base_url = base_url.substr(0, base_url.length() - 1);
+    }
+  }
 
   std::unique_ptr<i_llm_chat_context> openai_api::create_chat_context() {
     return std::make_unique<openai_chat_context>();
@@ -82,21 +168,22 @@ namespace flx::llm {
     return std::make_unique<openai_message>(data);
   }
 
-  std::unique_ptr<i_llm_message> openai_api::generate_response(
-    i_llm_chat_context& context,
-    const std::vector<i_llm_function*>* functions)
+  flx_string openai_api::build_chat_request_body(
+    openai_chat_context& context,
+    const std::vector<i_llm_function*>* functions,
+    bool stream)
   {
-    auto* openai_ctx = dynamic_cast<openai_chat_context*>(&context);
-    if (!openai_ctx) return nullptr;
-
     flxv_map request_body_map;
-    const auto& settings = openai_ctx->get_settings();
+    const auto& settings = context.get_settings();
     // if model not set throw missing settings exception
     if (!settings.count("model")) {
       std::cerr << "Error: Model setting is missing." << std::endl;
-      return nullptr;
+      return flx_string();
     }
     request_body_map["model"] = settings.at("model");
+    if (stream) {
+      request_body_map["stream"] = true;
+    }
 
            // ? Add support for structured outputs via response_format.
            // The user should provide the entire response_format map in the settings.
@@ -104,19 +191,36 @@ namespace flx::llm {
       request_body_map["response_format"] = settings.at("response_format");
     }
 
-    flxv_vector messages_vec;
-    for (const auto& msg : openai_ctx->get_messages()) {
-      messages_vec.push_back(msg->get_data());
-    }
-    request_body_map["messages"] = messages_vec;
-
-    if (functions && !functions->empty()) {
-      flxv_vector tools_vec;
+    // Tools als fertige JSON-Fragmente; Funktionen aus der tool_registry
+    // bringen ihr Schema schon serialisiert mit
+    flx_string tools_json;
+    bool has_tools = functions && !functions->empty();
+    if (has_tools) {
+      request_body_map["tool_choice"] = flx_string("auto");
+      tools_json = "[";
+      bool first = true;
       for (const auto& func : *functions) {
-        tools_vec.push_back(function_to_variant(*func));
+        if (!first) tools_json += ",";
+        first = false;
+        const flx_string* schema = func->get_schema_json();
+        if (schema) {
+          tools_json += "{\"type\":\"function\",\"function\":";
+          tools_json += *schema;
+          tools_json += "}";
+        } else {
+          flx_variant tool_var = function_to_variant(*func);
+          flx_json tool_handler(&tool_var.to_map());
+          tools_json += tool_handler.create();
+        }
       }
-      request_body_map["tools"] = tools_vec;
-      request_body_map["tool_choice"] = flx_string("auto");
+      tools_json += "]";
+    }
+
+    // Verlauf ins Budget bringen; die Tool-Schemas zählen mit
+    context_window& window = context.get_window();
+    if (!window.fit(estimate_tokens(tools_json))) {
+      std::cerr << "Warning: Chat history exceeds the context budget (" << window.total_tokens()
+                << " of " << window.get_budget() << " tokens)." << std::endl;
     }
 
     flx_json json_handler(&request_body_map);
@@ -124,8 +228,33 @@ namespace flx::llm {
 
     if (json_body_string.empty()) {
       std::cerr << "Error: Failed to create JSON request body." << std::endl;
+      return json_body_string;
+    }
+
+    // Nachrichten (pro Nachricht gecachtes JSON) und Tools vor dem schließenden '}' einfügen
+    json_body_string = json_body_string.substr(0, json_body_string.length() - 1);
+    json_body_string += ",\"messages\":";
+    window.append_messages_json(json_body_string);
+    if (has_tools) {
+      json_body_string += ",\"tools\":";
+      json_body_string += tools_json;
+    }
+    json_body_string += "}";
+    return json_body_string;
+  }
+
+  std::unique_ptr<i_llm_message> openai_api::generate_response(
+    i_llm_chat_context& context,
+    const std::vector<i_llm_function*>* functions)
+  {
+    auto* openai_ctx = dynamic_cast<openai_chat_context*>(&context);
+    if (!openai_ctx) return nullptr;
+
+    flx_string json_body_string = build_chat_request_body(*openai_ctx, functions, false);
+    if (json_body_string.empty()) {
       return nullptr;
     }
+    const auto& settings = openai_ctx->get_settings();
 
     // LOGGING: Request details
     api_timestamp("START OpenAI API Request");
@@ -145,14 +274,17 @@ namespace flx::llm {
       }
     }
 
-    flx_http_request request("https://api.openai.com/v1/chat/completions");
+    flx_http_request request(base_url + "/chat/completions");
     request.set_header("Content-Type", "application/json");
     request.set_header("Authorization", "Bearer " + api_key.to_std_const());
     request.set_method("POST");
     request.set_body(json_body_string.to_std());
+    configure_api_request(request, 300000);
 
     api_timestamp("Before HTTP request.send()");
+    flx_scoped_timer timer(flx_metrics::instance().timer("llm.chat"));
     if (!request.send() || request.get_status_code() != 200) {
+      timer.fail();
       std::cerr << "HTTP Request failed: " << request.get_error_message().to_std() << std::endl;
       std::cerr << "Response Body: " << request.get_response_body().to_std() << std::endl;
       return nullptr;
@@ -211,54 +343,295 @@ namespace flx::llm {
     return std::make_unique<openai_message>(data);
   }
 
+  bool openai_stream_assembler::add_chunk(const flx_string& payload, const i_llm_api::delta_callback& on_delta)
+  {
+    if (payload == "[DONE]") {
+      done = true;
+      return true;
+    }
+
+    nlohmann::json chunk = nlohmann::json::parse(payload.to_std_const(), nullptr, false);
+    if (chunk.is_discarded() || !chunk.is_object()) {
+      std::cerr << "Error: Invalid stream chunk: " << payload.to_std_const() << std::endl;
+      return true;
+    }
+
+    auto error_it = chunk.find("error");
+    if (error_it != chunk.end()) {
+      auto msg_it = error_it->find("message");
+      error = (msg_it != error_it->end() && msg_it->is_string()) ? flx_string(msg_it->get<std::string>()) : flx_string(error_it->dump());
+      done = true;
+      return true;
+    }
+
+    auto choices_it = chunk.find("choices");
+    if (choices_it == chunk.end() || !choices_it->is_array() || choices_it->empty()) {
+      return true;  // z.B. Usage-Chunk am Ende
+    }
+    const nlohmann::json& choice = (*choices_it)[0];
+
+    auto reason_it = choice.find("finish_reason");
+    if (reason_it != choice.end() && reason_it->is_string()) {
+      finish_reason = reason_it->get<std::string>();
+    }
+
+    auto delta_it = choice.find("delta");
+    if (delta_it == choice.end() || !delta_it->is_object()) {
+      return true;
+    }
+
+    auto tool_calls_it = delta_it->find("tool_calls");
+    if (tool_calls_it != delta_it->end() && tool_calls_it->is_array()) {
+      for (const auto& part : *tool_calls_it) {
+        // Teile eines Aufrufs kommen über mehrere Chunks, zusammengehalten durch index
+        long long index = part.value("index", 0LL);
+        tool_call_part& call = tool_calls[index];
+        auto id_it = part.find("id");
+        if (id_it != part.end() && id_it->is_string()) call.id = id_it->get<std::string>();
+        auto type_it = part.find("type");
+        if (type_it != part.end() && type_it->is_string()) call.type = type_it->get<std::string>();
+        auto function_it = part.find("function");
+        if (function_it != part.end() && function_it->is_object()) {
+          auto name_it = function_it->find("name");
+          if (name_it != function_it->end() && name_it->is_string()) call.name += name_it->get<std::string>();
+          auto args_it = function_it->find("arguments");
+          if (args_it != function_it->end() && args_it->is_string()) call.arguments += args_it->get<std::string>();
+        }
+      }
+    }
+
+    auto content_it = delta_it->find("content");
+    if (content_it != delta_it->end() && content_it->is_string()) {
+      flx_string text(content_it->get<std::string>());
+      has_content = true;
+      if (!text.empty()) {
+        content += text;
+        if (on_delta && !on_delta(text)) {
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+
+  flxv_map openai_stream_assembler::get_message() const
+  {
+    flxv_map message;
+    message["role"] = "assistant";
+    if (has_content) {
+      message["content"] = content;
+    } else {
+      message["content"] = flx_variant();
+    }
+    if (!tool_calls.empty()) {
+      flxv_vector calls;
+      for (const auto& entry : tool_calls) {
+        flxv_map function;
+        function["name"] = entry.second.name;
+        function["arguments"] = entry.second.arguments;
+        flxv_map call;
+        call["id"] = entry.second.id;
+        call["type"] = entry.second.type.empty() ? flx_string("function") : entry.second.type;
+        call["function"] = function;
+        calls.push_back(call);
+      }
+      message["tool_calls"] = calls;
+    }
+    return message;
+  }
+
+  std::unique_ptr<i_llm_message> openai_api::generate_response_stream(
+    i_llm_chat_context& context,
+    const std::vector<i_llm_function*>* functions,
+    const delta_callback& on_delta)
+  {
+    auto* openai_ctx = dynamic_cast<openai_chat_context*>(&context);
+    if (!openai_ctx) return nullptr;
+
+    flx_string json_body_string = build_chat_request_body(*openai_ctx, functions, true);
+    if (json_body_string.empty()) {
+      return nullptr;
+    }
+
+    openai_stream_assembler assembler;
+    bool cancelled = false;
+    flx_sse_parser parser([&](const flx_sse_parser::event& ev) {
+      if (!assembler.add_chunk(ev.data, on_delta)) {
+        cancelled = true;
+        return false;
+      }
+      return true;
+    });
+
+    flx_http_request request(base_url + "/chat/completions");
+    request.set_header("Content-Type", "application/json");
+    request.set_header("Accept", "text/event-stream");
+    request.set_header("Authorization", "Bearer " + api_key.to_std_const());
+    request.set_method("POST");
+    request.set_body(json_body_string.to_std());
+    configure_api_request(request, 300000);
+    request.set_stream_callback([&](const char* data, size_t size) {
+      return parser.feed(data, size);
+    });
+
+    api_timestamp("START OpenAI API Stream");
+    flx_scoped_timer timer(flx_metrics::instance().timer("llm.chat_stream"));
+    if (!request.send() || request.get_status_code() != 200) {
+      timer.fail();
+      if (cancelled) {
+        std::cerr << "OpenAI stream cancelled by caller." << std::endl;
+      } else {
+        std::cerr << "HTTP Request failed: " << request.get_error_message().to_std() << std::endl;
+        std::cerr << "Response Body: " << request.get_response_body().to_std() << std::endl;
+      }
+      return nullptr;
+    }
+    api_timestamp("END OpenAI API Stream");
+
+    if (assembler.has_error()) {
+      timer.fail();
+      std::cerr << "OpenAI stream error: " << assembler.get_error().to_std_const() << std::endl;
+      return nullptr;
+    }
+    if (!assembler.is_done()) {
+      std::cerr << "Warning: OpenAI stream ended without [DONE]." << std::endl;
+    }
+
+    flx_variant data = assembler.get_message();
+    return std::make_unique<openai_message>(data);
+  }
+
   bool openai_api::embedding(const flx_string& text, flxv_vector& embedding) {
-    // Limit text length to avoid token limit (8192 tokens ≈ 6000 chars)
-    // If text too long, summarize it first
-    flx_string processed_text = text;
-    if (text.length() > 6000) {
-      std::cout << "[OpenAI] Text too long (" << text.length()
+    std::vector<std::vector<float>> embeddings;
+    if (!embedding_batch({text}, embeddings) || embeddings.empty()) {
+      return false;
+    }
+
+    embedding.clear();
+    embedding.reserve(embeddings[0].size());
+    for (float value : embeddings[0]) {
+      embedding.push_back(flx_variant(static_cast<double>(value)));
+    }
+    return true;
+  }
+
+  bool openai_api::embedding_batch(const std::vector<flx_string>& texts, std::vector<std::vector<float>>& embeddings) {
+    return embedding_batch(texts, embeddings, long_text);
+  }
+
+  bool openai_api::embedding_batch(const std::vector<flx_string>& texts, std::vector<std::vector<float>>& embeddings,
+                                   const long_text_options& options) {
+    embeddings.clear();
+    if (texts.empty()) {
+      return true;
+    }
+
+    if (options.strategy != long_text_strategy::chunk) {
+      return send_embedding_inputs(prepare_embedding_inputs(texts, options), embeddings);
+    }
+
+    // Lange Texte in überlappende Abschnitte zerlegen; alle Abschnitte gehen in
+    // dieselben Batch-Requests und werden danach pro Text gepoolt
+    std::vector<std::vector<text_chunk>> chunks(texts.size());
+    std::vector<flx_string> inputs;
+    inputs.reserve(texts.size());
+    for (size_t i = 0; i < texts.size(); ++i) {
+      chunks[i] = split_into_chunks(texts[i], options);
+      if (chunks[i].size() == 1) {
+        inputs.push_back(texts[i]);
+        continue;
+      }
+      for (const auto& chunk : chunks[i]) {
+        inputs.push_back(texts[i].substr(chunk.offset, chunk.length));
+      }
+    }
+    if (inputs.size() == texts.size()) {
+      return send_embedding_inputs(inputs, embeddings);
+    }
+
+    std::cout << "[OpenAI] Embedding " << texts.size() << " text(s) as " << inputs.size() << " chunks" << std::endl;
+    std::vector<std::vector<float>> chunk_embeddings;
+    if (!send_embedding_inputs(inputs, chunk_embeddings)) {
+      return false;
+    }
+
+    embeddings.reserve(texts.size());
+    size_t next = 0;
+    for (size_t i = 0; i < texts.size(); ++i) {
+      std::vector<std::vector<float>> parts(std::make_move_iterator(chunk_embeddings.begin() + next),
+                                            std::make_move_iterator(chunk_embeddings.begin() + next + chunks[i].size()));
+      next += chunks[i].size();
+      embeddings.push_back(pool_embeddings(parts, chunks[i], options.pooling));
+    }
+    return true;
+  }
+
+  bool openai_api::send_embedding_inputs(const std::vector<flx_string>& inputs, std::vector<std::vector<float>>& embeddings) {
+    embeddings.clear();
+    embeddings.reserve(inputs.size());
+
+    // Split into requests that stay within the per-request input and token limits
+    size_t begin = 0;
+    while (begin < inputs.size()) {
+      size_t end = begin;
+      size_t tokens = 0;
+      while (end < inputs.size() && end - begin < embedding_max_inputs_per_request) {
+        size_t input_tokens = estimate_embedding_tokens(inputs[end]);
+        if (end > begin && tokens + input_tokens > embedding_max_tokens_per_request) break;
+        tokens += input_tokens;
+        ++end;
+      }
+
+      std::vector<flx_string> chunk(inputs.begin() + begin, inputs.begin() + end);
+      std::vector<std::vector<float>> chunk_embeddings;
+      if (!send_embedding_request(chunk, chunk_embeddings)) {
+        embeddings.clear();
+        return false;
+      }
+      for (auto& e : chunk_embeddings) {
+        embeddings.push_back(std::move(e));
+      }
+      begin = end;
+    }
+
+    return true;
+  }
+
+  // Strategien summarize/truncate für Texte über chunk_tokens. Alle
+  // Zusammenfassungen eines Batches laufen parallel; bei Fehlern wird der
+  // Anfang des Textes verwendet.
+  std::vector<flx_string> openai_api::prepare_embedding_inputs(const std::vector<flx_string>& texts,
+                                                               const long_text_options& options) {
+    std::vector<flx_string> inputs = texts;
+    const size_t max_chars = options.chunk_tokens * 2;
+
+    std::vector<size_t> long_indices;
+    std::vector<std::unique_ptr<flx_http_request>> requests;
+    for (size_t i = 0; i < texts.size(); ++i) {
+      if (texts[i].length() <= max_chars) continue;
+      if (options.strategy == long_text_strategy::truncate) {
+        inputs[i] = leading_chunk(texts[i], options);
+        continue;
+      }
+      std::cout << "[OpenAI] Text too long (" << texts[i].length()
                 << " chars), summarizing first..." << std::endl;
+      long_indices.push_back(i);
+      requests.push_back(create_summary_request(texts[i]));
+    }
+    if (requests.empty()) {
+      return inputs;
+    }
+
+    std::vector<flx_http_request*> pending;
+    for (auto& r : requests) pending.push_back(r.get());
+    flx_http_multi multi(8, 8);
+    multi.execute(pending);
 
-      // Create summarization request
-      flxv_map summ_request;
-      summ_request["model"] = flx_string("gpt-4o-mini");
-      summ_request["max_tokens"] = 2000;
-      summ_request["temperature"] = 0.3;
-
-      // Messages array
-      flxv_vector messages;
-
-      // System message
-      flxv_map sys_msg;
-      sys_msg["role"] = flx_string("system");
-      sys_msg["content"] = flx_string(
-        "Du extrahierst die semantische DNA von Ausschreibungsdokumenten. "
-        "Maximale Informationsdichte: Alle wichtigen Fakten, keine Füllwörter."
-      );
-      messages.push_back(flx_variant(sys_msg));
-
-      // User message
-      flxv_map user_msg;
-      user_msg["role"] = flx_string("user");
-      user_msg["content"] = flx_string(
-        "Deine Aufgabe ist es die wichtigsten Informationen aus folgendem Wust zu extrahieren. "
-        "Maximale Informationsdichte bitte:\n\n"
-      ) + text;
-      messages.push_back(flx_variant(user_msg));
-
-      summ_request["messages"] = messages;
-
-      // Make summarization request
-      flx_json summ_json(&summ_request);
-      flx_string summ_body = summ_json.create();
-
-      flx_http_request summ_req("https://api.openai.com/v1/chat/completions");
-      summ_req.set_header("Content-Type", "application/json");
-      summ_req.set_header("Authorization", "Bearer " + api_key.to_std_const());
-      summ_req.set_method("POST");
-      summ_req.set_body(summ_body.to_std());
-
-      if (summ_req.send() && summ_req.get_status_code() == 200) {
+    for (size_t k = 0; k < long_indices.size(); ++k) {
+      size_t i = long_indices[k];
+      flx_http_request& summ_req = *requests[k];
+      flx_string summary;
+      if (summ_req.get_status_code() == 200) {
         // Parse summarization response
         flxv_map summ_response;
         flx_json summ_parser(&summ_response);
@@ -270,45 +643,99 @@ namespace flx::llm {
               if (choice.count("message") && choice["message"].is_map()) {
                 flxv_map& msg = choice["message"].to_map();
                 if (msg.count("content")) {
-                  processed_text = msg["content"].to_string();
-                  std::cout << "[OpenAI] Summarized to " << processed_text.length()
-                            << " chars" << std::endl;
+                  summary = msg["content"].to_string();
                 }
               }
             }
           }
         }
+      }
+
+      if (!summary.empty()) {
+        inputs[i] = summary;
+        std::cout << "[OpenAI] Summarized to " << summary.length() << " chars" << std::endl;
       } else {
-        std::cerr << "[OpenAI] Summarization failed, using first 6000 chars as fallback" << std::endl;
-        processed_text = text.substr(0, 6000);
+        std::cerr << "[OpenAI] Summarization failed, using first " << max_chars << " chars as fallback" << std::endl;
+        inputs[i] = leading_chunk(texts[i], options);
       }
     }
 
-    // Build embedding request body
-    flxv_map request_body;
-    request_body["model"] = flx_string("text-embedding-3-large");
-    request_body["input"] = processed_text;
+    return inputs;
+  }
 
-    // Convert to JSON
-    flx_json json_handler(&request_body);
-    flx_string json_body = json_handler.create();
+  std::unique_ptr<flx_http_request> openai_api::create_summary_request(const flx_string& text) {
+    // Create summarization request
+    flxv_map summ_request;
+    summ_request["model"] = flx_string("gpt-4o-mini");
+    summ_request["max_tokens"] = 2000;
+    summ_request["temperature"] = 0.3;
+
+    // Messages array
+    flxv_vector messages;
+
+    // System message
+    flxv_map sys_msg;
+    sys_msg["role"] = flx_string("system");
+    sys_msg["content"] = flx_string(
+      "Du extrahierst die semantische DNA von Ausschreibungsdokumenten. "
+      "Maximale Informationsdichte: Alle wichtigen Fakten, keine Füllwörter."
+    );
+    messages.push_back(flx_variant(sys_msg));
+
+    // User message
+    flxv_map user_msg;
+    user_msg["role"] = flx_string("user");
+    user_msg["content"] = flx_string(
+      "Deine Aufgabe ist es die wichtigsten Informationen aus folgendem Wust zu extrahieren. "
+      "Maximale Informationsdichte bitte:\n\n"
+    ) + text;
+    messages.push_back(flx_variant(user_msg));
+
+    summ_request["messages"] = messages;
+
+    flx_json summ_json(&summ_request);
+    flx_string summ_body = summ_json.create();
+
+    auto summ_req = std::make_unique<flx_http_request>(base_url + "/chat/completions");
+    summ_req->set_header("Content-Type", "application/json");
+    summ_req->set_header("Authorization", "Bearer " + api_key.to_std_const());
+    summ_req->set_method("POST");
+    summ_req->set_body(summ_body.to_std());
+    configure_api_request(*summ_req, 120000);
+    return summ_req;
+  }
 
-    if (json_body.empty()) {
-      std::cerr << "Error: Failed to create JSON request body for embedding." << std::endl;
-      return false;
+  bool openai_api::send_embedding_request(const std::vector<flx_string>& inputs, std::vector<std::vector<float>>& embeddings) {
+    // Build embedding request body. base64 transfers the raw float32 values:
+    // about a quarter of the JSON number text and no number parsing.
+    nlohmann::json request_body;
+    request_body["model"] = embedding_model.to_std_const();
+    request_body["encoding_format"] = "base64";
+    nlohmann::json input_array = nlohmann::json::array();
+    size_t total_chars = 0;
+    for (const auto& input : inputs) {
+      input_array.push_back(input.to_std_const());
+      total_chars += input.length();
     }
+    request_body["input"] = std::move(input_array);
 
     // Make HTTP request
-    flx_http_request request("https://api.openai.com/v1/embeddings");
+    flx_http_request request(base_url + "/embeddings");
     request.set_header("Content-Type", "application/json");
     request.set_header("Authorization", "Bearer " + api_key.to_std_const());
     request.set_method("POST");
-    request.set_body(json_body.to_std());
+    request.set_body(request_body.dump());
+    configure_api_request(request, 60000);
+    // Embeddings haben keine Nebenwirkungen, ein Timeout darf wiederholt werden
+    request.set_idempotent(true);
 
     api_timestamp("START OpenAI Embedding Request");
-    std::cout << "Requesting embedding for text (length: " << text.length() << " chars)..." << std::endl;
+    std::cout << "Requesting " << inputs.size() << " embedding(s) (total length: "
+              << total_chars << " chars)..." << std::endl;
 
+    flx_scoped_timer timer(flx_metrics::instance().timer("llm.embedding"));
     if (!request.send() || request.get_status_code() != 200) {
+      timer.fail();
       std::cerr << "HTTP Request failed: " << request.get_error_message().to_std() << std::endl;
       std::cerr << "Response Body: " << request.get_response_body().to_std() << std::endl;
       return false;
@@ -316,39 +743,54 @@ namespace flx::llm {
 
     api_timestamp("END OpenAI Embedding Request");
 
-    // Parse response
-    flx_string response_body = request.get_response_body();
-    flxv_map response_map;
-    flx_json response_handler(&response_map);
-
-    if (!response_handler.parse(response_body)) {
+    // Parse response directly into float vectors (no flx_variant per value)
+    // Response format: { "data": [{ "embedding": "<base64>" | [...], "index": 0 }], "model": "...", "usage": {...} }
+    nlohmann::json response = nlohmann::json::parse(request.get_response_body().to_std_const(), nullptr, false);
+    if (response.is_discarded()) {
+      timer.fail();
       std::cerr << "Error: Failed to parse JSON response." << std::endl;
       return false;
     }
 
-    // Extract embedding from response
-    // Response format: { "data": [{ "embedding": [...], "index": 0 }], "model": "...", "usage": {...} }
-    if (!response_map.count("data") || !response_map["data"].is_vector()) {
+    auto data_it = response.find("data");
+    if (data_it == response.end() || !data_it->is_array()) {
+      timer.fail();
       std::cerr << "Error: No 'data' array in response." << std::endl;
       return false;
     }
 
-    flxv_vector& data_array = response_map["data"].to_vector();
-    if (data_array.empty() || !data_array[0].is_map()) {
-      std::cerr << "Error: Empty or invalid data array." << std::endl;
-      return false;
+    embeddings.assign(inputs.size(), std::vector<float>());
+    size_t received = 0;
+    for (size_t position = 0; position < data_it->size(); ++position) {
+      const nlohmann::json& item = (*data_it)[position];
+      if (!item.is_object()) continue;
+
+      size_t index = item.value("index", position);
+      auto emb_it = item.find("embedding");
+      if (index >= embeddings.size() || emb_it == item.end()) continue;
+
+      std::vector<float>& target = embeddings[index];
+      if (emb_it->is_string()) {
+        if (!decode_base64_floats(emb_it->get_ref<const std::string&>(), target)) continue;
+      } else if (emb_it->is_array()) {
+        target.reserve(emb_it->size());
+        for (const auto& value : *emb_it) {
+          target.push_back(value.get<float>());
+        }
+      } else {
+        continue;
+      }
+      ++received;
     }
 
-    flxv_map& first_item = data_array[0].to_map();
-    if (!first_item.count("embedding") || !first_item["embedding"].is_vector()) {
-      std::cerr << "Error: No 'embedding' vector in data item." << std::endl;
+    if (received != inputs.size()) {
+      timer.fail();
+      std::cerr << "Error: Expected " << inputs.size() << " embeddings, got " << received << "." << std::endl;
       return false;
     }
 
-    embedding = first_item["embedding"].to_vector();
-
-    std::cout << "Successfully received embedding with " << embedding.size()
-              << " dimensions (model: text-embedding-3-large)" << std::endl;
+    std::cout << "Successfully received " << received << " embedding(s) with " << embeddings[0].size()
+              << " dimensions (model: " << embedding_model.c_str() << ")" << std::endl;
 
     return true;
   }
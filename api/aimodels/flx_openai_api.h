@@ -4,6 +4,11 @@
 
 
 #include "../../aiprocesses/chat/flx_llm_api.h"
+#include "../../aiprocesses/chat/flx_llm_context_window.h"
+#include "flx_embedding_chunker.h"
+#include <map>
+
+class flx_http_request;
 
 namespace flx::llm {
   class openai_message final : public i_llm_message {
@@ -24,29 +29,77 @@ namespace flx::llm {
 
   class openai_chat_context final : public i_llm_chat_context {
     flxv_map settings;
-    std::vector<std::unique_ptr<i_llm_message>> messages;
+    context_window window;
   public:
-    void set_settings(const flxv_map& s) override { settings = s; }
+    openai_chat_context();
+    // "max_context_tokens" (int) setzt das Token-Budget des Verlaufs
+    void set_settings(const flxv_map& s) override;
     flxv_map& get_settings() { return settings; }
-    void add_message(std::unique_ptr<i_llm_message> message) override { messages.push_back(std::move(message)); }
-    const std::vector<std::unique_ptr<i_llm_message>>& get_messages() const noexcept override { return messages; }
+    void add_message(std::unique_ptr<i_llm_message> message) override { window.add(std::move(message)); }
+    const std::vector<std::unique_ptr<i_llm_message>>& get_messages() const noexcept override { return window.get_messages(); }
+    unsigned long long get_message_id(size_t index) const override { return window.get_id(index); }
     void replace_system_message(const flx_string &new_system_message) override {
-      messages[0] = std::make_unique<openai_message>(message_role::SYSTEM, new_system_message);
+      window.replace(0, std::make_unique<openai_message>(message_role::SYSTEM, new_system_message));
     }
+    // Budget, Kürzungs-Policy und gecachte Nachrichten-JSONs
+    context_window& get_window() { return window; }
     std::unique_ptr<i_llm_chat_context> clone() const override {
       auto cloned_context = std::make_unique<openai_chat_context>();
-      cloned_context->set_settings(settings);
-      for (const auto& msg : messages) {
-        cloned_context->add_message(msg->clone());
-      }
+      cloned_context->settings = settings;
+      cloned_context->window.assign_clone(window);
       return cloned_context;
     }
   };
 
+  // Setzt die Chunks einer Chat-Completion mit "stream": true wieder zur Nachricht zusammen
+  class openai_stream_assembler {
+  public:
+    // Ein data-Payload des Streams (JSON-Chunk oder "[DONE]").
+    // Gibt false zurück, wenn on_delta abgebrochen hat.
+    bool add_chunk(const flx_string& payload, const i_llm_api::delta_callback& on_delta);
+
+    bool is_done() const noexcept { return done; }
+    bool has_error() const noexcept { return !error.empty(); }
+    const flx_string& get_error() const noexcept { return error; }
+    const flx_string& get_finish_reason() const noexcept { return finish_reason; }
+
+    // Nachricht im Format von choices[0].message (role, content, tool_calls)
+    flxv_map get_message() const;
+
+  private:
+    struct tool_call_part {
+      flx_string id;
+      flx_string type;
+      flx_string name;
+      flx_string arguments;
+    };
+
+    flx_string content;
+    bool has_content = false;
+    std::map<long long, tool_call_part> tool_calls;
+    flx_string finish_reason;
+    flx_string error;
+    bool done = false;
+  };
+
   class openai_api final : public i_llm_api {
     flx_string api_key;
+    flx_string embedding_model;
+    flx_string base_url;
+    long_text_options long_text;
   public:
-    explicit openai_api(flx_string key);
+    // base_url leer: OPENAI_BASE_URL aus der Umgebung, sonst https://api.openai.com/v1
+    explicit openai_api(flx_string key, flx_string base_url = flx_string());
+
+    // Für OpenAI-kompatible Server (lokaler Stand-in, Proxy, ...); ohne abschließendes '/'
+    void set_base_url(const flx_string& url);
+    const flx_string& get_base_url() const noexcept { return base_url; }
+
+    const flx_string& get_embedding_model() const noexcept { return embedding_model; }
+
+    // Standard für Texte über dem Eingabelimit: Abschnitte einbetten und poolen
+    void set_long_text_options(const long_text_options& options) { long_text = options; }
+    const long_text_options& get_long_text_options() const noexcept { return long_text; }
 
     std::unique_ptr<i_llm_chat_context> create_chat_context() override;
     std::unique_ptr<i_llm_message> create_message(message_role role, flx_variant content) override;
@@ -57,10 +110,32 @@ namespace flx::llm {
       const std::vector<i_llm_function*>* functions=0
       ) override;
 
+    std::unique_ptr<i_llm_message> generate_response_stream(
+      i_llm_chat_context& context,
+      const std::vector<i_llm_function*>* functions,
+      const delta_callback& on_delta
+      ) override;
+
     bool embedding(const flx_string& text, flxv_vector& embedding) override;
+    bool embedding_batch(const std::vector<flx_string>& texts, std::vector<std::vector<float>>& embeddings) override;
+    // Wie oben, aber mit eigener Strategie für lange Texte (z.B. aus Modell-Metadaten)
+    bool embedding_batch(const std::vector<flx_string>& texts, std::vector<std::vector<float>>& embeddings,
+                         const long_text_options& options);
+    // Kürzt zu lange Texte nach options.strategy (summarize/truncate), kürzere bleiben unverändert.
+    // Das Ergebnis kann ohne Optionen eingebettet werden, z.B. über einen embedding_batcher.
+    std::vector<flx_string> prepare_embedding_inputs(const std::vector<flx_string>& texts, const long_text_options& options);
 
   private:
-    flx_variant function_to_variant(const i_llm_function& func);  };
+    // Limits of /v1/embeddings per request (2048 inputs, 300k tokens), with headroom
+    static constexpr size_t embedding_max_inputs_per_request = 2048;
+    static constexpr size_t embedding_max_tokens_per_request = 250000;
+
+    flx_variant function_to_variant(const i_llm_function& func);
+    flx_string build_chat_request_body(openai_chat_context& context, const std::vector<i_llm_function*>* functions, bool stream);
+    bool send_embedding_inputs(const std::vector<flx_string>& inputs, std::vector<std::vector<float>>& embeddings);
+    std::unique_ptr<flx_http_request> create_summary_request(const flx_string& text);
+    bool send_embedding_request(const std::vector<flx_string>& inputs, std::vector<std::vector<float>>& embeddings);
+  };
 
 } // namespace flx::llm
 
@@ -0,0 +1,183 @@
+#include "flx_http_multi.h"
+#include "flx_http_transfer.h"
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <map>
+#include <memory>
+#include <thread>
+
+namespace {
+
+  using steady_clock = std::chrono::steady_clock;
+
+  // Ein Request im Event-Loop: aktueller Versuch und frühester Startzeitpunkt
+  struct multi_job {
+    flx_http_request* request = nullptr;
+    int attempt = 0;
+    steady_clock::time_point not_before;
+    std::unique_ptr<flx_http_transfer> transfer;
+  };
+
+  struct multi_handle_deleter {
+    void operator()(CURLM* m) const { if (m) curl_multi_cleanup(m); }
+  };
+
+} // namespace
+
+flx_http_multi::flx_http_multi(size_t max_concurrency, size_t max_per_host)
+    : max_concurrency_(std::max<size_t>(1, max_concurrency)),
+      max_per_host_(max_per_host) {}
+
+void flx_http_multi::set_max_concurrency(size_t max_concurrency) {
+  max_concurrency_ = std::max<size_t>(1, max_concurrency);
+}
+
+void flx_http_multi::set_max_per_host(size_t max_per_host) {
+  max_per_host_ = max_per_host;
+}
+
+size_t flx_http_multi::execute(const std::vector<flx_http_request*>& requests, completion_callback on_complete) {
+  std::unique_ptr<CURLM, multi_handle_deleter> multi(curl_multi_init());
+  size_t succeeded = 0;
+
+  auto finish = [&](flx_http_request& request, bool ok) {
+    if (ok) ++succeeded;
+    if (on_complete) on_complete(request, ok);
+  };
+
+  if (!multi) {
+    for (auto* request : requests) {
+      if (!request) continue;
+      request->error_message_ = "Failed to initialize libcurl multi handle.";
+      finish(*request, false);
+    }
+    return succeeded;
+  }
+
+  curl_multi_setopt(multi.get(), CURLMOPT_MAX_TOTAL_CONNECTIONS, static_cast<long>(max_concurrency_));
+  if (max_per_host_ > 0) {
+    curl_multi_setopt(multi.get(), CURLMOPT_MAX_HOST_CONNECTIONS, static_cast<long>(max_per_host_));
+  }
+  curl_multi_setopt(multi.get(), CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+
+  std::vector<multi_job> jobs;
+  jobs.reserve(requests.size());
+  std::deque<size_t> pending;
+  for (auto* request : requests) {
+    if (!request) continue;
+    multi_job job;
+    job.request = request;
+    pending.push_back(jobs.size());
+    jobs.push_back(std::move(job));
+  }
+
+  std::map<CURL*, size_t> active;
+
+  // Ein Versuch ist beendet (Transfer abgeschlossen oder gar nicht erst gestartet)
+  auto release = [&](multi_job& job) {
+    if (job.transfer && job.transfer->handle) {
+      curl_multi_remove_handle(multi.get(), job.transfer->handle);
+      curl_easy_cleanup(job.transfer->handle);
+    }
+    job.transfer.reset();
+  };
+
+  auto settle = [&](size_t index, bool ok, bool retryable) {
+    multi_job& job = jobs[index];
+    flx_http_request& request = *job.request;
+    if (!ok && retryable && job.attempt < request.max_retries_) {
+      job.not_before = steady_clock::now() + std::chrono::milliseconds(request.retry_delay_ms(job.attempt));
+      ++job.attempt;
+      pending.push_back(index);
+      return;
+    }
+    finish(request, ok);
+  };
+
+  while (!pending.empty() || !active.empty()) {
+    // 1. Neue Transfers starten, soweit Kapazität frei und Backoff abgelaufen
+    auto now = steady_clock::now();
+    size_t to_check = pending.size();
+    while (to_check-- > 0 && active.size() < max_concurrency_) {
+      size_t index = pending.front();
+      pending.pop_front();
+      multi_job& job = jobs[index];
+      if (job.not_before > now) {
+        pending.push_back(index);
+        continue;
+      }
+
+      job.request->attempts_ = job.attempt + 1;
+      job.transfer = std::make_unique<flx_http_transfer>();
+      job.transfer->handle = curl_easy_init();
+      // Der Multi-Handle hat einen eigenen Verbindungspool
+      job.transfer->attach_share = false;
+
+      if (!job.request->prepare_transfer(*job.transfer, nullptr)) {
+        release(job);
+        settle(index, false, false);
+        continue;
+      }
+      if (curl_multi_add_handle(multi.get(), job.transfer->handle) != CURLM_OK) {
+        job.request->error_message_ = "Failed to add handle to libcurl multi.";
+        release(job);
+        settle(index, false, false);
+        continue;
+      }
+      active[job.transfer->handle] = index;
+    }
+
+    if (active.empty()) {
+      if (pending.empty()) break;
+      // Nur noch Requests im Backoff: bis zum frühesten Startzeitpunkt warten
+      auto earliest = jobs[pending.front()].not_before;
+      for (size_t index : pending) {
+        earliest = std::min(earliest, jobs[index].not_before);
+      }
+      std::this_thread::sleep_until(earliest);
+      continue;
+    }
+
+    // 2. Transfers vorantreiben
+    int running = 0;
+    curl_multi_perform(multi.get(), &running);
+
+    // 3. Abgeschlossene Transfers auswerten
+    int remaining = 0;
+    while (CURLMsg* msg = curl_multi_info_read(multi.get(), &remaining)) {
+      if (msg->msg != CURLMSG_DONE) continue;
+      auto it = active.find(msg->easy_handle);
+      if (it == active.end()) continue;
+
+      size_t index = it->second;
+      active.erase(it);
+      multi_job& job = jobs[index];
+      bool retryable = false;
+      bool ok = job.request->complete_transfer(*job.transfer, msg->data.result, nullptr, retryable);
+      release(job);
+      settle(index, ok, retryable);
+    }
+
+    // 4. Auf Socket-Aktivität warten (kurz, damit Backoff-Jobs starten können)
+    if (!active.empty()) {
+#if LIBCURL_VERSION_NUM >= 0x074200 // 7.66.0
+      curl_multi_poll(multi.get(), nullptr, 0, 50, nullptr);
+#else
+      curl_multi_wait(multi.get(), nullptr, 0, 50, nullptr);
+#endif
+    }
+  }
+
+  return succeeded;
+}
+
+std::future<size_t> flx_http_multi::execute_async(std::vector<flx_http_request*> requests, completion_callback on_complete) {
+  size_t max_concurrency = max_concurrency_;
+  size_t max_per_host = max_per_host_;
+  return std::async(std::launch::async, [max_concurrency, max_per_host, requests = std::move(requests),
+                                         on_complete = std::move(on_complete)]() {
+    flx_http_multi worker(max_concurrency, max_per_host);
+    return worker.execute(requests, on_complete);
+  });
+}
@@ -0,0 +1,55 @@
+#ifndef FLX_HTTP_MULTI_H
+#define FLX_HTTP_MULTI_H
+
+#include "flx_http_request.h"
+#include <functional>
+#include <future>
+#include <vector>
+
+/**
+ * @brief Führt viele flx_http_request gleichzeitig aus (libcurl multi interface).
+ *
+ * Alle Transfers laufen in einem Event-Loop auf dem aufrufenden Thread, teilen
+ * sich einen Verbindungspool und nutzen HTTP/2-Multiplexing, wenn verfügbar.
+ * Timeouts, Retry-Einstellungen und Header werden pro Request übernommen.
+ *
+ * Beispiel:
+ * @code
+ *   std::vector<flx_http_request*> batch = ...;
+ *   flx_http_multi multi(16, 8);
+ *   multi.execute(batch, [](flx_http_request& r, bool ok) { ... });
+ * @endcode
+ */
+class flx_http_multi {
+public:
+  using completion_callback = std::function<void(flx_http_request& request, bool success)>;
+
+  /**
+   * @param max_concurrency Maximal gleichzeitig laufende Transfers.
+   * @param max_per_host Maximale Verbindungen pro Host (weitere warten in libcurl).
+   */
+  explicit flx_http_multi(size_t max_concurrency = 16, size_t max_per_host = 8);
+
+  void set_max_concurrency(size_t max_concurrency);
+  void set_max_per_host(size_t max_per_host);
+
+  /**
+   * @brief Führt alle Requests aus und blockiert bis alle fertig sind.
+   * @param requests Nicht besitzende Zeiger; müssen bis zum Ende leben.
+   * @param on_complete Wird pro Request (in Abschlussreihenfolge) auf diesem Thread aufgerufen.
+   * @return Anzahl erfolgreicher Requests (Statuscode 2xx).
+   */
+  size_t execute(const std::vector<flx_http_request*>& requests, completion_callback on_complete = nullptr);
+
+  /**
+   * @brief Wie execute(), aber auf einem eigenen Thread.
+   * Der Callback wird dann auf diesem Thread aufgerufen.
+   */
+  std::future<size_t> execute_async(std::vector<flx_http_request*> requests, completion_callback on_complete = nullptr);
+
+private:
+  size_t max_concurrency_;
+  size_t max_per_host_;
+};
+
+#endif // FLX_HTTP_MULTI_H
@@ -1,8 +1,12 @@
 #include "flx_http_request.h"
+#include "flx_http_transfer.h"
 #include <curl/curl.h>
 #include <string>
 #include <vector>
 #include <iostream>
+#include <mutex>
+#include <thread>
+#include <chrono>
 #include <memory> // F�r std::unique_ptr
 
 // Anonymer Namespace f�r interne Hilfsfunktionen und Callbacks
@@ -80,15 +84,140 @@ namespace {
     return fwrite(contents, size, nmemb, file);
   }
 
+  // Prozessweiter Share-Handle: DNS-Cache, TLS-Sessions und Verbindungspool
+  // werden zwischen allen Threads geteilt. Wird absichtlich nie freigegeben,
+  // damit Thread-lokale Handles beim Programmende keine Reihenfolgeprobleme haben.
+  class curl_shared_state {
+  public:
+    static curl_shared_state& instance() {
+      static curl_shared_state* state = new curl_shared_state();
+      return *state;
+    }
+
+    CURLSH* share() const { return share_; }
+    bool http2_supported() const { return http2_supported_; }
+
+  private:
+    CURLSH* share_ = nullptr;
+    bool http2_supported_ = false;
+    std::mutex locks_[CURL_LOCK_DATA_LAST];
+
+    curl_shared_state() {
+      curl_global_init(CURL_GLOBAL_DEFAULT);
+
+      curl_version_info_data* info = curl_version_info(CURLVERSION_NOW);
+      http2_supported_ = info && (info->features & CURL_VERSION_HTTP2);
+
+      share_ = curl_share_init();
+      if (share_) {
+        curl_share_setopt(share_, CURLSHOPT_LOCKFUNC, lock_callback);
+        curl_share_setopt(share_, CURLSHOPT_UNLOCKFUNC, unlock_callback);
+        curl_share_setopt(share_, CURLSHOPT_USERDATA, this);
+        curl_share_setopt(share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+        curl_share_setopt(share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+#if LIBCURL_VERSION_NUM >= 0x073900 // 7.57.0
+        curl_share_setopt(share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+#endif
+      }
+    }
+
+    static void lock_callback(CURL*, curl_lock_data data, curl_lock_access, void* userptr) {
+      static_cast<curl_shared_state*>(userptr)->locks_[data].lock();
+    }
+
+    static void unlock_callback(CURL*, curl_lock_data data, void* userptr) {
+      static_cast<curl_shared_state*>(userptr)->locks_[data].unlock();
+    }
+  };
+
+  // Ein CURL-Handle pro Thread. curl_easy_reset() behält offene Verbindungen,
+  // DNS- und Session-Cache, daher entfällt der Handshake bei Folgeanfragen.
+  struct thread_handle_cache {
+    CURL* handle = nullptr;
+    bool in_use = false;
+    ~thread_handle_cache() { if (handle) curl_easy_cleanup(handle); }
+  };
+
+  thread_local thread_handle_cache t_handle_cache;
+
+  // Leiht das Thread-Handle aus; bei verschachtelten Aufrufen (z.B. aus einem
+  // Callback heraus) oder ohne Wiederverwendung wird ein eigenes Handle erzeugt.
+  class curl_handle_lease {
+  public:
+    explicit curl_handle_lease(bool reuse) {
+      if (reuse && !t_handle_cache.in_use) {
+        if (!t_handle_cache.handle) {
+          t_handle_cache.handle = curl_easy_init();
+        } else {
+          curl_easy_reset(t_handle_cache.handle);
+        }
+        handle_ = t_handle_cache.handle;
+        cached_ = handle_ != nullptr;
+        if (cached_) t_handle_cache.in_use = true;
+      } else {
+        handle_ = curl_easy_init();
+      }
+    }
+
+    ~curl_handle_lease() {
+      if (cached_) {
+        t_handle_cache.in_use = false;
+      } else if (handle_) {
+        curl_easy_cleanup(handle_);
+      }
+    }
+
+    curl_handle_lease(const curl_handle_lease&) = delete;
+    curl_handle_lease& operator=(const curl_handle_lease&) = delete;
+
+    CURL* get() const { return handle_; }
+
+  private:
+    CURL* handle_ = nullptr;
+    bool cached_ = false;
+  };
+
+  bool is_transient_curl_error(CURLcode res) {
+    switch (res) {
+      case CURLE_COULDNT_RESOLVE_HOST:
+      case CURLE_COULDNT_CONNECT:
+      case CURLE_OPERATION_TIMEDOUT:
+      case CURLE_SEND_ERROR:
+      case CURLE_RECV_ERROR:
+      case CURLE_GOT_NOTHING:
+      case CURLE_PARTIAL_FILE:
+      case CURLE_HTTP2:
+      case CURLE_HTTP2_STREAM:
+        return true;
+      default:
+        return false;
+    }
+  }
+
+  bool is_transient_http_status(long code) {
+    return code == 408 || code == 429 || code == 500 || code == 502 || code == 503 || code == 504;
+  }
+
+  // Der Server hat die Anfrage abgelehnt, ohne sie auszuführen
+  bool is_unprocessed_http_status(long code) {
+    return code == 408 || code == 429 || code == 503;
+  }
+
 } // Ende anonymer Namespace
 
 // --- Implementierung der Klassenmethoden ---
 
 flx_http_request::flx_http_request()
-    : url_(), method_("GET"), status_code_(0) {}
+    : url_(), method_("GET"), status_code_(0),
+      connect_timeout_ms_(10000), timeout_ms_(0), max_retries_(0), retry_backoff_ms_(500), idempotent_(-1),
+      reuse_connection_(true), http2_(true), verify_peer_(true), attempts_(0),
+      stream_started_(false), stream_aborted_(false) {}
 
 flx_http_request::flx_http_request(const flx_string& url)
-    : url_(url), method_("GET"), status_code_(0) {}
+    : url_(url), method_("GET"), status_code_(0),
+      connect_timeout_ms_(10000), timeout_ms_(0), max_retries_(0), retry_backoff_ms_(500), idempotent_(-1),
+      reuse_connection_(true), http2_(true), verify_peer_(true), attempts_(0),
+      stream_started_(false), stream_aborted_(false) {}
 
 // Setter und Getter bleiben unver�ndert
 void flx_http_request::set_url(const flx_string& url) { url_ = url; }
@@ -112,101 +241,200 @@ const flxv_map& flx_http_request::get_params() const { return params_; }
 void flx_http_request::set_body(const flx_string& body) { body_ = body; }
 flx_string flx_http_request::get_body() const { return body_; }
 
-// Die zentrale 'send'-Methode, neu implementiert mit libcurl
+void flx_http_request::set_connect_timeout_ms(long ms) { connect_timeout_ms_ = ms; }
+void flx_http_request::set_timeout_ms(long ms) { timeout_ms_ = ms; }
+void flx_http_request::set_retry(int max_retries, long backoff_ms) {
+  max_retries_ = max_retries < 0 ? 0 : max_retries;
+  retry_backoff_ms_ = backoff_ms;
+}
+void flx_http_request::set_idempotent(bool idempotent) { idempotent_ = idempotent ? 1 : 0; }
+void flx_http_request::set_reuse_connection(bool reuse) { reuse_connection_ = reuse; }
+void flx_http_request::set_http2(bool enabled) { http2_ = enabled; }
+void flx_http_request::set_verify_peer(bool verify) { verify_peer_ = verify; }
+int flx_http_request::get_attempts() const { return attempts_; }
+
+void flx_http_request::set_stream_callback(stream_callback callback) { stream_callback_ = std::move(callback); }
+
+// Schreib-Callback im Streaming-Modus: 2xx-Daten gehen direkt an den Callback
+size_t flx_http_request::stream_write_callback(void* contents, size_t size, size_t nmemb, void* userp) {
+  size_t real_size = size * nmemb;
+  flx_http_transfer* transfer = static_cast<flx_http_transfer*>(userp);
+  flx_http_request* self = transfer->request;
+
+  long http_code = 0;
+  curl_easy_getinfo(transfer->handle, CURLINFO_RESPONSE_CODE, &http_code);
+  if (http_code < 200 || http_code >= 300) {
+    self->response_body_.append(static_cast<char*>(contents), real_size);
+    return real_size;
+  }
+
+  self->stream_started_ = true;
+  if (!self->stream_callback_(static_cast<const char*>(contents), real_size)) {
+    self->stream_aborted_ = true;
+    return 0; // libcurl bricht mit CURLE_WRITE_ERROR ab
+  }
+  return real_size;
+}
+
+// Die zentrale 'send'-Methode: ein Versuch pro perform(), Wiederholung mit Backoff
 bool flx_http_request::send() {
+  attempts_ = 0;
+  for (int attempt = 0; ; ++attempt) {
+    bool retryable = false;
+    attempts_ = attempt + 1;
+    bool ok = perform(nullptr, retryable);
+    if (ok || !retryable || attempt >= max_retries_) {
+      return ok;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(retry_delay_ms(attempt)));
+  }
+}
+
+bool flx_http_request::is_idempotent() const {
+  if (idempotent_ >= 0) {
+    return idempotent_ == 1;
+  }
+  return method_ == "GET" || method_ == "HEAD" || method_ == "PUT" || method_ == "DELETE" || method_ == "OPTIONS";
+}
+
+long flx_http_request::retry_delay_ms(int attempt) const {
+  // Retry-After (Sekunden) vom Server hat Vorrang
+  for (const char* key : {"Retry-After", "retry-after"}) {
+    auto it = response_headers_.find(key);
+    if (it != response_headers_.end() && it->second.is_string()) {
+      long seconds = it->second.string_value().trim().to_int(-1);
+      if (seconds >= 0) {
+        return std::min(seconds * 1000L, 60000L);
+      }
+    }
+  }
+  long delay = retry_backoff_ms_ << std::min(attempt, 6);
+  return std::min(delay, 30000L);
+}
+
+bool flx_http_request::perform(FILE* output_file, bool& retryable) {
+  retryable = false;
+
+  curl_handle_lease curl(reuse_connection_);
+  flx_http_transfer transfer;
+  transfer.handle = curl.get();
+  transfer.attach_share = reuse_connection_;
+
+  if (!prepare_transfer(transfer, output_file)) {
+    return false;
+  }
+
+         // Anfrage senden
+  CURLcode res = curl_easy_perform(curl.get());
+  return complete_transfer(transfer, res, output_file, retryable);
+}
+
+bool flx_http_request::prepare_transfer(flx_http_transfer& transfer, FILE* output_file) {
   // 1. Reset der Antwortdaten
   status_code_ = 0;
   response_body_.clear();
   response_headers_.clear();
   error_message_.clear();
+  stream_started_ = false;
+  stream_aborted_ = false;
+  transfer.request = this;
 
   if (url_.empty()) {
     error_message_ = "URL is empty.";
     return false;
   }
 
-         // RAII-Wrapper f�r CURL und curl_slist, um die Freigabe zu garantieren
-  auto curl_deleter = [](CURL* c) { if (c) curl_easy_cleanup(c); };
-  auto slist_deleter = [](struct curl_slist* s) { if (s) curl_slist_free_all(s); };
-
-  std::unique_ptr<CURL, decltype(curl_deleter)> curl(curl_easy_init(), curl_deleter);
+  CURL* curl = transfer.handle;
   if (!curl) {
     error_message_ = "Failed to initialize libcurl.";
     return false;
   }
 
-  std::unique_ptr<struct curl_slist, decltype(slist_deleter)> header_list(nullptr, slist_deleter);
-  char errbuf[CURL_ERROR_SIZE] = {0};
-
   try {
     // 2. URL und Parameter zusammenbauen
     flx_string final_url = url_;
     flx_string method_upper = method_.upper();
     if (method_upper == "GET" && !params_.empty()) {
-      flx_string query_string = encode_params(curl.get(), params_);
+      flx_string query_string = encode_params(curl, params_);
       if (!query_string.empty()) {
         final_url += flx_string(final_url.find("?") == flx_string::npos ? "?" : "&") + query_string;
       }
     }
 
     // 3. libcurl-Optionen setzen
-    curl_easy_setopt(curl.get(), CURLOPT_URL, final_url.c_str());
-    curl_easy_setopt(curl.get(), CURLOPT_ERRORBUFFER, errbuf);
-
-    // Automatisch Redirects folgen (�blich und n�tzlich)
-    curl_easy_setopt(curl.get(), CURLOPT_FOLLOWLOCATION, 1L);
+    curl_easy_setopt(curl, CURLOPT_URL, final_url.c_str());
+    curl_easy_setopt(curl, CURLOPT_ERRORBUFFER, transfer.errbuf);
+    curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(curl, CURLOPT_PRIVATE, this);
+
+    // Automatisch Redirects folgen (üblich und nützlich)
+    curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
+
+           // Verbindung: Timeouts, Keep-Alive, HTTP/2
+    curl_shared_state& shared = curl_shared_state::instance();
+    if (transfer.attach_share && shared.share()) {
+      curl_easy_setopt(curl, CURLOPT_SHARE, shared.share());
+    }
+    if (connect_timeout_ms_ > 0) {
+      curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT_MS, connect_timeout_ms_);
+    }
+    if (timeout_ms_ > 0) {
+      curl_easy_setopt(curl, CURLOPT_TIMEOUT_MS, timeout_ms_);
+    }
+    curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
+    if (!reuse_connection_) {
+      curl_easy_setopt(curl, CURLOPT_FRESH_CONNECT, 1L);
+      curl_easy_setopt(curl, CURLOPT_FORBID_REUSE, 1L);
+    }
+    if (http2_ && shared.http2_supported()) {
+      curl_easy_setopt(curl, CURLOPT_HTTP_VERSION, (long)CURL_HTTP_VERSION_2TLS);
+      curl_easy_setopt(curl, CURLOPT_PIPEWAIT, 1L);
+    }
+    if (!verify_peer_) {
+      curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 0L);
+      curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, 0L);
+    }
 
-           // Callbacks f�r Response Body und Header setzen
-    curl_easy_setopt(curl.get(), CURLOPT_WRITEFUNCTION, write_callback);
-    curl_easy_setopt(curl.get(), CURLOPT_WRITEDATA, &response_body_);
-    curl_easy_setopt(curl.get(), CURLOPT_HEADERFUNCTION, header_callback);
-    curl_easy_setopt(curl.get(), CURLOPT_HEADERDATA, &response_headers_);
+           // Callbacks für Response Body und Header setzen
+    if (output_file) {
+      curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, file_write_callback);
+      curl_easy_setopt(curl, CURLOPT_WRITEDATA, output_file);
+    } else if (stream_callback_) {
+      curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, &flx_http_request::stream_write_callback);
+      curl_easy_setopt(curl, CURLOPT_WRITEDATA, &transfer);
+    } else {
+      curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_callback);
+      curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response_body_);
+    }
+    curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, header_callback);
+    curl_easy_setopt(curl, CURLOPT_HEADERDATA, &response_headers_);
 
-           // 4. Request-Header setzen
+           // 4. Request-Header setzen (Liste lebt bis zum Ende des Transfers)
     for (const auto& pair : headers_) {
       if (pair.second.is_string()) {
         flx_string header_string = pair.first + ": " + pair.second.string_value();
-        header_list.reset(curl_slist_append(header_list.release(), header_string.c_str()));
+        transfer.header_list = curl_slist_append(transfer.header_list, header_string.c_str());
       }
     }
-    if (header_list) {
-      curl_easy_setopt(curl.get(), CURLOPT_HTTPHEADER, header_list.get());
+    if (transfer.header_list) {
+      curl_easy_setopt(curl, CURLOPT_HTTPHEADER, transfer.header_list);
     }
 
            // 5. HTTP-Methode und Body setzen
     if (method_upper == "POST") {
-      curl_easy_setopt(curl.get(), CURLOPT_POST, 1L);
-      curl_easy_setopt(curl.get(), CURLOPT_POSTFIELDS, body_.c_str());
-      curl_easy_setopt(curl.get(), CURLOPT_POSTFIELDSIZE, body_.length());
+      curl_easy_setopt(curl, CURLOPT_POST, 1L);
+      curl_easy_setopt(curl, CURLOPT_POSTFIELDS, body_.c_str());
+      curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, body_.length());
     } else if (method_upper == "PUT") {
-      curl_easy_setopt(curl.get(), CURLOPT_CUSTOMREQUEST, "PUT");
-      curl_easy_setopt(curl.get(), CURLOPT_POSTFIELDS, body_.c_str());
-      curl_easy_setopt(curl.get(), CURLOPT_POSTFIELDSIZE, body_.length());
+      curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, "PUT");
+      curl_easy_setopt(curl, CURLOPT_POSTFIELDS, body_.c_str());
+      curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, body_.length());
     } else if (method_upper == "DELETE") {
-      curl_easy_setopt(curl.get(), CURLOPT_CUSTOMREQUEST, "DELETE");
-    } else if (method_upper != "GET") { // F�r andere Methoden
-      curl_easy_setopt(curl.get(), CURLOPT_CUSTOMREQUEST, method_upper.c_str());
+      curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, "DELETE");
+    } else if (method_upper != "GET") { // Für andere Methoden
+      curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, method_upper.c_str());
     }
-
-           // 6. Anfrage senden
-    CURLcode res = curl_easy_perform(curl.get());
-
-           // 7. Ergebnis auswerten
-    if (res != CURLE_OK) {
-      error_message_ = flx_string("libcurl error: ") + curl_easy_strerror(res) + " - " + errbuf;
-      return false;
-    }
-
-    long http_code = 0;
-    curl_easy_getinfo(curl.get(), CURLINFO_RESPONSE_CODE, &http_code);
-    status_code_ = static_cast<int>(http_code);
-
-    if (http_code > 300)
-    {
-      error_message_ = flx_string("HTTP error: ") + std::to_string(status_code_) + " - " + response_body_;
-    }
-
-    return status_code_ >= 200 && status_code_ < 300;
+    return true;
 
   } catch (const std::exception& e) {
     error_message_ = flx_string("Standard Exception: ") + e.what();
@@ -217,6 +445,44 @@ bool flx_http_request::send() {
   }
 }
 
+bool flx_http_request::complete_transfer(flx_http_transfer& transfer, int curl_result, FILE* output_file, bool& retryable) {
+  retryable = false;
+
+         // Ergebnis auswerten
+  CURLcode res = static_cast<CURLcode>(curl_result);
+  if (res != CURLE_OK) {
+    if (stream_aborted_) {
+      error_message_ = "Stream aborted by callback.";
+      return false;
+    }
+    error_message_ = flx_string("libcurl error: ") + curl_easy_strerror(res) + " - " + transfer.errbuf;
+    // Bereits gelieferte Stream-Daten lassen sich nicht zurücknehmen
+    retryable = !stream_started_ && is_transient_curl_error(res);
+    if (retryable && !is_idempotent()) {
+      // Nach einem Timeout kann der Server die Anfrage schon ausführen; nur wiederholen, was nie gesendet wurde
+      long request_size = 0;
+      curl_easy_getinfo(transfer.handle, CURLINFO_REQUEST_SIZE, &request_size);
+      retryable = request_size == 0;
+    }
+    return false;
+  }
+
+  long http_code = 0;
+  curl_easy_getinfo(transfer.handle, CURLINFO_RESPONSE_CODE, &http_code);
+  status_code_ = static_cast<int>(http_code);
+
+  if (http_code > 300)
+  {
+    error_message_ = flx_string("HTTP error: ") + std::to_string(status_code_);
+    if (!output_file) {
+      error_message_ += flx_string(" - ") + response_body_;
+    }
+    retryable = is_transient_http_status(http_code) && (is_idempotent() || is_unprocessed_http_status(http_code));
+  }
+
+  return status_code_ >= 200 && status_code_ < 300;
+}
+
 // Antwort-Getter bleiben unver�ndert
 int flx_http_request::get_status_code() const { return status_code_; }
 flx_string flx_http_request::get_response_body() const { return response_body_; }
@@ -224,7 +490,7 @@ const flxv_map& flx_http_request::get_response_headers() const { return response
 flx_string flx_http_request::get_error_message() const { return error_message_; }
 
 bool flx_http_request::download_to_file(const flx_string& output_path) {
-  // 1. Reset der Antwortdaten
+  attempts_ = 1;
   status_code_ = 0;
   response_body_.clear();
   response_headers_.clear();
@@ -240,106 +506,16 @@ bool flx_http_request::download_to_file(const flx_string& output_path) {
     return false;
   }
 
-  // 2. Datei zum Schreiben öffnen
+  // Datei zum Schreiben öffnen
   FILE* file = fopen(output_path.c_str(), "wb");
   if (!file) {
     error_message_ = flx_string("Failed to open output file: ") + output_path;
     return false;
   }
 
-  // RAII-Wrapper für CURL und curl_slist
-  auto curl_deleter = [](CURL* c) { if (c) curl_easy_cleanup(c); };
-  auto slist_deleter = [](struct curl_slist* s) { if (s) curl_slist_free_all(s); };
-
-  std::unique_ptr<CURL, decltype(curl_deleter)> curl(curl_easy_init(), curl_deleter);
-  if (!curl) {
-    error_message_ = "Failed to initialize libcurl.";
-    fclose(file);
-    return false;
-  }
-
-  std::unique_ptr<struct curl_slist, decltype(slist_deleter)> header_list(nullptr, slist_deleter);
-  char errbuf[CURL_ERROR_SIZE] = {0};
-
-  try {
-    // 3. URL und Parameter zusammenbauen
-    flx_string final_url = url_;
-    flx_string method_upper = method_.upper();
-    if (method_upper == "GET" && !params_.empty()) {
-      flx_string query_string = encode_params(curl.get(), params_);
-      if (!query_string.empty()) {
-        final_url += flx_string(final_url.find("?") == flx_string::npos ? "?" : "&") + query_string;
-      }
-    }
-
-    // 4. libcurl-Optionen setzen
-    curl_easy_setopt(curl.get(), CURLOPT_URL, final_url.c_str());
-    curl_easy_setopt(curl.get(), CURLOPT_ERRORBUFFER, errbuf);
-    curl_easy_setopt(curl.get(), CURLOPT_FOLLOWLOCATION, 1L);
-
-    // Callbacks für direktes Datei-Schreiben
-    curl_easy_setopt(curl.get(), CURLOPT_WRITEFUNCTION, file_write_callback);
-    curl_easy_setopt(curl.get(), CURLOPT_WRITEDATA, file);
-
-    // Response Header tracking
-    curl_easy_setopt(curl.get(), CURLOPT_HEADERFUNCTION, header_callback);
-    curl_easy_setopt(curl.get(), CURLOPT_HEADERDATA, &response_headers_);
-
-    // 5. Request-Header setzen
-    for (const auto& pair : headers_) {
-      if (pair.second.is_string()) {
-        flx_string header_string = pair.first + ": " + pair.second.string_value();
-        header_list.reset(curl_slist_append(header_list.release(), header_string.c_str()));
-      }
-    }
-    if (header_list) {
-      curl_easy_setopt(curl.get(), CURLOPT_HTTPHEADER, header_list.get());
-    }
-
-    // 6. HTTP-Methode und Body setzen
-    if (method_upper == "POST") {
-      curl_easy_setopt(curl.get(), CURLOPT_POST, 1L);
-      curl_easy_setopt(curl.get(), CURLOPT_POSTFIELDS, body_.c_str());
-      curl_easy_setopt(curl.get(), CURLOPT_POSTFIELDSIZE, body_.length());
-    } else if (method_upper == "PUT") {
-      curl_easy_setopt(curl.get(), CURLOPT_CUSTOMREQUEST, "PUT");
-      curl_easy_setopt(curl.get(), CURLOPT_POSTFIELDS, body_.c_str());
-      curl_easy_setopt(curl.get(), CURLOPT_POSTFIELDSIZE, body_.length());
-    } else if (method_upper == "DELETE") {
-      curl_easy_setopt(curl.get(), CURLOPT_CUSTOMREQUEST, "DELETE");
-    } else if (method_upper != "GET") {
-      curl_easy_setopt(curl.get(), CURLOPT_CUSTOMREQUEST, method_upper.c_str());
-    }
-
-    // 7. Anfrage senden
-    CURLcode res = curl_easy_perform(curl.get());
-
-    // 8. Datei schließen
-    fclose(file);
-
-    // 9. Ergebnis auswerten
-    if (res != CURLE_OK) {
-      error_message_ = flx_string("libcurl error: ") + curl_easy_strerror(res) + " - " + errbuf;
-      return false;
-    }
-
-    long http_code = 0;
-    curl_easy_getinfo(curl.get(), CURLINFO_RESPONSE_CODE, &http_code);
-    status_code_ = static_cast<int>(http_code);
-
-    if (http_code > 300) {
-      error_message_ = flx_string("HTTP error: ") + std::to_string(status_code_);
-    }
-
-    return status_code_ >= 200 && status_code_ < 300;
-
-  } catch (const std::exception& e) {
-    fclose(file);
-    error_message_ = flx_string("Standard Exception: ") + e.what();
-    return false;
-  } catch (...) {
-    fclose(file);
-    error_message_ = "An unknown error occurred during file download.";
-    return false;
-  }
+  // Kein automatischer Retry: die Datei wäre bereits teilweise geschrieben
+  bool retryable = false;
+  bool ok = perform(file, retryable);
+  fclose(file);
+  return ok;
 }
@@ -1,8 +1,13 @@
 #ifndef FLX_HTTP_REQUEST_H
 #define FLX_HTTP_REQUEST_H
 
+#include <cstdio>
+#include <functional>
+
 #include "../../utils/flx_variant.h" // Enth�lt flx_string und flx_variant_map Definitionen
 
+struct flx_http_transfer;
+
 // Vorw�rtsdeklarationen sind nicht notwendig, da die HTTPRequest-Bibliothek
 // nur in der .cpp-Datei verwendet wird.
 
@@ -135,6 +140,78 @@ public:
    */
   flx_string get_error_message() const;
 
+  /**
+   * @brief Setzt das Timeout für den Verbindungsaufbau (TCP + TLS).
+   * @param ms Timeout in Millisekunden, 0 = libcurl-Standard.
+   */
+  void set_connect_timeout_ms(long ms);
+
+  /**
+   * @brief Setzt das Gesamt-Timeout für einen Versuch (inkl. Übertragung).
+   * @param ms Timeout in Millisekunden, 0 = kein Timeout.
+   */
+  void set_timeout_ms(long ms);
+
+  /**
+   * @brief Aktiviert automatische Wiederholungen bei transienten Fehlern
+   * (Verbindungsfehler, Timeouts, HTTP 408/429/500/502/503/504).
+   * Nicht idempotente Anfragen (siehe set_idempotent) werden nur wiederholt,
+   * wenn der Server sie nicht verarbeitet hat.
+   * @param max_retries Anzahl zusätzlicher Versuche, 0 = keine Wiederholung.
+   * @param backoff_ms Basis-Wartezeit, verdoppelt sich pro Versuch (Retry-After hat Vorrang).
+   */
+  void set_retry(int max_retries, long backoff_ms = 500);
+
+  /**
+   * @brief Markiert die Anfrage als gefahrlos wiederholbar.
+   * Standard nach Methode: GET, HEAD, PUT, DELETE und OPTIONS sind idempotent,
+   * POST und PATCH nicht. Diese werden nach einem Timeout, einer abgebrochenen
+   * Antwort oder HTTP 500/502/504 nicht wiederholt, weil der Server sie schon
+   * ausgeführt haben kann - nur wenn nichts gesendet wurde (Verbindungsfehler)
+   * oder der Server sie abgelehnt hat (HTTP 408/429/503).
+   */
+  void set_idempotent(bool idempotent);
+
+  /**
+   * @brief Steuert die Wiederverwendung von Verbindungen.
+   * Standardmäßig nutzt jeder Thread ein gecachtes CURL-Handle und alle Threads
+   * teilen DNS-Cache, TLS-Sessions und den Verbindungspool (Keep-Alive).
+   * @param reuse false erzwingt eine frische Verbindung pro Anfrage.
+   */
+  void set_reuse_connection(bool reuse);
+
+  /**
+   * @brief Aktiviert HTTP/2 über TLS (ALPN), fällt automatisch auf HTTP/1.1 zurück.
+   * @param enabled Standard: true.
+   */
+  void set_http2(bool enabled);
+
+  /**
+   * @brief Steuert die Prüfung des Server-Zertifikats (nur für lokale Tests abschalten).
+   * @param verify Standard: true.
+   */
+  void set_verify_peer(bool verify);
+
+  /**
+   * @brief Gibt die Anzahl der Versuche der letzten Anfrage zurück (1 = ohne Wiederholung).
+   */
+  int get_attempts() const;
+
+  /**
+   * @brief Callback für Streaming-Antworten: erhält jeden empfangenen Block sofort.
+   * Rückgabe false bricht die Übertragung ab.
+   */
+  using stream_callback = std::function<bool(const char* data, size_t size)>;
+
+  /**
+   * @brief Liefert den Body erfolgreicher Antworten (2xx) blockweise an den Callback,
+   * statt ihn in get_response_body() zu sammeln (z.B. Server-Sent Events).
+   * Fehlerantworten landen weiterhin in get_response_body(). Sobald Daten geliefert
+   * wurden, wird nicht mehr wiederholt.
+   * @param callback nullptr deaktiviert das Streaming.
+   */
+  void set_stream_callback(stream_callback callback);
+
 private:
   flx_string url_;
   flx_string method_; // z.B. "GET", "POST", "PUT", "DELETE"
@@ -148,6 +225,33 @@ private:
   flxv_map response_headers_;
   flx_string error_message_;
 
+         // Verbindungs-Optionen
+  long connect_timeout_ms_;
+  long timeout_ms_;
+  int max_retries_;
+  long retry_backoff_ms_;
+  int idempotent_; // -1 = nach Methode, sonst set_idempotent()
+  bool reuse_connection_;
+  bool http2_;
+  bool verify_peer_;
+  int attempts_;
+
+         // Streaming (set_stream_callback)
+  stream_callback stream_callback_;
+  bool stream_started_;
+  bool stream_aborted_;
+  static size_t stream_write_callback(void* contents, size_t size, size_t nmemb, void* userp);
+
+         // Führt genau einen Versuch aus; output_file == nullptr schreibt in response_body_
+  bool perform(FILE* output_file, bool& retryable);
+  long retry_delay_ms(int attempt) const;
+  bool is_idempotent() const;
+
+         // Aufgeteilter Versuch für flx_http_multi (libcurl-Zustand in flx_http_transfer.h)
+  friend class flx_http_multi;
+  bool prepare_transfer(flx_http_transfer& transfer, FILE* output_file);
+  bool complete_transfer(flx_http_transfer& transfer, int curl_result, FILE* output_file, bool& retryable);
+
          // Interne Hilfsmethoden (optional, falls ben�tigt)
          // void parse_url(); // Zum Extrahieren von Host, Pfad etc. aus der URL
 };
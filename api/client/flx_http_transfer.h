@@ -0,0 +1,28 @@
+#ifndef FLX_HTTP_TRANSFER_H
+#define FLX_HTTP_TRANSFER_H
+
+// Interner Header: nur von flx_http_request.cpp und flx_http_multi.cpp eingebunden,
+// damit libcurl nicht in die öffentlichen Header gelangt.
+
+#include <curl/curl.h>
+
+class flx_http_request;
+
+// libcurl-Zustand eines einzelnen Versuchs, der bis zum Ende des Transfers leben muss
+struct flx_http_transfer {
+  CURL* handle = nullptr;       // Nicht im Besitz: Eigentümer ist Lease bzw. flx_http_multi
+  flx_http_request* request = nullptr;
+  bool attach_share = true;     // Prozessweiten DNS-/TLS-/Verbindungs-Cache nutzen
+  curl_slist* header_list = nullptr;
+  char errbuf[CURL_ERROR_SIZE] = {0};
+
+  flx_http_transfer() = default;
+  flx_http_transfer(const flx_http_transfer&) = delete;
+  flx_http_transfer& operator=(const flx_http_transfer&) = delete;
+
+  ~flx_http_transfer() {
+    if (header_list) curl_slist_free_all(header_list);
+  }
+};
+
+#endif // FLX_HTTP_TRANSFER_H
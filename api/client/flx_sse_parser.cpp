@@ -0,0 +1,84 @@
+#include "flx_sse_parser.h"
+
+flx_sse_parser::flx_sse_parser(event_callback callback)
+    : callback_(std::move(callback)), has_data_(false), last_was_cr_(false), stopped_(false) {}
+
+void flx_sse_parser::reset() {
+  line_.clear();
+  current_ = event();
+  has_data_ = false;
+  last_was_cr_ = false;
+  stopped_ = false;
+}
+
+bool flx_sse_parser::feed(const char* data, size_t size) {
+  if (stopped_) return false;
+
+  size_t i = 0;
+  while (i < size) {
+    if (last_was_cr_ && data[i] == '\n') {
+      // Zweiter Teil von \r\n, Zeile wurde schon beim \r abgeschlossen
+      last_was_cr_ = false;
+      ++i;
+      continue;
+    }
+    last_was_cr_ = false;
+
+    size_t end = i;
+    while (end < size && data[end] != '\n' && data[end] != '\r') ++end;
+    line_.append(data + i, end - i);
+    if (end == size) break;
+
+    last_was_cr_ = (data[end] == '\r');
+    if (!process_line()) {
+      stopped_ = true;
+      return false;
+    }
+    line_.clear();
+    i = end + 1;
+  }
+  return true;
+}
+
+bool flx_sse_parser::process_line() {
+  // Leerzeile: Event ausliefern
+  if (line_.empty()) {
+    if (!has_data_) {
+      current_ = event();
+      return true;
+    }
+    event ev = std::move(current_);
+    current_ = event();
+    has_data_ = false;
+    return callback_(ev);
+  }
+
+  // Kommentar
+  if (line_[0] == ':') {
+    return true;
+  }
+
+  flx_string field;
+  flx_string value;
+  size_t colon = line_.find(":");
+  if (colon == flx_string::npos) {
+    field = line_;
+  } else {
+    field = line_.substr(0, colon);
+    size_t start = colon + 1;
+    if (start < line_.length() && line_[start] == ' ') ++start;
+    value = line_.substr(start);
+  }
+
+  if (field == "data") {
+    if (has_data_) current_.data += "\n";
+    current_.data += value;
+    has_data_ = true;
+  } else if (field == "event") {
+    current_.type = value;
+  } else if (field == "id") {
+    current_.id = value;
+  }
+  // "retry" und unbekannte Felder werden ignoriert
+  return true;
+}
@@ -0,0 +1,52 @@
+#ifndef FLX_SSE_PARSER_H
+#define FLX_SSE_PARSER_H
+
+#include "../../utils/flx_string.h"
+#include <functional>
+
+/**
+ * @brief Inkrementeller Parser für Server-Sent Events (text/event-stream).
+ *
+ * Nimmt beliebig zerteilte Blöcke entgegen (z.B. aus
+ * flx_http_request::set_stream_callback) und ruft den Callback für jedes
+ * vollständige Event auf. Zeilenenden \n, \r\n und \r werden unterstützt,
+ * auch wenn sie über Blockgrenzen verteilt sind.
+ */
+class flx_sse_parser {
+public:
+  struct event {
+    flx_string type = "message";
+    flx_string data;
+    flx_string id;
+  };
+
+  /**
+   * @brief Callback pro Event; Rückgabe false beendet das Parsen.
+   */
+  using event_callback = std::function<bool(const event& ev)>;
+
+  explicit flx_sse_parser(event_callback callback);
+
+  /**
+   * @brief Verarbeitet einen weiteren Block.
+   * @return false, wenn der Callback abgebrochen hat.
+   */
+  bool feed(const char* data, size_t size);
+
+  /**
+   * @brief Setzt den Parser für einen neuen Stream zurück.
+   */
+  void reset();
+
+private:
+  event_callback callback_;
+  flx_string line_;
+  event current_;
+  bool has_data_;
+  bool last_was_cr_;
+  bool stopped_;
+
+  bool process_line();
+};
+
+#endif // FLX_SSE_PARSER_H
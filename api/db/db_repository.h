@@ -7,6 +7,7 @@
 #include "db_search_criteria.h"
 #include "db_exceptions.h"
 #include "flx_semantic_embedder.h"
+#include "../server/flx_metrics.h"
 #include "../../utils/flx_model.h"
 #include <vector>
 #include <set>
@@ -209,6 +210,8 @@ inline flx_string db_repository::get_last_error() const
 
 inline void db_repository::create(flx_model& model)
 {
+  flx_scoped_timer timer(flx_metrics::instance().timer("db.create"));
+
   if (!connection_ || !connection_->is_connected()) {
     throw db_connection_error("Database not connected");
   }
@@ -280,6 +283,8 @@ inline void db_repository::create(flx_model& model)
 
 inline void db_repository::update(flx_model& model)
 {
+  flx_scoped_timer timer(flx_metrics::instance().timer("db.update"));
+
   if (!connection_ || !connection_->is_connected()) {
     throw db_connection_error("Database not connected");
   }
@@ -911,6 +916,8 @@ inline flx_string db_repository::extract_table_name(const flx_model& model)
 
 inline void db_repository::search(const db_search_criteria& criteria, flx_list& results)
 {
+  flx_scoped_timer timer(flx_metrics::instance().timer("db.search"));
+
   validate_search_prerequisites(results);
 
   auto sample = results.factory();  // Keep sample alive for entire function
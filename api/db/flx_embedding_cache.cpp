@@ -0,0 +1,351 @@
+#include "flx_embedding_cache.h"
+#include "db_connection.h"
+#include "db_query.h"
+#include "../server/flx_metrics.h"
+#include "../../utils/flx_atomic_file.h"
+#include <openssl/evp.h>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+// ============================================================================
+// float16 conversion (IEEE 754 binary16, round to nearest even)
+// ============================================================================
+
+uint16_t flx_embedding_cache::float_to_half(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+
+    uint16_t sign = static_cast<uint16_t>((bits >> 16) & 0x8000);
+    uint32_t exponent = (bits >> 23) & 0xFF;
+    uint32_t mantissa = bits & 0x7FFFFF;
+
+    if (exponent == 0xFF) {
+        // Inf / NaN (keep NaN quiet)
+        return sign | 0x7C00 | (mantissa ? 0x200 : 0);
+    }
+
+    int32_t half_exponent = static_cast<int32_t>(exponent) - 127 + 15;
+    if (half_exponent >= 0x1F) {
+        return sign | 0x7C00;  // Overflow -> Inf
+    }
+
+    if (half_exponent <= 0) {
+        // Subnormal half or zero
+        if (half_exponent < -10) {
+            return sign;
+        }
+        mantissa |= 0x800000;
+        uint32_t shift = static_cast<uint32_t>(14 - half_exponent);
+        uint32_t half_mantissa = mantissa >> shift;
+        uint32_t remainder = mantissa & ((1u << shift) - 1);
+        uint32_t halfway = 1u << (shift - 1);
+        if (remainder > halfway || (remainder == halfway && (half_mantissa & 1))) {
+            ++half_mantissa;
+        }
+        return sign | static_cast<uint16_t>(half_mantissa);
+    }
+
+    uint32_t half = (static_cast<uint32_t>(half_exponent) << 10) | (mantissa >> 13);
+    uint32_t remainder = mantissa & 0x1FFF;
+    if (remainder > 0x1000 || (remainder == 0x1000 && (half & 1))) {
+        ++half;  // May carry into the exponent, which rounds up correctly (up to Inf)
+    }
+    return sign | static_cast<uint16_t>(half);
+}
+
+float flx_embedding_cache::half_to_float(uint16_t value) {
+    uint32_t sign = static_cast<uint32_t>(value & 0x8000) << 16;
+    uint32_t exponent = (value >> 10) & 0x1F;
+    uint32_t mantissa = value & 0x3FF;
+    uint32_t bits;
+
+    if (exponent == 0) {
+        if (mantissa == 0) {
+            bits = sign;
+        } else {
+            // Normalize subnormal
+            exponent = 127 - 15 + 1;
+            while (!(mantissa & 0x400)) {
+                mantissa <<= 1;
+                --exponent;
+            }
+            mantissa &= 0x3FF;
+            bits = sign | (exponent << 23) | (mantissa << 13);
+        }
+    } else if (exponent == 0x1F) {
+        bits = sign | 0x7F800000 | (mantissa << 13);
+    } else {
+        bits = sign | ((exponent - 15 + 127) << 23) | (mantissa << 13);
+    }
+
+    float result;
+    std::memcpy(&result, &bits, sizeof(result));
+    return result;
+}
+
+// ============================================================================
+// flx_embedding_cache
+// ============================================================================
+
+double flx_embedding_cache::stats::hit_rate() const {
+    uint64_t total = memory_hits + store_hits + misses;
+    return total ? static_cast<double>(memory_hits + store_hits) / total : 0.0;
+}
+
+flx_embedding_cache::flx_embedding_cache(size_t capacity, i_embedding_store* store)
+    : capacity_(capacity ? capacity : 1)
+    , store_(store)
+{
+}
+
+flx_string flx_embedding_cache::make_key(const flx_string& model_name, const flx_string& text) {
+    unsigned char digest[EVP_MAX_MD_SIZE];
+    unsigned int digest_len = 0;
+
+    EVP_MD_CTX* ctx = EVP_MD_CTX_new();
+    EVP_DigestInit_ex(ctx, EVP_sha256(), nullptr);
+    EVP_DigestUpdate(ctx, model_name.c_str(), model_name.length());
+    EVP_DigestUpdate(ctx, "\0", 1);  // Separator: ("ab","c") != ("a","bc")
+    EVP_DigestUpdate(ctx, text.c_str(), text.length());
+    EVP_DigestFinal_ex(ctx, digest, &digest_len);
+    EVP_MD_CTX_free(ctx);
+
+    static const char hex[] = "0123456789abcdef";
+    std::string key;
+    key.reserve(digest_len * 2);
+    for (unsigned int i = 0; i < digest_len; ++i) {
+        key += hex[digest[i] >> 4];
+        key += hex[digest[i] & 0x0F];
+    }
+    return flx_string(key);
+}
+
+bool flx_embedding_cache::get(const flx_string& key, std::vector<float>& embedding) {
+    auto decode = [&embedding](const std::vector<uint16_t>& payload) {
+        embedding.resize(payload.size());
+        for (size_t i = 0; i < payload.size(); ++i) {
+            embedding[i] = half_to_float(payload[i]);
+        }
+    };
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = index_.find(key.to_std_const());
+        if (it != index_.end()) {
+            lru_.splice(lru_.begin(), lru_, it->second);
+            decode(it->second->second);
+            ++stats_.memory_hits;
+            flx_metrics::instance().counter("embedding_cache.hit_memory").fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+
+    std::vector<uint16_t> payload;
+    if (store_ && store_->load(key, payload) && !payload.empty()) {
+        decode(payload);
+        std::lock_guard<std::mutex> lock(mutex_);
+        insert_locked(key.to_std_const(), std::move(payload));
+        ++stats_.store_hits;
+        flx_metrics::instance().counter("embedding_cache.hit_store").fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++stats_.misses;
+    flx_metrics::instance().counter("embedding_cache.miss").fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+void flx_embedding_cache::put(const flx_string& key, const std::vector<float>& embedding) {
+    if (embedding.empty()) {
+        return;
+    }
+
+    std::vector<uint16_t> payload(embedding.size());
+    for (size_t i = 0; i < embedding.size(); ++i) {
+        payload[i] = float_to_half(embedding[i]);
+    }
+
+    if (store_ && !store_->store(key, payload)) {
+        std::cerr << "[embedding_cache] Failed to persist entry " << key.c_str() << std::endl;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    insert_locked(key.to_std_const(), std::move(payload));
+}
+
+void flx_embedding_cache::insert_locked(const std::string& key, std::vector<uint16_t> payload) {
+    auto it = index_.find(key);
+    if (it != index_.end()) {
+        it->second->second = std::move(payload);
+        lru_.splice(lru_.begin(), lru_, it->second);
+        return;
+    }
+
+    lru_.emplace_front(key, std::move(payload));
+    index_[key] = lru_.begin();
+
+    while (lru_.size() > capacity_) {
+        index_.erase(lru_.back().first);
+        lru_.pop_back();
+    }
+}
+
+flx_embedding_cache::stats flx_embedding_cache::get_stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+size_t flx_embedding_cache::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return lru_.size();
+}
+
+void flx_embedding_cache::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    lru_.clear();
+    index_.clear();
+    stats_ = stats();
+}
+
+// ============================================================================
+// flx_embedding_file_store
+// ============================================================================
+
+flx_embedding_file_store::flx_embedding_file_store(const flx_string& directory)
+    : directory_(directory)
+{
+}
+
+flx_string flx_embedding_file_store::path_for(const flx_string& key) const {
+    return directory_ + "/" + key.substr(0, 2) + "/" + key + ".f16";
+}
+
+bool flx_embedding_file_store::load(const flx_string& key, std::vector<uint16_t>& payload) {
+    std::ifstream in(path_for(key).c_str(), std::ios::binary);
+    if (!in) {
+        return false;
+    }
+
+    char magic[4];
+    uint32_t dims = 0;
+    if (!in.read(magic, 4) || std::memcmp(magic, "FE16", 4) != 0 ||
+        !in.read(reinterpret_cast<char*>(&dims), sizeof(dims)) || dims == 0 || dims > (1u << 20)) {
+        return false;
+    }
+
+    payload.resize(dims);
+    if (!in.read(reinterpret_cast<char*>(payload.data()), dims * sizeof(uint16_t))) {
+        payload.clear();
+        return false;
+    }
+    return true;
+}
+
+bool flx_embedding_file_store::store(const flx_string& key, const std::vector<uint16_t>& payload) {
+    std::filesystem::path target(path_for(key).to_std_const());
+    std::error_code ec;
+    std::filesystem::create_directories(target.parent_path(), ec);
+    if (ec) {
+        return false;
+    }
+
+    uint32_t dims = static_cast<uint32_t>(payload.size());
+    std::string content("FE16", 4);
+    content.append(reinterpret_cast<const char*>(&dims), sizeof(dims));
+    content.append(reinterpret_cast<const char*>(payload.data()), payload.size() * sizeof(uint16_t));
+
+    // Keys are content hashes: if the rename loses against another writer
+    // of the same key, the entry on disk is just as good
+    if (flx_write_file_atomic(target.string(), content)) {
+        return true;
+    }
+    return std::filesystem::exists(target, ec);
+}
+
+// ============================================================================
+// flx_embedding_pg_store
+// ============================================================================
+
+flx_embedding_pg_store::flx_embedding_pg_store(db_connection* connection, const flx_string& table_name)
+    : connection_(connection)
+    , table_name_(table_name)
+{
+}
+
+void flx_embedding_pg_store::ensure_table() {
+    std::call_once(table_created_, [this] {
+        auto query = connection_->create_query();
+        query->prepare("CREATE TABLE IF NOT EXISTS " + table_name_ + " ("
+                       "key TEXT PRIMARY KEY, "
+                       "dims INTEGER NOT NULL, "
+                       "payload BYTEA NOT NULL, "
+                       "created_at TIMESTAMPTZ NOT NULL DEFAULT now())");
+        if (!query->execute()) {
+            std::cerr << "[embedding_cache] " << query->get_last_error().c_str() << std::endl;
+        }
+    });
+}
+
+bool flx_embedding_pg_store::load(const flx_string& key, std::vector<uint16_t>& payload) {
+    if (!connection_ || !connection_->is_connected()) {
+        return false;
+    }
+    ensure_table();
+
+    auto query = connection_->create_query();
+    query->prepare("SELECT encode(payload, 'hex') AS payload FROM " + table_name_ + " WHERE key = :key");
+    query->bind("key", key);
+    if (!query->execute() || !query->next()) {
+        return false;
+    }
+
+    flxv_map row = query->get_row();
+    const std::string& hex = row["payload"].to_string().to_std_const();
+    if (hex.size() % 4 != 0) {
+        return false;
+    }
+
+    auto nibble = [](char c) -> uint16_t {
+        return static_cast<uint16_t>(c <= '9' ? c - '0' : (c | 0x20) - 'a' + 10);
+    };
+
+    // Little-endian uint16 per value
+    payload.resize(hex.size() / 4);
+    for (size_t i = 0; i < payload.size(); ++i) {
+        const char* p = hex.data() + i * 4;
+        uint16_t lo = static_cast<uint16_t>((nibble(p[0]) << 4) | nibble(p[1]));
+        uint16_t hi = static_cast<uint16_t>((nibble(p[2]) << 4) | nibble(p[3]));
+        payload[i] = static_cast<uint16_t>(lo | (hi << 8));
+    }
+    return true;
+}
+
+bool flx_embedding_pg_store::store(const flx_string& key, const std::vector<uint16_t>& payload) {
+    if (!connection_ || !connection_->is_connected()) {
+        return false;
+    }
+    ensure_table();
+
+    static const char hex_digits[] = "0123456789abcdef";
+    std::string hex;
+    hex.reserve(payload.size() * 4);
+    for (uint16_t value : payload) {
+        unsigned char lo = value & 0xFF;
+        unsigned char hi = value >> 8;
+        hex += hex_digits[lo >> 4];
+        hex += hex_digits[lo & 0x0F];
+        hex += hex_digits[hi >> 4];
+        hex += hex_digits[hi & 0x0F];
+    }
+
+    auto query = connection_->create_query();
+    query->prepare("INSERT INTO " + table_name_ + " (key, dims, payload) "
+                   "VALUES (:key, :dims, decode(:payload, 'hex')) ON CONFLICT (key) DO NOTHING");
+    query->bind("key", key);
+    query->bind("dims", flx_variant(static_cast<long long>(payload.size())));
+    query->bind("payload", flx_string(hex));
+    return query->execute();
+}
@@ -0,0 +1,112 @@
+#ifndef FLX_EMBEDDING_CACHE_H
+#define FLX_EMBEDDING_CACHE_H
+
+#include "../../utils/flx_string.h"
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class db_connection;
+
+/**
+ * Persistent backing store for flx_embedding_cache.
+ * Payloads are float16 values (IEEE 754 binary16).
+ */
+class i_embedding_store {
+public:
+    virtual ~i_embedding_store() = default;
+    virtual bool load(const flx_string& key, std::vector<uint16_t>& payload) = 0;
+    virtual bool store(const flx_string& key, const std::vector<uint16_t>& payload) = 0;
+};
+
+/**
+ * One file per embedding: <directory>/<key[0..1]>/<key>.f16
+ * Layout: "FE16", uint32 dimensions, dimensions * uint16 (little endian)
+ */
+class flx_embedding_file_store : public i_embedding_store {
+public:
+    explicit flx_embedding_file_store(const flx_string& directory);
+
+    bool load(const flx_string& key, std::vector<uint16_t>& payload) override;
+    bool store(const flx_string& key, const std::vector<uint16_t>& payload) override;
+
+private:
+    flx_string directory_;
+
+    flx_string path_for(const flx_string& key) const;
+};
+
+/**
+ * Postgres table (created on first use):
+ *   key TEXT PRIMARY KEY, dims INTEGER, payload BYTEA, created_at TIMESTAMPTZ
+ */
+class flx_embedding_pg_store : public i_embedding_store {
+public:
+    explicit flx_embedding_pg_store(db_connection* connection, const flx_string& table_name = "embedding_cache");
+
+    bool load(const flx_string& key, std::vector<uint16_t>& payload) override;
+    bool store(const flx_string& key, const std::vector<uint16_t>& payload) override;
+
+private:
+    db_connection* connection_;
+    flx_string table_name_;
+    std::once_flag table_created_;
+
+    void ensure_table();
+};
+
+/**
+ * Content-addressed embedding cache
+ *
+ * Key: SHA-256 of (embedding model name, text). Identical semantic DNA maps to
+ * the same key, so unchanged records never hit the embedding API again.
+ *
+ * Lookup order: in-memory LRU -> backing store (optional) -> miss.
+ * Entries are kept as float16 (half the size of float, same precision as the
+ * halfvec column the embeddings end up in).
+ *
+ * Hit/miss counts are exported via flx_metrics counters
+ * "embedding_cache.hit_memory", "embedding_cache.hit_store", "embedding_cache.miss".
+ */
+class flx_embedding_cache {
+public:
+    struct stats {
+        uint64_t memory_hits = 0;
+        uint64_t store_hits = 0;
+        uint64_t misses = 0;
+
+        double hit_rate() const;
+    };
+
+    explicit flx_embedding_cache(size_t capacity = 2048, i_embedding_store* store = nullptr);
+
+    static flx_string make_key(const flx_string& model_name, const flx_string& text);
+
+    bool get(const flx_string& key, std::vector<float>& embedding);
+    void put(const flx_string& key, const std::vector<float>& embedding);
+
+    stats get_stats() const;
+    size_t size() const;
+    void clear();
+
+    static uint16_t float_to_half(float value);
+    static float half_to_float(uint16_t value);
+
+private:
+    using entry = std::pair<std::string, std::vector<uint16_t>>;
+
+    size_t capacity_;
+    i_embedding_store* store_;
+
+    mutable std::mutex mutex_;
+    std::list<entry> lru_;  // Front = most recently used
+    std::unordered_map<std::string, std::list<entry>::iterator> index_;
+    stats stats_;
+
+    void insert_locked(const std::string& key, std::vector<uint16_t> payload);
+};
+
+#endif // FLX_EMBEDDING_CACHE_H
@@ -4,9 +4,42 @@
 
 flx_semantic_embedder::flx_semantic_embedder(const flx_string& openai_api_key)
     : api_(openai_api_key)
+    , batcher_(api_)
+    , cache_(nullptr)
 {
 }
 
+void flx_semantic_embedder::set_cache(flx_embedding_cache* cache) {
+    cache_ = cache;
+}
+
+void flx_semantic_embedder::set_long_text_options(const flx::llm::long_text_options& options) {
+    long_text_ = options;
+}
+
+flx::llm::long_text_options flx_semantic_embedder::options_for(flx_model& model) const {
+    const auto& properties = model.get_properties();
+    auto it = properties.find("semantic_embedding");
+    if (it == properties.end() || it->second == nullptr) {
+        return long_text_;
+    }
+    return flx::llm::long_text_options::from_meta(it->second->get_meta(), long_text_);
+}
+
+flx_string flx_semantic_embedder::embedding_signature(const flx::llm::long_text_options& options) const {
+    const char* strategy = "chunk";
+    if (options.strategy == flx::llm::long_text_strategy::summarize) {
+        strategy = "summarize";
+    } else if (options.strategy == flx::llm::long_text_strategy::truncate) {
+        strategy = "truncate";
+    }
+    std::ostringstream out;
+    out << api_.get_embedding_model().to_std_const() << '|' << strategy << '|'
+        << options.chunk_tokens << '|' << options.overlap_tokens << '|'
+        << (options.pooling == flx::llm::pooling_mode::mean ? "mean" : "weighted");
+    return flx_string(out.str());
+}
+
 flx_string flx_semantic_embedder::extract_text_from_property(flx_property_i* prop, flx_model& model) {
     if (prop->is_null()) {
         return flx_string();
@@ -89,11 +122,120 @@ flx_string flx_semantic_embedder::create_semantic_dna(flx_model& model) {
 }
 
 bool flx_semantic_embedder::generate_embedding(const flx_string& text, flxv_vector& embedding) {
+    std::vector<float> compact;
+    if (!generate_embedding(text, compact)) {
+        return false;
+    }
+
+    embedding.clear();
+    embedding.reserve(compact.size());
+    for (float value : compact) {
+        embedding.push_back(flx_variant(static_cast<double>(value)));
+    }
+    return true;
+}
+
+bool flx_semantic_embedder::generate_embedding(const flx_string& text, std::vector<float>& embedding) {
+    return generate_embedding(text, embedding, long_text_, nullptr, nullptr);
+}
+
+bool flx_semantic_embedder::embed_texts(const std::vector<flx_string>& texts, std::vector<std::vector<float>>& embeddings) {
+    if (!cache_) {
+        return batcher_.embed_all(texts, embeddings);
+    }
+
+    embeddings.assign(texts.size(), std::vector<float>());
+    std::vector<flx_string> keys;
+    std::vector<flx_string> missing;
+    std::vector<size_t> missing_index;
+    for (size_t i = 0; i < texts.size(); ++i) {
+        keys.push_back(flx_embedding_cache::make_key(api_.get_embedding_model(), texts[i]));
+        if (!cache_->get(keys.back(), embeddings[i])) {
+            missing.push_back(texts[i]);
+            missing_index.push_back(i);
+        }
+    }
+    if (missing.empty()) {
+        return true;
+    }
+
+    std::vector<std::vector<float>> fresh;
+    if (!batcher_.embed_all(missing, fresh)) {
+        return false;
+    }
+    for (size_t k = 0; k < missing.size(); ++k) {
+        cache_->put(keys[missing_index[k]], fresh[k]);
+        embeddings[missing_index[k]] = std::move(fresh[k]);
+    }
+    return true;
+}
+
+bool flx_semantic_embedder::generate_embedding(const flx_string& text, std::vector<float>& embedding,
+                                               const flx::llm::long_text_options& options,
+                                               std::vector<std::vector<float>>* chunk_embeddings,
+                                               std::vector<flx::llm::text_chunk>* chunks) {
     if (text.empty()) {
         return false;
     }
 
-    return api_.embedding(text, embedding);
+    // summarize/truncate shorten the text first, cached under their own key
+    // (the length they cut to is part of it)
+    if (options.strategy != flx::llm::long_text_strategy::chunk) {
+        flx_string key = flx_embedding_cache::make_key(embedding_signature(options), text);
+        if (cache_ && cache_->get(key, embedding)) {
+            return true;
+        }
+        std::vector<flx_string> inputs = api_.prepare_embedding_inputs({text}, options);
+        if (inputs.empty() || inputs[0].empty()) {
+            return false;
+        }
+        // The batcher embeds with the API's own options, which would chunk an
+        // input above their limit (e.g. a long summary); send those directly,
+        // with a limit that keeps the prepared input as it is
+        size_t tokens = flx::llm::estimate_embedding_tokens(inputs[0]);
+        if (tokens <= api_.get_long_text_options().chunk_tokens) {
+            if (!batcher_.embed(inputs[0], embedding)) {
+                return false;
+            }
+        } else {
+            std::vector<std::vector<float>> result;
+            flx::llm::long_text_options whole = options;
+            whole.strategy = flx::llm::long_text_strategy::truncate;
+            whole.chunk_tokens = tokens;
+            if (!api_.embedding_batch(inputs, result, whole) || result.empty()) {
+                return false;
+            }
+            embedding = std::move(result[0]);
+        }
+        if (cache_) {
+            cache_->put(key, embedding);
+        }
+        return true;
+    }
+
+    // Chunks are cached individually: editing one passage re-embeds only that chunk
+    std::vector<flx::llm::text_chunk> parts = flx::llm::split_into_chunks(text, options);
+    std::vector<flx_string> texts;
+    texts.reserve(parts.size());
+    for (const auto& part : parts) {
+        texts.push_back(parts.size() == 1 ? text : text.substr(part.offset, part.length));
+    }
+
+    std::vector<std::vector<float>> vectors;
+    if (!embed_texts(texts, vectors)) {
+        return false;
+    }
+    embedding = flx::llm::pool_embeddings(vectors, parts, options.pooling);
+    if (embedding.empty()) {
+        return false;
+    }
+    if (chunk_embeddings) {
+        *chunk_embeddings = std::move(vectors);
+    }
+    if (chunks) {
+        *chunks = std::move(parts);
+    }
+    return true;
 }
 
 bool flx_semantic_embedder::embed_model(flx_model& model) {
@@ -104,15 +246,60 @@ bool flx_semantic_embedder::embed_model(flx_model& model) {
         return false;  // No semantic properties found
     }
 
-    // Step 2: Generate embedding
-    flxv_vector embedding;
-    if (!generate_embedding(dna, embedding)) {
+    // Per-chunk vectors only for models that can store them
+    bool wants_chunks = model.get_properties().count("semantic_chunks") > 0;
+
+    // Unchanged DNA with an embedding from the same model and options already
+    // on the model: nothing to do
+    flx::llm::long_text_options options = options_for(model);
+    flx_string signature = embedding_signature(options);
+    const flxv_map& data = *model;
+    auto text_it = data.find("semantic_text");
+    auto signature_it = data.find("semantic_embedding_signature");
+    auto embedding_it = data.find("semantic_embedding");
+    auto chunks_it = data.find("semantic_chunks");
+    if (text_it != data.end() && embedding_it != data.end() && signature_it != data.end() &&
+        text_it->second.is_string() && text_it->second.string_value() == dna &&
+        signature_it->second.is_string() && signature_it->second.string_value() == signature &&
+        embedding_it->second.is_vector() && !embedding_it->second.vector_value().empty() &&
+        (!wants_chunks || (chunks_it != data.end() && chunks_it->second.is_vector()))) {
+        return true;
+    }
+
+    // Step 2: Generate embedding (chunked and batched with concurrent callers)
+    std::vector<float> pooled;
+    std::vector<std::vector<float>> chunk_vectors;
+    std::vector<flx::llm::text_chunk> chunks;
+    if (!generate_embedding(dna, pooled, options,
+                            wants_chunks ? &chunk_vectors : nullptr,
+                            wants_chunks ? &chunks : nullptr)) {
         return false;
     }
 
+    auto to_variant = [](const std::vector<float>& values) {
+        flxv_vector out;
+        out.reserve(values.size());
+        for (float value : values) {
+            out.push_back(flx_variant(static_cast<double>(value)));
+        }
+        return out;
+    };
+
     // Step 3: Store in model
     model["semantic_text"] = flx_variant(dna);
-    model["semantic_embedding"] = flx_variant(embedding);
+    model["semantic_embedding_signature"] = flx_variant(signature);
+    model["semantic_embedding"] = flx_variant(to_variant(pooled));
+    if (wants_chunks) {
+        flxv_vector chunk_list;
+        for (size_t i = 0; i < chunks.size() && i < chunk_vectors.size(); ++i) {
+            flxv_map entry;
+            entry["offset"] = static_cast<long long>(chunks[i].offset);
+            entry["length"] = static_cast<long long>(chunks[i].length);
+            entry["embedding"] = to_variant(chunk_vectors[i]);
+            chunk_list.push_back(entry);
+        }
+        model["semantic_chunks"] = flx_variant(chunk_list);
+    }
 
     return true;
 }
@@ -5,6 +5,9 @@
 #include "../../utils/flx_string.h"
 #include "../../utils/flx_variant.h"
 #include "../aimodels/flx_openai_api.h"
+#include "../aimodels/flx_embedding_batcher.h"
+#include "flx_embedding_cache.h"
+#include <vector>
 
 /**
  * Generic semantic embedder for any flx_model
@@ -19,11 +22,37 @@
  * - Combines them into a "semantic DNA" text
  * - Generates OpenAI embedding vector
  * - Stores in model["semantic_embedding"]
+ *
+ * Concurrent calls (e.g. parallel repository inserts) are coalesced into
+ * batched /v1/embeddings requests by an embedding_batcher.
+ *
+ * Unchanged records cost no API call: embed_model() skips models whose stored
+ * semantic_text equals the new DNA and whose semantic_embedding_signature
+ * (embedding model and long-text options) still matches, and an optional flx_embedding_cache
+ * (set_cache) serves embeddings for previously seen DNA texts.
+ *
+ * Long DNA texts are split into overlapping chunks that are embedded in one
+ * batch and pooled into the document vector (no summarization call). The
+ * strategy is chosen per model through metadata on semantic_embedding, e.g.
+ * flxp_vector(semantic_embedding, {{"column", "semantic_embedding"},
+ *                                  {"chunk_tokens", 512}, {"pooling", "mean"}})
+ * A model with a semantic_chunks property also gets the per-chunk vectors
+ * ({offset, length, embedding} per chunk) for sub-passage matching.
  */
 class flx_semantic_embedder {
 public:
     explicit flx_semantic_embedder(const flx_string& openai_api_key);
 
+    /**
+     * Optional embedding cache (not owned, nullptr disables caching)
+     */
+    void set_cache(flx_embedding_cache* cache);
+
+    /**
+     * Long-text handling for models without embedding metadata
+     */
+    void set_long_text_options(const flx::llm::long_text_options& options);
+
     /**
      * Creates semantic DNA from all properties marked with {"semantic": true}
      * Returns empty string if no semantic properties found
@@ -34,6 +63,16 @@ public:
      * Generates embedding vector for given text
      */
     bool generate_embedding(const flx_string& text, flxv_vector& embedding);
+    bool generate_embedding(const flx_string& text, std::vector<float>& embedding);
+
+    /**
+     * Generates the pooled embedding with an explicit long-text strategy;
+     * chunk_embeddings (optional) receives one vector per chunk
+     */
+    bool generate_embedding(const flx_string& text, std::vector<float>& embedding,
+                            const flx::llm::long_text_options& options,
+                            std::vector<std::vector<float>>* chunk_embeddings,
+                            std::vector<flx::llm::text_chunk>* chunks);
 
     /**
      * Complete workflow: DNA → embedding → store in model
@@ -43,6 +82,19 @@ public:
 
 private:
     flx::llm::openai_api api_;
+    flx::llm::embedding_batcher batcher_;
+    flx_embedding_cache* cache_;
+    flx::llm::long_text_options long_text_;
+
+    // Embeds texts through cache and batcher (cache misses go out in one batch)
+    bool embed_texts(const std::vector<flx_string>& texts, std::vector<std::vector<float>>& embeddings);
+
+    // Long-text options from the semantic_embedding property's metadata
+    flx::llm::long_text_options options_for(flx_model& model) const;
+
+    // Embedding model plus the options that shape the vector, e.g.
+    // "text-embedding-3-large|chunk|3000|300|weighted"
+    flx_string embedding_signature(const flx::llm::long_text_options& options) const;
 
     // Helper to extract text from a property
     flx_string extract_text_from_property(flx_property_i* prop, flx_model& model);
@@ -1,13 +1,98 @@
 #include "flx_httpdaemon.h"
 #include <errno.h>
 #include <string.h>
+#include <condition_variable>
 #include <iostream>
+#include <memory>
+#include <thread>
+
+namespace
+{
+  flx_string route_label(const flx_http_daemon::request& req, const flx_http_daemon::response& res)
+  {
+    if (!res.route.empty())
+    {
+      return res.route;
+    }
+    return res.statuscode == 404 ? flx_string("unmatched") : req.method;
+  }
+
+  // Buffer between a response::stream producer thread and the MHD reader callback
+  class stream_state : public flx_http_daemon::stream_writer
+  {
+  public:
+    static constexpr size_t max_buffered = 1 << 20;
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::string buffer;
+    bool finished = false;
+    bool closed = false;
+    uint64_t bytes_sent = 0;
+    flx_metric* metric = nullptr;
+
+    bool write(const flx_string& chunk) override
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      cv.wait(lock, [this] { return closed || buffer.size() < max_buffered; });
+      if (closed)
+      {
+        return false;
+      }
+      buffer += chunk.to_std_const();
+      cv.notify_all();
+      return true;
+    }
+
+    void finish()
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      finished = true;
+      cv.notify_all();
+    }
+  };
+
+  using stream_handle = std::shared_ptr<stream_state>;
+
+  ssize_t stream_read(void* cls, uint64_t, char* buf, size_t max)
+  {
+    stream_state& state = **static_cast<stream_handle*>(cls);
+    std::unique_lock<std::mutex> lock(state.mutex);
+    state.cv.wait(lock, [&state] { return !state.buffer.empty() || state.finished; });
+    if (state.buffer.empty())
+    {
+      return MHD_CONTENT_READER_END_OF_STREAM;
+    }
+    size_t n = std::min(max, state.buffer.size());
+    memcpy(buf, state.buffer.data(), n);
+    state.buffer.erase(0, n);
+    state.bytes_sent += n;
+    state.cv.notify_all();
+    return static_cast<ssize_t>(n);
+  }
+
+  void stream_free(void* cls)
+  {
+    stream_handle* handle = static_cast<stream_handle*>(cls);
+    {
+      std::lock_guard<std::mutex> lock((*handle)->mutex);
+      (*handle)->closed = true;
+      if ((*handle)->metric)
+      {
+        (*handle)->metric->add_bytes(0, (*handle)->bytes_sent);
+      }
+      (*handle)->cv.notify_all();
+    }
+    delete handle;
+  }
+}
 
 flx_http_daemon::flx_http_daemon()
 {
   threads = 1;
   running = false;
   ssl = false;
+  metrics_path = "/metrics";
 }
 
 flx_http_daemon::~flx_http_daemon()
@@ -48,6 +133,12 @@ void request_completed (void *, struct MHD_Connection *,
       std::cout << "request_completed: req was nullptr!" << std::endl;
       return;
     }
+    if (req->metric)
+    {
+      // Measured until the response is fully sent (or the connection aborted)
+      bool error = req->statuscode == 0 || req->statuscode >= 500;
+      req->metric->end(std::chrono::steady_clock::now() - req->received, error);
+    }
     delete req;
     *con_cls = NULL;
 }
@@ -73,6 +164,10 @@ MHD_Result flx_http_daemon::echo(void *cls, MHD_Connection *connection,
     req = new request();
     req->path = url;
     req->method = method;
+    req->received = std::chrono::steady_clock::now();
+    // Counted in flight under the method until the handler has matched a route
+    req->metric = &flx_metrics::instance().route(req->method);
+    req->metric->begin();
 
     // The headers are already valid. Lets use them
     MHD_get_connection_values(connection, MHD_HEADER_KIND, &fill_request, req);
@@ -99,7 +194,56 @@ MHD_Result flx_http_daemon::echo(void *cls, MHD_Connection *connection,
   }
 
   // Process the constructed request
-  response result(daemon->handle(*req));
+  response result;
+  if (!daemon->metrics_path.empty() && req->method == "GET" && req->path == daemon->metrics_path)
+  {
+    result.body = flx_metrics::instance().to_prometheus();
+    result.headers["Content-Type"] = "text/plain; version=0.0.4";
+    result.statuscode = 200;
+    result.route = "GET " + daemon->metrics_path;
+  }
+  else
+  {
+    result = daemon->handle(*req);
+  }
+  req->statuscode = result.statuscode;
+  // The label is only known once the handler has matched the path
+  flx_metric* labelled = &flx_metrics::instance().route(route_label(*req, result));
+  req->metric->move_to(*labelled);
+  req->metric = labelled;
+
+  if (result.stream)
+  {
+    // Streamed body: producer thread -> stream_state -> stream_read
+    auto state = std::make_shared<stream_state>();
+    state->metric = req->metric;
+    req->metric->add_bytes(req->body.size(), 0);
+    std::thread([state, producer = std::move(result.stream)]()
+    {
+      try
+      {
+        producer(*state);
+      }
+      catch (const std::exception& e)
+      {
+        std::cout << "Stream producer failed: " << e.what() << std::endl;
+      }
+      state->finish();
+    }).detach();
+
+    resp = MHD_create_response_from_callback(MHD_SIZE_UNKNOWN, 4096, &stream_read,
+                                             new stream_handle(state), &stream_free);
+    for (auto i = result.headers.begin(); i != result.headers.end(); ++i)
+    {
+      MHD_add_response_header (resp, i->first.c_str(), i->second.c_str());
+    }
+    std::cout << "Streaming response" << std::endl;
+    ret = MHD_queue_response(connection, result.statuscode, resp);
+    MHD_destroy_response(resp);
+    return ret;
+  }
+
+  req->metric->add_bytes(req->body.size(), result.body.size());
 
   // Construct response
   flx_string data = result.body;
@@ -212,6 +356,11 @@ void flx_http_daemon::activate_thread_pool(size_t threads)
   this->threads = threads;
 }
 
+void flx_http_daemon::activate_metrics(flx_string path)
+{
+  metrics_path = path;
+}
+
 flx_http_daemon::response flx_http_daemon::handle(flx_http_daemon::request req)
 {
   response r;
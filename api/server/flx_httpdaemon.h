@@ -3,6 +3,9 @@
 
 #include "microhttpd.h"
 #include "../../utils/flx_string.h"
+#include "flx_metrics.h"
+#include <chrono>
+#include <functional>
 #include <map>
 #include <mutex>
 
@@ -31,6 +34,7 @@ class flx_http_daemon
   MHD_Daemon* daemon;
   size_t threads;
   std::mutex mutex;
+  flx_string metrics_path;
 
 public:
   flx_http_daemon();
@@ -43,6 +47,8 @@ public:
   bool check_ssl_supported();
   void activate_ssl(flx_string privatekey, flx_string certificate);
   void activate_thread_pool(size_t threads);
+  // Serve flx_metrics in Prometheus format on this path ("" disables, default "/metrics")
+  void activate_metrics(flx_string path);
 
   struct request
   {
@@ -51,6 +57,22 @@ public:
     flx_string body;
     std::map<flx_string, flx_string> headers;
     std::map<flx_string, flx_string> params;
+
+    // Instrumentation, filled in by the daemon (metric is the method alone
+    // until handle() has returned, then the matched route)
+    std::chrono::steady_clock::time_point received;
+    flx_metric* metric = nullptr;
+    int statuscode = 0;
+  };
+
+  // Sink for streamed response bodies (see response::stream)
+  class stream_writer
+  {
+  public:
+    virtual ~stream_writer() = default;
+    // Queue a chunk for the client; blocks while too much is buffered.
+    // Returns false once the client has disconnected - stop producing then.
+    virtual bool write(const flx_string& chunk) = 0;
   };
 
   struct response
@@ -58,6 +80,17 @@ public:
     flx_string body;
     std::map<flx_string, flx_string> headers;
     int statuscode = 0;
+
+    // Route pattern the handler matched, e.g. "GET /api/docs/:id", used as the
+    // metrics label. Raw paths carry ids and would fill the route table. Empty:
+    // "unmatched" for a 404, otherwise the method alone.
+    flx_string route;
+
+    // Optional streamed body (e.g. text/event-stream). When set, body is ignored:
+    // headers go out immediately and stream runs on its own thread, every write()
+    // is sent as soon as the client can take it. An open stream occupies one
+    // daemon thread (see activate_thread_pool).
+    std::function<void(stream_writer& out)> stream;
   };
 
   virtual response handle(request req);
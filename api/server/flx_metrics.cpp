@@ -0,0 +1,360 @@
+#include "flx_metrics.h"
+#include <algorithm>
+#include <cmath>
+#include <exception>
+#include <mutex>
+#include <sstream>
+
+// ---------------------------------------------------------------------------
+// flx_latency_histogram
+// ---------------------------------------------------------------------------
+
+flx_latency_histogram::flx_latency_histogram()
+{
+  reset();
+}
+
+int flx_latency_histogram::bucket_index(uint64_t micros)
+{
+  if (micros < static_cast<uint64_t>(sub_count))
+  {
+    return static_cast<int>(micros);
+  }
+
+  int magnitude = 63 - __builtin_clzll(micros);
+  if (magnitude > max_magnitude)
+  {
+    return bucket_count - 1;
+  }
+
+  int shift = magnitude - sub_bits;
+  int sub = static_cast<int>((micros >> shift) & (sub_count - 1));
+  return (shift + 1) * sub_count + sub;
+}
+
+uint64_t flx_latency_histogram::bucket_lower_bound(int index)
+{
+  if (index < sub_count)
+  {
+    return static_cast<uint64_t>(index);
+  }
+  int shift = index / sub_count - 1;
+  uint64_t sub = static_cast<uint64_t>(index % sub_count);
+  return (static_cast<uint64_t>(sub_count) + sub) << shift;
+}
+
+uint64_t flx_latency_histogram::bucket_upper_bound(int index)
+{
+  if (index < sub_count)
+  {
+    return static_cast<uint64_t>(index);
+  }
+  int shift = index / sub_count - 1;
+  return bucket_lower_bound(index) + (uint64_t(1) << shift) - 1;
+}
+
+void flx_latency_histogram::record(uint64_t micros)
+{
+  buckets[bucket_index(micros)].fetch_add(1, std::memory_order_relaxed);
+  total_count.fetch_add(1, std::memory_order_relaxed);
+  total_sum.fetch_add(micros, std::memory_order_relaxed);
+
+  uint64_t prev = max_value.load(std::memory_order_relaxed);
+  while (micros > prev && !max_value.compare_exchange_weak(prev, micros, std::memory_order_relaxed))
+  {
+  }
+}
+
+void flx_latency_histogram::reset()
+{
+  for (auto& b : buckets)
+  {
+    b.store(0, std::memory_order_relaxed);
+  }
+  total_count.store(0, std::memory_order_relaxed);
+  total_sum.store(0, std::memory_order_relaxed);
+  max_value.store(0, std::memory_order_relaxed);
+}
+
+uint64_t flx_latency_histogram::count() const
+{
+  return total_count.load(std::memory_order_relaxed);
+}
+
+uint64_t flx_latency_histogram::sum() const
+{
+  return total_sum.load(std::memory_order_relaxed);
+}
+
+uint64_t flx_latency_histogram::max() const
+{
+  return max_value.load(std::memory_order_relaxed);
+}
+
+uint64_t flx_latency_histogram::percentile(double q) const
+{
+  // Snapshot the buckets first; concurrent writers may make total_count drift
+  uint64_t snapshot_total = 0;
+  std::array<uint64_t, bucket_count> snapshot;
+  for (int i = 0; i < bucket_count; ++i)
+  {
+    snapshot[i] = buckets[i].load(std::memory_order_relaxed);
+    snapshot_total += snapshot[i];
+  }
+  if (snapshot_total == 0)
+  {
+    return 0;
+  }
+
+  q = std::min(std::max(q, 0.0), 1.0);
+  uint64_t target = static_cast<uint64_t>(std::ceil(q * static_cast<double>(snapshot_total)));
+  if (target == 0)
+  {
+    target = 1;
+  }
+
+  uint64_t seen = 0;
+  for (int i = 0; i < bucket_count; ++i)
+  {
+    seen += snapshot[i];
+    if (seen >= target)
+    {
+      return std::min(bucket_upper_bound(i), max());
+    }
+  }
+  return max();
+}
+
+// ---------------------------------------------------------------------------
+// flx_metric / flx_scoped_timer
+// ---------------------------------------------------------------------------
+
+void flx_metric::begin()
+{
+  in_flight.fetch_add(1, std::memory_order_relaxed);
+}
+
+void flx_metric::end(std::chrono::steady_clock::duration elapsed, bool error)
+{
+  in_flight.fetch_sub(1, std::memory_order_relaxed);
+  calls.fetch_add(1, std::memory_order_relaxed);
+  if (error)
+  {
+    errors.fetch_add(1, std::memory_order_relaxed);
+  }
+  auto micros = std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+  latency.record(micros > 0 ? static_cast<uint64_t>(micros) : 0);
+}
+
+void flx_metric::move_to(flx_metric& other)
+{
+  if (&other == this)
+  {
+    return;
+  }
+  other.in_flight.fetch_add(1, std::memory_order_relaxed);
+  in_flight.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void flx_metric::add_bytes(uint64_t in, uint64_t out)
+{
+  bytes_in.fetch_add(in, std::memory_order_relaxed);
+  bytes_out.fetch_add(out, std::memory_order_relaxed);
+}
+
+flx_scoped_timer::flx_scoped_timer(flx_metric& m)
+  : metric(m), start(std::chrono::steady_clock::now()), failed(false)
+{
+  metric.begin();
+}
+
+flx_scoped_timer::~flx_scoped_timer()
+{
+  // Leaving the scope through an exception counts as failure
+  bool error = failed || std::uncaught_exceptions() > 0;
+  metric.end(std::chrono::steady_clock::now() - start, error);
+}
+
+void flx_scoped_timer::fail()
+{
+  failed = true;
+}
+
+// ---------------------------------------------------------------------------
+// flx_metrics
+// ---------------------------------------------------------------------------
+
+flx_metrics& flx_metrics::instance()
+{
+  static flx_metrics metrics;
+  return metrics;
+}
+
+flx_metric& flx_metrics::lookup(std::map<flx_string, std::unique_ptr<flx_metric>>& family, const flx_string& name, size_t limit)
+{
+  {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    auto it = family.find(name);
+    if (it != family.end())
+    {
+      return *it->second;
+    }
+  }
+
+  std::unique_lock<std::shared_mutex> lock(mutex);
+  flx_string key = (limit && family.size() >= limit) ? flx_string("other") : name;
+  auto& slot = family[key];
+  if (!slot)
+  {
+    slot = std::make_unique<flx_metric>();
+  }
+  return *slot;
+}
+
+flx_metric& flx_metrics::route(const flx_string& name)
+{
+  return lookup(routes, name, max_routes);
+}
+
+flx_metric& flx_metrics::timer(const flx_string& name)
+{
+  return lookup(timers, name, 0);
+}
+
+std::atomic<uint64_t>& flx_metrics::counter(const flx_string& name)
+{
+  {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    auto it = counters.find(name);
+    if (it != counters.end())
+    {
+      return *it->second;
+    }
+  }
+
+  std::unique_lock<std::shared_mutex> lock(mutex);
+  auto& slot = counters[name];
+  if (!slot)
+  {
+    slot = std::make_unique<std::atomic<uint64_t>>(0);
+  }
+  return *slot;
+}
+
+void flx_metrics::reset()
+{
+  std::unique_lock<std::shared_mutex> lock(mutex);
+  routes.clear();
+  timers.clear();
+  counters.clear();
+}
+
+namespace {
+
+  flx_string escape_label(const flx_string& value)
+  {
+    flx_string out;
+    for (char c : value.to_std_const())
+    {
+      if (c == '\\' || c == '"')
+      {
+        out += '\\';
+        out += c;
+      }
+      else if (c == '\n')
+      {
+        out += "\\n";
+      }
+      else
+      {
+        out += c;
+      }
+    }
+    return out;
+  }
+
+  void write_family(std::ostringstream& out, const char* prefix, const char* label,
+                    const std::map<flx_string, std::unique_ptr<flx_metric>>& family, bool with_bytes)
+  {
+    if (family.empty())
+    {
+      return;
+    }
+
+    static const double quantiles[] = {0.5, 0.99, 0.999};
+
+    out << "# TYPE " << prefix << "_duration_seconds summary\n";
+    for (const auto& entry : family)
+    {
+      const flx_metric& m = *entry.second;
+      flx_string l = flx_string(label) + "=\"" + escape_label(entry.first) + "\"";
+      for (double q : quantiles)
+      {
+        out << prefix << "_duration_seconds{" << l.to_std_const() << ",quantile=\"" << q << "\"} "
+            << m.latency.percentile(q) / 1e6 << "\n";
+      }
+      out << prefix << "_duration_seconds_sum{" << l.to_std_const() << "} " << m.latency.sum() / 1e6 << "\n";
+      out << prefix << "_duration_seconds_count{" << l.to_std_const() << "} " << m.latency.count() << "\n";
+    }
+
+    out << "# TYPE " << prefix << "_calls_total counter\n";
+    for (const auto& entry : family)
+    {
+      out << prefix << "_calls_total{" << label << "=\"" << escape_label(entry.first).to_std_const() << "\"} "
+          << entry.second->calls.load(std::memory_order_relaxed) << "\n";
+    }
+
+    out << "# TYPE " << prefix << "_errors_total counter\n";
+    for (const auto& entry : family)
+    {
+      out << prefix << "_errors_total{" << label << "=\"" << escape_label(entry.first).to_std_const() << "\"} "
+          << entry.second->errors.load(std::memory_order_relaxed) << "\n";
+    }
+
+    out << "# TYPE " << prefix << "_in_flight gauge\n";
+    for (const auto& entry : family)
+    {
+      out << prefix << "_in_flight{" << label << "=\"" << escape_label(entry.first).to_std_const() << "\"} "
+          << entry.second->in_flight.load(std::memory_order_relaxed) << "\n";
+    }
+
+    if (!with_bytes)
+    {
+      return;
+    }
+
+    out << "# TYPE " << prefix << "_request_bytes_total counter\n";
+    for (const auto& entry : family)
+    {
+      out << prefix << "_request_bytes_total{" << label << "=\"" << escape_label(entry.first).to_std_const() << "\"} "
+          << entry.second->bytes_in.load(std::memory_order_relaxed) << "\n";
+    }
+
+    out << "# TYPE " << prefix << "_response_bytes_total counter\n";
+    for (const auto& entry : family)
+    {
+      out << prefix << "_response_bytes_total{" << label << "=\"" << escape_label(entry.first).to_std_const() << "\"} "
+          << entry.second->bytes_out.load(std::memory_order_relaxed) << "\n";
+    }
+  }
+
+} // namespace
+
+flx_string flx_metrics::to_prometheus() const
+{
+  std::shared_lock<std::shared_mutex> lock(mutex);
+  std::ostringstream out;
+  write_family(out, "flx_http_request", "route", routes, true);
+  write_family(out, "flx_timer", "name", timers, false);
+
+  if (!counters.empty())
+  {
+    out << "# TYPE flx_counter_total counter\n";
+    for (const auto& entry : counters)
+    {
+      out << "flx_counter_total{name=\"" << escape_label(entry.first).to_std_const() << "\"} "
+          << entry.second->load(std::memory_order_relaxed) << "\n";
+    }
+  }
+  return flx_string(out.str());
+}
@@ -0,0 +1,137 @@
+#ifndef FLX_METRICS_H
+#define FLX_METRICS_H
+
+#include "../../utils/flx_string.h"
+#include <atomic>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <shared_mutex>
+
+// ============================================================================
+// FLX METRICS - Lock-free counters and latency histograms
+// ============================================================================
+//
+// Process-wide instrumentation used by flx_http_daemon (per route) and by any
+// component that wants to time its own operations (db_repository, LLM client).
+//
+// Hot path (record/increment) only touches relaxed atomics. The registry map
+// is guarded by a shared_mutex and is only written when a new name appears.
+//
+// Usage:
+//   flx_metric& m = flx_metrics::instance().timer("db.create");
+//   {
+//     flx_scoped_timer t(m);
+//     ... work ...
+//   }
+//   flx_string text = flx_metrics::instance().to_prometheus();
+//
+// ============================================================================
+
+// HDR-style log-linear histogram over microseconds.
+// Values below 2^sub_bits are exact, above that every power of two is split
+// into 2^sub_bits linear sub-buckets (~6% relative error with 4 bits).
+class flx_latency_histogram
+{
+public:
+  static constexpr int sub_bits = 4;
+  static constexpr int sub_count = 1 << sub_bits;
+  static constexpr int max_magnitude = 40;  // 2^40 us ~ 12 days, larger values are clamped
+  static constexpr int bucket_count = (max_magnitude - sub_bits + 2) * sub_count;
+
+  flx_latency_histogram();
+
+  void record(uint64_t micros);
+  void reset();
+
+  uint64_t count() const;
+  uint64_t sum() const;
+  uint64_t max() const;
+
+  // Highest value equivalent to the bucket holding quantile q (0..1), in microseconds
+  uint64_t percentile(double q) const;
+
+  static int bucket_index(uint64_t micros);
+  static uint64_t bucket_lower_bound(int index);
+  static uint64_t bucket_upper_bound(int index);
+
+private:
+  std::array<std::atomic<uint64_t>, bucket_count> buckets;
+  std::atomic<uint64_t> total_count;
+  std::atomic<uint64_t> total_sum;
+  std::atomic<uint64_t> max_value;
+};
+
+// Counters for one route or one named timer
+class flx_metric
+{
+public:
+  std::atomic<uint64_t> calls{0};
+  std::atomic<uint64_t> errors{0};
+  std::atomic<int64_t> in_flight{0};
+  std::atomic<uint64_t> bytes_in{0};
+  std::atomic<uint64_t> bytes_out{0};
+  flx_latency_histogram latency;
+
+  void begin();
+  void end(std::chrono::steady_clock::duration elapsed, bool error = false);
+  // Hand a begun call over to other, e.g. once the route of a request is known
+  void move_to(flx_metric& other);
+  void add_bytes(uint64_t in, uint64_t out);
+};
+
+// RAII timer: begin() on construction, end() on destruction
+class flx_scoped_timer
+{
+  flx_metric& metric;
+  std::chrono::steady_clock::time_point start;
+  bool failed;
+
+public:
+  explicit flx_scoped_timer(flx_metric& m);
+  ~flx_scoped_timer();
+
+  flx_scoped_timer(const flx_scoped_timer&) = delete;
+  flx_scoped_timer& operator=(const flx_scoped_timer&) = delete;
+
+  // Mark the timed operation as failed (counted in errors)
+  void fail();
+};
+
+class flx_metrics
+{
+public:
+  // Routes beyond this limit are folded into "other" to bound label cardinality
+  static constexpr size_t max_routes = 256;
+
+  static flx_metrics& instance();
+
+  // Per-route HTTP metrics, key is a route pattern, e.g. "GET /api/docs/:id"
+  flx_metric& route(const flx_string& name);
+
+  // Named timer for internal operations, e.g. "db.search", "llm.embedding"
+  flx_metric& timer(const flx_string& name);
+
+  // Named event counter, e.g. "embedding_cache.hit" / "embedding_cache.miss"
+  std::atomic<uint64_t>& counter(const flx_string& name);
+
+  // Prometheus text exposition format (version 0.0.4)
+  flx_string to_prometheus() const;
+
+  // Drop all registered metrics (tests only - invalidates references)
+  void reset();
+
+private:
+  flx_metrics() = default;
+
+  flx_metric& lookup(std::map<flx_string, std::unique_ptr<flx_metric>>& family, const flx_string& name, size_t limit);
+
+  mutable std::shared_mutex mutex;
+  std::map<flx_string, std::unique_ptr<flx_metric>> routes;
+  std::map<flx_string, std::unique_ptr<flx_metric>> timers;
+  std::map<flx_string, std::unique_ptr<std::atomic<uint64_t>>> counters;
+};
+
+#endif // FLX_METRICS_H
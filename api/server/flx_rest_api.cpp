@@ -1,4 +1,33 @@
 #include "flx_rest_api.h"
+#include <cctype>
+
+namespace
+{
+  // Path with id segments (numbers, hashes, UUIDs) replaced by ":id", so that
+  // "/api/docs/42" and "/api/docs/43" share one metrics label
+  flx_string route_pattern(const flx_string& method, const flx_string& path)
+  {
+    std::string pattern;
+    const std::string& raw = path.to_std_const();
+    size_t pos = 0;
+    while (pos < raw.size())
+    {
+      size_t next = raw.find('/', pos + 1);
+      std::string segment = raw.substr(pos, next == std::string::npos ? std::string::npos : next - pos);
+      bool digits = segment.size() > 1;
+      bool hex = segment.size() >= 17;
+      for (size_t i = 1; i < segment.size(); ++i)
+      {
+        unsigned char c = static_cast<unsigned char>(segment[i]);
+        digits = digits && std::isdigit(c);
+        hex = hex && (std::isxdigit(c) || c == '-');
+      }
+      pattern += (digits || hex) ? std::string("/:id") : segment;
+      pos = next == std::string::npos ? raw.size() : next;
+    }
+    return method + " " + flx_string(pattern.empty() ? std::string("/") : pattern);
+  }
+}
 
 flx_http_daemon::response flx_rest_api::handle(flx_http_daemon::request req)
 {
@@ -16,6 +45,7 @@ flx_http_daemon::response flx_rest_api::handle(flx_http_daemon::request req)
     r.headers["Access-Control-Allow-Headers"] = "Content-Type, Authorization";
     r.headers["Access-Control-Allow-Methods"] = "GET, POST, OPTIONS";
     r.statuscode = 204;
+    r.route = route_pattern(req.method, req.path);
   }
   return r;
 }
@@ -31,5 +61,6 @@ flx_http_daemon::response flx_rest_api::dispatch(request req)
     token = t[1];
   }
   r.statuscode = 200;
+  r.route = route_pattern(req.method, req.path);
   return r;
 }
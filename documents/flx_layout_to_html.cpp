@@ -4,6 +4,11 @@
 #include <map>
 #include <cmath>
 
+namespace {
+  // Slack for rounding when testing whether one geometry lies inside another
+  const double containment_tolerance = 0.1;
+}
+
 flx_layout_to_html::flx_layout_to_html() {
 }
 
@@ -34,70 +39,61 @@ std::shared_ptr<flx_layout_to_html::layout_node> flx_layout_to_html::build_spati
   std::vector<bool> used(sub_geos.size(), false);
 
   // Recursively build hierarchy
-  find_children_recursive(page, sub_geos, used, root);
+  flx_layout_index index = flx_layout_index::from_list(sub_geos);
+  find_children_recursive(flx_layout_index::bounds_of(page), sub_geos, index, used, root);
 
   return root;
 }
 
-void flx_layout_to_html::find_children_recursive(flx_layout_geometry& parent,
+void flx_layout_to_html::find_children_recursive(const flx_layout_index::box& parent,
                                                   flx_model_list<flx_layout_geometry>& candidates,
+                                                  const flx_layout_index& index,
                                                   std::vector<bool>& used,
                                                   std::shared_ptr<layout_node> parent_node) {
   // Find all candidates that are directly contained in parent
-  for (size_t i = 0; i < candidates.size(); ++i) {
+  std::vector<size_t> inside;
+  index.query_contained_in(parent, inside, containment_tolerance);
+
+  std::vector<size_t> covering;
+  for (size_t i : inside) {
     if (used[i]) continue;
 
-    auto& candidate = candidates[i];
-
-    // Check if candidate is contained in parent
-    if (is_contained_in(candidate, parent)) {
-      // Check if it's contained in any sibling (deeper nesting)
-      bool contained_in_sibling = false;
-      for (size_t j = 0; j < candidates.size(); ++j) {
-        if (i == j || used[j]) continue;
-
-        // If candidate is inside another candidate that's also inside parent,
-        // then it should be child of that candidate, not of parent
-        if (is_contained_in(candidate, candidates[j]) &&
-            is_contained_in(candidates[j], parent)) {
-          contained_in_sibling = true;
-          break;
-        }
+    // Check if it's contained in any sibling (deeper nesting)
+    const auto& candidate = index.item(i);
+    index.query_containing(candidate, covering, containment_tolerance);
+    bool contained_in_sibling = false;
+    for (size_t j : covering) {
+      if (i == j || used[j]) continue;
+
+      // If candidate is inside another candidate that's also inside parent,
+      // then it should be child of that candidate, not of parent
+      if (is_contained_in(index.item(j), parent)) {
+        contained_in_sibling = true;
+        break;
       }
+    }
 
-      // Only add as direct child if not contained in sibling
-      if (!contained_in_sibling) {
-        auto child_node = std::make_shared<layout_node>();
-        child_node->geometry = &candidate;
-        child_node->is_root = false;
+    // Only add as direct child if not contained in sibling
+    if (!contained_in_sibling) {
+      auto child_node = std::make_shared<layout_node>();
+      child_node->geometry = &candidates[i];
+      child_node->is_root = false;
 
-        parent_node->children.push_back(child_node);
-        used[i] = true;
+      parent_node->children.push_back(child_node);
+      used[i] = true;
 
-        // Recursively find children of this child
-        find_children_recursive(candidate, candidates, used, child_node);
-      }
+      // Recursively find children of this child
+      find_children_recursive(candidate, candidates, index, used, child_node);
     }
   }
 }
 
-bool flx_layout_to_html::is_contained_in(flx_layout_geometry& inner, flx_layout_geometry& outer) {
-  double inner_left = inner.x;
-  double inner_top = inner.y;
-  double inner_right = inner.x + inner.width;
-  double inner_bottom = inner.y + inner.height;
-
-  double outer_left = outer.x;
-  double outer_top = outer.y;
-  double outer_right = outer.x + outer.width;
-  double outer_bottom = outer.y + outer.height;
-
+bool flx_layout_to_html::is_contained_in(const flx_layout_index::box& inner, const flx_layout_index::box& outer) {
   // Inner must be completely within outer (with small tolerance for rounding)
-  const double tolerance = 0.1;
-  return (inner_left >= outer_left - tolerance &&
-          inner_top >= outer_top - tolerance &&
-          inner_right <= outer_right + tolerance &&
-          inner_bottom <= outer_bottom + tolerance);
+  return (inner.left >= outer.left - containment_tolerance &&
+          inner.top >= outer.top - containment_tolerance &&
+          inner.right <= outer.right + containment_tolerance &&
+          inner.bottom <= outer.bottom + containment_tolerance);
 }
 
 // ============================================================================
@@ -3,6 +3,7 @@
 
 #include "../utils/flx_string.h"
 #include "layout/flx_layout_geometry.h"
+#include "layout/flx_layout_index.h"
 #include <vector>
 #include <memory>
 
@@ -25,11 +26,12 @@ private:
   };
 
   std::shared_ptr<layout_node> build_spatial_tree(flx_layout_geometry& page);
-  void find_children_recursive(flx_layout_geometry& parent,
+  void find_children_recursive(const flx_layout_index::box& parent,
                                flx_model_list<flx_layout_geometry>& candidates,
+                               const flx_layout_index& index,
                                std::vector<bool>& used,
                                std::shared_ptr<layout_node> parent_node);
-  bool is_contained_in(flx_layout_geometry& inner, flx_layout_geometry& outer);
+  bool is_contained_in(const flx_layout_index::box& inner, const flx_layout_index::box& outer);
 
   // HTML generation
   flx_string generate_html_with_boilerplate(flx_layout_geometry& page,
@@ -0,0 +1,158 @@
+#include "flx_layout_index.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+  using box = flx_layout_index::box;
+
+  bool intersects(const box& a, const box& b) {
+    return !(a.right < b.left || a.left > b.right || a.bottom < b.top || a.top > b.bottom);
+  }
+
+  bool contains(const box& outer, const box& inner, double tolerance) {
+    return inner.left >= outer.left - tolerance &&
+           inner.top >= outer.top - tolerance &&
+           inner.right <= outer.right + tolerance &&
+           inner.bottom <= outer.bottom + tolerance;
+  }
+
+  void extend(box& target, const box& other) {
+    target.left = std::min(target.left, other.left);
+    target.top = std::min(target.top, other.top);
+    target.right = std::max(target.right, other.right);
+    target.bottom = std::max(target.bottom, other.bottom);
+  }
+
+  double center_x(const box& b) { return b.left + b.right; }
+  double center_y(const box& b) { return b.top + b.bottom; }
+
+}
+
+flx_layout_index::box flx_layout_index::bounds_of(const flx_layout_bounds& bounds) {
+  double x = bounds.x;
+  double y = bounds.y;
+  double width = bounds.width;
+  double height = bounds.height;
+  return {x, y, x + width, y + height};
+}
+
+flx_layout_index::flx_layout_index() {
+}
+
+flx_layout_index::flx_layout_index(const std::vector<box>& boxes, size_t node_size) {
+  build(boxes, node_size);
+}
+
+void flx_layout_index::build(const std::vector<box>& boxes, size_t node_size) {
+  node_size = std::max<size_t>(node_size, 2);
+  m_item_count = boxes.size();
+  m_items = boxes;
+  m_nodes.clear();
+  if (boxes.empty()) {
+    return;
+  }
+
+  std::vector<node> level;
+  level.reserve(boxes.size());
+  for (size_t i = 0; i < boxes.size(); ++i) {
+    level.push_back({boxes[i], i, 0});
+  }
+
+  // Each pass tiles one level: sort by x into vertical slices of
+  // slice_count * node_size entries, sort every slice by y and pack runs of
+  // node_size into parents. The level is stored in its tiled order, so the
+  // children of a parent are contiguous.
+  while (true) {
+    size_t offset = m_nodes.size();
+    size_t parent_count = (level.size() + node_size - 1) / node_size;
+    size_t slice_count = static_cast<size_t>(std::ceil(std::sqrt(static_cast<double>(parent_count))));
+    size_t slice_size = slice_count * node_size;
+
+    std::sort(level.begin(), level.end(), [](const node& a, const node& b) {
+      return center_x(a.bounds) < center_x(b.bounds);
+    });
+    for (size_t begin = 0; begin < level.size(); begin += slice_size) {
+      auto end = level.begin() + std::min(begin + slice_size, level.size());
+      std::sort(level.begin() + begin, end, [](const node& a, const node& b) {
+        return center_y(a.bounds) < center_y(b.bounds);
+      });
+    }
+
+    m_nodes.insert(m_nodes.end(), level.begin(), level.end());
+    if (level.size() == 1) {
+      break;
+    }
+
+    std::vector<node> parents;
+    parents.reserve(parent_count);
+    for (size_t begin = 0; begin < level.size(); begin += node_size) {
+      size_t end = std::min(begin + node_size, level.size());
+      node parent{level[begin].bounds, offset + begin, end - begin};
+      for (size_t i = begin + 1; i < end; ++i) {
+        extend(parent.bounds, level[i].bounds);
+      }
+      parents.push_back(parent);
+    }
+    level.swap(parents);
+  }
+}
+
+void flx_layout_index::query_intersects(const box& area, std::vector<size_t>& ids) const {
+  query(area, mode::intersects, 0.0, ids);
+}
+
+void flx_layout_index::query_contained_in(const box& area, std::vector<size_t>& ids, double tolerance) const {
+  query(area, mode::contained_in, tolerance, ids);
+}
+
+void flx_layout_index::query_containing(const box& area, std::vector<size_t>& ids, double tolerance) const {
+  query(area, mode::containing, tolerance, ids);
+}
+
+void flx_layout_index::query_point(double x, double y, std::vector<size_t>& ids) const {
+  query({x, y, x, y}, mode::containing, 0.0, ids);
+}
+
+void flx_layout_index::query(const box& area, mode how, double tolerance, std::vector<size_t>& ids) const {
+  ids.clear();
+  if (m_nodes.empty()) {
+    return;
+  }
+
+  // contained_in: an item inside the widened area overlaps it, and so does
+  // every node above the item. containing: a node covers all its items, so
+  // a node that does not cover the area holds no match either.
+  box widened{area.left - tolerance, area.top - tolerance, area.right + tolerance, area.bottom + tolerance};
+  auto visit = [&](const node& n) {
+    switch (how) {
+      case mode::intersects:
+        return intersects(n.bounds, area);
+      case mode::contained_in:
+        return intersects(n.bounds, widened);
+      case mode::containing:
+        return contains(n.bounds, area, tolerance);
+    }
+    return false;
+  };
+
+  std::vector<size_t> stack;
+  stack.push_back(m_nodes.size() - 1);
+  while (!stack.empty()) {
+    const node& n = m_nodes[stack.back()];
+    stack.pop_back();
+    if (!visit(n)) {
+      continue;
+    }
+    if (n.count == 0) {
+      if (how != mode::contained_in || contains(widened, n.bounds, 0.0)) {
+        ids.push_back(n.first);
+      }
+      continue;
+    }
+    for (size_t i = 0; i < n.count; ++i) {
+      stack.push_back(n.first + i);
+    }
+  }
+  std::sort(ids.begin(), ids.end());
+}
@@ -0,0 +1,73 @@
+#ifndef FLX_LAYOUT_INDEX_H
+#define FLX_LAYOUT_INDEX_H
+
+#include "flx_layout_bounds.h"
+#include <cstddef>
+#include <vector>
+
+/*
+ * Static spatial index over layout rectangles: a packed R-tree bulk-loaded
+ * with Sort-Tile-Recursive (STR) on every level. Items are identified by
+ * their position in the list passed to build(); queries return ids in
+ * ascending order, so a "first match" in list order is the first result.
+ *
+ * The boxes are copied out of the models once, queries never touch the
+ * flx_model properties.
+ */
+class flx_layout_index
+{
+public:
+  struct box {
+    double left;
+    double top;
+    double right;
+    double bottom;
+  };
+
+  static box bounds_of(const flx_layout_bounds& bounds);
+
+  flx_layout_index();
+  explicit flx_layout_index(const std::vector<box>& boxes, size_t node_size = 16);
+
+  template<typename T>
+  static flx_layout_index from_list(flx_model_list<T>& list, size_t node_size = 16) {
+    std::vector<box> boxes;
+    boxes.reserve(list.size());
+    for (size_t i = 0; i < list.size(); ++i) {
+      boxes.push_back(bounds_of(list[i]));
+    }
+    return flx_layout_index(boxes, node_size);
+  }
+
+  void build(const std::vector<box>& boxes, size_t node_size = 16);
+
+  size_t size() const { return m_item_count; }
+  bool empty() const { return m_item_count == 0; }
+  const box& item(size_t id) const { return m_items[id]; }
+
+  // Items overlapping area (touching edges count)
+  void query_intersects(const box& area, std::vector<size_t>& ids) const;
+  // Items lying completely inside area, widened by tolerance on every side
+  void query_contained_in(const box& area, std::vector<size_t>& ids, double tolerance = 0.0) const;
+  // Items completely covering area, each item widened by tolerance on every side
+  void query_containing(const box& area, std::vector<size_t>& ids, double tolerance = 0.0) const;
+  // Items containing the point (edges included)
+  void query_point(double x, double y, std::vector<size_t>& ids) const;
+
+private:
+  enum class mode { intersects, contained_in, containing };
+
+  struct node {
+    box bounds;
+    size_t first;  // item id for leaves, else index of the first child
+    size_t count;  // number of children, 0 for leaves
+  };
+
+  void query(const box& area, mode how, double tolerance, std::vector<size_t>& ids) const;
+
+  size_t m_item_count = 0;
+  std::vector<box> m_items;   // input boxes by id
+  std::vector<node> m_nodes;  // all levels, leaves first, root last
+};
+
+#endif // FLX_LAYOUT_INDEX_H
@@ -0,0 +1,502 @@
+#include "flx_pdf_content.h"
+#include <algorithm>
+
+namespace {
+
+  bool is_whitespace(char c) {
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == '\f' || c == '\0';
+  }
+
+  bool is_delimiter(char c) {
+    return c == '(' || c == ')' || c == '<' || c == '>' || c == '[' || c == ']' ||
+           c == '{' || c == '}' || c == '/' || c == '%';
+  }
+
+  bool is_regular(char c) {
+    return !is_whitespace(c) && !is_delimiter(c);
+  }
+
+  // PDF numbers: optional sign, digits, optional point, digits (no exponent)
+  bool parse_number(std::string_view text, double& value) {
+    size_t i = 0;
+    bool negative = false;
+    if (i < text.size() && (text[i] == '+' || text[i] == '-')) {
+      negative = text[i] == '-';
+      ++i;
+    }
+    double result = 0.0;
+    bool digits = false;
+    while (i < text.size() && text[i] >= '0' && text[i] <= '9') {
+      result = result * 10.0 + (text[i] - '0');
+      digits = true;
+      ++i;
+    }
+    if (i < text.size() && text[i] == '.') {
+      ++i;
+      double scale = 0.1;
+      while (i < text.size() && text[i] >= '0' && text[i] <= '9') {
+        result += (text[i] - '0') * scale;
+        scale *= 0.1;
+        digits = true;
+        ++i;
+      }
+    }
+    if (!digits || i != text.size()) {
+      return false;
+    }
+    value = negative ? -result : result;
+    return true;
+  }
+
+}
+
+// --- flx_pdf_content_lexer ---
+
+flx_pdf_content_lexer::flx_pdf_content_lexer(std::string_view data)
+  : m_data(data)
+{
+}
+
+bool flx_pdf_content_lexer::next(token& t) {
+  const size_t n = m_data.size();
+
+  // Whitespace and comments
+  while (m_pos < n) {
+    char c = m_data[m_pos];
+    if (is_whitespace(c)) {
+      ++m_pos;
+    } else if (c == '%') {
+      while (m_pos < n && m_data[m_pos] != '\n' && m_data[m_pos] != '\r') ++m_pos;
+    } else {
+      break;
+    }
+  }
+  if (m_pos >= n) {
+    return false;
+  }
+
+  const size_t start = m_pos;
+  const char c = m_data[m_pos];
+  t.offset = start;
+  t.number = 0.0;
+
+  switch (c) {
+    case '(': {
+      // Literal string: balanced parentheses, backslash escapes
+      int depth = 0;
+      while (m_pos < n) {
+        char s = m_data[m_pos++];
+        if (s == '\\') {
+          ++m_pos;
+        } else if (s == '(') {
+          ++depth;
+        } else if (s == ')' && --depth == 0) {
+          break;
+        }
+      }
+      m_pos = std::min(m_pos, n);
+      t.type = token_type::string;
+      break;
+    }
+    case '<':
+      if (m_pos + 1 < n && m_data[m_pos + 1] == '<') {
+        m_pos += 2;
+        t.type = token_type::dict_begin;
+      } else {
+        size_t close = m_data.find('>', m_pos + 1);
+        m_pos = close == std::string_view::npos ? n : close + 1;
+        t.type = token_type::hex_string;
+      }
+      break;
+    case '>':
+      if (m_pos + 1 < n && m_data[m_pos + 1] == '>') {
+        m_pos += 2;
+        t.type = token_type::dict_end;
+      } else {
+        ++m_pos;
+        t.type = token_type::op;  // stray delimiter, reported as an unknown operator
+      }
+      break;
+    case '[':
+    case '{':
+      ++m_pos;
+      t.type = token_type::array_begin;
+      break;
+    case ']':
+    case '}':
+      ++m_pos;
+      t.type = token_type::array_end;
+      break;
+    case ')':
+      ++m_pos;
+      t.type = token_type::op;
+      break;
+    case '/':
+      ++m_pos;
+      while (m_pos < n && is_regular(m_data[m_pos])) ++m_pos;
+      t.type = token_type::name;
+      t.text = m_data.substr(start + 1, m_pos - start - 1);
+      return true;
+    default: {
+      while (m_pos < n && is_regular(m_data[m_pos])) ++m_pos;
+      std::string_view word = m_data.substr(start, m_pos - start);
+      if (parse_number(word, t.number)) {
+        t.type = token_type::number;
+      } else if (word == "true" || word == "false" || word == "null") {
+        t.type = token_type::keyword;
+      } else {
+        t.type = token_type::op;
+      }
+      break;
+    }
+  }
+
+  t.text = m_data.substr(start, m_pos - start);
+  return true;
+}
+
+bool flx_pdf_content_lexer::skip_inline_image_data() {
+  const size_t n = m_data.size();
+  // One whitespace byte separates ID from the data
+  if (m_pos < n && is_whitespace(m_data[m_pos])) ++m_pos;
+  // EI preceded by whitespace and followed by whitespace or the end
+  size_t search = m_pos;
+  while (true) {
+    size_t found = m_data.find("EI", search);
+    if (found == std::string_view::npos) {
+      m_pos = n;
+      return false;
+    }
+    bool before = found > m_pos && is_whitespace(m_data[found - 1]);
+    bool after = found + 2 >= n || is_whitespace(m_data[found + 2]);
+    if (before && after) {
+      m_pos = found + 2;
+      return true;
+    }
+    search = found + 1;
+  }
+}
+
+// --- flx_pdf_content_scanner ---
+
+flx_pdf_content_scanner::flx_pdf_content_scanner(std::string_view content)
+  : m_lexer(content)
+{
+  m_operands.reserve(64);
+}
+
+bool flx_pdf_content_scanner::instruction::numbers(double* out, size_t count) const {
+  if (operand_count() < count) {
+    return false;
+  }
+  size_t first = operands->size() - count;
+  for (size_t i = 0; i < count; ++i) {
+    const auto& operand = (*operands)[first + i];
+    if (operand.type != flx_pdf_content_lexer::token_type::number) {
+      return false;
+    }
+    out[i] = operand.number;
+  }
+  return true;
+}
+
+bool flx_pdf_content_scanner::next(instruction& out) {
+  m_operands.clear();
+  flx_pdf_content_lexer::token t;
+  bool have_begin = false;
+  size_t begin = 0;
+
+  while (m_lexer.next(t)) {
+    if (!have_begin) {
+      begin = t.offset;
+      have_begin = true;
+    }
+    if (t.type != flx_pdf_content_lexer::token_type::op) {
+      m_operands.push_back(t);
+      continue;
+    }
+
+    out.op = t.text;
+    out.operands = &m_operands;
+    out.begin = begin;
+
+    if (t.text == "BI") {
+      // Inline image dictionary up to ID, then raw data up to EI
+      flx_pdf_content_lexer::token inner;
+      while (m_lexer.next(inner)) {
+        if (inner.type == flx_pdf_content_lexer::token_type::op && inner.text == "ID") {
+          m_lexer.skip_inline_image_data();
+          break;
+        }
+      }
+      m_operands.clear();
+      out.end = m_lexer.position();
+      return true;
+    }
+
+    out.end = t.offset + t.text.size();
+    return true;
+  }
+  return false;  // trailing operands without an operator are dropped
+}
+
+// --- flx_content ---
+
+namespace {
+
+  struct color_state {
+    double fill[3] = {0.0, 0.0, 0.0};
+    double stroke[3] = {0.0, 0.0, 0.0};
+  };
+
+  // Current path: every m and re starts a subpath, painting operators and n
+  // end the whole path (ISO 32000 8.5.2)
+  struct path_state {
+    using subpath = std::vector<std::pair<double, double>>;
+    std::vector<subpath> subpaths;
+    double x = 0.0;
+    double y = 0.0;
+
+    void move_to(double px, double py) {
+      subpaths.emplace_back();
+      subpaths.back().push_back({px, py});
+      x = px;
+      y = py;
+    }
+
+    void line_to(double px, double py) {
+      if (subpaths.empty()) {
+        subpaths.emplace_back();  // no current point: start here
+      }
+      subpaths.back().push_back({px, py});
+      x = px;
+      y = py;
+    }
+
+    void clear() { subpaths.clear(); }
+  };
+
+  void cmyk_to_rgb(const double cmyk[4], double rgb[3]) {
+    for (int i = 0; i < 3; ++i) {
+      rgb[i] = (1.0 - cmyk[i]) * (1.0 - cmyk[3]);
+    }
+  }
+
+  std::string hex_color(const double rgb[3]) {
+    static const char digits[] = "0123456789abcdef";
+    std::string hex = "#";
+    for (int i = 0; i < 3; ++i) {
+      int v = static_cast<int>(rgb[i] * 255);
+      v = std::max(0, std::min(255, v));
+      hex.push_back(digits[v >> 4]);
+      hex.push_back(digits[v & 15]);
+    }
+    return hex;
+  }
+
+  // One geometry per subpath, e.g. for several rectangles filled at once
+  void emit_geometry(const path_state& path, const double rgb[3], bool fill,
+                     flx_model_list<flx_layout_geometry>& geometries) {
+    for (const auto& subpath : path.subpaths) {
+      if (subpath.empty()) continue;
+      geometries.add_element();
+      auto& geom = geometries.back();
+      for (const auto& point : subpath) {
+        geom.vertices.add_element();
+        auto& vertex = geom.vertices.back();
+        vertex.x = point.first;
+        vertex.y = point.second;
+      }
+      if (fill) {
+        geom.fill_color = hex_color(rgb);
+      } else {
+        geom.stroke_color = hex_color(rgb);
+      }
+    }
+  }
+
+  void close_path(path_state& path) {
+    if (path.subpaths.empty() || path.subpaths.back().empty()) return;
+    auto& current = path.subpaths.back();
+    const auto first = current.front();
+    if (path.x != first.first || path.y != first.second) {
+      current.push_back(first);
+    }
+    path.x = first.first;
+    path.y = first.second;
+  }
+
+  // Text state, positioning and showing operators (ISO 32000 9.3, 9.4)
+  bool is_text_operator(std::string_view op) {
+    if (op.empty()) return false;
+    if (op == "'" || op == "\"") return true;
+    if (op.size() == 2 && op[0] == 'T') {
+      switch (op[1]) {
+        case 'f': case 'c': case 'w': case 'z': case 'L': case 'r': case 's':
+        case 'm': case 'd': case 'D': case '*': case 'j': case 'J':
+          return true;
+        default:
+          return false;
+      }
+    }
+    return false;
+  }
+
+}
+
+namespace flx_content {
+
+  void process_page_content(std::string_view content,
+                            flx_model_list<flx_layout_geometry>* geometries,
+                            std::string* filtered) {
+    flx_pdf_content_scanner scanner(content);
+    flx_pdf_content_scanner::instruction ins;
+
+    color_state colors;
+    std::vector<color_state> saved;
+    path_state path;
+    bool in_text = false;
+    double v[6];
+
+    if (filtered) {
+      filtered->clear();
+      filtered->reserve(content.size());
+    }
+
+    while (scanner.next(ins)) {
+      const std::string_view op = ins.op;
+
+      // --- Text and image removal ---
+      if (filtered) {
+        bool drop = in_text || op == "BT" || op == "ET" || op == "Do" || op == "BI" || is_text_operator(op);
+        if (!drop) {
+          filtered->append(content.data() + ins.begin, ins.end - ins.begin);
+          filtered->push_back('\n');
+        }
+      }
+      if (op == "BT") {
+        in_text = true;
+        continue;
+      }
+      if (op == "ET") {
+        in_text = false;
+        continue;
+      }
+      if (!geometries || in_text) {
+        continue;
+      }
+
+      // --- Geometry extraction ---
+      if (op.size() == 1) {
+        switch (op[0]) {
+          case 'q':
+            saved.push_back(colors);
+            break;
+          case 'Q':
+            if (!saved.empty()) {
+              colors = saved.back();
+              saved.pop_back();
+            }
+            break;
+          case 'm':
+            if (ins.numbers(v, 2)) {
+              path.move_to(v[0], v[1]);
+            }
+            break;
+          case 'l':
+            if (ins.numbers(v, 2)) {
+              path.line_to(v[0], v[1]);
+            }
+            break;
+          case 'c':
+            // Bezier curves are approximated by their end point
+            if (ins.numbers(v, 6)) {
+              path.line_to(v[4], v[5]);
+            }
+            break;
+          case 'v':
+          case 'y':
+            if (ins.numbers(v, 4)) {
+              path.line_to(v[2], v[3]);
+            }
+            break;
+          case 'h':
+            close_path(path);
+            break;
+          case 'g':
+            if (ins.numbers(v, 1)) {
+              colors.fill[0] = colors.fill[1] = colors.fill[2] = v[0];
+            }
+            break;
+          case 'G':
+            if (ins.numbers(v, 1)) {
+              colors.stroke[0] = colors.stroke[1] = colors.stroke[2] = v[0];
+            }
+            break;
+          case 'k':
+            if (ins.numbers(v, 4)) cmyk_to_rgb(v, colors.fill);
+            break;
+          case 'K':
+            if (ins.numbers(v, 4)) cmyk_to_rgb(v, colors.stroke);
+            break;
+          case 'f':
+          case 'F':
+            emit_geometry(path, colors.fill, true, *geometries);
+            path.clear();
+            break;
+          case 'S':
+            emit_geometry(path, colors.stroke, false, *geometries);
+            path.clear();
+            break;
+          case 's':
+            close_path(path);
+            emit_geometry(path, colors.stroke, false, *geometries);
+            path.clear();
+            break;
+          case 'B':
+            emit_geometry(path, colors.fill, true, *geometries);
+            emit_geometry(path, colors.stroke, false, *geometries);
+            path.clear();
+            break;
+          case 'b':
+            close_path(path);
+            emit_geometry(path, colors.fill, true, *geometries);
+            emit_geometry(path, colors.stroke, false, *geometries);
+            path.clear();
+            break;
+          case 'n':
+            path.clear();
+            break;
+          default:
+            break;
+        }
+      } else if (op == "re") {
+        // A closed subpath of its own; the current point ends at its origin
+        if (ins.numbers(v, 4)) {
+          path.move_to(v[0], v[1]);
+          path.line_to(v[0] + v[2], v[1]);
+          path.line_to(v[0] + v[2], v[1] + v[3]);
+          path.line_to(v[0], v[1] + v[3]);
+          path.line_to(v[0], v[1]);
+        }
+      } else if (op == "rg") {
+        if (ins.numbers(v, 3)) std::copy(v, v + 3, colors.fill);
+      } else if (op == "RG") {
+        if (ins.numbers(v, 3)) std::copy(v, v + 3, colors.stroke);
+      } else if (op == "f*") {
+        emit_geometry(path, colors.fill, true, *geometries);
+        path.clear();
+      } else if (op == "B*") {
+        emit_geometry(path, colors.fill, true, *geometries);
+        emit_geometry(path, colors.stroke, false, *geometries);
+        path.clear();
+      } else if (op == "b*") {
+        close_path(path);
+        emit_geometry(path, colors.fill, true, *geometries);
+        emit_geometry(path, colors.stroke, false, *geometries);
+        path.clear();
+      }
+    }
+  }
+
+}
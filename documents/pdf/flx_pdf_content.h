@@ -0,0 +1,95 @@
+#ifndef FLX_PDF_CONTENT_H
+#define FLX_PDF_CONTENT_H
+
+#include "../layout/flx_layout_geometry.h"
+#include <string>
+#include <string_view>
+#include <vector>
+
+/*
+ * Zero-copy lexer over a decoded PDF content stream (ISO 32000 7.2 / 7.8).
+ * Tokens are string_views into the stream, numbers are parsed in place
+ * (locale independent), comments are skipped.
+ */
+class flx_pdf_content_lexer
+{
+public:
+  enum class token_type {
+    number,
+    name,         // /Name, text without the slash
+    string,       // (literal), text with parentheses
+    hex_string,   // <hex>, text with angle brackets
+    keyword,      // true, false, null
+    array_begin,  // [ or {
+    array_end,    // ] or }
+    dict_begin,   // <<
+    dict_end,     // >>
+    op            // any other regular token: an operator
+  };
+
+  struct token {
+    token_type type = token_type::op;
+    std::string_view text;
+    double number = 0.0;
+    size_t offset = 0;  // byte offset of the first character
+  };
+
+  explicit flx_pdf_content_lexer(std::string_view data);
+
+  bool next(token& t);
+  // After an ID operator: skips the inline image data up to and including EI
+  bool skip_inline_image_data();
+
+  size_t position() const { return m_pos; }
+
+private:
+  std::string_view m_data;
+  size_t m_pos = 0;
+};
+
+/*
+ * Groups tokens into instructions (operands + operator) on a reused operand
+ * stack, in the style of PoDoFo's PdfContentStreamReader but without any
+ * allocation per token. Inline images (BI ... ID <data> EI) come out as a
+ * single BI instruction.
+ */
+class flx_pdf_content_scanner
+{
+public:
+  struct instruction {
+    std::string_view op;
+    const std::vector<flx_pdf_content_lexer::token>* operands = nullptr;
+    size_t begin = 0;  // byte range of operands and operator
+    size_t end = 0;
+
+    size_t operand_count() const { return operands ? operands->size() : 0; }
+    // Last count operands as numbers; false if there are fewer or one is not a number
+    bool numbers(double* out, size_t count) const;
+  };
+
+  explicit flx_pdf_content_scanner(std::string_view content);
+
+  bool next(instruction& out);
+
+private:
+  flx_pdf_content_lexer m_lexer;
+  std::vector<flx_pdf_content_lexer::token> m_operands;
+};
+
+namespace flx_content {
+
+  /*
+   * One pass over a page content stream.
+   * geometries (optional): filled and stroked paths as geometries, with
+   *   fill/stroke colour from rg/RG, g/G and k/K; q/Q save and restore colours.
+   * filtered (optional): the stream without text objects (BT...ET), text
+   *   state operators, XObjects (Do) and inline images; all other
+   *   instructions are copied verbatim, one per line.
+   */
+  void process_page_content(std::string_view content,
+                            flx_model_list<flx_layout_geometry>* geometries,
+                            std::string* filtered);
+
+}
+
+#endif // FLX_PDF_CONTENT_H
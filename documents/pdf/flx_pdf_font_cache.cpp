@@ -0,0 +1,170 @@
+#include "flx_pdf_font_cache.h"
+#include <main/PdfEncoding.h>
+#include <main/PdfEncodingMap.h>
+#include <mutex>
+
+using namespace PoDoFo;
+
+flx_pdf_font_cache::font_entry::font_entry(const PdfFont& font)
+  : m_font(font) {
+  try {
+    m_family = std::string(font.GetName());
+    size_t plus_pos = m_family.find('+');
+    if (plus_pos != std::string::npos) {
+      m_family = m_family.substr(plus_pos + 1);
+    }
+  } catch (const std::exception&) {
+    m_family.clear();
+  }
+
+  // Non-CMap encodings of code size 1 consume exactly one byte per code, so
+  // every possible code can be resolved right away
+  const PdfEncodingMap& map = font.GetEncoding().GetEncodingMap();
+  m_single_byte = map.GetType() != PdfEncodingMapType::CMap && map.GetLimits().MaxCodeSize == 1;
+  if (m_single_byte) {
+    for (int code = 0; code < 256; ++code) {
+      char byte = static_cast<char>(code);
+      m_byte_glyphs[static_cast<size_t>(code)] = resolve(std::string_view(&byte, 1));
+    }
+  }
+}
+
+flx_pdf_font_cache::font_entry::glyph flx_pdf_font_cache::font_entry::resolve(std::string_view code) const {
+  // A unit text state makes the scanned length the raw glyph width
+  PdfTextState unit;
+  unit.Font = &m_font;
+  unit.FontSize = 1.0;
+  unit.FontScale = 1.0;
+  unit.CharSpacing = 0.0;
+
+  glyph g;
+  std::vector<double> lengths;
+  std::vector<unsigned> positions;
+  PdfString encoded = PdfString::FromRaw(bufferview(code.data(), code.size()));
+  g.valid = m_font.TryScanEncodedString(encoded, unit, g.text, lengths, positions);
+  if (lengths.size() == 1) {
+    g.width = lengths[0];
+  } else {
+    g.valid = false;
+  }
+  return g;
+}
+
+const flx_pdf_font_cache::font_entry::glyph& flx_pdf_font_cache::font_entry::code_glyph(std::string_view code) const {
+  uint64_t key = code.size();
+  for (char c : code) {
+    key = (key << 8) | static_cast<unsigned char>(c);
+  }
+
+  {
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+    auto found = m_code_glyphs.find(key);
+    if (found != m_code_glyphs.end()) {
+      return found->second;
+    }
+  }
+
+  // PoDoFo resolves glyph metrics lazily, so resolving happens under the write lock
+  std::unique_lock<std::shared_mutex> lock(m_mutex);
+  auto found = m_code_glyphs.find(key);
+  if (found != m_code_glyphs.end()) {
+    return found->second;
+  }
+  return m_code_glyphs.emplace(key, resolve(code)).first->second;
+}
+
+bool flx_pdf_font_cache::font_entry::decode(const PdfString& encoded, const PdfTextState& state,
+                                            std::string& decoded, std::vector<double>& lengths,
+                                            std::vector<unsigned>& positions) const {
+  decoded.clear();
+  lengths.clear();
+  positions.clear();
+
+  std::string_view raw = encoded.GetRawData();
+  const PdfEncodingMap& map = m_font.GetEncoding().GetEncodingMap();
+  bool success = true;
+  auto it = raw.begin();
+  const auto end = raw.end();
+  while (it != end) {
+    const glyph* g;
+    if (m_single_byte) {
+      g = &m_byte_glyphs[static_cast<unsigned char>(*it)];
+      ++it;
+    } else {
+      auto code_begin = it;
+      PdfCID cid;
+      if (!map.TryGetNextCID(it, end, cid)) {
+        // Malformed or unmapped code: leave the fallback rules to PoDoFo
+        return m_font.TryScanEncodedString(encoded, state, decoded, lengths, positions);
+      }
+      g = &code_glyph(std::string_view(&*code_begin, static_cast<size_t>(it - code_begin)));
+    }
+
+    success = success && g->valid;
+    positions.push_back(static_cast<unsigned>(decoded.size()));
+    decoded += g->text;
+    lengths.push_back((g->width * state.FontSize + state.CharSpacing) * state.FontScale);
+  }
+  return success;
+}
+
+flx_pdf_font_cache::flx_pdf_font_cache() {
+}
+
+flx_pdf_font_cache::~flx_pdf_font_cache() {
+}
+
+const flx_pdf_font_cache::font_entry* flx_pdf_font_cache::get(const PdfResources& resources, std::string_view name) {
+  const PdfObject* object = resources.GetResource(PdfResourceType::Font, name);
+  if (object == nullptr) {
+    return nullptr;
+  }
+
+  const bool indirect = object->IsIndirect();
+  {
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+    if (indirect) {
+      auto found = m_fonts.find(object->GetIndirectReference());
+      if (found != m_fonts.end()) {
+        return found->second.get();
+      }
+    } else {
+      auto found = m_inline_fonts.find(object);
+      if (found != m_inline_fonts.end()) {
+        return found->second.get();
+      }
+    }
+  }
+
+  // Failures stay cached as nullptr entries too, so a broken font is only tried once
+  auto load = [&](auto& fonts, const auto& key) -> const font_entry* {
+    auto inserted = fonts.try_emplace(key);
+    if (inserted.second) {
+      try {
+        const PdfFont* font = resources.GetFont(name);
+        if (font != nullptr) {
+          inserted.first->second = std::make_unique<font_entry>(*font);
+        }
+      } catch (const std::exception&) {
+      }
+    }
+    return inserted.first->second.get();
+  };
+
+  std::unique_lock<std::shared_mutex> lock(m_mutex);
+  if (indirect) {
+    return load(m_fonts, object->GetIndirectReference());
+  }
+  return load(m_inline_fonts, object);
+}
+
+size_t flx_pdf_font_cache::size() const {
+  std::shared_lock<std::shared_mutex> lock(m_mutex);
+  return m_fonts.size() + m_inline_fonts.size();
+}
+
+void flx_pdf_font_cache::clear() {
+  std::unique_lock<std::shared_mutex> lock(m_mutex);
+  m_fonts.clear();
+  m_inline_fonts.clear();
+}
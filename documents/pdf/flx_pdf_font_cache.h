@@ -0,0 +1,86 @@
+#ifndef FLX_PDF_FONT_CACHE_H
+#define FLX_PDF_FONT_CACHE_H
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include <main/PdfFont.h>
+#include <main/PdfReference.h>
+#include <main/PdfResources.h>
+#include <main/PdfString.h>
+#include <main/PdfTextState.h>
+
+/*
+ * Fonts of one PDF document, keyed by the indirect reference of the font
+ * object (so /F1 on page 1 and /F1 on page 7 are only the same entry when
+ * they are the same font). PdfFont pointers belong to the document: use one
+ * cache per loaded document and drop it together with the document.
+ *
+ * Lookups are safe from several threads extracting pages concurrently.
+ */
+class flx_pdf_font_cache
+{
+public:
+  class font_entry
+  {
+  public:
+    explicit font_entry(const PoDoFo::PdfFont& font);
+
+    const PoDoFo::PdfFont& font() const { return m_font; }
+    // Font name without the subset prefix (ABCDEF+Arial -> Arial)
+    const std::string& family() const { return m_family; }
+
+    /*
+     * Same result as PdfFont::TryScanEncodedString, but the Unicode text and
+     * the glyph width of every character code are resolved once per font:
+     * one-byte fonts use a 256 entry table filled up front, multi-byte (CMap)
+     * fonts memoize each code on first use.
+     */
+    bool decode(const PoDoFo::PdfString& encoded, const PoDoFo::PdfTextState& state,
+                std::string& decoded, std::vector<double>& lengths, std::vector<unsigned>& positions) const;
+
+  private:
+    struct glyph {
+      std::string text;    // UTF-8
+      double width = 0.0;  // glyph space / 1000, before font size and char spacing
+      bool valid = false;  // code had a Unicode mapping
+    };
+
+    glyph resolve(std::string_view code) const;
+    const glyph& code_glyph(std::string_view code) const;
+
+    const PoDoFo::PdfFont& m_font;
+    std::string m_family;
+    bool m_single_byte = false;
+    std::array<glyph, 256> m_byte_glyphs;  // one-byte fonts, read-only after construction
+
+    mutable std::shared_mutex m_mutex;  // guards m_code_glyphs
+    mutable std::unordered_map<uint64_t, glyph> m_code_glyphs;
+  };
+
+  flx_pdf_font_cache();
+  ~flx_pdf_font_cache();
+
+  flx_pdf_font_cache(const flx_pdf_font_cache&) = delete;
+  flx_pdf_font_cache& operator=(const flx_pdf_font_cache&) = delete;
+
+  // Font resource /name of resources; nullptr if it is missing or cannot be loaded
+  const font_entry* get(const PoDoFo::PdfResources& resources, std::string_view name);
+
+  size_t size() const;
+  void clear();
+
+private:
+  mutable std::shared_mutex m_mutex;
+  std::unordered_map<PoDoFo::PdfReference, std::unique_ptr<font_entry>> m_fonts;
+  // Direct font dictionaries (not allowed by the spec, but they exist)
+  std::unordered_map<const PoDoFo::PdfObject*, std::unique_ptr<font_entry>> m_inline_fonts;
+};
+
+#endif // FLX_PDF_FONT_CACHE_H
@@ -0,0 +1,298 @@
+#include "flx_pdf_page_cache.h"
+#include "../../api/json/flx_json.h"
+#include "../../api/server/flx_metrics.h"
+#include "../../utils/flx_atomic_file.h"
+#include <main/PdfDocument.h>
+#include <main/PdfPage.h>
+#include <auxiliary/OutputStream.h>
+#include <openssl/evp.h>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+using namespace PoDoFo;
+
+namespace {
+
+  // Part of every key: bump when parse() produces a different layout for
+  // the same page, so old entries are no longer found
+  const char* const cache_version = "flx_pdf_page_cache/1";
+
+  // Page attributes that may be inherited from the page tree
+  const char* const inherited_keys[] = {"Resources", "MediaBox", "CropBox", "Rotate"};
+
+  /*
+   * Feeds a page and everything reachable from it into SHA-256. Indirect
+   * objects are hashed by content where they are first reached and by
+   * their visiting order afterwards, which handles cycles and keeps object
+   * numbers out of the key. Other pages (annotation /P, link targets) are
+   * only marked, they are not part of this page.
+   */
+  class object_hasher : public OutputStream
+  {
+  public:
+    object_hasher(const PdfIndirectObjectList& objects, const std::string& variant)
+      : m_objects(objects), m_ctx(EVP_MD_CTX_new()) {
+      EVP_DigestInit_ex(m_ctx, EVP_sha256(), nullptr);
+      text(cache_version);
+      // Default extraction keeps the keys it had before variants existed
+      if (!variant.empty()) {
+        tag('x');
+        text(variant);
+      }
+    }
+
+    ~object_hasher() {
+      EVP_MD_CTX_free(m_ctx);
+    }
+
+    void page(const PdfPage& page) {
+      m_visited.emplace(page.GetObject().GetIndirectReference(), m_visited.size());
+      const PdfDictionary& dict = page.GetDictionary();
+      tag('<');
+      for (const auto& entry : dict) {
+        if (entry.first == "Parent") continue;
+        text(entry.first.GetString());
+        object(entry.second);
+      }
+      tag('>');
+      for (const char* key : inherited_keys) {
+        if (dict.HasKey(key)) continue;
+        const PdfObject* inherited = dict.FindKeyParent(key);
+        if (inherited != nullptr) {
+          text(key);
+          object(*inherited);
+        }
+      }
+      if (page.GetObject().HasStream()) {
+        stream(page.GetObject());
+      }
+    }
+
+    std::string hex_digest() {
+      unsigned char digest[EVP_MAX_MD_SIZE];
+      unsigned int digest_len = 0;
+      EVP_DigestFinal_ex(m_ctx, digest, &digest_len);
+
+      static const char hex[] = "0123456789abcdef";
+      std::string key;
+      key.reserve(digest_len * 2);
+      for (unsigned int i = 0; i < digest_len; ++i) {
+        key += hex[digest[i] >> 4];
+        key += hex[digest[i] & 0x0F];
+      }
+      return key;
+    }
+
+  protected:
+    // Raw (still encoded) stream data arrives here through CopyTo
+    void writeBuffer(const char* buffer, size_t size) override {
+      EVP_DigestUpdate(m_ctx, buffer, size);
+    }
+
+  private:
+    void tag(char c) {
+      EVP_DigestUpdate(m_ctx, &c, 1);
+    }
+
+    void number(uint64_t value) {
+      EVP_DigestUpdate(m_ctx, &value, sizeof(value));
+    }
+
+    // Length first: ("ab","c") != ("a","bc")
+    void text(std::string_view value) {
+      number(value.size());
+      EVP_DigestUpdate(m_ctx, value.data(), value.size());
+    }
+
+    void object(const PdfObject& obj) {
+      switch (obj.GetDataType()) {
+        case PdfDataType::Reference:
+          reference(obj.GetReference());
+          break;
+        case PdfDataType::Array: {
+          const PdfArray& array = obj.GetArray();
+          tag('[');
+          number(array.GetSize());
+          for (const auto& item : array) {
+            object(item);
+          }
+          break;
+        }
+        case PdfDataType::Dictionary:
+          tag('<');
+          number(obj.GetDictionary().GetSize());
+          for (const auto& entry : obj.GetDictionary()) {
+            text(entry.first.GetString());
+            object(entry.second);
+          }
+          break;
+        default:
+          tag('v');
+          text(obj.ToString());
+          break;
+      }
+    }
+
+    void reference(const PdfReference& ref) {
+      auto known = m_visited.find(ref);
+      if (known != m_visited.end()) {
+        tag('#');
+        number(known->second);
+        return;
+      }
+      m_visited.emplace(ref, m_visited.size());
+
+      const PdfObject* target = m_objects.GetObject(ref);
+      if (target == nullptr) {
+        tag('0');
+        return;
+      }
+      if (target->IsDictionary()) {
+        const PdfName* type = nullptr;
+        if (target->GetDictionary().TryFindKeyAs("Type", type) && (*type == "Page" || *type == "Pages")) {
+          tag('P');
+          return;
+        }
+      }
+      object(*target);
+      if (target->HasStream()) {
+        stream(*target);
+      }
+    }
+
+    void stream(const PdfObject& obj) {
+      tag('s');
+      obj.GetStream()->CopyTo(*this, true);
+      tag('e');
+    }
+
+    const PdfIndirectObjectList& m_objects;
+    EVP_MD_CTX* m_ctx;
+    std::unordered_map<PdfReference, size_t> m_visited;
+  };
+
+}
+
+flx_pdf_page_cache::flx_pdf_page_cache(const std::string& directory, size_t capacity)
+  : m_directory(directory), m_capacity(capacity) {
+}
+
+std::string flx_pdf_page_cache::fingerprint(const PdfPage& page, const std::string& variant) {
+  object_hasher hasher(page.GetDocument().GetObjects(), variant);
+  hasher.page(page);
+  return hasher.hex_digest();
+}
+
+bool flx_pdf_page_cache::load(const std::string& key, flx_layout_geometry& page) {
+  flxv_map data;
+  bool found = false;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto cached = m_entries.find(key);
+    if (cached != m_entries.end()) {
+      data = cached->second.data;
+      touch(cached->second);
+      found = true;
+    }
+  }
+  std::string json;
+  if (!found && read_file(key, json) && flx_json(&data).parse(json)) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    insert(key, data);
+    found = true;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    ++(found ? m_stats.hits : m_stats.misses);
+  }
+  flx_metrics::instance().counter(found ? "pdf.page_cache.hit" : "pdf.page_cache.miss").fetch_add(1, std::memory_order_relaxed);
+  if (found) {
+    *page = std::move(data);
+  }
+  return found;
+}
+
+void flx_pdf_page_cache::store(const std::string& key, flx_layout_geometry& page) {
+  if (!m_directory.empty() && !write_file(key, flx_json(&*page).create().c_str())) {
+    std::cerr << "[pdf_page_cache] Failed to persist page " << key << std::endl;
+  }
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  insert(key, *page);
+}
+
+void flx_pdf_page_cache::insert(const std::string& key, const flxv_map& data) {
+  auto cached = m_entries.find(key);
+  if (cached != m_entries.end()) {
+    cached->second.data = data;
+    touch(cached->second);
+    return;
+  }
+
+  m_recent.push_front(key);
+  m_entries.emplace(key, entry{data, m_recent.begin()});
+  while (m_capacity > 0 && m_entries.size() > m_capacity) {
+    m_entries.erase(m_recent.back());
+    m_recent.pop_back();
+    ++m_stats.evictions;
+    flx_metrics::instance().counter("pdf.page_cache.evict").fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+void flx_pdf_page_cache::touch(entry& found) {
+  m_recent.splice(m_recent.begin(), m_recent, found.position);
+}
+
+flx_pdf_page_cache::stats flx_pdf_page_cache::get_stats() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_stats;
+}
+
+size_t flx_pdf_page_cache::size() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_entries.size();
+}
+
+void flx_pdf_page_cache::clear() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_entries.clear();
+  m_recent.clear();
+  m_stats = stats();
+}
+
+std::string flx_pdf_page_cache::path_for(const std::string& key) const {
+  return m_directory + "/" + key.substr(0, 2) + "/" + key + ".json";
+}
+
+bool flx_pdf_page_cache::read_file(const std::string& key, std::string& json) const {
+  if (m_directory.empty()) {
+    return false;
+  }
+  std::ifstream in(path_for(key), std::ios::binary);
+  if (!in) {
+    return false;
+  }
+  std::ostringstream content;
+  content << in.rdbuf();
+  json = content.str();
+  return !json.empty();
+}
+
+bool flx_pdf_page_cache::write_file(const std::string& key, const std::string& json) const {
+  std::filesystem::path target(path_for(key));
+  std::error_code ec;
+  std::filesystem::create_directories(target.parent_path(), ec);
+  if (ec) {
+    return false;
+  }
+
+  // Entries are content addressed: if the rename loses against another
+  // writer of the same key, the entry on disk is just as good
+  if (flx_write_file_atomic(target.string(), json)) {
+    return true;
+  }
+  return std::filesystem::exists(target, ec);
+}
@@ -0,0 +1,85 @@
+#ifndef FLX_PDF_PAGE_CACHE_H
+#define FLX_PDF_PAGE_CACHE_H
+
+#include "../layout/flx_layout_geometry.h"
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace PoDoFo {
+  class PdfPage;
+}
+
+/*
+ * Layout results of parse(), one entry per page, keyed by a fingerprint of
+ * the page content. The fingerprint is a SHA-256 over the page dictionary
+ * and every object it references (content streams, fonts, XObjects, ...),
+ * taken by value: object numbers do not matter, so a page keeps its key when
+ * an edit or a rewrite renumbers the file. Re-parsing a document after a
+ * small change restores the untouched pages and only reprocesses the rest.
+ *
+ * Entries are kept in memory as model data and, with a directory, as one
+ * JSON file per page (<directory>/<key[0..1]>/<key>.json) that outlives the
+ * process. JSON is only read once per entry: restoring a page from memory is
+ * a map copy, cheaper than extracting it again. With a capacity, the least
+ * recently used memory entries are dropped beyond that many pages (their
+ * files stay), so a long-running process does not grow without limit.
+ * All methods are safe to call from several threads.
+ *
+ * Hit/miss/eviction counts are exported via flx_metrics counters
+ * "pdf.page_cache.hit", "pdf.page_cache.miss" and "pdf.page_cache.evict".
+ */
+class flx_pdf_page_cache
+{
+public:
+  struct stats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;
+  };
+
+  // Empty directory: memory only; capacity: pages kept in memory, 0 = unlimited
+  explicit flx_pdf_page_cache(const std::string& directory = std::string(), size_t capacity = 0);
+
+  flx_pdf_page_cache(const flx_pdf_page_cache&) = delete;
+  flx_pdf_page_cache& operator=(const flx_pdf_page_cache&) = delete;
+
+  // Hex key of the page; changes with anything the page draws or inherits.
+  // variant names what was extracted (see flx_pdf_sio::extract_options):
+  // the same page parsed with other stages gets another key
+  static std::string fingerprint(const PoDoFo::PdfPage& page, const std::string& variant = std::string());
+
+  // Restores the stored layout of key into page; false on a miss
+  bool load(const std::string& key, flx_layout_geometry& page);
+  void store(const std::string& key, flx_layout_geometry& page);
+
+  stats get_stats() const;
+  size_t size() const;
+  // Drops the memory entries and the statistics, files stay
+  void clear();
+
+private:
+  std::string path_for(const std::string& key) const;
+  bool read_file(const std::string& key, std::string& json) const;
+  bool write_file(const std::string& key, const std::string& json) const;
+
+  struct entry {
+    flxv_map data;
+    std::list<std::string>::iterator position;  // in m_recent
+  };
+
+  // Caller holds m_mutex
+  void insert(const std::string& key, const flxv_map& data);
+  void touch(entry& found);
+
+  std::string m_directory;
+  size_t m_capacity;
+  mutable std::mutex m_mutex;
+  std::unordered_map<std::string, entry> m_entries;  // key -> page data
+  std::list<std::string> m_recent;                   // keys, most recently used first
+  stats m_stats;
+};
+
+#endif // FLX_PDF_PAGE_CACHE_H
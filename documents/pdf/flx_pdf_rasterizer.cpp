@@ -0,0 +1,364 @@
+#include "flx_pdf_rasterizer.h"
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#ifdef FLX_ENABLE_POPPLER
+#include <poppler-document.h>
+#include <poppler-image.h>
+#include <poppler-page.h>
+#include <poppler-page-renderer.h>
+#endif
+
+extern char** environ;
+
+namespace {
+
+  bool is_ppm_space(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f';
+  }
+
+  // Child process with the PDF on stdin and the PPM stream on stdout.
+  // The destructor terminates and reaps the child, so early returns and
+  // exceptions from page callbacks never leave a zombie or a blocked writer.
+  struct pdftoppm_process
+  {
+    pid_t pid = -1;
+    int stdout_fd = -1;
+    std::thread writer;
+
+    ~pdftoppm_process() { finish(true); }
+
+    // Returns the raw waitpid status, -1 if nothing was running
+    int finish(bool terminate) {
+      if (pid > 0 && terminate) {
+        kill(pid, SIGTERM);
+      }
+      if (stdout_fd >= 0) {
+        close(stdout_fd);
+        stdout_fd = -1;
+      }
+      if (writer.joinable()) {
+        writer.join();
+      }
+      int status = -1;
+      if (pid > 0) {
+        while (waitpid(pid, &status, 0) < 0 && errno == EINTR) {}
+        pid = -1;
+      }
+      return status;
+    }
+  };
+
+  void write_all(int fd, const char* data, size_t size) {
+    // EPIPE instead of SIGPIPE when the child exits before reading everything
+    sigset_t block;
+    sigemptyset(&block);
+    sigaddset(&block, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &block, nullptr);
+
+    size_t written = 0;
+    while (written < size) {
+      ssize_t n = ::write(fd, data + written, size - written);
+      if (n < 0) {
+        if (errno == EINTR) continue;
+        break;
+      }
+      written += static_cast<size_t>(n);
+    }
+    close(fd);
+  }
+
+}
+
+flx_pdf_rasterizer::flx_pdf_rasterizer()
+  : m_options()
+{
+}
+
+flx_pdf_rasterizer::flx_pdf_rasterizer(const options& opts)
+  : m_options(opts)
+{
+}
+
+bool flx_pdf_rasterizer::poppler_available() {
+#ifdef FLX_ENABLE_POPPLER
+  return true;
+#else
+  return false;
+#endif
+}
+
+bool flx_pdf_rasterizer::fail(const std::string& message) {
+  m_last_error = message;
+  return false;
+}
+
+bool flx_pdf_rasterizer::render(const char* data, size_t size, std::vector<cv::Mat>& pages) {
+  pages.clear();
+  return render(data, size, [&pages](int, cv::Mat& page) {
+    pages.push_back(page);
+    return true;
+  });
+}
+
+bool flx_pdf_rasterizer::render(const char* data, size_t size, const page_callback& on_page) {
+  m_last_error.clear();
+  if (data == nullptr || size == 0) {
+    return fail("no PDF data");
+  }
+  if (m_options.dpi <= 0) {
+    return fail("DPI must be positive");
+  }
+  if (m_options.first_page < 1 || (m_options.last_page != 0 && m_options.last_page < m_options.first_page)) {
+    return fail("invalid page range " + std::to_string(m_options.first_page) + "-" + std::to_string(m_options.last_page));
+  }
+
+  switch (m_options.engine) {
+    case backend::poppler:
+      return render_poppler(data, size, on_page);
+    case backend::pdftoppm:
+      return render_pdftoppm(data, size, on_page);
+    case backend::automatic:
+    default:
+      return poppler_available() ? render_poppler(data, size, on_page)
+                                 : render_pdftoppm(data, size, on_page);
+  }
+}
+
+bool flx_pdf_rasterizer::render_poppler(const char* data, size_t size, const page_callback& on_page) {
+#ifdef FLX_ENABLE_POPPLER
+  // load_from_raw_data does not copy; data outlives the document here
+  std::unique_ptr<poppler::document> doc(poppler::document::load_from_raw_data(data, static_cast<int>(size)));
+  if (!doc || doc->is_locked()) {
+    return fail("poppler could not open the document");
+  }
+
+  int last = doc->pages();
+  if (m_options.last_page != 0 && m_options.last_page < last) {
+    last = m_options.last_page;
+  }
+  if (m_options.first_page > last) {
+    return fail("page range starts after the last page");
+  }
+
+  poppler::page_renderer renderer;
+  renderer.set_render_hint(poppler::page_renderer::antialiasing, true);
+  renderer.set_render_hint(poppler::page_renderer::text_antialiasing, true);
+
+  const double dpi = static_cast<double>(m_options.dpi);
+  for (int number = m_options.first_page; number <= last; ++number) {
+    std::unique_ptr<poppler::page> page(doc->create_page(number - 1));
+    if (!page) {
+      return fail("poppler could not load page " + std::to_string(number));
+    }
+    poppler::image image = renderer.render_page(page.get(), dpi, dpi);
+    if (!image.is_valid()) {
+      return fail("poppler could not render page " + std::to_string(number));
+    }
+    // format_argb32 is native-endian 0xAARRGGBB, i.e. BGRA bytes on little endian
+    cv::Mat bgra(image.height(), image.width(), CV_8UC4,
+                 const_cast<char*>(image.const_data()), static_cast<size_t>(image.bytes_per_row()));
+    cv::Mat bgr;
+    cv::cvtColor(bgra, bgr, cv::COLOR_BGRA2BGR);
+    if (!on_page(number, bgr)) {
+      return true;
+    }
+  }
+  return true;
+#else
+  (void)data;
+  (void)size;
+  (void)on_page;
+  return fail("poppler backend not compiled in (FLX_ENABLE_POPPLER)");
+#endif
+}
+
+bool flx_pdf_rasterizer::render_pdftoppm(const char* data, size_t size, const page_callback& on_page) {
+  // Without an output root pdftoppm writes all pages as one PPM stream to stdout;
+  // "-" makes it read the PDF from stdin
+  std::vector<std::string> args = {
+    m_options.pdftoppm_path,
+    "-r", std::to_string(m_options.dpi),
+    "-f", std::to_string(m_options.first_page)
+  };
+  if (m_options.last_page != 0) {
+    args.push_back("-l");
+    args.push_back(std::to_string(m_options.last_page));
+  }
+  args.push_back("-");
+
+  std::vector<char*> argv;
+  for (auto& arg : args) {
+    argv.push_back(const_cast<char*>(arg.c_str()));
+  }
+  argv.push_back(nullptr);
+
+  int in_pipe[2];
+  int out_pipe[2];
+  if (pipe2(in_pipe, O_CLOEXEC) != 0) {
+    return fail(std::string("pipe failed: ") + std::strerror(errno));
+  }
+  if (pipe2(out_pipe, O_CLOEXEC) != 0) {
+    int error = errno;
+    close(in_pipe[0]);
+    close(in_pipe[1]);
+    return fail(std::string("pipe failed: ") + std::strerror(error));
+  }
+
+  posix_spawn_file_actions_t actions;
+  posix_spawn_file_actions_init(&actions);
+  posix_spawn_file_actions_adddup2(&actions, in_pipe[0], STDIN_FILENO);
+  posix_spawn_file_actions_adddup2(&actions, out_pipe[1], STDOUT_FILENO);
+
+  pdftoppm_process process;
+  int spawn_error = posix_spawnp(&process.pid, argv[0], &actions, nullptr, argv.data(), environ);
+  posix_spawn_file_actions_destroy(&actions);
+  close(in_pipe[0]);
+  close(out_pipe[1]);
+  if (spawn_error != 0) {
+    process.pid = -1;
+    close(in_pipe[1]);
+    close(out_pipe[0]);
+    return fail("cannot start " + m_options.pdftoppm_path + ": " + std::strerror(spawn_error));
+  }
+
+  process.stdout_fd = out_pipe[0];
+  int stdin_fd = in_pipe[1];
+  process.writer = std::thread(write_all, stdin_fd, data, size);
+
+  ppm_stream stream;
+  std::vector<char> chunk(1 << 16);
+  int page_number = m_options.first_page;
+  bool stopped = false;
+  while (!stopped) {
+    ssize_t n = ::read(process.stdout_fd, chunk.data(), chunk.size());
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      return fail(std::string("reading pdftoppm output failed: ") + std::strerror(errno));
+    }
+    if (n == 0) {
+      break;
+    }
+    if (!stream.feed(chunk.data(), static_cast<size_t>(n))) {
+      return fail("malformed PPM stream from pdftoppm");
+    }
+    cv::Mat page;
+    while (stream.pop(page)) {
+      if (!on_page(page_number++, page)) {
+        stopped = true;
+        break;
+      }
+    }
+  }
+
+  int status = process.finish(stopped);
+  if (stopped) {
+    return true;
+  }
+  if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+    return fail(m_options.pdftoppm_path + " failed with status " +
+                std::to_string(WIFEXITED(status) ? WEXITSTATUS(status) : status));
+  }
+  if (stream.incomplete()) {
+    return fail("truncated PPM stream from pdftoppm");
+  }
+  if (page_number == m_options.first_page) {
+    return fail("pdftoppm produced no pages");
+  }
+  return true;
+}
+
+int flx_pdf_rasterizer::ppm_stream::parse_header(size_t& data_start, int& width, int& height) const {
+  const std::string& b = m_buffer;
+  size_t pos = m_offset;
+  while (pos < b.size() && is_ppm_space(b[pos])) ++pos;
+  if (b.size() - pos < 2) return 0;
+  if (b[pos] != 'P' || b[pos + 1] != '6') return -1;
+  pos += 2;
+
+  long values[3] = {0, 0, 0};  // width, height, maxval
+  for (long& value : values) {
+    while (true) {
+      if (pos >= b.size()) return 0;
+      if (is_ppm_space(b[pos])) {
+        ++pos;
+      } else if (b[pos] == '#') {
+        size_t line_end = b.find('\n', pos);
+        if (line_end == std::string::npos) return 0;
+        pos = line_end + 1;
+      } else {
+        break;
+      }
+    }
+    if (!std::isdigit(static_cast<unsigned char>(b[pos]))) return -1;
+    while (pos < b.size() && std::isdigit(static_cast<unsigned char>(b[pos]))) {
+      value = value * 10 + (b[pos] - '0');
+      if (value > (1 << 20)) return -1;
+      ++pos;
+    }
+    if (pos >= b.size()) return 0;  // the number may continue in the next piece
+  }
+
+  // Exactly one whitespace byte separates maxval from the raster
+  if (!is_ppm_space(b[pos])) return -1;
+  if (values[0] <= 0 || values[1] <= 0 || values[2] != 255) return -1;
+  data_start = pos + 1;
+  width = static_cast<int>(values[0]);
+  height = static_cast<int>(values[1]);
+  return 1;
+}
+
+bool flx_pdf_rasterizer::ppm_stream::feed(const char* bytes, size_t count) {
+  if (m_failed) {
+    return false;
+  }
+  // Drop consumed images before growing the buffer
+  if (m_offset > 0 && m_offset >= m_buffer.size() / 2) {
+    m_buffer.erase(0, m_offset);
+    m_offset = 0;
+  }
+  m_buffer.append(bytes, count);
+
+  while (m_offset < m_buffer.size()) {
+    size_t data_start = 0;
+    int width = 0;
+    int height = 0;
+    int header = parse_header(data_start, width, height);
+    if (header < 0) {
+      m_failed = true;
+      return false;
+    }
+    if (header == 0) {
+      break;
+    }
+    size_t raster_bytes = static_cast<size_t>(width) * static_cast<size_t>(height) * 3;
+    if (m_buffer.size() - data_start < raster_bytes) {
+      m_buffer.reserve(data_start + raster_bytes);
+      break;
+    }
+    cv::Mat rgb(height, width, CV_8UC3, &m_buffer[data_start]);
+    cv::Mat bgr;
+    cv::cvtColor(rgb, bgr, cv::COLOR_RGB2BGR);
+    m_ready.push_back(bgr);
+    m_offset = data_start + raster_bytes;
+  }
+  return true;
+}
+
+bool flx_pdf_rasterizer::ppm_stream::pop(cv::Mat& image) {
+  if (m_ready.empty()) {
+    return false;
+  }
+  image = m_ready.front();
+  m_ready.pop_front();
+  return true;
+}
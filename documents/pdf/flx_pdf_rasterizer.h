@@ -0,0 +1,84 @@
+#ifndef FLX_PDF_RASTERIZER_H
+#define FLX_PDF_RASTERIZER_H
+
+#include <opencv2/opencv.hpp>
+#include <deque>
+#include <functional>
+#include <string>
+#include <vector>
+
+/*
+ * Renders PDF bytes straight into cv::Mat pages (BGR, CV_8UC3).
+ * Backends:
+ *  - poppler-cpp in process (compiled in with FLX_ENABLE_POPPLER)
+ *  - pdftoppm as a child process: PDF on stdin, binary PPM stream on stdout,
+ *    no temp files and no PNG encode/decode
+ * Pages are handed out one at a time as soon as they are complete.
+ */
+class flx_pdf_rasterizer
+{
+public:
+  enum class backend {
+    automatic,  // poppler if compiled in, else pdftoppm
+    poppler,
+    pdftoppm
+  };
+
+  struct options {
+    int dpi = 150;
+    int first_page = 1;  // 1-based, inclusive
+    int last_page = 0;   // inclusive, 0 = last page of the document
+    backend engine = backend::automatic;
+    std::string pdftoppm_path = "pdftoppm";
+  };
+
+  // Receives each page in order; return false to stop rendering
+  using page_callback = std::function<bool(int page_number, cv::Mat& page)>;
+
+  flx_pdf_rasterizer();
+  explicit flx_pdf_rasterizer(const options& opts);
+
+  bool render(const char* data, size_t size, const page_callback& on_page);
+  bool render(const char* data, size_t size, std::vector<cv::Mat>& pages);
+
+  const options& get_options() const { return m_options; }
+  const std::string& last_error() const { return m_last_error; }
+
+  static bool poppler_available();
+
+  /*
+   * Incremental decoder for concatenated binary PPM (P6, maxval 255) images,
+   * as written by pdftoppm to stdout. Bytes may arrive in arbitrary pieces.
+   */
+  class ppm_stream
+  {
+  public:
+    // Returns false once the stream is malformed
+    bool feed(const char* bytes, size_t count);
+    // Moves the next complete image (BGR) into image
+    bool pop(cv::Mat& image);
+
+    bool failed() const { return m_failed; }
+    // True while an image has started but is not complete yet
+    bool incomplete() const { return m_offset < m_buffer.size(); }
+
+  private:
+    // 1 = header complete, 0 = more bytes needed, -1 = malformed
+    int parse_header(size_t& data_start, int& width, int& height) const;
+
+    std::string m_buffer;
+    size_t m_offset = 0;  // start of the first unconsumed image
+    std::deque<cv::Mat> m_ready;
+    bool m_failed = false;
+  };
+
+private:
+  bool render_poppler(const char* data, size_t size, const page_callback& on_page);
+  bool render_pdftoppm(const char* data, size_t size, const page_callback& on_page);
+  bool fail(const std::string& message);
+
+  options m_options;
+  std::string m_last_error;
+};
+
+#endif // FLX_PDF_RASTERIZER_H
@@ -0,0 +1,346 @@
+#include "flx_pdf_regions.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+
+// SIMD versions need GCC/Clang target attributes: they are compiled for
+// SSSE3/AVX2 without raising the baseline of the rest of the build
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define FLX_REGION_KERNELS_X86 1
+#include <immintrin.h>
+#endif
+
+namespace {
+
+  // Scalar versions: fallback, tails of the SIMD loops and reference in tests
+
+  void similar_pixels_scalar(const uchar* a, const uchar* b, int count, int tolerance, uchar* out) {
+    for (int i = 0; i < count; ++i) {
+      int db = static_cast<int>(a[3 * i]) - static_cast<int>(b[3 * i]);
+      int dg = static_cast<int>(a[3 * i + 1]) - static_cast<int>(b[3 * i + 1]);
+      int dr = static_cast<int>(a[3 * i + 2]) - static_cast<int>(b[3 * i + 2]);
+      int distance = std::abs(db) + std::abs(dg) + std::abs(dr);
+      out[i] = static_cast<uchar>(distance <= tolerance);
+    }
+  }
+
+  // Breaks in joined[begin, width - 1), then the end of the row
+  int encode_runs_scalar(const uchar* joined, int begin, int width, int* run_ends, int count) {
+    for (int x = begin; x < width - 1; ++x) {
+      if (!joined[x]) {
+        run_ends[count++] = x + 1;
+      }
+    }
+    if (width > 0) {
+      run_ends[count++] = width;
+    }
+    return count;
+  }
+
+  void sum_pixels_scalar(const uchar* bgr, int count, uint64_t sums[3]) {
+    for (int i = 0; i < count; ++i) {
+      sums[0] += bgr[3 * i];
+      sums[1] += bgr[3 * i + 1];
+      sums[2] += bgr[3 * i + 2];
+    }
+  }
+
+#ifdef FLX_REGION_KERNELS_X86
+
+  /*
+   * 16 BGR pixels are 48 bytes in three registers. pshufb with these masks
+   * gathers one channel of them into a register of its own (plane):
+   * masks[c][r] picks the bytes of channel c that are in register r.
+   */
+  struct plane_masks {
+    alignas(16) signed char bytes[3][3][16];
+
+    plane_masks() {
+      for (int c = 0; c < 3; ++c) {
+        for (int r = 0; r < 3; ++r) {
+          for (int j = 0; j < 16; ++j) {
+            int local = 3 * j + c - 16 * r;
+            bytes[c][r][j] = static_cast<signed char>(local >= 0 && local < 16 ? local : -128);
+          }
+        }
+      }
+    }
+  };
+
+  const plane_masks& masks() {
+    static const plane_masks table;
+    return table;
+  }
+
+  // SSSE3: 16 pixels per step
+
+  __attribute__((target("ssse3")))
+  inline void load_masks(__m128i m[3][3]) {
+    for (int c = 0; c < 3; ++c) {
+      for (int r = 0; r < 3; ++r) {
+        m[c][r] = _mm_load_si128(reinterpret_cast<const __m128i*>(masks().bytes[c][r]));
+      }
+    }
+  }
+
+  __attribute__((target("ssse3")))
+  inline void to_planes(const __m128i in[3], const __m128i m[3][3], __m128i planes[3]) {
+    for (int c = 0; c < 3; ++c) {
+      planes[c] = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(in[0], m[c][0]), _mm_shuffle_epi8(in[1], m[c][1])),
+                               _mm_shuffle_epi8(in[2], m[c][2]));
+    }
+  }
+
+  __attribute__((target("ssse3")))
+  void similar_pixels_ssse3(const uchar* a, const uchar* b, int count, int tolerance, uchar* out) {
+    __m128i m[3][3];
+    load_masks(m);
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i one = _mm_set1_epi8(1);
+    // Distances are at most 765, they fit 16 bit lanes
+    const __m128i limit = _mm_set1_epi16(static_cast<short>(std::max(-1, std::min(tolerance, 765))));
+
+    int i = 0;
+    for (; i + 16 <= count; i += 16) {
+      __m128i diff[3];
+      for (int r = 0; r < 3; ++r) {
+        __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + 3 * i + 16 * r));
+        __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + 3 * i + 16 * r));
+        diff[r] = _mm_or_si128(_mm_subs_epu8(va, vb), _mm_subs_epu8(vb, va));
+      }
+      __m128i p[3];
+      to_planes(diff, m, p);
+      __m128i lo = _mm_add_epi16(_mm_add_epi16(_mm_unpacklo_epi8(p[0], zero), _mm_unpacklo_epi8(p[1], zero)),
+                                 _mm_unpacklo_epi8(p[2], zero));
+      __m128i hi = _mm_add_epi16(_mm_add_epi16(_mm_unpackhi_epi8(p[0], zero), _mm_unpackhi_epi8(p[1], zero)),
+                                 _mm_unpackhi_epi8(p[2], zero));
+      __m128i far = _mm_packs_epi16(_mm_cmpgt_epi16(lo, limit), _mm_cmpgt_epi16(hi, limit));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_andnot_si128(far, one));
+    }
+    similar_pixels_scalar(a + 3 * i, b + 3 * i, count - i, tolerance, out + i);
+  }
+
+  __attribute__((target("ssse3")))
+  int encode_runs_ssse3(const uchar* joined, int width, int* run_ends) {
+    const __m128i zero = _mm_setzero_si128();
+    int count = 0;
+    int x = 0;
+    for (; x + 16 <= width - 1; x += 16) {
+      __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(joined + x));
+      unsigned breaks = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, zero)));
+      while (breaks != 0) {
+        run_ends[count++] = x + __builtin_ctz(breaks) + 1;
+        breaks &= breaks - 1;
+      }
+    }
+    return encode_runs_scalar(joined, x, width, run_ends, count);
+  }
+
+  __attribute__((target("ssse3")))
+  void sum_pixels_ssse3(const uchar* bgr, int count, uint64_t sums[3]) {
+    __m128i m[3][3];
+    load_masks(m);
+    const __m128i zero = _mm_setzero_si128();
+    __m128i acc[3] = {zero, zero, zero};
+
+    int i = 0;
+    for (; i + 16 <= count; i += 16) {
+      __m128i in[3];
+      for (int r = 0; r < 3; ++r) {
+        in[r] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bgr + 3 * i + 16 * r));
+      }
+      __m128i p[3];
+      to_planes(in, m, p);
+      for (int c = 0; c < 3; ++c) {
+        acc[c] = _mm_add_epi64(acc[c], _mm_sad_epu8(p[c], zero));
+      }
+    }
+    for (int c = 0; c < 3; ++c) {
+      alignas(16) uint64_t lanes[2];
+      _mm_store_si128(reinterpret_cast<__m128i*>(lanes), acc[c]);
+      sums[c] += lanes[0] + lanes[1];
+    }
+    sum_pixels_scalar(bgr + 3 * i, count - i, sums);
+  }
+
+  // AVX2: 32 pixels per step. pshufb works per 128 bit lane, so the low
+  // lanes take pixels 0-15 and the high lanes pixels 16-31 of each step;
+  // unpack and pack are per lane as well and keep that order.
+
+  __attribute__((target("avx2")))
+  inline void load_masks(__m256i m[3][3]) {
+    for (int c = 0; c < 3; ++c) {
+      for (int r = 0; r < 3; ++r) {
+        m[c][r] = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(masks().bytes[c][r])));
+      }
+    }
+  }
+
+  // Register r of a step: bytes 16r.. of pixels 0-15 and of pixels 16-31
+  __attribute__((target("avx2")))
+  inline __m256i load_lanes(const uchar* step, int r) {
+    __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(step + 16 * r));
+    __m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(step + 48 + 16 * r));
+    return _mm256_inserti128_si256(_mm256_castsi128_si256(low), high, 1);
+  }
+
+  __attribute__((target("avx2")))
+  inline void to_planes(const __m256i in[3], const __m256i m[3][3], __m256i planes[3]) {
+    for (int c = 0; c < 3; ++c) {
+      planes[c] = _mm256_or_si256(_mm256_or_si256(_mm256_shuffle_epi8(in[0], m[c][0]), _mm256_shuffle_epi8(in[1], m[c][1])),
+                                  _mm256_shuffle_epi8(in[2], m[c][2]));
+    }
+  }
+
+  __attribute__((target("avx2")))
+  void similar_pixels_avx2(const uchar* a, const uchar* b, int count, int tolerance, uchar* out) {
+    __m256i m[3][3];
+    load_masks(m);
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i one = _mm256_set1_epi8(1);
+    const __m256i limit = _mm256_set1_epi16(static_cast<short>(std::max(-1, std::min(tolerance, 765))));
+
+    int i = 0;
+    for (; i + 32 <= count; i += 32) {
+      __m256i diff[3];
+      for (int r = 0; r < 3; ++r) {
+        __m256i va = load_lanes(a + 3 * i, r);
+        __m256i vb = load_lanes(b + 3 * i, r);
+        diff[r] = _mm256_or_si256(_mm256_subs_epu8(va, vb), _mm256_subs_epu8(vb, va));
+      }
+      __m256i p[3];
+      to_planes(diff, m, p);
+      __m256i lo = _mm256_add_epi16(_mm256_add_epi16(_mm256_unpacklo_epi8(p[0], zero), _mm256_unpacklo_epi8(p[1], zero)),
+                                    _mm256_unpacklo_epi8(p[2], zero));
+      __m256i hi = _mm256_add_epi16(_mm256_add_epi16(_mm256_unpackhi_epi8(p[0], zero), _mm256_unpackhi_epi8(p[1], zero)),
+                                    _mm256_unpackhi_epi8(p[2], zero));
+      __m256i far = _mm256_packs_epi16(_mm256_cmpgt_epi16(lo, limit), _mm256_cmpgt_epi16(hi, limit));
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm256_andnot_si256(far, one));
+    }
+    similar_pixels_scalar(a + 3 * i, b + 3 * i, count - i, tolerance, out + i);
+  }
+
+  __attribute__((target("avx2")))
+  int encode_runs_avx2(const uchar* joined, int width, int* run_ends) {
+    const __m256i zero = _mm256_setzero_si256();
+    int count = 0;
+    int x = 0;
+    for (; x + 32 <= width - 1; x += 32) {
+      __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(joined + x));
+      unsigned breaks = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, zero)));
+      while (breaks != 0) {
+        run_ends[count++] = x + __builtin_ctz(breaks) + 1;
+        breaks &= breaks - 1;
+      }
+    }
+    return encode_runs_scalar(joined, x, width, run_ends, count);
+  }
+
+  __attribute__((target("avx2")))
+  void sum_pixels_avx2(const uchar* bgr, int count, uint64_t sums[3]) {
+    __m256i m[3][3];
+    load_masks(m);
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i acc[3] = {zero, zero, zero};
+
+    int i = 0;
+    for (; i + 32 <= count; i += 32) {
+      __m256i in[3];
+      for (int r = 0; r < 3; ++r) {
+        in[r] = load_lanes(bgr + 3 * i, r);
+      }
+      __m256i p[3];
+      to_planes(in, m, p);
+      for (int c = 0; c < 3; ++c) {
+        acc[c] = _mm256_add_epi64(acc[c], _mm256_sad_epu8(p[c], zero));
+      }
+    }
+    for (int c = 0; c < 3; ++c) {
+      alignas(32) uint64_t lanes[4];
+      _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), acc[c]);
+      sums[c] += lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    }
+    sum_pixels_scalar(bgr + 3 * i, count - i, sums);
+  }
+
+#endif
+
+  flx_regions::simd_level detect_simd_level() {
+#ifdef FLX_REGION_KERNELS_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+      return flx_regions::simd_level::avx2;
+    }
+    if (__builtin_cpu_supports("ssse3")) {
+      return flx_regions::simd_level::ssse3;
+    }
+#endif
+    return flx_regions::simd_level::scalar;
+  }
+
+  // -1 until the first kernel call or set_simd_level()
+  std::atomic<int> active_level{-1};
+
+}
+
+namespace flx_regions {
+
+  simd_level supported_simd_level() {
+    static const simd_level level = detect_simd_level();
+    return level;
+  }
+
+  simd_level active_simd_level() {
+    int level = active_level.load(std::memory_order_relaxed);
+    if (level < 0) {
+      level = static_cast<int>(supported_simd_level());
+      active_level.store(level, std::memory_order_relaxed);
+    }
+    return static_cast<simd_level>(level);
+  }
+
+  void set_simd_level(simd_level level) {
+    level = std::min(level, supported_simd_level());
+    active_level.store(static_cast<int>(level), std::memory_order_relaxed);
+  }
+
+  const char* simd_level_name(simd_level level) {
+    switch (level) {
+      case simd_level::avx2: return "avx2";
+      case simd_level::ssse3: return "ssse3";
+      default: return "scalar";
+    }
+  }
+
+  void similar_pixels(const uchar* a, const uchar* b, int count, int tolerance, uchar* out) {
+    switch (active_simd_level()) {
+#ifdef FLX_REGION_KERNELS_X86
+      case simd_level::avx2: similar_pixels_avx2(a, b, count, tolerance, out); return;
+      case simd_level::ssse3: similar_pixels_ssse3(a, b, count, tolerance, out); return;
+#endif
+      default: similar_pixels_scalar(a, b, count, tolerance, out); return;
+    }
+  }
+
+  int encode_runs(const uchar* joined, int width, int* run_ends) {
+    switch (active_simd_level()) {
+#ifdef FLX_REGION_KERNELS_X86
+      case simd_level::avx2: return encode_runs_avx2(joined, width, run_ends);
+      case simd_level::ssse3: return encode_runs_ssse3(joined, width, run_ends);
+#endif
+      default: return encode_runs_scalar(joined, 0, width, run_ends, 0);
+    }
+  }
+
+  void sum_pixels(const uchar* bgr, int count, uint64_t sums[3]) {
+    sums[0] = sums[1] = sums[2] = 0;
+    switch (active_simd_level()) {
+#ifdef FLX_REGION_KERNELS_X86
+      case simd_level::avx2: sum_pixels_avx2(bgr, count, sums); return;
+      case simd_level::ssse3: sum_pixels_ssse3(bgr, count, sums); return;
+#endif
+      default: sum_pixels_scalar(bgr, count, sums); return;
+    }
+  }
+
+}
@@ -0,0 +1,164 @@
+#include "flx_pdf_regions.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+  // Union-find over provisional run labels. The smaller label always becomes
+  // the root, so a root is the first run of its component in raster order.
+  struct label_sets
+  {
+    std::vector<int> parent;
+
+    int add() {
+      int label = static_cast<int>(parent.size());
+      parent.push_back(label);
+      return label;
+    }
+
+    int find(int label) {
+      while (parent[label] != label) {
+        parent[label] = parent[parent[label]];
+        label = parent[label];
+      }
+      return label;
+    }
+
+    void unite(int a, int b) {
+      a = find(a);
+      b = find(b);
+      if (a < b) {
+        parent[b] = a;
+      } else if (b < a) {
+        parent[a] = b;
+      }
+    }
+  };
+
+  struct labeled_run
+  {
+    int y;
+    int x_begin;
+    int x_end;
+    int label;
+    uint64_t sums[3];  // B, G, R
+  };
+
+}
+
+cv::Mat flx_color_region::to_local_mask(int border) const {
+  cv::Mat mask = cv::Mat::zeros(bounding_box.height + 2 * border, bounding_box.width + 2 * border, CV_8UC1);
+  for (const run& r : runs) {
+    uchar* row = mask.ptr<uchar>(r.y - bounding_box.y + border);
+    std::memset(row + r.x_begin - bounding_box.x + border, 255, static_cast<size_t>(r.x_end - r.x_begin));
+  }
+  return mask;
+}
+
+cv::Mat flx_color_region::to_mask(cv::Size page_size) const {
+  cv::Mat mask = cv::Mat::zeros(page_size, CV_8UC1);
+  for (const run& r : runs) {
+    std::memset(mask.ptr<uchar>(r.y) + r.x_begin, 255, static_cast<size_t>(r.x_end - r.x_begin));
+  }
+  return mask;
+}
+
+namespace flx_regions {
+
+  std::vector<flx_color_region> label_color_regions(const cv::Mat& image, int tolerance, int min_area) {
+    std::vector<flx_color_region> regions;
+    if (image.empty() || image.type() != CV_8UC3) {
+      return regions;
+    }
+
+    const int width = image.cols;
+    const int height = image.rows;
+    std::vector<uchar> horizontal(static_cast<size_t>(width));
+    std::vector<uchar> vertical(static_cast<size_t>(width));
+    std::vector<int> labels(static_cast<size_t>(width));
+    std::vector<int> previous_labels(static_cast<size_t>(width));
+    std::vector<int> run_ends(static_cast<size_t>(width));
+    std::vector<labeled_run> runs;
+    runs.reserve(static_cast<size_t>(height) * 4);
+    label_sets sets;
+
+    // Pass 1: split every row into runs of similar neighbours, then join runs
+    // of consecutive rows wherever a pixel is similar to the one above it.
+    // The colour sums of the regions are gathered per run on the way.
+    for (int y = 0; y < height; ++y) {
+      const uchar* row = image.ptr<uchar>(y);
+      similar_pixels(row, row + 3, width - 1, tolerance, horizontal.data());
+      int run_count = encode_runs(horizontal.data(), width, run_ends.data());
+
+      int x = 0;
+      for (int k = 0; k < run_count; ++k) {
+        labeled_run r{y, x, run_ends[static_cast<size_t>(k)], sets.add(), {0, 0, 0}};
+        sum_pixels(row + 3 * x, r.x_end - x, r.sums);
+        std::fill(labels.begin() + r.x_begin, labels.begin() + r.x_end, r.label);
+        runs.push_back(r);
+        x = r.x_end;
+      }
+
+      if (y > 0) {
+        similar_pixels(image.ptr<uchar>(y - 1), row, width, tolerance, vertical.data());
+        int last_above = -1;
+        int last_below = -1;
+        for (int i = 0; i < width; ++i) {
+          if (!vertical[static_cast<size_t>(i)]) continue;
+          int above = previous_labels[static_cast<size_t>(i)];
+          int below = labels[static_cast<size_t>(i)];
+          if (above != last_above || below != last_below) {
+            sets.unite(above, below);
+            last_above = above;
+            last_below = below;
+          }
+        }
+      }
+      std::swap(labels, previous_labels);
+    }
+
+    // Pass 2 (over runs only): resolve roots and sum region sizes
+    std::vector<int> area(sets.parent.size(), 0);
+    for (labeled_run& r : runs) {
+      r.label = sets.find(r.label);
+      area[static_cast<size_t>(r.label)] += r.x_end - r.x_begin;
+    }
+
+    // Pass 3: collect the large regions; the first run seen per root is the
+    // component's first pixel in raster order, which fixes the region order
+    std::vector<int> region_of(sets.parent.size(), -1);
+    std::vector<cv::Vec4i> extent;  // min x, min y, max x (exclusive), max y
+    std::vector<cv::Vec3d> sums;
+    for (const labeled_run& r : runs) {
+      if (area[static_cast<size_t>(r.label)] < min_area) continue;
+      int& index = region_of[static_cast<size_t>(r.label)];
+      if (index < 0) {
+        index = static_cast<int>(regions.size());
+        regions.emplace_back();
+        regions.back().pixel_count = area[static_cast<size_t>(r.label)];
+        extent.push_back(cv::Vec4i(r.x_begin, r.y, r.x_end, r.y));
+        sums.push_back(cv::Vec3d(0.0, 0.0, 0.0));
+      }
+      flx_color_region& region = regions[static_cast<size_t>(index)];
+      region.runs.push_back({r.y, r.x_begin, r.x_end});
+      cv::Vec4i& e = extent[static_cast<size_t>(index)];
+      e[0] = std::min(e[0], r.x_begin);
+      e[2] = std::max(e[2], r.x_end);
+      e[3] = r.y;
+      cv::Vec3d& s = sums[static_cast<size_t>(index)];
+      s[0] += static_cast<double>(r.sums[0]);
+      s[1] += static_cast<double>(r.sums[1]);
+      s[2] += static_cast<double>(r.sums[2]);
+    }
+
+    for (size_t i = 0; i < regions.size(); ++i) {
+      const cv::Vec4i& e = extent[i];
+      const cv::Vec3d& s = sums[i];
+      double count = static_cast<double>(regions[i].pixel_count);
+      regions[i].bounding_box = cv::Rect(e[0], e[1], e[2] - e[0], e[3] - e[1] + 1);
+      regions[i].mean_color = cv::Scalar(s[0] / count, s[1] / count, s[2] / count, 0.0);
+    }
+    return regions;
+  }
+
+}
@@ -0,0 +1,74 @@
+#ifndef FLX_PDF_REGIONS_H
+#define FLX_PDF_REGIONS_H
+
+#include <opencv2/opencv.hpp>
+#include <cstdint>
+#include <vector>
+
+/*
+ * Colour-coherent region of a rendered page.
+ * Two 4-neighbours belong to the same region when the sum of their absolute
+ * B, G and R differences is at most the tolerance (neighbour-to-neighbour, so
+ * a gradient can grow a region step by step).
+ * The pixels are stored as horizontal runs instead of a full-page mask.
+ */
+struct flx_color_region
+{
+  struct run {
+    int y;
+    int x_begin;  // inclusive
+    int x_end;    // exclusive
+  };
+
+  cv::Rect bounding_box;
+  int pixel_count = 0;
+  cv::Scalar mean_color;  // B, G, R like cv::mean
+  std::vector<run> runs;  // raster order
+
+  // Mask of bounding_box size plus border pixels on every side
+  cv::Mat to_local_mask(int border = 0) const;
+  // Full-page mask (debug output)
+  cv::Mat to_mask(cv::Size page_size) const;
+};
+
+namespace flx_regions {
+
+  /*
+   * Connected-component labeling of a BGR (CV_8UC3) image over runs with a
+   * union-find, in one pass over the pixels. Regions smaller than min_area
+   * are dropped. Regions come out ordered by their first pixel in raster
+   * order, the same order a seed-per-unvisited-pixel flood fill finds them.
+   */
+  std::vector<flx_color_region> label_color_regions(const cv::Mat& image, int tolerance = 20, int min_area = 100);
+
+  /*
+   * Pixel kernels of the labeling, in flx_pdf_region_kernels.cpp. Each has
+   * a scalar version and SSSE3/AVX2 versions (x86 with GCC/Clang); the best
+   * one the CPU supports is picked at runtime. All levels give identical
+   * results.
+   */
+  enum class simd_level { scalar, ssse3, avx2 };
+
+  // Best level of this CPU
+  simd_level supported_simd_level();
+  // Level the kernels use; set_simd_level clamps to the supported one
+  // (tests and benchmarks compare levels with it)
+  simd_level active_simd_level();
+  void set_simd_level(simd_level level);
+  const char* simd_level_name(simd_level level);
+
+  // out[x] = 1 if pixels a[x] and b[x] (BGR) are within tolerance, else 0
+  void similar_pixels(const uchar* a, const uchar* b, int count, int tolerance, uchar* out);
+
+  // Splits a row of width pixels into runs: joined[x] (width - 1 entries,
+  // from similar_pixels of the row and the row shifted by one) says whether
+  // x and x + 1 are in the same run. Writes the exclusive run ends and
+  // returns the number of runs.
+  int encode_runs(const uchar* joined, int width, int* run_ends);
+
+  // Per channel sums of count BGR pixels
+  void sum_pixels(const uchar* bgr, int count, uint64_t sums[3]);
+
+}
+
+#endif // FLX_PDF_REGIONS_H
@@ -1,11 +1,20 @@
 #include "flx_pdf_sio.h"
 #include "flx_pdf_text_extractor.h"
+#include "flx_pdf_font_cache.h"
+#include "flx_pdf_page_cache.h"
+#include "flx_pdf_content.h"
+#include "../layout/flx_layout_index.h"
 #include <main/PdfMemDocument.h>
 #include <main/PdfPainter.h>
 #include <main/PdfColor.h>
 #include <auxiliary/StreamDevice.h>
 #include <main/PdfContentStreamReader.h>
+#include <map>
 #include <unordered_map>
+#include <unordered_set>
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
 #include <opencv2/opencv.hpp>
 #include <iostream>
 #include <iomanip>
@@ -14,6 +23,14 @@
 #include <fstream>
 #include <sstream>
 #include <stack>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include "../../utils/flx_thread_pool.h"
+#include "../../api/server/flx_metrics.h"
 
 using namespace PoDoFo;
 
@@ -57,27 +74,57 @@ flx_pdf_sio::~flx_pdf_sio() {
 }
 
 bool flx_pdf_sio::parse(flx_string &data) {
+  release_document();
   this->pdf_data = data;
+  return parse_input();
+}
+
+bool flx_pdf_sio::parse_file(const flx_string& path) {
+  release_document();
+  pdf_data.clear();
+  auto how = m_parse_options.copy_input ? flx_mapped_file::mode::copy : flx_mapped_file::mode::map;
+  if (!m_input_file.open(path.c_str(), how)) {
+    std::cout << "❌ PDF loading failed: " << m_input_file.last_error() << std::endl;
+    return false;
+  }
+  FLX_PDF_TRACE_LOG(m_trace, (m_parse_options.copy_input ? "📄 Read " : "📄 Mapped ") << path.c_str() << " (" << m_input_file.size() << " bytes)");
+  return parse_input();
+}
+
+std::string_view flx_pdf_sio::input() const {
+  if (m_input_file.is_open()) {
+    return m_input_file.view();
+  }
+  return std::string_view(pdf_data.c_str(), pdf_data.size());
+}
+
+// The document reads from the input bytes until it is gone, so it is
+// dropped before the input is replaced
+void flx_pdf_sio::release_document() {
+  if (m_pdf != nullptr) {
+    delete m_pdf;
+    m_pdf = nullptr;
+  }
+  clear_font_cache();
+  m_input_file.close();
+}
+
+bool flx_pdf_sio::parse_input() {
+  m_trace.reset();
+  FLX_PDF_TRACE_SPAN(m_trace, "parse");
   try {
-    if (m_pdf != nullptr) {
-      delete m_pdf;
-    }
     m_pdf = new PdfMemDocument();
 
-    // CRITICAL FIX for XObject support: Create stable buffer copy!
-    // PoDoFo's XObject processing accesses the buffer LATER (lazy loading).
-    // The buffer MUST remain valid throughout the entire lifetime of PdfMemDocument!
-    // std::vector<char> guarantees stable pointer (no reallocation after construction).
-    pdf_data_buffer.clear();
-    pdf_data_buffer.reserve(data.size());
-    pdf_data_buffer.assign(data.c_str(), data.c_str() + data.size());
-
-    bufferview buffer(pdf_data_buffer.data(), pdf_data_buffer.size());
+    // PoDoFo loads objects (XObjects included) on demand from this view,
+    // it stays valid as long as m_pdf (see release_document)
+    std::string_view bytes = input();
+    bufferview buffer(bytes.data(), bytes.size());
 
     // Try to load PDF - some PDFs may have EOF marker issues
     try {
+      FLX_PDF_TRACE_SPAN(m_trace, "load");
       m_pdf->LoadFromBuffer(buffer);
-      std::cout << "✅ PDF loaded successfully" << std::endl;
+      FLX_PDF_TRACE_LOG(m_trace, "✅ PDF loaded successfully");
     } catch (const std::exception& e) {
       std::cout << "❌ PDF loading failed: " << e.what() << std::endl;
       std::cout << "This may be due to PDF format issues or missing EOF markers." << std::endl;
@@ -85,7 +132,7 @@ bool flx_pdf_sio::parse(flx_string &data) {
       return false;
     }
     
-    std::cout << "Starting complete PDF → Layout extraction..." << std::endl;
+    FLX_PDF_TRACE_LOG(m_trace, "Starting complete PDF → Layout extraction...");
 
     // DISABLED: Phase 1 extraction was interfering with XObject processing in Phase 2!
     // The first pass through all pages was somehow consuming/modifying XObjects,
@@ -136,25 +183,21 @@ bool flx_pdf_sio::parse(flx_string &data) {
     
     for (size_t page_idx = 0; page_idx < clean_images.size(); page_idx++) {
       const cv::Mat& page_image = clean_images[page_idx];
-      std::cout << "📄 Processing page " << (page_idx + 1) << " (" << page_image.cols << "x" << page_image.rows << ")" << std::endl;
+      FLX_PDF_TRACE_LOG(m_trace, "📄 Processing page " << (page_idx + 1) << " (" << page_image.cols << "x" << page_image.rows << ")");
       
-      // Create debug directory for this page
-      std::string debug_dir = "debug_page_" + std::to_string(page_idx + 1);
-      create_debug_directory(debug_dir);
-      
-      // Save original rendered PDF image
-      std::string original_path = debug_dir + "/01_original_pdf_render.png";
-      cv::imwrite(original_path, page_image);
-      std::cout << "💾 Saved original PDF render: " << original_path << std::endl;
+      // Original rendered PDF image (trace artifact)
+      if (FLX_PDF_TRACE_ARTIFACTS(m_trace)) {
+        m_trace.write_artifact(page_idx, "01_original_pdf_render.png", page_image);
+      }
       
-      // Detect color regions using flood-fill
-      auto color_masks = detect_color_regions(page_image, debug_dir);
+      // Detect color regions (connected-component labeling)
+      auto color_regions = detect_color_regions(page_image, page_idx);
       
-      // Extract contours from masks
-      auto page_contours = extract_contours_from_masks(color_masks, page_image, debug_dir);
+      // Extract contours from the region runs
+      auto page_contours = extract_contours_from_regions(color_regions, page_image, page_idx);
       all_page_contours.push_back(page_contours);
       
-      std::cout << "✅ Page " << (page_idx + 1) << " complete: " << page_contours.size() << " regions detected" << std::endl;
+      FLX_PDF_TRACE_LOG(m_trace, "✅ Page " << (page_idx + 1) << " complete: " << page_contours.size() << " regions detected");
     }
     
     // Step 6: Build hierarchical geometry structure from contours
@@ -174,50 +217,28 @@ bool flx_pdf_sio::parse(flx_string &data) {
     */
     
     // Create page structures and extract texts directly into them
-    std::cout << "Creating page structures from PDF..." << std::endl;
-
-    // CRITICAL FIX: Clear static font cache before second extraction pass!
-    // The font cache contains PdfFont* pointers from the first pass, which may be invalid
-    // for the second pass extraction. This was causing XObject texts to be skipped.
-    std::cout << "🔧 Clearing font cache before per-page extraction..." << std::endl;
-    flx_pdf_text_extractor::clear_font_cache();
+    FLX_PDF_TRACE_LOG(m_trace, "Creating page structures from PDF...");
 
-    pages = flx_model_list<flx_layout_geometry>();
+    // Clear in place: assigning a fresh list would detach pages from the
+    // model, and the JSON of this object would show no pages
+    pages.clear();
     int page_count = m_pdf->GetPages().GetCount();
 
-    // Extract texts page by page directly into page structures
-    for (int page_idx = 0; page_idx < page_count; page_idx++) {
-        pages.add_element();
-        auto& page_geom = pages.back();
-
-        // Set up basic page geometry (full page bounds)
-        page_geom.x = 0.0;
-        page_geom.y = 0.0;
-        page_geom.width = 595.0;  // A4 width in points (TODO: read actual page size)
-        page_geom.height = 842.0; // A4 height in points
-
-        // CRITICAL FIX: Clear font cache between pages to prevent XObject processing issues
-        // The static font cache can contain stale PdfFont* pointers from previous pages,
-        // causing XObject text extraction to fail on subsequent pages.
-        flx_pdf_text_extractor::clear_font_cache();
-
-        // Extract texts for this specific page
-        auto& pdf_page = m_pdf->GetPages().GetPageAt(page_idx);
-        flx_pdf_text_extractor extractor;
-        extractor.extract_text_with_fonts(pdf_page, page_geom.texts);
+    // Extract texts page by page (in parallel) directly into page structures
+    if (!run_page_pipeline(page_count)) {
+      return false;
     }
 
     // Count total texts across all pages
     int total_texts = 0;
-    for (int i = 0; i < pages.size(); i++) {
+    for (size_t i = 0; i < pages.size(); i++) {
         total_texts += pages[i].texts.size();
     }
 
-    std::cout << "✅ Created " << pages.size() << " page structures with "
-              << total_texts << " texts total" << std::endl;
-    
-    std::cout << "Complete PDF → Layout extraction finished. Created " 
-              << pages.size() << " page structures." << std::endl;
+    FLX_PDF_TRACE_COUNT(m_trace, "pages", pages.size());
+    FLX_PDF_TRACE_COUNT(m_trace, "texts", total_texts);
+    FLX_PDF_TRACE_LOG(m_trace, "✅ Created " << pages.size() << " page structures with "
+                      << total_texts << " texts total");
     
     return true;
   } catch (const std::exception& e) {
@@ -226,27 +247,787 @@ bool flx_pdf_sio::parse(flx_string &data) {
   }
 }
 
+namespace {
+
+  // Pixel coordinates of a page rendered at dpi -> PDF points
+  void geometries_to_points(flx_model_list<flx_layout_geometry>& geometries, double dpi) {
+    for (size_t i = 0; i < geometries.size(); ++i) {
+      auto& geometry = geometries[i];
+      geometry.x = flx_coords::png_to_pdf_coord(geometry.x, dpi);
+      geometry.y = flx_coords::png_to_pdf_coord(geometry.y, dpi);
+      geometry.width = flx_coords::png_to_pdf_coord(geometry.width, dpi);
+      geometry.height = flx_coords::png_to_pdf_coord(geometry.height, dpi);
+      for (size_t v = 0; v < geometry.vertices.size(); ++v) {
+        auto& vertex = geometry.vertices[v];
+        vertex.x = flx_coords::png_to_pdf_coord(vertex.x, dpi);
+        vertex.y = flx_coords::png_to_pdf_coord(vertex.y, dpi);
+      }
+      geometries_to_points(geometry.sub_geometries, dpi);
+    }
+  }
+
+  // Affine PDF matrix [a b c d e f]
+  struct pdf_matrix {
+    double a = 1.0, b = 0.0, c = 0.0, d = 1.0, e = 0.0, f = 0.0;
+  };
+
+  // m applied first, then n
+  pdf_matrix multiply(const pdf_matrix& m, const pdf_matrix& n) {
+    return {m.a * n.a + m.b * n.c, m.a * n.b + m.b * n.d,
+            m.c * n.a + m.d * n.c, m.c * n.b + m.d * n.d,
+            m.e * n.a + m.f * n.c + n.e, m.e * n.b + m.f * n.d + n.f};
+  }
+
+  const char* image_mime_type(const PdfDictionary& image) {
+    const PdfObject* filter = image.FindKey("Filter");
+    const PdfName* name = nullptr;
+    if (filter != nullptr && filter->IsArray() && filter->GetArray().GetSize() > 0) {
+      filter = filter->GetArray().FindAt(filter->GetArray().GetSize() - 1);
+    }
+    if (filter == nullptr || !filter->TryGetName(name)) {
+      return "";
+    }
+    if (*name == "DCTDecode") return "image/jpeg";
+    if (*name == "JPXDecode") return "image/jp2";
+    return "";
+  }
+
+  /*
+   * Image XObjects drawn by a content stream, with their bounds in layout
+   * coordinates (top left origin): the unit square under the current
+   * transformation matrix. Form XObjects are followed with their own
+   * matrix and resources.
+   */
+  void collect_image_placements(std::string_view content, const PdfDictionary* resources, const pdf_matrix& base,
+                                double page_height, int depth, flx_model_list<flx_layout_image>& images) {
+    const PdfObject* xobjects = resources != nullptr ? resources->FindKey("XObject") : nullptr;
+    if (xobjects == nullptr || !xobjects->IsDictionary()) {
+      return;
+    }
+
+    pdf_matrix ctm = base;
+    std::vector<pdf_matrix> saved;
+    flx_pdf_content_scanner scanner(content);
+    flx_pdf_content_scanner::instruction instruction;
+    while (scanner.next(instruction)) {
+      if (instruction.op == "q") {
+        saved.push_back(ctm);
+      } else if (instruction.op == "Q") {
+        if (!saved.empty()) {
+          ctm = saved.back();
+          saved.pop_back();
+        }
+      } else if (instruction.op == "cm") {
+        double v[6];
+        if (instruction.numbers(v, 6)) {
+          ctm = multiply({v[0], v[1], v[2], v[3], v[4], v[5]}, ctm);
+        }
+      } else if (instruction.op == "Do" && instruction.operand_count() > 0) {
+        const auto& operand = instruction.operands->back();
+        if (operand.type != flx_pdf_content_lexer::token_type::name) continue;
+        const PdfObject* xobject = xobjects->GetDictionary().FindKey(operand.text);
+        if (xobject == nullptr || !xobject->IsDictionary()) continue;
+        const PdfDictionary& dict = xobject->GetDictionary();
+        const PdfName* subtype = nullptr;
+        if (!dict.TryFindKeyAs("Subtype", subtype)) continue;
+
+        if (*subtype == "Image") {
+          double xs[4] = {ctm.e, ctm.a + ctm.e, ctm.c + ctm.e, ctm.a + ctm.c + ctm.e};
+          double ys[4] = {ctm.f, ctm.b + ctm.f, ctm.d + ctm.f, ctm.b + ctm.d + ctm.f};
+          double left = *std::min_element(xs, xs + 4);
+          double right = *std::max_element(xs, xs + 4);
+          double bottom = *std::min_element(ys, ys + 4);
+          double top = *std::max_element(ys, ys + 4);
+
+          flx_layout_image image(left, page_height - top, right - left, top - bottom);
+          const PdfObject* width = dict.FindKey("Width");
+          const PdfObject* height = dict.FindKey("Height");
+          if (width != nullptr && height != nullptr) {
+            image.original_width = static_cast<int>(width->GetNumberLenient());
+            image.original_height = static_cast<int>(height->GetNumberLenient());
+          }
+          const char* mime_type = image_mime_type(dict);
+          if (*mime_type != '\0') {
+            image.mime_type = mime_type;
+          }
+          images.push_back(image);
+        } else if (*subtype == "Form" && depth < 8 && xobject->HasStream()) {
+          pdf_matrix form;
+          const PdfObject* matrix = dict.FindKey("Matrix");
+          if (matrix != nullptr && matrix->IsArray() && matrix->GetArray().GetSize() == 6) {
+            const PdfArray& m = matrix->GetArray();
+            form = {m[0].GetReal(), m[1].GetReal(), m[2].GetReal(), m[3].GetReal(), m[4].GetReal(), m[5].GetReal()};
+          }
+          const PdfObject* form_resources = dict.FindKey("Resources");
+          charbuff form_content = xobject->GetStream()->GetCopy();
+          collect_image_placements(std::string_view(form_content.data(), form_content.size()),
+                                   form_resources != nullptr && form_resources->IsDictionary() ? &form_resources->GetDictionary() : resources,
+                                   multiply(form, ctm), page_height, depth + 1, images);
+        }
+      }
+    }
+  }
+
+}
+
+// Spatial index of one geometry list; the indexes of the sub-geometry lists
+// are built the first time content lands in them
+struct flx_pdf_sio::geometry_index {
+  bool built = false;
+  flx_layout_index boxes;
+  std::vector<std::unique_ptr<geometry_index>> children;
+};
+
+// One page on its way through the pipeline; dropped once merged into pages
+struct flx_pdf_sio::page_job {
+  int page_index = 0;
+  int raster_page = 0;          // 1-based page of the geometry source
+  size_t next_stage = 0;
+  flx_model_list<flx_layout_text> texts;
+  flx_model_list<flx_layout_image> images;
+  flx_model_list<flx_layout_geometry> geometries;
+  std::string fingerprint;      // page cache key (with a page cache only)
+  flx_layout_geometry cached;   // layout restored from the page cache
+  bool from_cache = false;
+  std::string error;
+  bool done = false;
+};
+
+// Renders the geometry source once, on its own thread, and hands every page
+// to its job. Pages are rendered only once their job has started, so at most
+// the pipeline window of images is held; pages nobody takes (served from the
+// page cache) are dropped when merged
+struct flx_pdf_sio::raster_feed {
+  std::mutex mutex;
+  std::condition_variable changed;
+  std::map<int, cv::Mat> pages;  // rendered and not taken yet, by raster page
+  int started = 0;               // raster pages whose job has started
+  int merged = 0;                // raster pages that no longer need an image
+  bool closed = false;
+  bool finished = false;
+  std::string error;
+  std::thread thread;
+
+  void start(const std::string& source, const flx_pdf_rasterizer::options& options) {
+    thread = std::thread([this, &source, options] {
+      flx_pdf_rasterizer rasterizer(options);
+      bool ok = rasterizer.render(source.data(), source.size(), [this](int page_number, cv::Mat& page) {
+        std::unique_lock<std::mutex> lock(mutex);
+        changed.wait(lock, [&] { return closed || page_number <= started; });
+        if (closed) {
+          return false;
+        }
+        if (page_number > merged) {
+          pages[page_number] = std::move(page);
+          changed.notify_all();
+        }
+        return true;
+      });
+      std::lock_guard<std::mutex> lock(mutex);
+      if (!ok && !closed) {
+        error = rasterizer.last_error();
+      }
+      finished = true;
+      changed.notify_all();
+    });
+  }
+
+  // Blocks until the page is rendered; false if rendering ended without it
+  bool take(int raster_page, cv::Mat& page) {
+    std::unique_lock<std::mutex> lock(mutex);
+    changed.wait(lock, [&] { return closed || finished || pages.count(raster_page) > 0; });
+    auto it = pages.find(raster_page);
+    if (it == pages.end()) {
+      return false;
+    }
+    page = std::move(it->second);
+    pages.erase(it);
+    return true;
+  }
+
+  void set_started(int raster_page) {
+    std::lock_guard<std::mutex> lock(mutex);
+    started = raster_page;
+    changed.notify_all();
+  }
+
+  void set_merged(int raster_page) {
+    std::lock_guard<std::mutex> lock(mutex);
+    merged = raster_page;
+    pages.erase(raster_page);
+  }
+
+  ~raster_feed() {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      closed = true;
+    }
+    changed.notify_all();
+    if (thread.joinable()) {
+      thread.join();
+    }
+  }
+};
+
+// Page indexes of the extract options' ranges, in document order
+std::vector<int> flx_pdf_sio::selected_pages(int page_count) const {
+  std::vector<int> indexes;
+  if (m_extract_options.pages.empty()) {
+    for (int i = 0; i < page_count; ++i) {
+      indexes.push_back(i);
+    }
+    return indexes;
+  }
+  std::vector<bool> selected(page_count, false);
+  for (const auto& range : m_extract_options.pages) {
+    int first = std::max(1, range.first);
+    int last = (range.last <= 0 || range.last > page_count) ? page_count : range.last;
+    for (int number = first; number <= last; ++number) {
+      selected[number - 1] = true;
+    }
+  }
+  for (int i = 0; i < page_count; ++i) {
+    if (selected[i]) {
+      indexes.push_back(i);
+    }
+  }
+  return indexes;
+}
+
+bool flx_pdf_sio::extract_options::parse_page_list(const std::string& list, std::vector<page_range>& ranges) {
+  ranges.clear();
+  auto read_number = [](const std::string& text, size_t& pos, int& value) {
+    size_t start = pos;
+    value = 0;
+    while (pos < text.size() && std::isdigit(static_cast<unsigned char>(text[pos])) && value < 1000000) {
+      value = value * 10 + (text[pos++] - '0');
+    }
+    return pos > start && value > 0;
+  };
+
+  size_t pos = 0;
+  while (pos < list.size()) {
+    page_range range;
+    if (!read_number(list, pos, range.first)) {
+      return false;
+    }
+    range.last = range.first;
+    if (pos < list.size() && list[pos] == '-') {
+      ++pos;
+      range.last = 0;  // "10-": to the end
+      if (pos < list.size() && list[pos] != ',') {
+        if (!read_number(list, pos, range.last) || range.last < range.first) {
+          return false;
+        }
+      }
+    }
+    ranges.push_back(range);
+    if (pos < list.size()) {
+      if (list[pos] != ',' || ++pos == list.size()) {
+        return false;
+      }
+    }
+  }
+  return !ranges.empty();
+}
+
+bool flx_pdf_sio::run_page_pipeline(int page_count) {
+  m_stage_timings.clear();
+  auto pipeline_start = std::chrono::steady_clock::now();
+
+  const extract_options& extract = m_extract_options;
+  bool geometry = extract.geometry || extract.hierarchy;
+  std::vector<int> page_indexes = selected_pages(page_count);
+  int job_count = static_cast<int>(page_indexes.size());
+  FLX_PDF_TRACE_COUNT(m_trace, "pipeline.selected_pages", job_count);
+
+  // The raster pass works on one copy of the selected pages without texts and
+  // images. The first page that reaches the geometry stage builds it and
+  // starts rendering it, so a run served from the page cache never does
+  std::string geometry_source;
+  std::once_flag geometry_source_once;
+  bool geometry_source_ok = false;
+  flx_pdf_rasterizer::options raster_options = m_render_options;
+  raster_options.dpi = extract.dpi;
+  raster_options.first_page = 1;
+  raster_options.last_page = job_count;
+  // Declared after the source: the render thread is joined before it goes away
+  raster_feed feed;
+
+  // Pages parsed with other stages are different entries in the page cache
+  std::string cache_variant;
+  if (!extract.texts || extract.images || geometry) {
+    cache_variant = std::string(extract.texts ? "t" : "") + (extract.images ? "i" : "") +
+                    (extract.geometry ? "g" : "") + (extract.hierarchy ? "h" : "");
+    if (geometry) {
+      cache_variant += "@" + std::to_string(extract.dpi);
+    }
+  }
+
+  size_t threads = m_parse_options.threads;
+  if (threads == 0) {
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  threads = std::max<size_t>(1, std::min<size_t>(threads, job_count));
+  size_t window = m_parse_options.max_pages_in_flight ? m_parse_options.max_pages_in_flight : 2 * threads;
+
+  // Workers parse their own copy of the document from the shared buffer:
+  // PdfMemDocument loads objects lazily and is not safe to share across threads
+  std::unique_ptr<flx_thread_pool> pool;
+  if (threads > 1) {
+    pool = std::make_unique<flx_thread_pool>(threads);
+  }
+  std::vector<std::unique_ptr<PdfMemDocument>> worker_docs(threads);
+  // Fonts are cached per document and live as long as it, across all its pages
+  std::vector<std::unique_ptr<flx_pdf_font_cache>> worker_fonts(threads);
+
+  // Summed per stage for get_stage_timings(), also exported as pdf.parse.<stage> metrics
+  struct stage_clock {
+    const char* name;
+    flx_metric& metric;
+    std::atomic<uint64_t> nanos{0};
+    std::atomic<size_t> count{0};
+    explicit stage_clock(const char* n)
+      : name(n), metric(flx_metrics::instance().timer(flx_string("pdf.parse.") + n)) {}
+    void add(std::chrono::steady_clock::duration elapsed) {
+      nanos += std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+      ++count;
+    }
+  };
+  stage_clock load_clock{"load_document"};
+  stage_clock merge_clock{"merge"};
+
+  auto document = [&]() -> PdfMemDocument& {
+    if (!pool) {
+      return *m_pdf;
+    }
+    auto& doc = worker_docs[pool->current_worker()];
+    if (!doc) {
+      FLX_PDF_TRACE_SPAN(m_trace, "load_document");
+      flx_scoped_timer timer(load_clock.metric);
+      auto start = std::chrono::steady_clock::now();
+      doc = std::make_unique<PdfMemDocument>();
+      std::string_view bytes = input();
+      doc->LoadFromBuffer(bufferview(bytes.data(), bytes.size()));
+      load_clock.add(std::chrono::steady_clock::now() - start);
+    }
+    return *doc;
+  };
+  auto fonts = [&]() -> flx_pdf_font_cache& {
+    if (!pool) {
+      return font_cache();
+    }
+    auto& cache = worker_fonts[pool->current_worker()];
+    if (!cache) {
+      cache = std::make_unique<flx_pdf_font_cache>();
+    }
+    return *cache;
+  };
+
+  // Per-page task chain of the requested stages
+  struct page_stage {
+    stage_clock clock;
+    std::function<void(page_job&)> run;
+  };
+  std::vector<std::unique_ptr<page_stage>> stages;
+  // With a page cache, unchanged pages end after their fingerprint
+  if (m_page_cache != nullptr) {
+    stages.push_back(std::unique_ptr<page_stage>(new page_stage{stage_clock("fingerprint"), [&](page_job& job) {
+      auto& pdf_page = document().GetPages().GetPageAt(job.page_index);
+      job.fingerprint = flx_pdf_page_cache::fingerprint(pdf_page, cache_variant);
+      job.from_cache = m_page_cache->load(job.fingerprint, job.cached);
+    }}));
+  }
+  if (extract.texts) {
+    stages.push_back(std::unique_ptr<page_stage>(new page_stage{stage_clock("extract_text"), [&](page_job& job) {
+      auto& pdf_page = document().GetPages().GetPageAt(job.page_index);
+      flx_pdf_text_extractor extractor(&fonts(), &m_trace);
+      extractor.extract_text_with_fonts(pdf_page, job.texts);
+    }}));
+  }
+  if (extract.images) {
+    stages.push_back(std::unique_ptr<page_stage>(new page_stage{stage_clock("extract_images"), [&](page_job& job) {
+      extract_page_images(document().GetPages().GetPageAt(job.page_index), job.images);
+    }}));
+  }
+  if (geometry) {
+    // Render, color regions and contours in pixels, then geometries in points
+    stages.push_back(std::unique_ptr<page_stage>(new page_stage{stage_clock("geometry"), [&](page_job& job) {
+      std::call_once(geometry_source_once, [&] {
+        geometry_source_ok = create_geometry_source(page_indexes, geometry_source);
+        if (geometry_source_ok) {
+          feed.start(geometry_source, raster_options);
+        }
+      });
+      if (!geometry_source_ok) {
+        throw std::runtime_error("creating the geometry source failed");
+      }
+      cv::Mat image;
+      if (!feed.take(job.raster_page, image)) {
+        std::lock_guard<std::mutex> lock(feed.mutex);
+        throw std::runtime_error("rendering failed: " + (feed.error.empty() ? std::string("page missing") : feed.error));
+      }
+      if (FLX_PDF_TRACE_ARTIFACTS(m_trace)) {
+        m_trace.write_artifact(job.page_index, "01_original_pdf_render.png", image);
+      }
+      auto regions = detect_color_regions(image, job.page_index);
+      // A contour outlines one region: its colour is the region mean from the labeling
+      std::vector<int> contour_regions;
+      auto contours = extract_contours_from_regions(regions, image, job.page_index, &contour_regions);
+      std::vector<cv::Scalar> colors;
+      for (int region : contour_regions) {
+        colors.push_back(regions[region].mean_color);
+      }
+      build_page_geometries(contours, image, job.geometries, &colors);
+      geometries_to_points(job.geometries, extract.dpi);
+    }}));
+  }
+  if (extract.hierarchy) {
+    // Containers take the regions inside them, then the texts and images
+    // inside a region move there; the rest stays on the page
+    stages.push_back(std::unique_ptr<page_stage>(new page_stage{stage_clock("hierarchy"), [&](page_job& job) {
+      build_hierarchical_structure(job.geometries);
+      geometry_index index;
+      flx_model_list<flx_layout_text> page_texts;
+      for (size_t i = 0; i < job.texts.size(); i++) {
+        auto& text = job.texts[i];
+        flx_layout_geometry* target = find_content_target(index, job.geometries, text.x, text.y);
+        if (target != nullptr) {
+          target->texts.push_back(text);
+        } else {
+          page_texts.push_back(text);
+        }
+      }
+      flx_model_list<flx_layout_image> page_images;
+      for (size_t i = 0; i < job.images.size(); i++) {
+        auto& image = job.images[i];
+        flx_layout_geometry* target = find_content_target(index, job.geometries, image.x, image.y);
+        if (target != nullptr) {
+          target->images.push_back(image);
+        } else {
+          page_images.push_back(image);
+        }
+      }
+      job.texts = page_texts;
+      job.images = page_images;
+    }}));
+  }
+
+  // Set once on_page() ends parse(): started pages skip their remaining stages
+  std::atomic<bool> stopping{false};
+
+  std::mutex done_mutex;
+  std::condition_variable done_cv;
+
+  // Runs one stage and schedules the next one; on a worker the follow-up goes
+  // to its own deque, so a page usually finishes where it started
+  std::function<void(page_job*)> run_stage = [&](page_job* job) {
+    // Marks the job done on every way out, unless the next stage took it
+    // over: a job that is never done blocks the merge loop forever
+    struct done_guard {
+      page_job* job;
+      std::mutex& mutex;
+      std::condition_variable& cv;
+      int exceptions = std::uncaught_exceptions();
+      bool handed_off = false;
+
+      ~done_guard() {
+        if (handed_off) {
+          return;
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        if (std::uncaught_exceptions() > exceptions && job->error.empty()) {
+          job->error = "page pipeline interrupted";
+        }
+        job->done = true;
+        cv.notify_all();
+      }
+    } guard{job, done_mutex, done_cv};
+
+    if (job->next_stage < stages.size() && !stopping) {
+      page_stage& stage = *stages[job->next_stage];
+      FLX_PDF_TRACE_SPAN(m_trace, stage.clock.name);
+      flx_scoped_timer timer(stage.clock.metric);
+      auto start = std::chrono::steady_clock::now();
+      try {
+        stage.run(*job);
+      } catch (const std::exception& e) {
+        job->error = std::string(stage.clock.name) + ": " + e.what();
+        timer.fail();
+      } catch (...) {
+        job->error = std::string(stage.clock.name) + ": unknown exception";
+        timer.fail();
+      }
+      stage.clock.add(std::chrono::steady_clock::now() - start);
+    }
+
+    if (job->error.empty() && !job->from_cache && !stopping && ++job->next_stage < stages.size()) {
+      if (pool) {
+        pool->submit([&run_stage, job] { run_stage(job); });
+      } else {
+        run_stage(job);
+      }
+      guard.handed_off = true;
+    }
+  };
+
+  // Start pages while fewer than window are unmerged, merge strictly in page
+  // order: the result does not depend on the thread count
+  std::vector<std::unique_ptr<page_job>> jobs(job_count);
+  int next_start = 0;
+  int merged = 0;
+  size_t cached_pages = 0;
+  std::string error;
+  for (int next_merge = 0; next_merge < job_count; ++next_merge) {
+    while (next_start < job_count && static_cast<size_t>(next_start - next_merge) < window) {
+      jobs[next_start] = std::make_unique<page_job>();
+      page_job* job = jobs[next_start].get();
+      job->page_index = page_indexes[next_start];
+      job->raster_page = ++next_start;
+      if (geometry) {
+        feed.set_started(job->raster_page);
+      }
+      if (pool) {
+        pool->submit([&run_stage, job] { run_stage(job); });
+      } else {
+        run_stage(job);
+      }
+    }
+
+    page_job& job = *jobs[next_merge];
+    int page_number = job.page_index + 1;
+    {
+      std::unique_lock<std::mutex> lock(done_mutex);
+      done_cv.wait(lock, [&job] { return job.done; });
+    }
+    if (!job.error.empty() && error.empty()) {
+      error = "page " + std::to_string(job.page_index + 1) + ": " + job.error;
+    }
+
+    FLX_PDF_TRACE_SPAN(m_trace, "merge");
+    flx_scoped_timer merge_timer(merge_clock.metric);
+    auto merge_start = std::chrono::steady_clock::now();
+    pages.add_element();
+    auto& page_geom = pages.back();
+
+    if (job.from_cache) {
+      *page_geom = std::move(*job.cached);
+      ++cached_pages;
+    } else {
+      // Set up basic page geometry (full page bounds)
+      page_geom.x = 0.0;
+      page_geom.y = 0.0;
+      page_geom.width = 595.0;  // A4 width in points (TODO: read actual page size)
+      page_geom.height = 842.0; // A4 height in points
+      *page_geom.texts = std::move(*job.texts);
+      if (extract.images) {
+        *page_geom.images = std::move(*job.images);
+      }
+      if (geometry) {
+        *page_geom.sub_geometries = std::move(*job.geometries);
+      }
+      if (m_page_cache != nullptr && job.error.empty()) {
+        m_page_cache->store(job.fingerprint, page_geom);
+      }
+    }
+    if (geometry) {
+      feed.set_merged(job.raster_page);
+    }
+    jobs[next_merge].reset();
+    merge_clock.add(std::chrono::steady_clock::now() - merge_start);
+    ++merged;
+
+    if (extract.on_page && !extract.on_page(page_number, page_geom)) {
+      FLX_PDF_TRACE_LOG(m_trace, "⏹️ Extraction stopped after page " << page_number);
+      stopping = true;
+      break;
+    }
+  }
+
+  // Pages already started finish without their remaining stages and are dropped
+  for (int i = merged; i < next_start; ++i) {
+    page_job& job = *jobs[i];
+    std::unique_lock<std::mutex> lock(done_mutex);
+    done_cv.wait(lock, [&job] { return job.done; });
+  }
+  pool.reset();
+
+  double wall_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - pipeline_start).count();
+  auto report = [this](const stage_clock& clock) {
+    m_stage_timings.push_back({clock.name, clock.nanos / 1e6, clock.count});
+  };
+  report(load_clock);
+  for (const auto& stage : stages) {
+    report(stage->clock);
+  }
+  report(merge_clock);
+  m_stage_timings.push_back({"total", wall_ms, static_cast<size_t>(merged)});
+
+  FLX_PDF_TRACE_COUNT(m_trace, "pipeline.threads", threads);
+  if (m_page_cache != nullptr) {
+    FLX_PDF_TRACE_COUNT(m_trace, "page_cache.hits", cached_pages);
+  }
+  if (FLX_PDF_TRACE_LOGGING(m_trace)) {
+    std::cout << "⏱️ Page pipeline: " << merged << " of " << page_count << " pages on " << threads << " thread(s) in "
+              << std::fixed << std::setprecision(1) << wall_ms << " ms" << std::endl;
+    for (const auto& timing : m_stage_timings) {
+      if (timing.name == "total" || timing.count == 0) continue;
+      std::cout << "   " << timing.name << ": " << timing.total_ms << " ms (" << timing.count << "x, "
+                << timing.total_ms / timing.count << " ms each)" << std::endl;
+    }
+    std::cout.unsetf(std::ios::floatfield);
+  }
+
+  if (!error.empty()) {
+    std::cerr << "Error in PDF → Layout extraction: " << error << std::endl;
+    return false;
+  }
+  return true;
+}
+
+// serialize(): objects every page refers to. The font encoding records the
+// glyphs in use for subsetting, so it is only called under font_mutex. The
+// subset numbers glyphs in order of first use, so all characters are
+// registered serially in drawing order before the pages are built.
+struct flx_pdf_sio::serialize_resources {
+  PdfFont* font = nullptr;
+  std::mutex font_mutex;
+  std::vector<std::unique_ptr<PdfImage>> images;       // one XObject per distinct image
+  std::vector<std::vector<int>> page_images;           // image of every image element, drawing order (-1: not loadable)
+  std::unordered_map<std::string, int> path_images;    // image by file path
+  std::vector<std::unique_ptr<std::string>> image_data;
+  std::unordered_map<std::string_view, int> data_images;  // image by file content (views into image_data)
+};
+
+// Content stream of one page and the shared resources it draws
+struct flx_pdf_sio::page_content {
+  std::string stream;
+  bool uses_font = false;
+  std::vector<int> images;                // distinct images in order of first use
+  const std::vector<int>* image_slots = nullptr;
+  size_t next_image = 0;
+  PdfColor fill = PdfColor(0.0, 0.0, 0.0);  // colours in effect (PDF default black)
+  PdfColor stroke = PdfColor(0.0, 0.0, 0.0);
+};
+
+namespace {
+
+  const char* const font_resource = "F1";
+
+  std::string image_resource(int slot) {
+    return "Im" + std::to_string(slot + 1);
+  }
+
+  // Up to three decimals, no trailing zeros
+  void append_number(std::string& out, double value) {
+    char buffer[32];
+    int length = std::snprintf(buffer, sizeof(buffer), "%.3f", value);
+    while (length > 0 && buffer[length - 1] == '0') --length;
+    if (length > 0 && buffer[length - 1] == '.') --length;
+    if (length == 2 && buffer[0] == '-' && buffer[1] == '0') {
+      out += '0';
+      return;
+    }
+    out.append(buffer, length);
+  }
+
+  void append_operator(std::string& out, std::initializer_list<double> operands, const char* op) {
+    for (double operand : operands) {
+      append_number(out, operand);
+      out += ' ';
+    }
+    out += op;
+    out += '\n';
+  }
+
+  // Distinct UTF-8 characters of all texts, in drawing order
+  void collect_characters(flx_layout_geometry& geometry, std::string& characters, std::unordered_set<std::string>& seen) {
+    for (size_t i = 0; i < geometry.sub_geometries.size(); ++i) {
+      collect_characters(geometry.sub_geometries[i], characters, seen);
+    }
+    for (size_t i = 0; i < geometry.texts.size(); ++i) {
+      std::string text = geometry.texts[i].text->c_str();
+      for (size_t pos = 0; pos < text.size();) {
+        size_t length = 1;
+        while (pos + length < text.size() && (static_cast<unsigned char>(text[pos + length]) & 0xC0) == 0x80) {
+          ++length;
+        }
+        std::string character = text.substr(pos, length);
+        if (seen.insert(character).second) {
+          characters += character;
+        }
+        pos += length;
+      }
+    }
+  }
+
+}
+
 bool flx_pdf_sio::serialize(flx_string &data) {
   try {
     // Create new PDF document from layout structure
-    if (m_pdf != nullptr) {
-      delete m_pdf;
-    }
+    release_document();
     m_pdf = new PdfMemDocument();
     
-    // Create pages from layout structure
-    for (size_t i = 0; i < pages.size(); ++i) {
-      auto& page_layout = pages[i];
-      
-      // Create PDF page
-      auto& pdf_page = m_pdf->GetPages().CreatePage(PdfPageSize::A4);
-      PdfPainter painter;
-      painter.SetCanvas(pdf_page);
-      
-      // Render page content
-      render_geometry_to_page(painter, page_layout);
-      
-      painter.FinishDrawing();
+    // Shared resources first: one font lookup, one image object per distinct image
+    size_t page_count = pages.size();
+    serialize_resources shared;
+    shared.font = m_pdf->GetFonts().SearchFont("Arial", PdfFontSearchParams{});
+    shared.page_images.resize(page_count);
+    std::vector<flx_layout_geometry*> page_layouts;
+    for (size_t i = 0; i < page_count; ++i) {
+      page_layouts.push_back(&pages[i]);
+      collect_page_images(shared, pages[i], shared.page_images[i]);
+    }
+    if (shared.font != nullptr) {
+      std::string characters;
+      std::unordered_set<std::string> seen;
+      for (size_t i = 0; i < page_count; ++i) {
+        collect_characters(pages[i], characters, seen);
+      }
+      if (!characters.empty()) {
+        shared.font->GetEncoding().ConvertToEncoded(characters);
+      }
+    }
+    
+    // Content streams only read their own page, so pages are built in parallel
+    std::vector<page_content> contents(page_count);
+    auto build_page = [&](size_t i) {
+      contents[i].image_slots = &shared.page_images[i];
+      write_page_content(shared, *page_layouts[i], contents[i]);
+    };
+    size_t threads = m_serialize_options.threads;
+    if (threads == 0) {
+      threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    threads = std::min(threads, page_count);
+    if (threads > 1) {
+      flx_thread_pool pool(threads);
+      for (size_t i = 0; i < page_count; ++i) {
+        pool.submit([&build_page, i] { build_page(i); });
+      }
+      pool.wait_idle();
+    } else {
+      for (size_t i = 0; i < page_count; ++i) {
+        build_page(i);
+      }
+    }
+    
+    // Create pages in order and attach their streams and resources
+    for (size_t i = 0; i < page_count; ++i) {
+      auto& content = contents[i];
+      PdfCanvas& canvas = m_pdf->GetPages().CreatePage(PdfPageSize::A4);
+      PdfResourceOperations& resources = canvas.GetOrCreateResources();
+      if (content.uses_font) {
+        resources.AddResource(PdfResourceType::Font, PdfName(font_resource), shared.font->GetObject());
+      }
+      for (int slot : content.images) {
+        resources.AddResource(PdfResourceType::XObject, PdfName(image_resource(slot)), shared.images[slot]->GetObject());
+      }
+      if (!content.stream.empty()) {
+        std::string stream = "q\n" + content.stream + "Q\n";
+        canvas.GetOrCreateContentsStream(PdfStreamAppendFlags::None).SetData(bufferview(stream.data(), stream.size()));
+      }
     }
     
     // Serialize to buffer using PoDoFo StreamDevice
@@ -266,62 +1047,92 @@ bool flx_pdf_sio::serialize(flx_string &data) {
   }
 }
 
-bool flx_pdf_sio::render(std::vector<cv::Mat>& output_images, int dpi) {
-  output_images.clear();
-  if (m_pdf == nullptr) {
-    return false;
+void flx_pdf_sio::collect_page_images(serialize_resources& shared, flx_layout_geometry& geometry, std::vector<int>& slots) {
+  // Same order as write_page_content draws them
+  for (size_t i = 0; i < geometry.sub_geometries.size(); ++i) {
+    collect_page_images(shared, geometry.sub_geometries[i], slots);
+  }
+  for (size_t i = 0; i < geometry.images.size(); ++i) {
+    slots.push_back(load_shared_image(shared, geometry.images[i]));
+  }
+}
+
+int flx_pdf_sio::load_shared_image(serialize_resources& shared, flx_layout_image& image_elem) {
+  std::string path = image_elem.image_path->c_str();
+  if (path.empty()) {
+    return -1;
   }
   
-  // Create temporary directory for PDF conversion
-  long long timestamp = std::chrono::steady_clock::now().time_since_epoch().count();
-  std::filesystem::path temp_dir = std::filesystem::temp_directory_path() / ("flx_pdf_render_" + std::to_string(timestamp));
-  
-  try {
-    std::filesystem::create_directories(temp_dir);
-    std::filesystem::path temp_pdf = temp_dir / "input.pdf";
-    
-    // Write PDF data to temporary file
-    std::ofstream outfile(temp_pdf, std::ios::binary);
-    if (!outfile.is_open()) {
-      std::filesystem::remove_all(temp_dir);
-      return false;
+  auto known_path = shared.path_images.find(path);
+  if (known_path != shared.path_images.end()) {
+    if (known_path->second >= 0) {
+      auto& image = *shared.images[known_path->second];
+      image_elem.original_width = static_cast<int>(image.GetWidth());
+      image_elem.original_height = static_cast<int>(image.GetHeight());
     }
-    outfile.write(this->pdf_data.c_str(), this->pdf_data.size());
-    outfile.close();
-    
-    // Use pdftoppm to convert PDF to images
-    std::string cmd = "pdftoppm -png -r " + std::to_string(dpi) + " '" + temp_pdf.string() + "' '" + (temp_dir / "page").string() + "'";
-    int result = system(cmd.c_str());
+    return known_path->second;
+  }
+  
+  int slot = -1;
+  std::ifstream file(path, std::ios::binary);
+  if (file.is_open()) {
+    auto image_data = std::make_unique<std::string>((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
     
-    if (result == 0) {
-      // Load generated images in order
-      std::vector<std::filesystem::path> image_files;
-      for (const auto& entry : std::filesystem::directory_iterator(temp_dir)) {
-        if (entry.path().extension() == ".png") {
-          image_files.push_back(entry.path());
-        }
-      }
-      
-      // Sort by filename to maintain page order
-      std::sort(image_files.begin(), image_files.end());
-      
-      for (const auto& image_path : image_files) {
-        cv::Mat img = cv::imread(image_path.string());
-        if (!img.empty()) {
-          output_images.push_back(img);
-        }
+    // Identical files under different paths share the object as well
+    auto known_data = shared.data_images.find(*image_data);
+    if (known_data != shared.data_images.end()) {
+      slot = known_data->second;
+    } else {
+      try {
+        auto pdf_image = m_pdf->CreateImage();
+        pdf_image->LoadFromBuffer(bufferview(image_data->data(), image_data->size()));
+        slot = static_cast<int>(shared.images.size());
+        shared.images.push_back(std::move(pdf_image));
+        shared.data_images.emplace(std::string_view(*image_data), slot);
+        shared.image_data.push_back(std::move(image_data));
+      } catch (const std::exception& e) {
+        std::cout << "Error creating PDF image: " << e.what() << std::endl;
       }
     }
-    
-    // Cleanup
-    std::filesystem::remove_all(temp_dir);
-    return result == 0 && !output_images.empty();
-    
-  } catch (const std::exception& e) {
-    std::cerr << "Error rendering PDF: " << e.what() << std::endl;
-    std::filesystem::remove_all(temp_dir);
+  }
+  shared.path_images.emplace(path, slot);
+  
+  if (slot < 0) {
+    std::cout << "Failed to load image: " << path << std::endl;
+    return -1;
+  }
+  auto& image = *shared.images[slot];
+  image_elem.original_width = static_cast<int>(image.GetWidth());
+  image_elem.original_height = static_cast<int>(image.GetHeight());
+  return slot;
+}
+
+bool flx_pdf_sio::render(std::vector<cv::Mat>& output_images, int dpi) {
+  flx_pdf_rasterizer::options options = m_render_options;
+  options.dpi = dpi;
+  return render(output_images, options);
+}
+
+bool flx_pdf_sio::render(std::vector<cv::Mat>& output_images, const flx_pdf_rasterizer::options& options) {
+  output_images.clear();
+  return render(options, [&output_images](int, cv::Mat& page) {
+    output_images.push_back(page);
+    return true;
+  });
+}
+
+bool flx_pdf_sio::render(const flx_pdf_rasterizer::options& options, const flx_pdf_rasterizer::page_callback& on_page) {
+  std::string_view bytes = input();
+  if (m_pdf == nullptr || bytes.empty()) {
     return false;
   }
+
+  flx_pdf_rasterizer rasterizer(options);
+  if (!rasterizer.render(bytes.data(), bytes.size(), on_page)) {
+    std::cerr << "Error rendering PDF: " << rasterizer.last_error() << std::endl;
+    return false;
+  }
+  return true;
 }
 
 bool flx_pdf_sio::add_text(flx_string text, double x, double y) {
@@ -335,42 +1146,136 @@ bool flx_pdf_sio::add_text(flx_string text, double x, double y) {
   return true;
 }
 
-void flx_pdf_sio::render_geometry_to_page(PdfPainter& painter, flx_layout_geometry& geometry) {
+void flx_pdf_sio::write_page_content(serialize_resources& shared, flx_layout_geometry& geometry, page_content& content) {
   // Render the polygon shape first (background)
   if (geometry.vertices.size() >= 3) {
-    render_polygon_shape(painter, geometry);
+    write_polygon_shape(geometry, content);
   }
   
   // Recursively render sub-geometries first (background layers)
   for (size_t i = 0; i < geometry.sub_geometries.size(); ++i) {
-    render_geometry_to_page(painter, geometry.sub_geometries[i]);
+    write_page_content(shared, geometry.sub_geometries[i], content);
   }
   
   // Render all text elements (foreground)
   for (size_t i = 0; i < geometry.texts.size(); ++i) {
-    render_text_element(painter, geometry.texts[i]);
+    write_text_element(shared, geometry.texts[i], content);
   }
   
   // Render all image elements (topmost layer)
   for (size_t i = 0; i < geometry.images.size(); ++i) {
-    render_image_element(painter, geometry.images[i]);
+    write_image_element(geometry.images[i], content);
+  }
+}
+
+void flx_pdf_sio::write_polygon_shape(flx_layout_geometry& geometry, page_content& content) {
+  bool has_fill = geometry.fill_color->empty() == false;
+  bool has_stroke = geometry.stroke_color->empty() == false;
+  if (!has_fill && !has_stroke) return;
+  
+  // Colours are only written when they change, like PdfPainter does
+  std::string& out = content.stream;
+  if (has_fill) {
+    PdfColor color = parse_hex_color(geometry.fill_color);
+    if (!(color == content.fill)) {
+      append_operator(out, {color.GetRed(), color.GetGreen(), color.GetBlue()}, "rg");
+      content.fill = color;
+    }
+  }
+  if (has_stroke) {
+    PdfColor color = parse_hex_color(geometry.stroke_color);
+    if (!(color == content.stroke)) {
+      append_operator(out, {color.GetRed(), color.GetGreen(), color.GetBlue()}, "RG");
+      content.stroke = color;
+    }
+  }
+  
+  auto& first_vertex = geometry.vertices[0];
+  append_operator(out, {first_vertex.x, first_vertex.y}, "m");
+  for (size_t i = 1; i < geometry.vertices.size(); ++i) {
+    auto& vertex = geometry.vertices[i];
+    append_operator(out, {vertex.x, vertex.y}, "l");
+  }
+  
+  if (has_fill) {
+    // Fill (and stroke) close the polygon, stroke only draws the outline
+    out += "h\n";
+    out += has_stroke ? "B\n" : "f\n";
+  } else {
+    out += "S\n";
   }
 }
 
-void flx_pdf_sio::render_text_element(PdfPainter& painter, flx_layout_text& text_elem) {
-  // Set font
-  auto* font = m_pdf->GetFonts().SearchFont("Arial", PdfFontSearchParams{});
-  if (font != nullptr) {
-    painter.TextState.SetFont(*font, text_elem.font_size);
+void flx_pdf_sio::write_text_element(serialize_resources& shared, flx_layout_text& text_elem, page_content& content) {
+  if (shared.font == nullptr) {
+    throw std::runtime_error("No font available for text");
   }
   
-  // Ensure text has proper color (black text)
-  PdfColor text_color(0.0, 0.0, 0.0); // Black
-  painter.GraphicsState.SetNonStrokingColor(text_color);
+  // Black text
+  std::string& out = content.stream;
+  PdfColor text_color(0.0, 0.0, 0.0);
+  if (!(text_color == content.fill)) {
+    append_operator(out, {0.0, 0.0, 0.0}, "rg");
+    content.fill = text_color;
+  }
   
-  // Render text at position
   flx_string text_content = text_elem.text;
-  painter.DrawText(text_content.c_str(), text_elem.x, text_elem.y);
+  charbuff encoded;
+  bool hex;
+  {
+    std::lock_guard<std::mutex> lock(shared.font_mutex);
+    encoded = shared.font->GetEncoding().ConvertToEncoded(text_content.c_str());
+    hex = !shared.font->GetEncoding().IsSimpleEncoding();
+  }
+  
+  out += "q\nBT\n/";
+  out += font_resource;
+  out += ' ';
+  append_operator(out, {static_cast<double>(text_elem.font_size)}, "Tf");
+  append_operator(out, {text_elem.x, text_elem.y}, "Td");
+  if (hex) {
+    static const char digits[] = "0123456789ABCDEF";
+    out += '<';
+    for (unsigned char c : encoded) {
+      out += digits[c >> 4];
+      out += digits[c & 0x0F];
+    }
+    out += '>';
+  } else {
+    out += '(';
+    for (char c : encoded) {
+      if (c == '(' || c == ')' || c == '\\') out += '\\';
+      if (c == '\r') { out += "\\r"; continue; }
+      if (c == '\n') { out += "\\n"; continue; }
+      out += c;
+    }
+    out += ')';
+  }
+  out += " Tj\nET\nQ\n";
+  content.uses_font = true;
+}
+
+void flx_pdf_sio::write_image_element(flx_layout_image& image_elem, page_content& content) {
+  int slot = (*content.image_slots)[content.next_image++];
+  if (slot < 0) {
+    return;
+  }
+  
+  // Convert from top-left coordinate system to PDF's bottom-left coordinate system
+  // A4 page height is 842 points
+  double pdf_y = 842.0 - image_elem.y - image_elem.height;
+  
+  // The image space is the unit square: scale it to the element size
+  std::string& out = content.stream;
+  out += "q\n";
+  append_operator(out, {image_elem.width, 0.0, 0.0, image_elem.height, image_elem.x, pdf_y}, "cm");
+  out += '/';
+  out += image_resource(slot);
+  out += " Do\nQ\n";
+  
+  if (std::find(content.images.begin(), content.images.end(), slot) == content.images.end()) {
+    content.images.push_back(slot);
+  }
 }
 
 void flx_pdf_sio::render_polygon_shape(PdfPainter& painter, flx_layout_geometry& geometry) {
@@ -410,64 +1315,75 @@ void flx_pdf_sio::render_polygon_shape(PdfPainter& painter, flx_layout_geometry&
   }
 }
 
-void flx_pdf_sio::render_image_element(PdfPainter& painter, flx_layout_image& image_elem) {
-  if (!load_image_from_path(image_elem)) {
-    flx_string path = image_elem.image_path;
-    std::cout << "Failed to load image: " << path.c_str() << std::endl;
-    return;
-  }
-  
+// Second document over the same input bytes. It loads objects on demand
+// like m_pdf, so the geometry pass only materializes what it filters
+// instead of a Save/reload round trip of the whole file
+std::unique_ptr<PoDoFo::PdfMemDocument> flx_pdf_sio::create_pdf_copy() {
   try {
-    // Create PdfImage from OpenCV Mat
-    auto pdf_image = this->create_pdf_image_from_mat(image_elem);
-    if (pdf_image == nullptr) {
-      std::cout << "Failed to create PDF image" << std::endl;
-      return;
+    std::string_view bytes = input();
+    if (bytes.empty()) {
+      return nullptr;
     }
+    auto copy = std::make_unique<PdfMemDocument>();
+    copy->LoadFromBuffer(bufferview(bytes.data(), bytes.size()));
     
-    // Calculate scaling factors based on desired vs original dimensions
-    double original_width = pdf_image->GetWidth();
-    double original_height = pdf_image->GetHeight();
-    double scale_x = image_elem.width / original_width;
-    double scale_y = image_elem.height / original_height;
-    
-    // Convert from top-left coordinate system to PDF's bottom-left coordinate system
-    // A4 page height is 842 points
-    double pdf_y = 842.0 - image_elem.y - image_elem.height;
-    
-    
-    // Draw image at position with calculated scaling
-    painter.DrawImage(*pdf_image, image_elem.x, pdf_y, scale_x, scale_y);
+    FLX_PDF_TRACE_LOG(m_trace, "Created PDF copy with " << copy->GetPages().GetCount() << " pages");
+    return copy;
     
   } catch (const std::exception& e) {
-    std::cout << "Error rendering image: " << e.what() << std::endl;
+    std::cout << "Error creating PDF copy: " << e.what() << std::endl;
+    return nullptr;
   }
 }
 
-
-std::unique_ptr<PoDoFo::PdfMemDocument> flx_pdf_sio::create_pdf_copy() {
+// PDF of the given pages with texts and images removed, for the raster pass:
+// page n of it is page_indexes[n - 1] of the document. Other pages are
+// dropped before the save, so their content is never loaded.
+bool flx_pdf_sio::create_geometry_source(const std::vector<int>& page_indexes, std::string& pdf_content) {
+  FLX_PDF_TRACE_SPAN(m_trace, "geometry_source");
+  auto copy = create_pdf_copy();
+  if (!copy) {
+    return false;
+  }
   try {
-    // Create new document and copy from current
-    auto copy = std::make_unique<PdfMemDocument>();
-    
-    // Serialize current PDF to buffer and reload into copy
+    auto& copy_pages = copy->GetPages();
+    std::vector<bool> keep(copy_pages.GetCount(), false);
+    for (int index : page_indexes) {
+      keep[index] = true;
+    }
+    for (int i = static_cast<int>(keep.size()) - 1; i >= 0; --i) {
+      if (!keep[i]) {
+        copy_pages.RemovePageAt(i);
+      }
+    }
+    if (!remove_texts_and_images_from_copy(copy.get())) {
+      return false;
+    }
+
     std::stringstream buffer;
     StandardStreamDevice device(buffer);
-    m_pdf->Save(device);
-    
-    std::string pdf_content = buffer.str();
-    bufferview buffer_view(pdf_content.c_str(), pdf_content.size());
-    copy->LoadFromBuffer(buffer_view);
-    
-    std::cout << "Created PDF copy with " << copy->GetPages().GetCount() << " pages" << std::endl;
-    return copy;
-    
+    copy->Save(device);
+    pdf_content = buffer.str();
+    FLX_PDF_TRACE_LOG(m_trace, "  Geometry source: " << page_indexes.size() << " pages, " << pdf_content.size() << " bytes");
+    return true;
   } catch (const std::exception& e) {
-    std::cout << "Error creating PDF copy: " << e.what() << std::endl;
-    return nullptr;
+    std::cout << "Error creating geometry source: " << e.what() << std::endl;
+    return false;
   }
 }
 
+void flx_pdf_sio::extract_page_images(const PdfPage& page, flx_model_list<flx_layout_image>& images) {
+  auto contents = page.GetContents();
+  const PdfObject* resources = page.GetDictionary().FindKeyParent("Resources");
+  if (contents == nullptr || resources == nullptr || !resources->IsDictionary()) {
+    return;
+  }
+  charbuff content = contents->GetCopy();
+  collect_image_placements(std::string_view(content.data(), content.size()), &resources->GetDictionary(),
+                           pdf_matrix(), page.GetRect().Height, 0, images);
+  FLX_PDF_TRACE_COUNT(m_trace, "images", images.size());
+}
+
 bool flx_pdf_sio::extract_texts_and_images(flx_model_list<flx_layout_text>& texts, flx_model_list<flx_layout_image>& images) {
   try {
     if (m_pdf == nullptr) {
@@ -479,7 +1395,7 @@ bool flx_pdf_sio::extract_texts_and_images(flx_model_list<flx_layout_text>& text
     std::cout << "Extracting content from " << pages.GetCount() << " pages..." << std::endl;
     
     // Use our custom text extractor instead of primitive ExtractTextTo
-    flx_pdf_text_extractor text_extractor;
+    flx_pdf_text_extractor text_extractor(&font_cache(), &m_trace);
     
     for (unsigned int page_num = 0; page_num < pages.GetCount(); ++page_num) {
       auto& page = pages.GetPageAt(page_num);
@@ -521,122 +1437,46 @@ bool flx_pdf_sio::extract_texts_and_images(flx_model_list<flx_layout_text>& text
   }
 }
 
-bool flx_pdf_sio::load_image_from_path(flx_layout_image& image_elem) {
-  flx_string path = image_elem.image_path;
-  if (path.empty()) {
-    return false;
-  }
-  
-  // Load image with OpenCV
-  cv::Mat image = cv::imread(path.c_str(), cv::IMREAD_COLOR);
-  if (image.empty()) {
-    return false;
-  }
-  
-  // Store original dimensions
-  image_elem.original_width = image.cols;
-  image_elem.original_height = image.rows;
-  
-  // TODO: Store cv::Mat for later use - for now just validate loading
-  return true;
-}
-
-std::unique_ptr<PoDoFo::PdfImage> flx_pdf_sio::create_pdf_image_from_mat(flx_layout_image& image_elem) {
-  flx_string path = image_elem.image_path;
-  if (path.empty()) {
-    return nullptr;
-  }
-  
-  try {
-    // Create PdfImage object
-    auto pdf_image = m_pdf->CreateImage();
-    
-    // Load image data from file into PoDoFo
-    std::ifstream file(path.c_str(), std::ios::binary);
-    if (!file.is_open()) {
-      return nullptr;
-    }
-    
-    // Read file into buffer
-    std::string image_data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
-    file.close();
-    
-    // Load buffer into PdfImage
-    bufferview buffer(image_data.c_str(), image_data.size());
-    pdf_image->LoadFromBuffer(buffer);
-    
-    return pdf_image;
-    
-  } catch (const std::exception& e) {
-    std::cout << "Error creating PDF image: " << e.what() << std::endl;
-    return nullptr;
-  }
-}
-
 bool flx_pdf_sio::remove_texts_and_images_from_copy(PoDoFo::PdfMemDocument* pdf_copy) {
-  std::cout << "  Removing texts and images from PDF copy..." << std::endl;
+  FLX_PDF_TRACE_LOG(m_trace, "  Removing texts and images from PDF copy...");
   
   try {
     auto& pages = pdf_copy->GetPages();
     
     for (unsigned int page_num = 0; page_num < pages.GetCount(); ++page_num) {
-      try {
-        std::cout << "    Processing page " << (page_num + 1) << "..." << std::endl;
-        
-        auto& page = pages.GetPageAt(page_num);
-        
-        // Get the page's content stream
-        auto contents = page.GetContents();
-        if (contents == nullptr) {
-          std::cout << "    Page " << (page_num + 1) << ": No contents found" << std::endl;
-          continue;
-        }
-      
-      // Read the current content stream  
-      auto content_buffer = contents->GetCopy();
-      std::string content_str(content_buffer.data(), content_buffer.size());
+      auto& page = pages.GetPageAt(page_num);
       
-      if (content_str.empty()) {
-        std::cout << "    Page " << (page_num + 1) << ": Empty content stream" << std::endl;
-        continue;
+      // Images are no longer drawn: without their resource entries the save
+      // for rendering (which drops unreferenced objects) never loads them
+      PdfObject* resources = page.GetDictionary().FindKeyParent("Resources");
+      if (resources != nullptr && resources->IsDictionary()) {
+        resources->GetDictionary().RemoveKey("XObject");
       }
       
-      // Debug: Show original content
-      std::cout << "    Original content (" << content_str.size() << " bytes):" << std::endl;
-      std::cout << "    " << content_str.substr(0, 200) << "..." << std::endl;
-      
-      // Filter out text and image operators while keeping path operations
-      std::string filtered_content = filter_pdf_content_stream(content_str);
-      
-      // Debug: Show filtered content  
-      std::cout << "    Filtered content (" << filtered_content.size() << " bytes):" << std::endl;
-      std::cout << "    " << filtered_content.substr(0, 200) << "..." << std::endl;
-      
-      // Replace the content stream with filtered version
-      if (filtered_content.empty()) {
-        std::cout << "    Page " << (page_num + 1) << ": Warning - filtered content is empty, skipping" << std::endl;
-      } else {
-        try {
-          contents->Reset();  // Clear existing content
-          auto& stream = contents->CreateStreamForAppending();
-          stream.GetOutputStream().Write(filtered_content);
-          std::cout << "    Page " << (page_num + 1) << ": Stream write successful" << std::endl;
-        } catch (const std::exception& stream_error) {
-          std::cout << "    Page " << (page_num + 1) << ": Stream write error: " << stream_error.what() << std::endl;
-          return false;
-        }
+      auto contents = page.GetContents();
+      if (contents == nullptr) {
+        continue;
       }
       
-      std::cout << "    Page " << (page_num + 1) << ": Successfully filtered " 
-                << content_str.size() << " -> " << filtered_content.size() << " bytes" << std::endl;
-        
-      } catch (const std::exception& page_error) {
-        std::cout << "    Page " << (page_num + 1) << ": Error processing page: " << page_error.what() << std::endl;
+      // Filter out text and image operators while keeping path operations
+      auto content_buffer = contents->GetCopy();
+      std::string content_str(content_buffer.data(), content_buffer.size());
+      std::string filtered_content = filter_pdf_content_stream(content_str);
+      
+      try {
+        contents->Reset();
+        auto& stream = contents->CreateStreamForAppending();
+        stream.GetOutputStream().Write(filtered_content);
+      } catch (const std::exception& stream_error) {
+        std::cout << "    Page " << (page_num + 1) << ": Stream write error: " << stream_error.what() << std::endl;
         return false;
       }
+      
+      FLX_PDF_TRACE_LOG(m_trace, "    Page " << (page_num + 1) << ": filtered "
+                        << content_str.size() << " -> " << filtered_content.size() << " bytes");
     }
     
-    std::cout << "  Successfully cleaned " << pages.GetCount() << " pages" << std::endl;
+    FLX_PDF_TRACE_LOG(m_trace, "  Successfully cleaned " << pages.GetCount() << " pages");
     return true;
     
   } catch (const std::exception& e) {
@@ -646,7 +1486,8 @@ bool flx_pdf_sio::remove_texts_and_images_from_copy(PoDoFo::PdfMemDocument* pdf_
 }
 
 bool flx_pdf_sio::render_clean_pdf_to_images(PoDoFo::PdfMemDocument* pdf_copy, std::vector<cv::Mat>& clean_images) {
-  std::cout << "  Rendering cleaned PDF to images..." << std::endl;
+  FLX_PDF_TRACE_SPAN(m_trace, "render");
+  FLX_PDF_TRACE_LOG(m_trace, "  Rendering cleaned PDF to images...");
   clean_images.clear();
   
   if (pdf_copy == nullptr) {
@@ -654,195 +1495,110 @@ bool flx_pdf_sio::render_clean_pdf_to_images(PoDoFo::PdfMemDocument* pdf_copy, s
     return false;
   }
   
-  // Create temporary directory for PDF conversion
-  long long timestamp = std::chrono::steady_clock::now().time_since_epoch().count();
-  std::filesystem::path temp_dir = std::filesystem::temp_directory_path() / ("flx_clean_pdf_render_" + std::to_string(timestamp));
-  
   try {
-    std::filesystem::create_directories(temp_dir);
-    std::filesystem::path temp_pdf = temp_dir / "clean_input.pdf";
-    
-    // Save the cleaned PDF copy to temporary file
+    // Serialize the cleaned copy into memory; the rasterizer takes it from there
     std::stringstream buffer;
     StandardStreamDevice device(buffer);
     pdf_copy->Save(device);
-    
-    std::ofstream outfile(temp_pdf, std::ios::binary);
-    if (!outfile.is_open()) {
-      std::filesystem::remove_all(temp_dir);
-      std::cout << "    Error: Cannot write temporary PDF file" << std::endl;
-      return false;
-    }
-    
     std::string pdf_content = buffer.str();
-    outfile.write(pdf_content.c_str(), pdf_content.size());
-    outfile.close();
-    
-    std::cout << "    Saved cleaned PDF to: " << temp_pdf.string() << std::endl;
     
-    // Use pdftoppm to convert cleaned PDF to images
-    int dpi = 150; // Lower DPI for geometry analysis (faster processing)
-    std::string cmd = "pdftoppm -png -r " + std::to_string(dpi) + " '" + temp_pdf.string() + "' '" + (temp_dir / "clean_page").string() + "'";
-    std::cout << "    Running: " << cmd << std::endl;
-    
-    int result = system(cmd.c_str());
-    
-    if (result == 0) {
-      // Load generated images in order
-      std::vector<std::filesystem::path> image_files;
-      for (const auto& entry : std::filesystem::directory_iterator(temp_dir)) {
-        if (entry.path().extension() == ".png" && entry.path().stem().string().find("clean_page") == 0) {
-          image_files.push_back(entry.path());
-        }
-      }
-      
-      // Sort by filename to maintain page order
-      std::sort(image_files.begin(), image_files.end());
-      
-      for (const auto& image_path : image_files) {
-        cv::Mat img = cv::imread(image_path.string(), cv::IMREAD_COLOR);
-        if (!img.empty()) {
-          clean_images.push_back(img);
-          std::cout << "    Loaded clean image: " << img.cols << "x" << img.rows << " from " << image_path.filename().string() << std::endl;
-        }
+    flx_pdf_rasterizer rasterizer(m_render_options);
+    bool rendered = rasterizer.render(pdf_content.data(), pdf_content.size(), [this, &clean_images]([[maybe_unused]] int page_number, cv::Mat& img) {
+      if (!img.empty()) {
+        clean_images.push_back(img);
+        FLX_PDF_TRACE_LOG(m_trace, "    Rendered clean page " << page_number << ": " << img.cols << "x" << img.rows);
       }
-      
-      std::cout << "  Successfully rendered " << clean_images.size() << " clean pages to images" << std::endl;
-    } else {
-      std::cout << "    Error: pdftoppm command failed with code " << result << std::endl;
+      return true;
+    });
+    
+    if (!rendered) {
+      std::cout << "    Error: " << rasterizer.last_error() << std::endl;
+      return false;
     }
     
-    // Cleanup
-    std::filesystem::remove_all(temp_dir);
-    return result == 0 && !clean_images.empty();
+    FLX_PDF_TRACE_COUNT(m_trace, "render.pages", clean_images.size());
+    FLX_PDF_TRACE_LOG(m_trace, "  Successfully rendered " << clean_images.size() << " clean pages to images");
+    return !clean_images.empty();
     
   } catch (const std::exception& e) {
     std::cout << "Error rendering clean PDF: " << e.what() << std::endl;
-    std::filesystem::remove_all(temp_dir);
     return false;
   }
 }
 
-std::vector<cv::Mat> flx_pdf_sio::detect_color_regions(const cv::Mat& page_image, const std::string& debug_dir) {
-  std::cout << "🎨 Detecting color regions using flood-fill..." << std::endl;
-  std::vector<cv::Mat> masks;
+std::vector<flx_color_region> flx_pdf_sio::detect_color_regions(const cv::Mat& page_image, int page_index) {
+  FLX_PDF_TRACE_SPAN(m_trace, "color_regions");
+  FLX_PDF_TRACE_LOG(m_trace, "🎨 Detecting color regions using connected-component labeling...");
+  std::vector<flx_color_region> regions;
   
   if (page_image.empty()) {
     std::cout << "    Error: Empty page image" << std::endl;
-    return masks;
+    return regions;
   }
   
-  // Create a mask to track already processed pixels (0 = unprocessed, 1 = processed)
-  cv::Mat processed = cv::Mat::zeros(page_image.size(), CV_8UC1);
-  
   int color_tolerance = 20; // Color difference threshold between neighbors
   int min_area = 100; // Minimum region area in pixels
-  int region_count = 0;
   
-  std::cout << "    Processing image: " << page_image.cols << "x" << page_image.rows << std::endl;
+  FLX_PDF_TRACE_LOG(m_trace, "    Processing image: " << page_image.cols << "x" << page_image.rows);
   
-  // Single pass: Process every pixel exactly once
-  // Each pixel becomes a seed only if not already processed by flood-fill
-  for (int y = 0; y < page_image.rows; y++) {
-    for (int x = 0; x < page_image.cols; x++) {
-      
-      // Skip if already processed
-      if (processed.at<uchar>(y, x) > 0) {
-        continue;
-      }
-      
-      // This pixel hasn't been processed yet - use as seed for new region
-      cv::Mat region_mask = cv::Mat::zeros(page_image.size(), CV_8UC1);
-      int filled_pixels = flood_fill_neighbor_based(page_image, cv::Point(x, y), region_mask, processed, color_tolerance);
-      
-      // Check if region is large enough
-      if (filled_pixels >= min_area) {
-        // Calculate bounding rect and dominant color
-        cv::Rect bounding_rect = cv::boundingRect(region_mask);
-        cv::Scalar mean_color = cv::mean(page_image, region_mask);
-        
-        // Store this region mask
-        masks.push_back(region_mask.clone());
-        region_count++;
-        
-        std::cout << "    Region " << region_count << ": " << filled_pixels << " pixels, "
-                  << "bbox(" << bounding_rect.x << "," << bounding_rect.y << "," 
-                  << bounding_rect.width << "," << bounding_rect.height << "), "
-                  << "color(" << (int)mean_color[2] << "," << (int)mean_color[1] << "," << (int)mean_color[0] << ")" << std::endl;
-      }
-      // Note: Even small regions are marked as processed to avoid reprocessing
+  regions = flx_regions::label_color_regions(page_image, color_tolerance, min_area);
+  FLX_PDF_TRACE_COUNT(m_trace, "color_regions.regions", regions.size());
+  
+  if (FLX_PDF_TRACE_LOGGING(m_trace)) {
+    for (size_t i = 0; i < regions.size(); i++) {
+      const flx_color_region& region = regions[i];
+      const cv::Rect& bbox = region.bounding_box;
+      std::cout << "    Region " << (i+1) << ": " << region.pixel_count << " pixels, "
+                << "bbox(" << bbox.x << "," << bbox.y << "," 
+                << bbox.width << "," << bbox.height << "), "
+                << "color(" << (int)region.mean_color[2] << "," << (int)region.mean_color[1] << "," << (int)region.mean_color[0] << ")" << std::endl;
     }
+    std::cout << "🎯 Found " << regions.size() << " color-coherent regions" << std::endl;
   }
   
-  std::cout << "🎯 Found " << masks.size() << " color-coherent regions (processed every pixel exactly once)" << std::endl;
-  
-  // Debug: Save region visualization if debug directory provided
-  if (!debug_dir.empty() && !masks.empty()) {
-    std::cout << "🖼️  Creating debug visualizations..." << std::endl;
-    
-    // Create a colored visualization of all regions
-    cv::Mat region_colors = page_image.clone();
+  // Region visualizations as trace artifacts
+  if (FLX_PDF_TRACE_ARTIFACTS(m_trace) && page_index >= 0 && !regions.empty()) {
+    // Paint every region in its mean color
     cv::Mat all_regions_mask = cv::Mat::zeros(page_image.size(), CV_8UC3);
-    
-    // Use original dominant colors for each region  
-    std::vector<cv::Vec3b> region_color_palette;
-    for (size_t i = 0; i < masks.size(); i++) {
-      // Calculate actual dominant color from original image
-      cv::Scalar mean_color_scalar = cv::mean(page_image, masks[i]);
-      cv::Vec3b original_color(
-        (uchar)mean_color_scalar[0], // B
-        (uchar)mean_color_scalar[1], // G  
-        (uchar)mean_color_scalar[2]  // R
-      );
-      region_color_palette.push_back(original_color);
-    }
-    
-    // Apply original colored masks
-    for (size_t i = 0; i < masks.size(); i++) {
-      cv::Vec3b color = region_color_palette[i];
+    for (size_t i = 0; i < regions.size(); i++) {
+      const flx_color_region& region = regions[i];
+      cv::Vec3b color((uchar)region.mean_color[0], (uchar)region.mean_color[1], (uchar)region.mean_color[2]);
       
-      // Save individual region mask
-      std::string mask_path = debug_dir + "/02_region_" + std::to_string(i+1) + "_mask.png";
-      cv::imwrite(mask_path, masks[i]);
+      m_trace.write_artifact(page_index, "02_region_" + std::to_string(i+1) + "_mask.png", region.to_mask(page_image.size()));
       
-      // Add colored overlay to combined visualization
-      all_regions_mask.setTo(color, masks[i]);
-      
-      // Calculate region stats
-      int pixel_count = cv::countNonZero(masks[i]);
-      cv::Rect bbox = cv::boundingRect(masks[i]);
-      cv::Scalar mean_color = cv::mean(page_image, masks[i]);
-      
-      std::cout << "    🟦 Region " << (i+1) << ": " << pixel_count << " pixels, "
-                << "bbox(" << bbox.x << "," << bbox.y << "," << bbox.width << "," << bbox.height << "), "
-                << "color(" << (int)mean_color[2] << "," << (int)mean_color[1] << "," << (int)mean_color[0] << ")" << std::endl;
+      for (const auto& run : region.runs) {
+        cv::Vec3b* row = all_regions_mask.ptr<cv::Vec3b>(run.y);
+        std::fill(row + run.x_begin, row + run.x_end, color);
+      }
     }
+    m_trace.write_artifact(page_index, "02_all_regions_colored.png", all_regions_mask);
     
-    // Save combined visualization
-    std::string regions_path = debug_dir + "/02_all_regions_colored.png";
-    cv::imwrite(regions_path, all_regions_mask);
-    std::cout << "💾 Saved regions visualization: " << regions_path << std::endl;
-    
-    // Create overlay version
     cv::Mat overlay;
     cv::addWeighted(page_image, 0.6, all_regions_mask, 0.4, 0, overlay);
-    std::string overlay_path = debug_dir + "/02_regions_overlay.png";
-    cv::imwrite(overlay_path, overlay);
-    std::cout << "💾 Saved regions overlay: " << overlay_path << std::endl;
+    m_trace.write_artifact(page_index, "02_regions_overlay.png", overlay);
   }
   
-  return masks;
+  return regions;
 }
 
-std::vector<std::vector<cv::Point>> flx_pdf_sio::extract_contours_from_masks(const std::vector<cv::Mat>& masks, const cv::Mat& original_image, const std::string& debug_dir) {
-  std::cout << "📐 Extracting contours from masks..." << std::endl;
+std::vector<std::vector<cv::Point>> flx_pdf_sio::extract_contours_from_regions(const std::vector<flx_color_region>& regions, const cv::Mat& original_image, int page_index,
+                                                                               std::vector<int>* contour_regions) {
+  FLX_PDF_TRACE_SPAN(m_trace, "contours");
+  FLX_PDF_TRACE_LOG(m_trace, "📐 Extracting contours from regions...");
   std::vector<std::vector<cv::Point>> all_contours;
   
-  for (const auto& mask : masks) {
+  if (contour_regions != nullptr) {
+    contour_regions->clear();
+  }
+  for (size_t region_index = 0; region_index < regions.size(); region_index++) {
+    const auto& region = regions[region_index];
     std::vector<std::vector<cv::Point>> mask_contours;
     std::vector<cv::Vec4i> hierarchy;
     
-    cv::findContours(mask, mask_contours, hierarchy, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE);
+    // Bounding-box mask with a zero border, shifted back to page coordinates
+    cv::Mat mask = region.to_local_mask(1);
+    cv::Point offset(region.bounding_box.x - 1, region.bounding_box.y - 1);
+    cv::findContours(mask, mask_contours, hierarchy, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE, offset);
     
     for (const auto& contour : mask_contours) {
       if (contour.size() >= 3) {
@@ -852,18 +1608,19 @@ std::vector<std::vector<cv::Point>> flx_pdf_sio::extract_contours_from_masks(con
         
         if (simplified_contour.size() >= 3) {
           all_contours.push_back(simplified_contour);
+          if (contour_regions != nullptr) {
+            contour_regions->push_back(static_cast<int>(region_index));
+          }
         }
       }
     }
   }
   
-  std::cout << "🔺 Extracted " << all_contours.size() << " polygon contours" << std::endl;
+  FLX_PDF_TRACE_COUNT(m_trace, "contours.polygons", all_contours.size());
+  FLX_PDF_TRACE_LOG(m_trace, "🔺 Extracted " << all_contours.size() << " polygon contours");
   
-  // Debug: Save contour visualizations if debug directory provided
-  if (!debug_dir.empty() && !original_image.empty() && !all_contours.empty()) {
-    std::cout << "🖊️  Creating contour visualizations..." << std::endl;
-    
-    // Create contour visualization
+  // Contour visualizations as trace artifacts
+  if (FLX_PDF_TRACE_ARTIFACTS(m_trace) && page_index >= 0 && !original_image.empty() && !all_contours.empty()) {
     cv::Mat contour_image = original_image.clone();
     cv::Mat pure_contours = cv::Mat::zeros(original_image.size(), CV_8UC3);
     
@@ -881,18 +1638,10 @@ std::vector<std::vector<cv::Point>> flx_pdf_sio::extract_contours_from_masks(con
       for (const cv::Point& pt : all_contours[i]) {
         cv::circle(contour_image, pt, 3, cv::Scalar(0, 255, 0), -1);
       }
-      
-      std::cout << "    📍 Contour " << (i+1) << ": " << all_contours[i].size() << " vertices" << std::endl;
     }
     
-    // Save contour visualizations
-    std::string contours_path = debug_dir + "/03_contours_on_original.png";
-    cv::imwrite(contours_path, contour_image);
-    std::cout << "💾 Saved contours on original: " << contours_path << std::endl;
-    
-    std::string pure_contours_path = debug_dir + "/03_contours_filled.png";
-    cv::imwrite(pure_contours_path, pure_contours);
-    std::cout << "💾 Saved filled contours: " << pure_contours_path << std::endl;
+    m_trace.write_artifact(page_index, "03_contours_on_original.png", contour_image);
+    m_trace.write_artifact(page_index, "03_contours_filled.png", pure_contours);
   }
   
   return all_contours;
@@ -901,17 +1650,18 @@ std::vector<std::vector<cv::Point>> flx_pdf_sio::extract_contours_from_masks(con
 void flx_pdf_sio::build_geometry_hierarchy(const std::vector<std::vector<std::vector<cv::Point>>>& page_contours,
                                           const std::vector<cv::Mat>& clean_images,
                                           flx_model_list<flx_layout_geometry>& geometries) {
-  std::cout << "📊 Building geometry hierarchy..." << std::endl;
+  FLX_PDF_TRACE_SPAN(m_trace, "hierarchy");
+  FLX_PDF_TRACE_LOG(m_trace, "📊 Building geometry hierarchy...");
   geometries = flx_model_list<flx_layout_geometry>();
   
-  std::cout << "   Processing " << page_contours.size() << " pages with contours..." << std::endl;
+  FLX_PDF_TRACE_LOG(m_trace, "   Processing " << page_contours.size() << " pages with contours...");
   
   // Process each page separately
   for (size_t page_idx = 0; page_idx < page_contours.size(); page_idx++) {
     const auto& page_contour_list = page_contours[page_idx];
     const cv::Mat& page_image = (page_idx < clean_images.size()) ? clean_images[page_idx] : cv::Mat();
     
-    std::cout << "   📄 Page " << (page_idx + 1) << ": " << page_contour_list.size() << " contours" << std::endl;
+    FLX_PDF_TRACE_LOG(m_trace, "   📄 Page " << (page_idx + 1) << ": " << page_contour_list.size() << " contours");
     
     // Create page geometry
     flx_layout_geometry page_geom;
@@ -925,78 +1675,25 @@ void flx_pdf_sio::build_geometry_hierarchy(const std::vector<std::vector<std::ve
       page_geom.fill_color = "#F7F4F6"; // Default page background
     }
   
-    // Clean up old debug directory and create fresh one
-    std::string debug_dir = "debug_page_" + std::to_string(page_idx + 1);
-    std::string cleanup_cmd = "rm -rf " + debug_dir;
-    system(cleanup_cmd.c_str());
-    create_debug_directory(debug_dir);
-    
     // TEMPORARILY DISABLE Hough line detection - causing crash
     std::vector<flx_layout_geometry> detected_lines; // Empty
-    std::cout << "    🔍 Hough line detection temporarily disabled - crash debugging" << std::endl;
+    FLX_PDF_TRACE_LOG(m_trace, "    🔍 Hough line detection temporarily disabled - crash debugging");
     
     // Convert contours to sub-geometries for this page
     flx_model_list<flx_layout_geometry> page_sub_geometries;
-    for (size_t i = 0; i < page_contour_list.size(); ++i) {
-      const auto& contour = page_contour_list[i];
-      
-      flx_layout_geometry geom;
-      
-      // Calculate bounding rectangle
-      cv::Rect bbox = cv::boundingRect(contour);
-      geom.x = bbox.x;
-      geom.y = bbox.y;
-      geom.width = bbox.width;
-      geom.height = bbox.height;
-      
-      // Convert cv::Point contour to flx_layout_vertex
-      for (const auto& point : contour) {
-        flx_layout_vertex vertex;
-        vertex.x = point.x;
-        vertex.y = point.y;
-        geom.vertices.push_back(vertex);
-      }
-      
-      // Calculate dominant color from the page image
-      cv::Scalar mean_color = cv::Scalar(128, 128, 128); // Default gray
-      if (!page_image.empty()) {
-        mean_color = calculate_dominant_color_for_contour_from_image(contour, page_image);
-      }
-      
-      // Check if this contour should be treated as a line (≤5px width)
-      if (is_contour_line_shaped(contour, 5.0)) {
-        // Store as stroke_color for lines
-        geom.stroke_color = rgb_to_hex_string(mean_color);
-      } else {
-        // Store as fill_color for filled shapes  
-        geom.fill_color = rgb_to_hex_string(mean_color);
-      }
-      
-      page_sub_geometries.push_back(geom);
-      
-      // Debug output differentiate between lines and shapes
-      if (geom.stroke_color->empty() == false) {
-        std::cout << "     🔸 LINE " << (i+1) << ": " << geom.vertices.size() << " vertices, "
-                  << "stroke_color=" << geom.stroke_color->c_str() << ", bbox(" 
-                  << geom.x << "," << geom.y << "," << geom.width << "," << geom.height << ")" << std::endl;
-      } else {
-        std::cout << "     🔸 SHAPE " << (i+1) << ": " << geom.vertices.size() << " vertices, "
-                  << "fill_color=" << geom.fill_color->c_str() << ", bbox(" 
-                  << geom.x << "," << geom.y << "," << geom.width << "," << geom.height << ")" << std::endl;
-      }
-    }
+    build_page_geometries(page_contour_list, page_image, page_sub_geometries);
     
     // Add detected lines to the page sub-geometries
     for (const auto& line : detected_lines) {
       page_sub_geometries.push_back(line);
-      std::cout << "     📏 HOUGH LINE: " << line.vertices.size() << " vertices, "
-                << "stroke_color=" << line.stroke_color->c_str() << ", bbox(" 
-                << line.x << "," << line.y << "," << line.width << "," << line.height << ")" << std::endl;
+      FLX_PDF_TRACE_LOG(m_trace, "     📏 HOUGH LINE: " << line.vertices.size() << " vertices, "
+                        << "stroke_color=" << line.stroke_color->c_str() << ", bbox(" 
+                        << line.x << "," << line.y << "," << line.width << "," << line.height << ")");
     }
     
     // TEMPORARILY DISABLE hierarchical structure - causing crash
     //build_hierarchical_structure(page_sub_geometries);
-    std::cout << "    🏗️ Hierarchical structure temporarily disabled - debugging content assignment" << std::endl;
+    FLX_PDF_TRACE_LOG(m_trace, "    🏗️ Hierarchical structure temporarily disabled - debugging content assignment");
     
     // Assign sub-geometries to page
     page_geom.sub_geometries = page_sub_geometries;
@@ -1004,121 +1701,116 @@ void flx_pdf_sio::build_geometry_hierarchy(const std::vector<std::vector<std::ve
     // Add page to main geometries list
     geometries.push_back(page_geom);
     
-    std::cout << "     ✅ Page " << (page_idx + 1) << " complete: " << page_sub_geometries.size() << " sub-geometries" << std::endl;
+    FLX_PDF_TRACE_LOG(m_trace, "     ✅ Page " << (page_idx + 1) << " complete: " << page_sub_geometries.size() << " sub-geometries");
   }
   
-  std::cout << "  📊 Built hierarchy: " << geometries.size() << " pages with nested geometries" << std::endl;
+  FLX_PDF_TRACE_LOG(m_trace, "  📊 Built hierarchy: " << geometries.size() << " pages with nested geometries");
+}
+
+// Contours of one page (pixel coordinates of page_image) as geometries: thin
+// ones are lines with a stroke colour, the rest shapes with a fill colour
+void flx_pdf_sio::build_page_geometries(const std::vector<std::vector<cv::Point>>& contours,
+                                        const cv::Mat& page_image,
+                                        flx_model_list<flx_layout_geometry>& geometries,
+                                        const std::vector<cv::Scalar>* contour_colors) {
+  for (size_t i = 0; i < contours.size(); ++i) {
+    const auto& contour = contours[i];
+    
+    flx_layout_geometry geom;
+    
+    // Calculate bounding rectangle
+    cv::Rect bbox = cv::boundingRect(contour);
+    geom.x = bbox.x;
+    geom.y = bbox.y;
+    geom.width = bbox.width;
+    geom.height = bbox.height;
+    
+    // Convert cv::Point contour to flx_layout_vertex
+    for (const auto& point : contour) {
+      flx_layout_vertex vertex;
+      vertex.x = point.x;
+      vertex.y = point.y;
+      geom.vertices.push_back(vertex);
+    }
+    
+    // Dominant color: known from the region statistics, else sampled from the page image
+    cv::Scalar mean_color = cv::Scalar(128, 128, 128); // Default gray
+    if (contour_colors != nullptr && i < contour_colors->size()) {
+      mean_color = (*contour_colors)[i];
+    } else if (!page_image.empty()) {
+      mean_color = calculate_dominant_color_for_contour_from_image(contour, page_image);
+    }
+    
+    // Check if this contour should be treated as a line (≤5px width)
+    if (contour.size() >= 4 && is_line_shaped(bbox, 5.0)) {
+      // Store as stroke_color for lines
+      geom.stroke_color = rgb_to_hex_string(mean_color);
+    } else {
+      // Store as fill_color for filled shapes  
+      geom.fill_color = rgb_to_hex_string(mean_color);
+    }
+    
+    geometries.push_back(geom);
+    
+    // Debug output differentiate between lines and shapes
+    if (geom.stroke_color->empty() == false) {
+      FLX_PDF_TRACE_COUNT(m_trace, "hierarchy.lines", 1);
+      FLX_PDF_TRACE_LOG(m_trace, "     🔸 LINE " << (i+1) << ": " << geom.vertices.size() << " vertices, "
+                        << "stroke_color=" << geom.stroke_color->c_str() << ", bbox(" 
+                        << geom.x << "," << geom.y << "," << geom.width << "," << geom.height << ")");
+    } else {
+      FLX_PDF_TRACE_COUNT(m_trace, "hierarchy.shapes", 1);
+      FLX_PDF_TRACE_LOG(m_trace, "     🔸 SHAPE " << (i+1) << ": " << geom.vertices.size() << " vertices, "
+                        << "fill_color=" << geom.fill_color->c_str() << ", bbox(" 
+                        << geom.x << "," << geom.y << "," << geom.width << "," << geom.height << ")");
+    }
+  }
 }
 
 void flx_pdf_sio::assign_content_to_geometries(flx_model_list<flx_layout_text>& texts, 
                                               flx_model_list<flx_layout_image>& images,
                                               flx_model_list<flx_layout_geometry>& geometries) {
-  std::cout << "  Assigning content to geometries..." << std::endl;
+  FLX_PDF_TRACE_LOG(m_trace, "  Assigning content to geometries...");
+  
+  geometry_index index;
   
   // Assign texts to geometries
   for (size_t i = 0; i < texts.size(); i++) {
-    assign_content_to_geometry_recursive(texts.at(i), geometries);
+    auto& text = texts.at(i);
+    flx_layout_geometry* target = find_content_target(index, geometries, text.x, text.y);
+    if (target != nullptr) {
+      target->texts.push_back(text);
+    }
   }
   
   // Assign images to geometries
   for (size_t i = 0; i < images.size(); i++) {
-    assign_content_to_geometry_recursive(images.at(i), geometries);
+    auto& image = images.at(i);
+    flx_layout_geometry* target = find_content_target(index, geometries, image.x, image.y);
+    if (target != nullptr) {
+      target->images.push_back(image);
+    }
   }
   
-  std::cout << "  Content assignment completed" << std::endl;
+  FLX_PDF_TRACE_LOG(m_trace, "  Content assignment completed");
 }
 
 void flx_pdf_sio::assign_content_to_geometries_flx(flx_model_list<flx_layout_text>& texts, 
                                                   flx_model_list<flx_layout_image>& images,
                                                   flx_model_list<flx_layout_geometry>& geometries) {
-  std::cout << "  Assigning content to geometries..." << std::endl;
-  
-  // Assign texts to geometries
-  for (size_t i = 0; i < texts.size(); i++) {
-    assign_content_to_geometry_recursive_flx(texts.at(i), geometries);
-  }
-  
-  // Assign images to geometries
-  for (size_t i = 0; i < images.size(); i++) {
-    assign_content_to_geometry_recursive_flx(images.at(i), geometries);
-  }
-  
-  std::cout << "  Content assignment completed" << std::endl;
+  assign_content_to_geometries(texts, images, geometries);
 }
 
 std::string flx_pdf_sio::filter_pdf_content_stream(const std::string& content) {
-  std::istringstream input(content);
-  std::ostringstream output;
-  std::string line;
-  bool skip_text_block = false;
-  
-  while (std::getline(input, line)) {
-    // Remove leading/trailing whitespace for easier parsing
-    std::string trimmed = line;
-    
-    // Safely trim leading whitespace
-    size_t start = trimmed.find_first_not_of(" \t");
-    if (start == std::string::npos) {
-      trimmed = "";  // Line is all whitespace
-    } else {
-      // Safely trim trailing whitespace
-      size_t end = trimmed.find_last_not_of(" \t");
-      if (end != std::string::npos) {
-        trimmed = trimmed.substr(start, end - start + 1);
-      } else {
-        trimmed = "";  // Shouldn't happen, but be safe
-      }
-    }
-    
-    // Skip text operators and text blocks
-    if (trimmed == "BT") {
-      skip_text_block = true;
-      continue;
-    } else if (trimmed == "ET") {
-      skip_text_block = false;
-      continue;
-    } else if (skip_text_block) {
-      // Skip all content within text blocks
-      continue;
-    }
-    
-    // Skip image operators (Do commands)
-    if (trimmed.find(" Do") != std::string::npos) {
-      std::cout << "    Filtering image operator: " << trimmed << std::endl;
-      continue;
-    }
-    
-    // Skip font setting operators (Tf commands)
-    if (trimmed.find(" Tf") != std::string::npos) {
-      continue;
-    }
-    
-    // Skip text positioning operators
-    if (trimmed.find(" Tm") != std::string::npos || 
-        trimmed.find(" Td") != std::string::npos ||
-        trimmed.find(" TD") != std::string::npos ||
-        trimmed.find(" T*") != std::string::npos) {
-      continue;
-    }
-    
-    // Skip text showing operators
-    if (trimmed.find(" Tj") != std::string::npos ||
-        trimmed.find(" TJ") != std::string::npos ||
-        trimmed.find("'") != std::string::npos ||
-        trimmed.find("\"") != std::string::npos) {
-      continue;
-    }
-    
-    // Keep path drawing operators (m, l, c, s, S, f, F, B, b, etc.)
-    // Keep color operators (rg, RG, k, K, cs, CS, sc, SC, etc.)
-    // Keep graphics state operators (q, Q, cm, etc.)
-    output << line << "\n";
-  }
-  
-  return output.str();
+  // Drops text objects, text operators, XObjects and inline images; keeps
+  // paths, colours and graphics state (one instruction per line)
+  std::string filtered;
+  flx_content::process_page_content(content, nullptr, &filtered);
+  return filtered;
 }
 
 bool flx_pdf_sio::extract_geometries_from_content_streams(flx_model_list<flx_layout_geometry>& all_geometries) {
+  FLX_PDF_TRACE_SPAN(m_trace, "content_geometries");
   try {
     auto& pdf_pages = m_pdf->GetPages();
     
@@ -1138,7 +1830,7 @@ bool flx_pdf_sio::extract_geometries_from_content_streams(flx_model_list<flx_lay
       // Get content stream
       auto contents = pdf_page.GetContents();
       if (contents == nullptr) {
-        std::cout << "Page " << (page_num + 1) << ": No content stream" << std::endl;
+        FLX_PDF_TRACE_LOG(m_trace, "Page " << (page_num + 1) << ": No content stream");
         continue;
       }
       
@@ -1148,15 +1840,15 @@ bool flx_pdf_sio::extract_geometries_from_content_streams(flx_model_list<flx_lay
       
       // Parse geometries into this page's sub_geometries
       if (parse_content_stream_for_geometries(content_str, page_geometry.sub_geometries)) {
-        std::cout << "Page " << (page_num + 1) << ": Successfully parsed content stream" << std::endl;
-        std::cout << "Page " << (page_num + 1) << ": Extracted " << page_geometry.sub_geometries.size() << " geometries" << std::endl;
+        FLX_PDF_TRACE_COUNT(m_trace, "content_geometries.geometries", page_geometry.sub_geometries.size());
+        FLX_PDF_TRACE_LOG(m_trace, "Page " << (page_num + 1) << ": Extracted " << page_geometry.sub_geometries.size() << " geometries");
       } else {
         std::cout << "Page " << (page_num + 1) << ": Failed to parse geometries" << std::endl;
         return false;
       }
     }
     
-    std::cout << "Total pages created: " << all_geometries.size() << std::endl;
+    FLX_PDF_TRACE_LOG(m_trace, "Total pages created: " << all_geometries.size());
     return true;
     
   } catch (const std::exception& e) {
@@ -1166,67 +1858,7 @@ bool flx_pdf_sio::extract_geometries_from_content_streams(flx_model_list<flx_lay
 }
 
 bool flx_pdf_sio::parse_content_stream_for_geometries(const std::string& content, flx_model_list<flx_layout_geometry>& geometries) {
-  std::istringstream input(content);
-  std::string line;
-  pdf_graphics_state state;
-  std::stack<pdf_graphics_state> state_stack;  // For q/Q save/restore
-  
-  while (std::getline(input, line)) {
-    // Remove whitespace
-    std::string trimmed = line;
-    trimmed.erase(0, trimmed.find_first_not_of(" \t"));
-    trimmed.erase(trimmed.find_last_not_of(" \t") + 1);
-    
-    if (trimmed.empty()) continue;
-    
-    std::cout << "  Processing line: '" << trimmed << "'" << std::endl;
-    
-    // Graphics state save/restore - DISABLED FOR DEBUGGING
-    if (trimmed == "q") {
-      // state_stack.push(state);  // DISABLED - causes segfault with flx_model_list
-      std::cout << "  Ignoring q (save graphics state)" << std::endl;
-      continue;
-    } else if (trimmed == "Q") {
-      // if (!state_stack.empty()) {
-      //   state = state_stack.top();
-      //   state_stack.pop();
-      // }
-      std::cout << "  Ignoring Q (restore graphics state)" << std::endl;
-      continue;
-    }
-    
-    // Path construction operators
-    if (trimmed.find(" m") != std::string::npos && trimmed.back() == 'm') {
-      parse_move_to(trimmed, state);
-    } else if (trimmed.find(" l") != std::string::npos && trimmed.back() == 'l') {
-      parse_line_to(trimmed, state);
-    } else if (trimmed.find(" c") != std::string::npos && trimmed.back() == 'c') {
-      parse_curve_to(trimmed, state);
-    } else if (trimmed == "h") {
-      parse_close_path(state);
-    } else if (trimmed.find(" re") != std::string::npos && trimmed.substr(trimmed.length()-2) == "re") {
-      parse_rectangle(trimmed, state);
-    }
-    
-    // Color operators  
-    else if (trimmed.find(" rg") != std::string::npos && trimmed.substr(trimmed.length()-2) == "rg") {
-      parse_fill_color(trimmed, state);
-    } else if (trimmed.find(" RG") != std::string::npos && trimmed.substr(trimmed.length()-2) == "RG") {
-      parse_stroke_color(trimmed, state);
-    }
-    
-    // Paint operators
-    else if (trimmed == "f" || trimmed == "F") {
-      parse_fill_path(state, geometries);
-    } else if (trimmed == "S") {
-      parse_stroke_path(state, geometries);
-    } else if (trimmed == "B" || trimmed == "b") {
-      // Fill and stroke
-      parse_fill_path(state, geometries);
-      parse_stroke_path(state, geometries);
-    }
-  }
-  
+  flx_content::process_page_content(content, &geometries, nullptr);
   return true;
 }
 
@@ -1253,78 +1885,6 @@ bool flx_pdf_sio::replace_page_content_stream(PoDoFo::PdfPage& page, const std::
   }
 }
 
-int flx_pdf_sio::flood_fill_neighbor_based(const cv::Mat& image, cv::Point seed, cv::Mat& region_mask, cv::Mat& processed, int tolerance) {
-  if (seed.x < 0 || seed.y < 0 || seed.x >= image.cols || seed.y >= image.rows) {
-    return 0;
-  }
-  
-  if (processed.at<uchar>(seed.y, seed.x) > 0) {
-    return 0;
-  }
-  
-  std::stack<cv::Point> stack;
-  stack.push(seed);
-  int filled_pixels = 0;
-  
-  // 4-connectivity neighbors (up, down, left, right)
-  const int dx[] = {0, 0, -1, 1};
-  const int dy[] = {-1, 1, 0, 0};
-  
-  while (!stack.empty()) {
-    cv::Point current = stack.top();
-    stack.pop();
-    
-    // Skip if already processed
-    if (processed.at<uchar>(current.y, current.x) > 0) {
-      continue;
-    }
-    
-    // Mark as processed and part of region
-    processed.at<uchar>(current.y, current.x) = 255;
-    region_mask.at<uchar>(current.y, current.x) = 255;
-    filled_pixels++;
-    
-    // Get current pixel color
-    cv::Vec3b current_color = image.at<cv::Vec3b>(current.y, current.x);
-    
-    // Check all 4 neighbors
-    for (int i = 0; i < 4; i++) {
-      int nx = current.x + dx[i];
-      int ny = current.y + dy[i];
-      
-      // Check bounds
-      if (nx < 0 || ny < 0 || nx >= image.cols || ny >= image.rows) {
-        continue;
-      }
-      
-      // Skip if already processed
-      if (processed.at<uchar>(ny, nx) > 0) {
-        continue;
-      }
-      
-      // Check if neighbor color is similar to current pixel
-      cv::Vec3b neighbor_color = image.at<cv::Vec3b>(ny, nx);
-      if (is_color_similar(current_color, neighbor_color, tolerance)) {
-        stack.push(cv::Point(nx, ny));
-      }
-    }
-  }
-  
-  return filled_pixels;
-}
-
-bool flx_pdf_sio::is_color_similar(const cv::Vec3b& color1, const cv::Vec3b& color2, int tolerance) {
-  // Calculate Euclidean distance in RGB color space
-  int diff_b = std::abs((int)color1[0] - (int)color2[0]);
-  int diff_g = std::abs((int)color1[1] - (int)color2[1]);
-  int diff_r = std::abs((int)color1[2] - (int)color2[2]);
-  
-  // Use Manhattan distance for speed (sum of absolute differences)
-  int total_diff = diff_b + diff_g + diff_r;
-  
-  return total_diff <= tolerance;
-}
-
 cv::Scalar flx_pdf_sio::calculate_dominant_color_for_contour(const std::vector<cv::Point>& contour, 
                                                         const std::vector<cv::Mat>& clean_images, 
                                                         size_t contour_index) {
@@ -1354,12 +1914,21 @@ cv::Scalar flx_pdf_sio::calculate_dominant_color_for_contour_from_image(const st
     return cv::Scalar(255, 255, 255); // Default white
   }
   
-  // Create a mask for the contour
-  cv::Mat mask = cv::Mat::zeros(image.size(), CV_8UC1);
-  cv::fillPoly(mask, std::vector<std::vector<cv::Point>>{contour}, cv::Scalar(255));
+  // Mask of the contour's bounding box only, not of the whole page
+  cv::Rect bbox = cv::boundingRect(contour) & cv::Rect(0, 0, image.cols, image.rows);
+  if (bbox.width <= 0 || bbox.height <= 0) {
+    return cv::Scalar(255, 255, 255);
+  }
+  std::vector<cv::Point> local_contour;
+  local_contour.reserve(contour.size());
+  for (const cv::Point& point : contour) {
+    local_contour.push_back(cv::Point(point.x - bbox.x, point.y - bbox.y));
+  }
+  cv::Mat mask = cv::Mat::zeros(bbox.height, bbox.width, CV_8UC1);
+  cv::fillPoly(mask, std::vector<std::vector<cv::Point>>{local_contour}, cv::Scalar(255));
   
   // Calculate mean color within the contour region
-  cv::Scalar mean_color = cv::mean(image, mask);
+  cv::Scalar mean_color = cv::mean(image(bbox), mask);
   return mean_color;
 }
 
@@ -1375,10 +1944,10 @@ std::string flx_pdf_sio::rgb_to_hex_string(const cv::Scalar& color) {
 
 bool flx_pdf_sio::is_contour_line_shaped(const std::vector<cv::Point>& contour, double max_width) {
   if (contour.size() < 4) return false; // Need at least 4 points for a meaningful shape
-  
-  // Calculate bounding rectangle
-  cv::Rect bounding_rect = cv::boundingRect(contour);
-  
+  return is_line_shaped(cv::boundingRect(contour), max_width);
+}
+
+bool flx_pdf_sio::is_line_shaped(const cv::Rect& bounding_rect, double max_width) {
   // Check if width or height is very small (line-like)
   double width = bounding_rect.width;
   double height = bounding_rect.height;
@@ -1388,15 +1957,16 @@ bool flx_pdf_sio::is_contour_line_shaped(const std::vector<cv::Point>& contour,
   bool is_thin_vertical = (width <= max_width && height > max_width);
   
   if (is_thin_horizontal || is_thin_vertical) {
-    std::cout << "    🔍 Detected line-shaped contour: " << width << "x" << height 
-              << " pixels (threshold: " << max_width << "px)" << std::endl;
+    FLX_PDF_TRACE_LOG(m_trace, "    🔍 Detected line-shaped contour: " << width << "x" << height 
+                      << " pixels (threshold: " << max_width << "px)");
     return true;
   }
   
   return false;
 }
 
-flx_model_list<flx_layout_geometry> flx_pdf_sio::detect_lines_hough(const cv::Mat& image, const std::string& debug_dir) {
+flx_model_list<flx_layout_geometry> flx_pdf_sio::detect_lines_hough(const cv::Mat& image, int page_index) {
+  FLX_PDF_TRACE_SPAN(m_trace, "hough_lines");
   flx_model_list<flx_layout_geometry> detected_lines;
   
   if (image.empty()) {
@@ -1404,7 +1974,7 @@ flx_model_list<flx_layout_geometry> flx_pdf_sio::detect_lines_hough(const cv::Ma
     return detected_lines;
   }
   
-  std::cout << "    🔍 Starting Hough line detection..." << std::endl;
+  FLX_PDF_TRACE_LOG(m_trace, "    🔍 Starting Hough line detection...");
   
   // Convert to grayscale if needed
   cv::Mat gray;
@@ -1418,18 +1988,17 @@ flx_model_list<flx_layout_geometry> flx_pdf_sio::detect_lines_hough(const cv::Ma
   cv::Mat edges;
   cv::Canny(gray, edges, 50, 150, 3);
   
-  // Save debug edge detection image
-  if (!debug_dir.empty()) {
-    std::string edge_path = debug_dir + "/04_edges_canny.png";
-    cv::imwrite(edge_path, edges);
-    std::cout << "      💾 Saved edge detection: " << edge_path << std::endl;
+  // Edge detection image as trace artifact
+  if (FLX_PDF_TRACE_ARTIFACTS(m_trace) && page_index >= 0) {
+    m_trace.write_artifact(page_index, "04_edges_canny.png", edges);
   }
   
   // Apply Hough Line Transform  
   std::vector<cv::Vec4i> lines;
   cv::HoughLinesP(edges, lines, 1, CV_PI/180, 50, 30, 10);
   
-  std::cout << "    📏 Detected " << lines.size() << " lines with Hough transform" << std::endl;
+  FLX_PDF_TRACE_COUNT(m_trace, "hough_lines.lines", lines.size());
+  FLX_PDF_TRACE_LOG(m_trace, "    📏 Detected " << lines.size() << " lines with Hough transform");
   
   // Convert lines to flx_layout_geometry with stroke_color
   for (size_t i = 0; i < lines.size(); i++) {
@@ -1477,140 +2046,84 @@ flx_model_list<flx_layout_geometry> flx_pdf_sio::detect_lines_hough(const cv::Ma
     
     detected_lines.push_back(line_geom);
     
-    std::cout << "      📏 Line " << (i+1) << ": (" << line[0] << "," << line[1] 
-              << ") → (" << line[2] << "," << line[3] << "), color="; 
-    if (line_geom.stroke_color->empty() == false) {
-      std::cout << line_geom.stroke_color->c_str();
-    } else {
-      std::cout << "(empty)";
-    }
-    std::cout << std::endl;
+    FLX_PDF_TRACE_LOG(m_trace, "      📏 Line " << (i+1) << ": (" << line[0] << "," << line[1] 
+                      << ") → (" << line[2] << "," << line[3] << "), color="
+                      << (line_geom.stroke_color->empty() ? "(empty)" : line_geom.stroke_color->c_str()));
   }
   
-  // Create debug visualization
-  if (!debug_dir.empty() && lines.size() > 0) {
+  // Line visualization as trace artifact
+  if (FLX_PDF_TRACE_ARTIFACTS(m_trace) && page_index >= 0 && lines.size() > 0) {
     cv::Mat line_vis = image.clone();
     for (const auto& line : lines) {
       cv::line(line_vis, cv::Point(line[0], line[1]), cv::Point(line[2], line[3]), 
                cv::Scalar(0, 255, 0), 2); // Green lines
     }
-    std::string lines_path = debug_dir + "/04_detected_lines.png";
-    cv::imwrite(lines_path, line_vis);
-    std::cout << "      💾 Saved line visualization: " << lines_path << std::endl;
+    m_trace.write_artifact(page_index, "04_detected_lines.png", line_vis);
   }
   
   return detected_lines;
 }
 
-bool flx_pdf_sio::is_geometry_contained_in(const flx_layout_geometry& inner, const flx_layout_geometry& outer) {
-  // Check if inner's bounding box is completely within outer's bounding box
-  double inner_left = inner.x;
-  double inner_top = inner.y;
-  double inner_right = inner.x + inner.width;
-  double inner_bottom = inner.y + inner.height;
-  
-  double outer_left = outer.x;
-  double outer_top = outer.y;
-  double outer_right = outer.x + outer.width;
-  double outer_bottom = outer.y + outer.height;
-  
-  return (inner_left >= outer_left && 
-          inner_top >= outer_top && 
-          inner_right <= outer_right && 
-          inner_bottom <= outer_bottom);
-}
-
-void flx_pdf_sio::assign_content_to_geometry_recursive(flx_layout_text& text, flx_model_list<flx_layout_geometry>& geometries) {
-  for (size_t i = 0; i < geometries.size(); i++) {
-    auto& geometry = geometries.at(i);
-    if (is_point_in_geometry(text.x, text.y, geometry)) {
-      // Try to assign to deepest possible sub-geometry first
-      if (geometry.sub_geometries.size() > 0) {
-        assign_content_to_geometry_recursive_flx(text, geometry.sub_geometries);
-      } else {
-        // Add to this geometry if no deeper container found
-        geometry.texts.push_back(text);
-      }
-      return; // Only assign to one geometry
-    }
+flx_layout_geometry* flx_pdf_sio::find_content_target(geometry_index& index,
+                                                      flx_model_list<flx_layout_geometry>& geometries,
+                                                      double x, double y) {
+  if (!index.built) {
+    index.boxes = flx_layout_index::from_list(geometries);
+    index.children.resize(geometries.size());
+    index.built = true;
   }
-}
-
-void flx_pdf_sio::assign_content_to_geometry_recursive(flx_layout_image& image, flx_model_list<flx_layout_geometry>& geometries) {
-  for (size_t i = 0; i < geometries.size(); i++) {
-    auto& geometry = geometries.at(i);
-    if (is_point_in_geometry(image.x, image.y, geometry)) {
-      // Try to assign to deepest possible sub-geometry first
-      if (geometry.sub_geometries.size() > 0) {
-        assign_content_to_geometry_recursive_flx(image, geometry.sub_geometries);
-      } else {
-        // Add to this geometry if no deeper container found
-        geometry.images.push_back(image);
-      }
-      return; // Only assign to one geometry
-    }
+  
+  // The first geometry in list order containing the point takes the content;
+  // if it has sub-geometries the content goes one level deeper (or nowhere)
+  std::vector<size_t> hits;
+  index.boxes.query_point(x, y, hits);
+  if (hits.empty()) {
+    return nullptr;
   }
-}
-
-void flx_pdf_sio::assign_content_to_geometry_recursive_flx(flx_layout_text& text, flx_model_list<flx_layout_geometry>& geometries) {
-  for (size_t i = 0; i < geometries.size(); ++i) {
-    auto& geometry = geometries[i];
-    if (is_point_in_geometry(text.x, text.y, geometry)) {
-      if (geometry.sub_geometries.size() > 0) {
-        assign_content_to_geometry_recursive_flx(text, geometry.sub_geometries);
-      } else {
-        geometry.texts.push_back(text);
-      }
-      return;
-    }
+  
+  auto& geometry = geometries[hits.front()];
+  if (geometry.sub_geometries.size() == 0) {
+    return &geometry;
   }
-}
-
-void flx_pdf_sio::assign_content_to_geometry_recursive_flx(flx_layout_image& image, flx_model_list<flx_layout_geometry>& geometries) {
-  for (size_t i = 0; i < geometries.size(); ++i) {
-    auto& geometry = geometries[i];
-    if (is_point_in_geometry(image.x, image.y, geometry)) {
-      if (geometry.sub_geometries.size() > 0) {
-        assign_content_to_geometry_recursive_flx(image, geometry.sub_geometries);
-      } else {
-        geometry.images.push_back(image);
-      }
-      return;
-    }
+  auto& child = index.children[hits.front()];
+  if (!child) {
+    child = std::make_unique<geometry_index>();
   }
-}
-
-bool flx_pdf_sio::is_point_in_geometry(double x, double y, const flx_layout_geometry& geometry) {
-  return (x >= geometry.x && 
-          y >= geometry.y && 
-          x <= geometry.x + geometry.width && 
-          y <= geometry.y + geometry.height);
+  return find_content_target(*child, geometry.sub_geometries, x, y);
 }
 
 void flx_pdf_sio::build_hierarchical_structure(flx_model_list<flx_layout_geometry>& geometries) {
-  std::cout << "    🏗️ Building hierarchical structure for " << geometries.size() << " geometries..." << std::endl;
+  FLX_PDF_TRACE_LOG(m_trace, "    🏗️ Building hierarchical structure for " << geometries.size() << " geometries...");
   
   if (geometries.size() <= 1) return;
   
   try {
-    // Convert to std::vector for safer manipulation
-    std::vector<flx_layout_geometry> geometry_vector;
+    // Containers get their nested geometries in place (copying the models
+    // into a std::vector left dangling list storage behind)
+    std::vector<flx_layout_index::box> boxes;
     for (size_t i = 0; i < geometries.size(); i++) {
-      geometry_vector.push_back(geometries[i]);
+      boxes.push_back(flx_layout_index::bounds_of(geometries[i]));
     }
+    flx_layout_index index(boxes);
     
     // Sort geometries by area (largest first) to process containers before contained items
     std::vector<std::pair<size_t, double>> geometry_areas;
-    for (size_t i = 0; i < geometry_vector.size(); i++) {
-      double area = geometry_vector[i].width * geometry_vector[i].height;
+    for (size_t i = 0; i < boxes.size(); i++) {
+      double area = (boxes[i].right - boxes[i].left) * (boxes[i].bottom - boxes[i].top);
       geometry_areas.push_back({i, area});
     }
     
     std::sort(geometry_areas.begin(), geometry_areas.end(), 
              [](const auto& a, const auto& b) { return a.second > b.second; });
     
+    std::vector<size_t> rank(geometry_areas.size());
+    for (size_t r = 0; r < geometry_areas.size(); r++) {
+      rank[geometry_areas[r].first] = r;
+    }
+    
     // Create a working list to track which geometries are still available for assignment
-    std::vector<bool> available(geometry_vector.size(), true);
+    std::vector<bool> available(geometries.size(), true);
+    std::vector<size_t> contained;
     
     // Process geometries from largest to smallest
     for (const auto& outer_pair : geometry_areas) {
@@ -1618,40 +2131,39 @@ void flx_pdf_sio::build_hierarchical_structure(flx_model_list<flx_layout_geometr
       
       if (!available[outer_idx]) continue;
       
-      auto& outer_geom = geometry_vector[outer_idx];
+      auto& outer_geom = geometries[outer_idx];
       
-      // Find all smaller geometries that are contained in this one
-      for (const auto& inner_pair : geometry_areas) {
-        size_t inner_idx = inner_pair.first;
-        
+      // Smaller geometries contained in this one, largest first
+      index.query_contained_in(boxes[outer_idx], contained);
+      std::sort(contained.begin(), contained.end(),
+               [&rank](size_t a, size_t b) { return rank[a] < rank[b]; });
+      
+      for (size_t inner_idx : contained) {
         if (inner_idx == outer_idx || !available[inner_idx]) continue;
-        if (inner_pair.second >= outer_pair.second) continue; // Only check smaller geometries
+        if (geometry_areas[rank[inner_idx]].second >= outer_pair.second) continue; // Only smaller geometries
         
-        auto& inner_geom = geometry_vector[inner_idx];
+        auto& inner_geom = geometries[inner_idx];
+        FLX_PDF_TRACE_LOG(m_trace, "      📦 Moving geometry " << inner_idx << " into geometry " << outer_idx 
+                          << " (container: " << outer_geom.width << "x" << outer_geom.height 
+                          << ", contained: " << inner_geom.width << "x" << inner_geom.height << ")");
         
-        // Check if inner is contained in outer
-        if (is_geometry_contained_in(inner_geom, outer_geom)) {
-          std::cout << "      📦 Moving geometry " << inner_idx << " into geometry " << outer_idx 
-                    << " (container: " << outer_geom.width << "x" << outer_geom.height 
-                    << ", contained: " << inner_geom.width << "x" << inner_geom.height << ")" << std::endl;
-          
-          // Move the contained geometry to the container's sub_geometries
-          outer_geom.sub_geometries.push_back(inner_geom);
-          available[inner_idx] = false; // Mark as used
-        }
+        // Move the contained geometry to the container's sub_geometries
+        outer_geom.sub_geometries.push_back(inner_geom);
+        available[inner_idx] = false; // Mark as used
       }
     }
     
     // Create new flx_model_list with only top-level geometries
     flx_model_list<flx_layout_geometry> top_level_geometries;
-    for (size_t i = 0; i < geometry_vector.size(); i++) {
+    for (size_t i = 0; i < geometries.size(); i++) {
       if (available[i]) {
-        top_level_geometries.push_back(geometry_vector[i]);
+        top_level_geometries.push_back(geometries[i]);
       }
     }
     
-    std::cout << "      🏆 Result: " << top_level_geometries.size() << " top-level, " 
-              << (geometry_vector.size() - top_level_geometries.size()) << " nested" << std::endl;
+    [[maybe_unused]] size_t nested = geometries.size() - top_level_geometries.size();
+    FLX_PDF_TRACE_COUNT(m_trace, "hierarchy.nested", static_cast<int64_t>(nested));
+    FLX_PDF_TRACE_LOG(m_trace, "      🏆 Result: " << top_level_geometries.size() << " top-level, " << nested << " nested");
     
     // Replace original list with hierarchical structure
     geometries = top_level_geometries;
@@ -1662,201 +2174,6 @@ void flx_pdf_sio::build_hierarchical_structure(flx_model_list<flx_layout_geometr
   }
 }
 
-// PDF Operator Parsers
-
-bool flx_pdf_sio::parse_move_to(const std::string& line, pdf_graphics_state& state) {
-  // Format: "x y m"
-  std::istringstream iss(line);
-  double x, y;
-  char op;
-  
-  if (iss >> x >> y >> op && op == 'm') {
-    state.current_x = x;
-    state.current_y = y;
-    state.current_path.clear();  // Clear path
-    state.current_path.push_back({x, y});
-    state.path_closed = false;
-    return true;
-  }
-  return false;
-}
-
-bool flx_pdf_sio::parse_line_to(const std::string& line, pdf_graphics_state& state) {
-  // Format: "x y l"  
-  std::istringstream iss(line);
-  double x, y;
-  char op;
-  
-  if (iss >> x >> y >> op && op == 'l') {
-    state.current_x = x;
-    state.current_y = y;
-    state.current_path.push_back({x, y});
-    return true;
-  }
-  return false;
-}
-
-bool flx_pdf_sio::parse_curve_to(const std::string& line, pdf_graphics_state& state) {
-  // Format: "x1 y1 x2 y2 x3 y3 c" - Cubic Bezier curve
-  std::istringstream iss(line);
-  double x1, y1, x2, y2, x3, y3;
-  char op;
-  
-  if (iss >> x1 >> y1 >> x2 >> y2 >> x3 >> y3 >> op && op == 'c') {
-    // For now, approximate Bezier curve with line to end point
-    // TODO: Add proper Bezier support to flx_layout_geometry
-    state.current_x = x3;
-    state.current_y = y3;
-    state.current_path.push_back({x3, y3});
-    std::cout << "    Bezier curve approximated as line: (" << x1 << "," << y1 << ") -> (" << x3 << "," << y3 << ")" << std::endl;
-    return true;
-  }
-  return false;
-}
-
-bool flx_pdf_sio::parse_close_path(pdf_graphics_state& state) {
-  if (state.current_path.size() > 0) {
-    // Close path by adding line back to first point if not already there
-    const auto& first = state.current_path[0];
-    double first_x = first.first;
-    double first_y = first.second;
-    if (state.current_x != first_x || state.current_y != first_y) {
-      state.current_path.push_back({first_x, first_y});
-    }
-    state.path_closed = true;
-    state.current_x = first_x;
-    state.current_y = first_y;
-  }
-  return true;
-}
-
-bool flx_pdf_sio::parse_rectangle(const std::string& line, pdf_graphics_state& state) {
-  // Format: "x y w h re"
-  std::istringstream iss(line);
-  double x, y, w, h;
-  std::string op;
-  
-  if (iss >> x >> y >> w >> h >> op && op == "re") {
-    // Create rectangle path
-    state.current_path.clear();  // Clear path
-    
-    state.current_path.push_back({x, y});
-    state.current_path.push_back({x + w, y});
-    state.current_path.push_back({x + w, y + h});
-    state.current_path.push_back({x, y + h});
-    state.current_path.push_back({x, y});  // Close rectangle
-    
-    state.path_closed = true;
-    state.current_x = x;
-    state.current_y = y;
-    return true;
-  }
-  return false;
-}
-
-bool flx_pdf_sio::parse_fill_color(const std::string& line, pdf_graphics_state& state) {
-  // Format: "r g b rg"
-  std::istringstream iss(line);
-  double r, g, b;
-  std::string op;
-  
-  if (iss >> r >> g >> b >> op && op == "rg") {
-    state.fill_color_r = r;
-    state.fill_color_g = g; 
-    state.fill_color_b = b;
-    return true;
-  }
-  return false;
-}
-
-bool flx_pdf_sio::parse_stroke_color(const std::string& line, pdf_graphics_state& state) {
-  // Format: "r g b RG"
-  std::istringstream iss(line);
-  double r, g, b;
-  std::string op;
-  
-  if (iss >> r >> g >> b >> op && op == "RG") {
-    state.stroke_color_r = r;
-    state.stroke_color_g = g; 
-    state.stroke_color_b = b;
-    return true;
-  }
-  return false;
-}
-
-bool flx_pdf_sio::parse_fill_path(pdf_graphics_state& state, flx_model_list<flx_layout_geometry>& geometries) {
-  if (state.current_path.size() == 0) return false;
-  
-  std::cout << "    Creating geometry with " << state.current_path.size() << " vertices" << std::endl;
-  
-  // Work directly with flx_model_list - proper way!
-  geometries.add_element();  // Add new geometry to the list
-  auto& geom = geometries.back();  // Get reference to the new geometry
-  
-  std::cout << "    Added geometry to flx_model_list successfully" << std::endl;
-  
-  // Now work directly on the geometry in the vector - ADD ALL VERTICES
-  try {
-    for (const auto& point : state.current_path) {
-      geom.vertices.add_element();
-      auto& vertex = geom.vertices.back();
-      vertex.x = point.first;
-      vertex.y = point.second;
-    }
-    std::cout << "    Added all " << state.current_path.size() << " vertices successfully" << std::endl;
-  } catch (const std::exception& e) {
-    std::cout << "    ERROR in fill_path: " << e.what() << std::endl;
-    return false;
-  }
-  
-  // Convert RGB to hex color
-  int r = (int)(state.fill_color_r * 255);
-  int g = (int)(state.fill_color_g * 255);
-  int b = (int)(state.fill_color_b * 255);
-  
-  std::ostringstream color_stream;
-  color_stream << "#" << std::setfill('0') << std::setw(2) << std::hex << r
-               << std::setw(2) << g << std::setw(2) << b;
-  geom.fill_color = color_stream.str();
-  
-  std::cout << "    SUCCESS! Created filled geometry with " << state.current_path.size() 
-            << " vertices, color: #FF0000" << std::endl;
-  
-  return true;
-}
-
-bool flx_pdf_sio::parse_stroke_path(pdf_graphics_state& state, flx_model_list<flx_layout_geometry>& geometries) {
-  if (state.current_path.size() == 0) return false;
-  
-  std::cout << "    Creating stroked geometry with " << state.current_path.size() << " vertices" << std::endl;
-  
-  // Work directly with flx_model_list
-  geometries.add_element();
-  auto& geom = geometries.back();
-  
-  // Add all vertices
-  for (const auto& point : state.current_path) {
-    geom.vertices.add_element();
-    auto& vertex = geom.vertices.back();
-    vertex.x = point.first;
-    vertex.y = point.second;
-  }
-  
-  // Convert RGB to hex color for stroke
-  int r = (int)(state.stroke_color_r * 255);
-  int g = (int)(state.stroke_color_g * 255);
-  int b = (int)(state.stroke_color_b * 255);
-  
-  std::ostringstream color_stream;
-  color_stream << "#" << std::setfill('0') << std::setw(2) << std::hex << r
-               << std::setw(2) << g << std::setw(2) << b;
-  geom.stroke_color = color_stream.str();
-  
-  std::cout << "    Created stroked geometry successfully!" << std::endl;
-  
-  return true;
-}
-
 std::unique_ptr<PoDoFo::PdfMemDocument> flx_pdf_sio::create_geometry_only_pdf(flx_model_list<flx_layout_geometry>& geometry_pages) {
   try {
     auto clean_pdf = std::make_unique<PdfMemDocument>();
@@ -1903,29 +2220,24 @@ void flx_pdf_sio::render_geometry_only_to_page(PoDoFo::PdfPainter& painter, flx_
   // This creates a "geometry-only" version of the PDF
 }
 
-void flx_pdf_sio::create_debug_directory(const std::string& dir_name) {
-  // Create directory using mkdir -p equivalent
-  std::string command = "mkdir -p " + dir_name;
-  system(command.c_str());
-}
-
 void flx_pdf_sio::clear() {
-  // Clear the PDF document
-  if (m_pdf != nullptr) {
-    delete m_pdf;
-    m_pdf = nullptr;
-  }
+  // Clear the PDF document, its cached fonts and a mapped input file
+  release_document();
   
   // Clear all pages and their contents
   pages.clear();
   
-  // CRITICAL: Clear static font cache in text extractor to avoid stale font pointers
-  clear_static_font_cache();
-  
   std::cout << "PDF processor cleared and memory released" << std::endl;
 }
 
-void flx_pdf_sio::clear_static_font_cache() {
-  flx_pdf_text_extractor::clear_font_cache();
+void flx_pdf_sio::clear_font_cache() {
+  m_font_cache.reset();
+}
+
+flx_pdf_font_cache& flx_pdf_sio::font_cache() {
+  if (!m_font_cache) {
+    m_font_cache = std::make_unique<flx_pdf_font_cache>();
+  }
+  return *m_font_cache;
 }
 
@@ -4,9 +4,15 @@
 #include "../flx_doc_sio.h"
 #include "../layout/flx_layout_geometry.h"
 #include "flx_pdf_coords.h"
+#include "flx_pdf_rasterizer.h"
+#include "flx_pdf_regions.h"
+#include "flx_pdf_trace.h"
+#include "../../utils/flx_mapped_file.h"
+#include <functional>
 #include <vector>
 #include <memory>
 #include <stack>
+#include <string>
 #include <opencv2/opencv.hpp>
 
 namespace PoDoFo { 
@@ -16,61 +22,167 @@ namespace PoDoFo {
   class PdfPage;
 }
 namespace cv { class Mat; }
+class flx_pdf_font_cache;
+class flx_pdf_page_cache;
 
 class flx_pdf_sio : public flx_doc_sio
 {
+public:
+  // Page pipeline of parse(): pages run as task chains on a work-stealing pool
+  struct parse_options {
+    size_t threads = 0;              // 0 = hardware concurrency, 1 = sequential on the calling thread
+    size_t max_pages_in_flight = 0;  // pages started but not yet merged into pages; 0 = 2 * threads
+    // parse_file() reads the file into memory instead of mapping it; for
+    // files another process may truncate or rewrite during the parse
+    bool copy_input = false;
+  };
+
+  // What parse() extracts: only the selected pages run through the pipeline
+  // and only the requested stages run per page. The defaults read the texts
+  // of every page; the raster pass (render, color regions, contours) only
+  // runs for geometry or hierarchy.
+  struct extract_options {
+    struct page_range {
+      int first = 1;  // 1-based, inclusive
+      int last = 0;   // inclusive, 0 = last page of the document
+    };
+    std::vector<page_range> pages;  // empty = all pages; pages come out in document order
+    bool texts = true;
+    bool images = false;     // placements of image XObjects (bounds, pixel size, type)
+    bool geometry = false;   // regions of the rendered page without texts and images
+    bool hierarchy = false;  // nests the regions and moves texts and images into them (implies geometry)
+    int dpi = 150;           // raster resolution of the geometry pass
+    // Called with every finished page in order; returning false ends parse()
+    // after that page (pages started in the meantime are discarded)
+    std::function<bool(int page_number, flx_layout_geometry& page)> on_page;
+
+    // "1-3,7,10-" -> ranges; false on a malformed list
+    static bool parse_page_list(const std::string& list, std::vector<page_range>& ranges);
+  };
+
+  // Page content of serialize(): content streams are built in parallel, the
+  // font and identical images are single objects shared by all pages
+  struct serialize_options {
+    size_t threads = 0;  // 0 = hardware concurrency, 1 = sequential on the calling thread
+  };
+
+  // Time spent per pipeline stage during the last parse() (summed over workers)
+  struct stage_timing {
+    std::string name;
+    double total_ms = 0.0;
+    size_t count = 0;
+  };
+
 private:
   PoDoFo::PdfMemDocument *m_pdf;
+  // Input bytes of m_pdf: the documents load objects lazily from them, so
+  // they stay untouched until m_pdf is replaced (see input())
   flx_string pdf_data;
-  std::vector<char> pdf_data_buffer;  // Stable buffer for LoadFromBuffer (XObject compatibility!)
+  flx_mapped_file m_input_file;  // parse_file() input, pdf_data is empty then
+  parse_options m_parse_options;
+  extract_options m_extract_options;
+  serialize_options m_serialize_options;
+  std::vector<stage_timing> m_stage_timings;
+  flx_pdf_rasterizer::options m_render_options;
+  std::unique_ptr<flx_pdf_font_cache> m_font_cache;  // fonts of m_pdf, reset with it
+  flx_pdf_trace m_trace;
+  flx_pdf_page_cache* m_page_cache = nullptr;  // not owned
 
 public:
   flx_pdf_sio();
   ~flx_pdf_sio();
 
+  void set_parse_options(const parse_options& options) { m_parse_options = options; }
+  const parse_options& get_parse_options() const { return m_parse_options; }
+  const std::vector<stage_timing>& get_stage_timings() const { return m_stage_timings; }
+  void set_extract_options(const extract_options& options) { m_extract_options = options; }
+  const extract_options& get_extract_options() const { return m_extract_options; }
+  void set_serialize_options(const serialize_options& options) { m_serialize_options = options; }
+  const serialize_options& get_serialize_options() const { return m_serialize_options; }
+
+  // Spans, counters, artifacts and progress output of the pipeline (all off by default)
+  void set_trace_options(const flx_pdf_trace::options& options) { m_trace.configure(options); }
+  const flx_pdf_trace& get_trace() const { return m_trace; }
+  // JSON report of the last parse(), see flx_pdf_trace::to_json
+  flx_string get_trace_report() const { return m_trace.to_json(); }
+
+  // Rasterizer settings (backend, DPI, page range) for render() and the geometry pass
+  void set_render_options(const flx_pdf_rasterizer::options& options) { m_render_options = options; }
+  const flx_pdf_rasterizer::options& get_render_options() const { return m_render_options; }
+
+  // Pages whose fingerprint is in the cache are restored instead of parsed;
+  // parsed pages are added to it (nullptr = off, the cache must outlive parse())
+  void set_page_cache(flx_pdf_page_cache* cache) { m_page_cache = cache; }
+  flx_pdf_page_cache* get_page_cache() const { return m_page_cache; }
+
   // Core document operations
   bool parse(flx_string &data) override;
   bool serialize(flx_string &data) override;
+  // parse() of a file that is memory mapped instead of read: no copy of the
+  // input is made and only the objects the pipeline touches are loaded
+  bool parse_file(const flx_string& path);
 
-  // PDF rendering
+  // PDF rendering (render options with the given DPI)
   bool render(std::vector<cv::Mat>& output_images, int dpi = 300);
+  bool render(std::vector<cv::Mat>& output_images, const flx_pdf_rasterizer::options& options);
+  // Hands out pages one by one while later pages are still rendering
+  bool render(const flx_pdf_rasterizer::options& options, const flx_pdf_rasterizer::page_callback& on_page);
 
   // Text operations
   bool add_text(flx_string text, double x, double y);
 
   // Memory cleanup
   void clear();
-  void clear_static_font_cache();
+  void clear_font_cache();
 
 private:
+  flx_pdf_font_cache& font_cache();
+  std::string_view input() const;
+  void release_document();
+  bool parse_input();
+
+  // Page content of serialize()
+  struct serialize_resources;
+  struct page_content;
+  void collect_page_images(serialize_resources& shared, flx_layout_geometry& geometry, std::vector<int>& slots);
+  int load_shared_image(serialize_resources& shared, flx_layout_image& image_elem);
+  void write_page_content(serialize_resources& shared, flx_layout_geometry& geometry, page_content& content);
+  void write_polygon_shape(flx_layout_geometry& geometry, page_content& content);
+  void write_text_element(serialize_resources& shared, flx_layout_text& text_elem, page_content& content);
+  void write_image_element(flx_layout_image& image_elem, page_content& content);
+
   // Internal rendering methods
-  void render_geometry_to_page(PoDoFo::PdfPainter& painter, flx_layout_geometry& geometry);
   void render_geometry_only_to_page(PoDoFo::PdfPainter& painter, flx_layout_geometry& geometry);
   void render_polygon_shape(PoDoFo::PdfPainter& painter, flx_layout_geometry& geometry);
-  void render_text_element(PoDoFo::PdfPainter& painter, flx_layout_text& text_elem);
-  void render_image_element(PoDoFo::PdfPainter& painter, flx_layout_image& image_elem);
-  
-  // Image processing helpers
-  bool load_image_from_path(flx_layout_image& image_elem);
-  std::unique_ptr<PoDoFo::PdfImage> create_pdf_image_from_mat(flx_layout_image& image_elem);
   
   
   // Geometry-only PDF creation
   std::unique_ptr<PoDoFo::PdfMemDocument> create_geometry_only_pdf(flx_model_list<flx_layout_geometry>& geometry_pages);
   
-  // Debug helpers
-  void create_debug_directory(const std::string& dir_name);
-  
   // PDF parsing methods
+  struct page_job;
+  struct raster_feed;
+  std::vector<int> selected_pages(int page_count) const;
+  bool run_page_pipeline(int page_count);
+  bool create_geometry_source(const std::vector<int>& page_indexes, std::string& pdf_content);
+  void extract_page_images(const PoDoFo::PdfPage& page, flx_model_list<flx_layout_image>& images);
   std::unique_ptr<PoDoFo::PdfMemDocument> create_pdf_copy();
   bool extract_texts_and_images(flx_model_list<flx_layout_text>& texts, flx_model_list<flx_layout_image>& images);
   bool remove_texts_and_images_from_copy(PoDoFo::PdfMemDocument* pdf_copy);
   bool render_clean_pdf_to_images(PoDoFo::PdfMemDocument* pdf_copy, std::vector<cv::Mat>& clean_images);
-  std::vector<cv::Mat> detect_color_regions(const cv::Mat& page_image, const std::string& debug_dir = "");
-  std::vector<std::vector<cv::Point>> extract_contours_from_masks(const std::vector<cv::Mat>& masks, const cv::Mat& original_image = cv::Mat(), const std::string& debug_dir = "");
+  // page_index names the trace artifacts of the page (-1: no artifacts)
+  std::vector<flx_color_region> detect_color_regions(const cv::Mat& page_image, int page_index = -1);
+  // contour_regions (optional) receives the index of the region of every contour
+  std::vector<std::vector<cv::Point>> extract_contours_from_regions(const std::vector<flx_color_region>& regions, const cv::Mat& original_image = cv::Mat(), int page_index = -1,
+                                                                    std::vector<int>* contour_regions = nullptr);
   void build_geometry_hierarchy(const std::vector<std::vector<std::vector<cv::Point>>>& page_contours,
                               const std::vector<cv::Mat>& clean_images,
                               flx_model_list<flx_layout_geometry>& geometries);
+  // contour_colors: colour per contour if known, else sampled from page_image
+  void build_page_geometries(const std::vector<std::vector<cv::Point>>& contours,
+                             const cv::Mat& page_image,
+                             flx_model_list<flx_layout_geometry>& geometries,
+                             const std::vector<cv::Scalar>* contour_colors = nullptr);
   void assign_content_to_geometries(flx_model_list<flx_layout_text>& texts, 
                                   flx_model_list<flx_layout_image>& images,
                                   flx_model_list<flx_layout_geometry>& geometries);
@@ -86,50 +198,19 @@ private:
   bool extract_geometries_from_content_streams(flx_model_list<flx_layout_geometry>& all_geometries);
   bool parse_content_stream_for_geometries(const std::string& content, flx_model_list<flx_layout_geometry>& geometries);
   
-  // PDF Graphics State tracking
-  struct pdf_graphics_state {
-    double fill_color_r, fill_color_g, fill_color_b;
-    double stroke_color_r, stroke_color_g, stroke_color_b;
-    double current_x, current_y;  // Current point for path operations
-    std::vector<std::pair<double, double>> current_path;  // Simple x,y pairs for now
-    bool path_closed;
-    
-    pdf_graphics_state() : fill_color_r(0), fill_color_g(0), fill_color_b(0),
-                          stroke_color_r(0), stroke_color_g(0), stroke_color_b(0), 
-                          current_x(0), current_y(0), path_closed(false) {}
-  };
-  
-  // PDF operator parsing helpers
-  bool parse_move_to(const std::string& line, pdf_graphics_state& state);
-  bool parse_line_to(const std::string& line, pdf_graphics_state& state);
-  bool parse_curve_to(const std::string& line, pdf_graphics_state& state);
-  bool parse_close_path(pdf_graphics_state& state);
-  bool parse_rectangle(const std::string& line, pdf_graphics_state& state);
-  bool parse_fill_color(const std::string& line, pdf_graphics_state& state);
-  bool parse_stroke_color(const std::string& line, pdf_graphics_state& state);
-  bool parse_fill_path(pdf_graphics_state& state, flx_model_list<flx_layout_geometry>& geometries);
-  bool parse_stroke_path(pdf_graphics_state& state, flx_model_list<flx_layout_geometry>& geometries);
-  
-  // Flood-fill algorithm helpers
-  int flood_fill_neighbor_based(const cv::Mat& image, cv::Point seed, cv::Mat& region_mask, cv::Mat& processed, int tolerance);
-  bool is_color_similar(const cv::Vec3b& color1, const cv::Vec3b& color2, int tolerance);
-  
   // Geometry processing helpers
   cv::Scalar calculate_dominant_color_for_contour(const std::vector<cv::Point>& contour, 
                                                 const std::vector<cv::Mat>& clean_images, 
                                                 size_t contour_index);
   bool is_contour_line_shaped(const std::vector<cv::Point>& contour, double max_width = 5.0);
+  bool is_line_shaped(const cv::Rect& bounding_rect, double max_width = 5.0);
   
   // Line detection using Hough Transform
-  flx_model_list<flx_layout_geometry> detect_lines_hough(const cv::Mat& image, const std::string& debug_dir = "");
+  flx_model_list<flx_layout_geometry> detect_lines_hough(const cv::Mat& image, int page_index = -1);
   cv::Scalar calculate_dominant_color_for_contour_from_image(const std::vector<cv::Point>& contour, const cv::Mat& image);
   std::string rgb_to_hex_string(const cv::Scalar& color);
-  bool is_geometry_contained_in(const flx_layout_geometry& inner, const flx_layout_geometry& outer);
-  void assign_content_to_geometry_recursive(flx_layout_text& text, flx_model_list<flx_layout_geometry>& geometries);
-  void assign_content_to_geometry_recursive(flx_layout_image& image, flx_model_list<flx_layout_geometry>& geometries);
-  void assign_content_to_geometry_recursive_flx(flx_layout_text& text, flx_model_list<flx_layout_geometry>& geometries);
-  void assign_content_to_geometry_recursive_flx(flx_layout_image& image, flx_model_list<flx_layout_geometry>& geometries);
-  bool is_point_in_geometry(double x, double y, const flx_layout_geometry& geometry);
+  struct geometry_index;
+  flx_layout_geometry* find_content_target(geometry_index& index, flx_model_list<flx_layout_geometry>& geometries, double x, double y);
   void build_hierarchical_structure(flx_model_list<flx_layout_geometry>& geometries);
 };
 
@@ -67,6 +67,7 @@ struct flx_pdf_text_extractor::TextState
   Matrix T_lm;  // Current T_lm
   double T_l = 0;             // Leading text Tl
   PdfTextState PdfState;
+  const flx_pdf_font_cache::font_entry* Font = nullptr;  // cached entry of PdfState.Font
   Vector2 WordSpacingVectorRaw;
   Vector2 SpaceCharVectorRaw;
   double WordSpacingLength = 0;
@@ -167,8 +168,8 @@ public:
 struct flx_pdf_text_extractor::flx_extraction_context
 {
 public:
-  flx_extraction_context(flx_model_list<flx_layout_text> &texts, const PdfPage &page, const string_view &pattern,
-    PdfTextExtractFlags flags, const nullable<Rect> &clipRect);
+  flx_extraction_context(flx_model_list<flx_layout_text> &texts, const PdfPage &page, flx_pdf_font_cache &fonts,
+    const string_view &pattern, PdfTextExtractFlags flags, const nullable<Rect> &clipRect);
 public:
   void BT_Operator();
   void ET_Operator();
@@ -188,6 +189,8 @@ public:
 private:
   const PdfPage& m_page;
   flx_model_list<flx_layout_text>& m_texts;
+  flx_pdf_font_cache& m_fonts;
+  unordered_map<string, const flx_pdf_font_cache::font_entry*> m_pageFonts;  // resource name -> font, this page only
   double m_pageHeight;
 public:
   const int PageIndex;
@@ -206,7 +209,10 @@ struct flx_pdf_text_extractor::GlyphAddress
   unsigned GlyphIndex;
 };
 
-flx_pdf_text_extractor::flx_pdf_text_extractor() {
+flx_pdf_text_extractor::flx_pdf_text_extractor(flx_pdf_font_cache* fonts, flx_pdf_trace* trace)
+  : m_own_fonts(fonts == nullptr ? std::make_unique<flx_pdf_font_cache>() : nullptr),
+    m_fonts(fonts == nullptr ? m_own_fonts.get() : fonts),
+    m_trace(trace) {
 }
 
 flx_pdf_text_extractor::~flx_pdf_text_extractor() {
@@ -215,10 +221,11 @@ flx_pdf_text_extractor::~flx_pdf_text_extractor() {
 bool flx_pdf_text_extractor::extract_text_with_fonts(const PdfPage& page, 
   flx_model_list<flx_layout_text>& texts) {
   try {
-    std::cout << "Starting complete PDF text extraction with fonts..." << std::endl;
     extract_text_directly_to(texts, page);
 
-    std::cout << "Successfully extracted " << texts.size() << " text entries with font information" << std::endl;
+    if (m_trace != nullptr) {
+      FLX_PDF_TRACE_LOG(*m_trace, "Successfully extracted " << texts.size() << " text entries with font information");
+    }
     return true;
 
   } catch (const std::exception& e) {
@@ -235,14 +242,11 @@ void flx_pdf_text_extractor::extract_text_directly_to(flx_model_list<flx_layout_
 void flx_pdf_text_extractor::extract_text_directly_to(flx_model_list<flx_layout_text>& texts, const PdfPage& page, 
   const std::string_view& pattern) const
 {
-  flx_extraction_context context(texts, page, pattern, PdfTextExtractFlags::None, { });
+  flx_extraction_context context(texts, page, *m_fonts, pattern, PdfTextExtractFlags::None, { });
 
   PdfContentReaderArgs args;
   args.Flags = PdfContentReaderFlags::None;
 
-  // DEBUG: Log that XObject processing is enabled
-  std::cout << "[TEXT EXTRACTION] Using PdfContentReaderFlags::None (XObjects ENABLED)" << std::endl;
-
   PdfContentStreamReader reader(page, args);
   PdfContent content;
   vector<double> lengths;
@@ -441,14 +445,14 @@ double flx_pdf_text_extractor::TextState::GetSpaceCharLength() const
 
 void flx_pdf_text_extractor::TextState::ScanString(const PdfString& encodedStr, string& decoded, vector<double>& lengths, vector<unsigned>& positions)
 {
-  if (PdfState.Font == nullptr) {
+  if (Font == nullptr) {
     decoded = encodedStr.GetString();
     lengths.clear();
     positions.clear();
     return;
   }
 
-  PdfState.Font->TryScanEncodedString(encodedStr, PdfState, decoded, lengths, positions);
+  Font->decode(encodedStr, PdfState, decoded, lengths, positions);
 }
 
 void flx_pdf_text_extractor::TextState::ComputeDependentState()
@@ -509,10 +513,11 @@ double flx_pdf_text_extractor::StatefulString::GetLengthRaw() const
 }
 
 flx_pdf_text_extractor::flx_extraction_context::flx_extraction_context(
-  flx_model_list<flx_layout_text>& texts, const PdfPage& page, const string_view& pattern,
-  PdfTextExtractFlags flags, const nullable<Rect>& clipRect) :
+  flx_model_list<flx_layout_text>& texts, const PdfPage& page, flx_pdf_font_cache& fonts,
+  const string_view& pattern, PdfTextExtractFlags flags, const nullable<Rect>& clipRect) :
                                                                m_page(page),
                                                                m_texts(texts),
+                                                               m_fonts(fonts),
                                                                m_pageHeight(page.GetRect().Height),
                                                                PageIndex(page.GetPageNumber() - 1),
                                                                Pattern(pattern),
@@ -540,33 +545,25 @@ void flx_pdf_text_extractor::flx_extraction_context::ET_Operator()
   }
 }
 
-static std::unordered_map<std::string, const PdfFont*> g_font_cache;
-
-void flx_pdf_text_extractor::clear_font_cache() {
-  g_font_cache.clear();
-  std::cout << "Static font cache cleared" << std::endl;
-}
-
 void flx_pdf_text_extractor::flx_extraction_context::Tf_Operator(const PdfName& fontname, double fontsize)
 {
   States.Current->PdfState.FontSize = fontsize;
-  
-  const std::string font_key(fontname.GetString());
-  
-  auto cached_font = g_font_cache.find(font_key);
-  if (cached_font != g_font_cache.end()) {
-    States.Current->PdfState.Font = cached_font->second;
-    return;
-  }
-  
-  try {
-    auto resources = m_page.GetResources();
-    States.Current->PdfState.Font = resources.GetFont(fontname);
-    g_font_cache[font_key] = States.Current->PdfState.Font;
-  } catch (...) {
-    States.Current->PdfState.Font = nullptr;
-    g_font_cache[font_key] = nullptr;
+
+  // Resource names are only unique per page; the document cache behind them
+  // is keyed by the font object
+  auto cached_font = m_pageFonts.find(string(fontname.GetString()));
+  if (cached_font == m_pageFonts.end()) {
+    const flx_pdf_font_cache::font_entry* font = nullptr;
+    try {
+      font = m_fonts.get(m_page.GetResources(), fontname.GetString());
+    } catch (...) {
+      font = nullptr;
+    }
+    cached_font = m_pageFonts.emplace(string(fontname.GetString()), font).first;
   }
+
+  States.Current->Font = cached_font->second;
+  States.Current->PdfState.Font = cached_font->second != nullptr ? &cached_font->second->font() : nullptr;
 }
 
 void flx_pdf_text_extractor::flx_extraction_context::cm_Operator(double a, double b, double c, double d, double e, double f)
@@ -654,7 +651,7 @@ void flx_pdf_text_extractor::flx_extraction_context::add_text_entry_from_chunk_a
   double total_length = 0.0;
   Vector2 position(0, 0);
   double font_size = 12.0;
-  const PdfFont* font = nullptr;
+  const flx_pdf_font_cache::font_entry* font = nullptr;
 
   size_t estimated_size = 0;
   for (const auto& stateful_str : chunk) {
@@ -671,7 +668,7 @@ void flx_pdf_text_extractor::flx_extraction_context::add_text_entry_from_chunk_a
     {
       position = stateful_str.Position;
       font_size = stateful_str.State.PdfState.FontSize > 0 ? stateful_str.State.PdfState.FontSize : 12.0;
-      font = stateful_str.State.PdfState.Font;
+      font = stateful_str.State.Font;
       first_string = false;
     }
   }
@@ -679,16 +676,8 @@ void flx_pdf_text_extractor::flx_extraction_context::add_text_entry_from_chunk_a
   if (!combined_text.empty())
   {
     string font_name = "Arial";
-    if (font != nullptr) {
-      try {
-        font_name = font->GetName();
-        size_t plus_pos = font_name.find('+');
-        if (plus_pos != string::npos) {
-          font_name = font_name.substr(plus_pos + 1);
-        }
-      } catch (const std::exception& e) {
-        std::cout << "Warning: Failed to extract font name: " << e.what() << std::endl;
-      }
+    if (font != nullptr && !font->family().empty()) {
+      font_name = font->family();
     }
     
     auto& layout_text = m_texts[index];
@@ -2,6 +2,8 @@
 #define FLX_PDF_TEXT_EXTRACTOR_H
 
 #include "../layout/flx_layout_text.h"
+#include "flx_pdf_font_cache.h"
+#include "flx_pdf_trace.h"
 #include <vector>
 #include <memory>
 #include <string>
@@ -25,13 +27,14 @@ using namespace PoDoFo;
 
 class flx_pdf_text_extractor {
 public:
-    flx_pdf_text_extractor();
+    // fonts: cache of the document the pages belong to; without one the
+    // extractor keeps its own, so it must then only see pages of one document.
+    // trace (optional) receives the progress output
+    explicit flx_pdf_text_extractor(flx_pdf_font_cache* fonts = nullptr, flx_pdf_trace* trace = nullptr);
     ~flx_pdf_text_extractor();
 
     bool extract_text_with_fonts(const PdfPage& page, 
                                  flx_model_list<flx_layout_text>& texts);
-    
-    static void clear_font_cache();
                                  
 private:
     struct TextState;
@@ -72,7 +75,10 @@ private:
     static void getSubstringIndices(const std::vector<unsigned>& positions, unsigned lowerPos, unsigned upperLimitPos,
         unsigned& lowerIndex, unsigned& upperLimitIndex);
     static EntryOptions optionsFromFlags(PdfTextExtractFlags flags);
-    
+
+    std::unique_ptr<flx_pdf_font_cache> m_own_fonts;
+    flx_pdf_font_cache* m_fonts;
+    flx_pdf_trace* m_trace;
 };
 
 #endif // FLX_PDF_TEXT_EXTRACTOR_H
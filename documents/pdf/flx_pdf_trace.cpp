@@ -0,0 +1,121 @@
+#include "flx_pdf_trace.h"
+#include "../../api/json/flx_json.h"
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <filesystem>
+
+flx_pdf_trace::span::span(flx_pdf_trace& trace, const char* stage)
+  : m_trace(trace.spans_enabled() ? &trace : nullptr), m_stage(stage) {
+  if (m_trace != nullptr) {
+    m_start = std::chrono::steady_clock::now();
+  }
+}
+
+flx_pdf_trace::span::~span() {
+  if (m_trace != nullptr) {
+    m_trace->record_span(m_stage, std::chrono::steady_clock::now() - m_start);
+  }
+}
+
+flx_pdf_trace::flx_pdf_trace() {
+}
+
+flx_pdf_trace::flx_pdf_trace(const options& opts)
+  : m_options(opts) {
+}
+
+void flx_pdf_trace::configure(const options& opts) {
+  m_options = opts;
+}
+
+void flx_pdf_trace::record_span(const char* stage, std::chrono::steady_clock::duration elapsed) {
+  double ms = std::chrono::duration<double, std::milli>(elapsed).count();
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto found = std::find_if(m_stages.begin(), m_stages.end(),
+                            [stage](const stage_report& s) { return s.name == stage; });
+  if (found == m_stages.end()) {
+    m_stages.push_back({stage, 1, ms, ms, ms});
+    return;
+  }
+  found->count++;
+  found->total_ms += ms;
+  found->min_ms = std::min(found->min_ms, ms);
+  found->max_ms = std::max(found->max_ms, ms);
+}
+
+void flx_pdf_trace::count(const char* name, int64_t delta) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_counters[name] += delta;
+}
+
+void flx_pdf_trace::write_artifact(int page, const std::string& name, const cv::Mat& image) {
+  if (!artifacts_enabled() || image.empty()) {
+    return;
+  }
+
+  std::filesystem::path dir(m_options.artifact_dir);
+  if (page >= 0) {
+    dir /= "page_" + std::to_string(page + 1);
+  }
+  std::error_code error;
+  std::filesystem::create_directories(dir, error);
+  std::string path = (dir / name).string();
+  if (error || !cv::imwrite(path, image)) {
+    count("artifacts.failed");
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_artifacts.push_back(path);
+}
+
+std::vector<flx_pdf_trace::stage_report> flx_pdf_trace::stages() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_stages;
+}
+
+std::map<std::string, int64_t> flx_pdf_trace::counters() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_counters;
+}
+
+std::vector<std::string> flx_pdf_trace::artifacts() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_artifacts;
+}
+
+flx_string flx_pdf_trace::to_json() const {
+  flxv_map report;
+  flxv_vector stage_list;
+  flxv_map counter_map;
+  flxv_vector artifact_list;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (const auto& stage : m_stages) {
+      flxv_map entry;
+      entry["name"] = flx_string(stage.name.c_str());
+      entry["count"] = static_cast<long long>(stage.count);
+      entry["total_ms"] = stage.total_ms;
+      entry["min_ms"] = stage.min_ms;
+      entry["max_ms"] = stage.max_ms;
+      stage_list.push_back(entry);
+    }
+    for (const auto& counter : m_counters) {
+      counter_map[flx_string(counter.first.c_str())] = static_cast<long long>(counter.second);
+    }
+    for (const auto& path : m_artifacts) {
+      artifact_list.push_back(flx_string(path.c_str()));
+    }
+  }
+  report["stages"] = stage_list;
+  report["counters"] = counter_map;
+  report["artifacts"] = artifact_list;
+  return flx_json(&report).create();
+}
+
+void flx_pdf_trace::reset() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_stages.clear();
+  m_counters.clear();
+  m_artifacts.clear();
+}
@@ -0,0 +1,123 @@
+#ifndef FLX_PDF_TRACE_H
+#define FLX_PDF_TRACE_H
+
+#include "../../utils/flx_string.h"
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace cv { class Mat; }
+
+/*
+ * Tracing for the PDF pipeline: per-stage spans, counters, optional image
+ * artifacts and progress log lines, all off unless configured at runtime.
+ *
+ * Without FLX_ENABLE_PDF_TRACE (CMake option FLUCTURE_PDF_TRACE) the
+ * FLX_PDF_TRACE_* macros expand to nothing and blocks guarded by
+ * FLX_PDF_TRACE_ARTIFACTS() or FLX_PDF_TRACE_LOGGING() are dead code.
+ * With it, a disabled trace costs one branch per macro.
+ *
+ * Spans and counters may be recorded from several threads.
+ */
+class flx_pdf_trace
+{
+public:
+  enum class level {
+    off,        // nothing is recorded
+    spans,      // stage timings and counters
+    artifacts   // spans plus debug images in artifact_dir/page_N/
+  };
+
+  struct options {
+    level detail = level::off;
+    bool log = false;                    // progress lines to std::cout
+    std::string artifact_dir = "pdf_trace";
+  };
+
+  // Summed timings of one stage
+  struct stage_report {
+    std::string name;
+    size_t count = 0;
+    double total_ms = 0.0;
+    double min_ms = 0.0;
+    double max_ms = 0.0;
+  };
+
+  // RAII span: times its scope as one run of the stage
+  class span
+  {
+  public:
+    span(flx_pdf_trace& trace, const char* stage);
+    ~span();
+
+    span(const span&) = delete;
+    span& operator=(const span&) = delete;
+
+  private:
+    flx_pdf_trace* m_trace;  // nullptr while spans are disabled
+    const char* m_stage;
+    std::chrono::steady_clock::time_point m_start;
+  };
+
+  flx_pdf_trace();
+  explicit flx_pdf_trace(const options& opts);
+
+  void configure(const options& opts);
+  const options& get_options() const { return m_options; }
+
+  bool spans_enabled() const { return m_options.detail != level::off; }
+  bool artifacts_enabled() const { return m_options.detail == level::artifacts; }
+  bool log_enabled() const { return m_options.log; }
+
+  void record_span(const char* stage, std::chrono::steady_clock::duration elapsed);
+  void count(const char* name, int64_t delta = 1);
+  // Writes artifact_dir/page_<page + 1>/<name> (artifact_dir/<name> for page < 0)
+  void write_artifact(int page, const std::string& name, const cv::Mat& image);
+
+  std::vector<stage_report> stages() const;  // in order of first appearance
+  std::map<std::string, int64_t> counters() const;
+  std::vector<std::string> artifacts() const;
+
+  /*
+   * Machine-readable report:
+   * {"stages": [{"name", "count", "total_ms", "min_ms", "max_ms"}...],
+   *  "counters": {"name": value...}, "artifacts": ["path"...]}
+   */
+  flx_string to_json() const;
+
+  // Drops recorded data, keeps the options
+  void reset();
+
+private:
+  options m_options;
+  mutable std::mutex m_mutex;
+  std::vector<stage_report> m_stages;
+  std::map<std::string, int64_t> m_counters;
+  std::vector<std::string> m_artifacts;
+};
+
+#define FLX_PDF_TRACE_CONCAT_(a, b) a##b
+#define FLX_PDF_TRACE_CONCAT(a, b) FLX_PDF_TRACE_CONCAT_(a, b)
+
+#ifdef FLX_ENABLE_PDF_TRACE
+#define FLX_PDF_TRACE_SPAN(trace, stage) \
+  flx_pdf_trace::span FLX_PDF_TRACE_CONCAT(flx_pdf_trace_span_, __LINE__)((trace), (stage))
+#define FLX_PDF_TRACE_COUNT(trace, name, delta) \
+  do { if ((trace).spans_enabled()) (trace).count((name), (delta)); } while (0)
+#define FLX_PDF_TRACE_LOG(trace, message) \
+  do { if ((trace).log_enabled()) std::cout << message << std::endl; } while (0)
+#define FLX_PDF_TRACE_ARTIFACTS(trace) ((trace).artifacts_enabled())
+#define FLX_PDF_TRACE_LOGGING(trace) ((trace).log_enabled())
+#else
+#define FLX_PDF_TRACE_SPAN(trace, stage) do { } while (0)
+#define FLX_PDF_TRACE_COUNT(trace, name, delta) do { } while (0)
+#define FLX_PDF_TRACE_LOG(trace, message) do { } while (0)
+#define FLX_PDF_TRACE_ARTIFACTS(trace) false
+#define FLX_PDF_TRACE_LOGGING(trace) false
+#endif
+
+#endif // FLX_PDF_TRACE_H
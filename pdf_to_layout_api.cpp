@@ -1,52 +1,33 @@
 #include "documents/pdf/flx_pdf_sio.h"
+#include "documents/pdf/flx_pdf_page_cache.h"
 #include "documents/layout/flx_layout_geometry.h"
 #include "api/json/flx_json.h"
+#include "utils/flx_thread_pool.h"
+#include "utils/flx_atomic_file.h"
 #include <iostream>
 #include <fstream>
 #include <cstdlib>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <deque>
 #include <filesystem>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
 #include <unistd.h>
 
-// Simple API function to convert PDF file to Layout structure
-bool pdf_file_to_layout(const std::string& pdf_path, flx_model_list<flx_layout_geometry>& pages) {
+// Simple API function to convert PDF file to Layout structure; options
+// select pages and stages (default: the texts of every page)
+bool pdf_file_to_layout(const std::string& pdf_path, flx_model_list<flx_layout_geometry>& pages,
+                        const flx_pdf_sio::extract_options& options = flx_pdf_sio::extract_options()) {
     try {
-        // Read PDF file
-        std::ifstream pdf_file(pdf_path, std::ios::binary);
-        if (!pdf_file) {
-            std::cerr << "Error: Cannot open PDF file: " << pdf_path << std::endl;
-            return false;
-        }
-        
-        // Read file content
-        pdf_file.seekg(0, std::ios::end);
-        size_t file_size = pdf_file.tellg();
-        pdf_file.seekg(0, std::ios::beg);
-        
-        std::string pdf_data_str;
-        pdf_data_str.resize(file_size);
-        pdf_file.read(&pdf_data_str[0], file_size);
-        
-        // IMPORTANT: Use the binary constructor, not c_str() which stops at NULL bytes!
-        flx_string pdf_data(pdf_data_str.data(), pdf_data_str.size());
-        pdf_file.close();
-        
-        std::cout << "📄 Loaded PDF: " << pdf_path << " (" << file_size << " bytes)" << std::endl;
-        std::cout << "🔍 PDF string size: " << pdf_data.size() << " bytes" << std::endl;
-        std::cout << "🔍 First 20 bytes: ";
-        for (int i = 0; i < std::min(20, (int)pdf_data.size()); i++) {
-            printf("%02X ", (unsigned char)pdf_data.c_str()[i]);
-        }
-        std::cout << std::endl;
-        std::cout << "🔍 Last 20 bytes: ";
-        size_t start = std::max(0, (int)pdf_data.size() - 20);
-        for (size_t i = start; i < pdf_data.size(); i++) {
-            printf("%02X ", (unsigned char)pdf_data.c_str()[i]);
-        }
-        std::cout << std::endl;
-        
-        // Parse PDF to Layout
+        // Parse PDF to Layout (the file is memory mapped, not read into memory)
         flx_pdf_sio parser;
-        bool success = parser.parse(pdf_data);
+        parser.set_extract_options(options);
+        bool success = parser.parse_file(pdf_path);
         
         if (!success) {
             std::cerr << "❌ Failed to parse PDF with our current implementation" << std::endl;
@@ -95,46 +76,509 @@ std::string pdf_sio_to_json(flx_pdf_sio& parser) {
     }
 }
 
+void print_usage(const char* program) {
+    std::cout << "Usage: " << program << " [options] <pdf_file> [output_context.txt]" << std::endl;
+    std::cout << "Converts PDF to layout structure for AI context." << std::endl;
+    std::cout << std::endl;
+    std::cout << "Options:" << std::endl;
+    std::cout << "  --pages LIST   Only these pages, e.g. 1-3,7,10- (default: all)" << std::endl;
+    std::cout << "  --no-text      Skip text extraction" << std::endl;
+    std::cout << "  --images       Extract image placements" << std::endl;
+    std::cout << "  --geometry     Detect regions on the rendered pages" << std::endl;
+    std::cout << "  --hierarchy    Nest regions and assign texts/images to them (implies --geometry)" << std::endl;
+    std::cout << "  --dpi N        Raster resolution of the geometry pass (default: 150)" << std::endl;
+    std::cout << "  --threads N    Pages processed in parallel (default: all cores)" << std::endl;
+    std::cout << "  --until TEXT   Stop after the first page whose text contains TEXT" << std::endl;
+    std::cout << "  --cache DIR    Reuse the layout of unchanged pages stored in DIR" << std::endl;
+    std::cout << "  --cache-entries N  Pages of --cache also kept in memory (default: 1000, 0 = all)" << std::endl;
+    std::cout << std::endl;
+    std::cout << "Batch mode: " << program << " [options] --batch MANIFEST | --watch DIR" << std::endl;
+    std::cout << "Writes <input>.layout.json next to every PDF and prints a summary." << std::endl;
+    std::cout << "  --batch FILE   Convert the PDFs listed in FILE, one path per line ('-' = stdin)" << std::endl;
+    std::cout << "  --watch DIR    Convert new and changed PDFs in DIR until SIGINT/SIGTERM" << std::endl;
+    std::cout << "  --poll N       Seconds between two scans of the watched directory (default: 2)" << std::endl;
+    std::cout << "  --jobs N       Documents converted at the same time (default: all cores)" << std::endl;
+    std::cout << "  --summary FILE Also write the summary as JSON" << std::endl;
+    std::cout << "In batch mode --threads defaults to 1, so at most --jobs documents are in memory." << std::endl;
+}
+
+// Page text contains needle (texts in sub-geometries included)
+bool page_contains_text(flx_layout_geometry& page, const std::string& needle) {
+    for (size_t i = 0; i < page.texts.size(); i++) {
+        if (std::string(page.texts[i].text->c_str()).find(needle) != std::string::npos) {
+            return true;
+        }
+    }
+    for (size_t i = 0; i < page.sub_geometries.size(); i++) {
+        if (page_contains_text(page.sub_geometries[i], needle)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Batch mode: one process converts many documents, so PoDoFo, the font
+// tables and OpenCV are set up once instead of per file
+
+namespace {
+
+    volatile std::sig_atomic_t stop_requested = 0;
+
+    void request_stop(int) {
+        stop_requested = 1;
+    }
+
+}
+
+struct batch_settings {
+    flx_pdf_sio::extract_options extract;
+    flx_pdf_sio::parse_options parse;
+    flx_pdf_page_cache* cache = nullptr;  // shared by all documents, may be null
+};
+
+// Outcome of one document
+struct batch_result {
+    std::string path;
+    std::string output;
+    bool ok = false;
+    std::string error;
+    size_t pages = 0;
+    double milliseconds = 0.0;
+};
+
+// <input>.layout.json next to the input
+std::string batch_output_path(const std::string& pdf_path) {
+    return pdf_path + ".layout.json";
+}
+
+batch_result convert_document(const std::string& pdf_path, const batch_settings& settings) {
+    batch_result result;
+    result.path = pdf_path;
+    result.output = batch_output_path(pdf_path);
+    auto start = std::chrono::steady_clock::now();
+
+    try {
+        flx_pdf_sio parser;
+        parser.set_extract_options(settings.extract);
+        parser.set_parse_options(settings.parse);
+        parser.set_page_cache(settings.cache);
+        if (!parser.parse_file(pdf_path)) {
+            result.error = "Failed to parse PDF";
+        } else {
+            result.pages = parser.pages.size();
+            result.ok = flx_write_file_atomic(result.output, pdf_sio_to_json(parser), &result.error);
+        }
+    } catch (const std::exception& e) {
+        result.error = e.what();
+    }
+
+    result.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+/*
+ * Totals of a run. With keep_all every result is kept for the summary (a
+ * manifest bounds their number); otherwise only counters and the last
+ * max_failures failures, so a watching daemon does not grow with the
+ * documents it has converted.
+ */
+struct batch_summary {
+    static constexpr size_t max_failures = 100;
+
+    bool keep_all = true;
+    size_t documents = 0;
+    size_t failed = 0;
+    size_t pages = 0;
+    double document_ms = 0.0;
+    double slowest_ms = 0.0;
+    std::vector<batch_result> results;  // every document, keep_all only
+    std::deque<batch_result> failures;  // oldest dropped beyond max_failures unless keep_all
+    size_t failures_dropped = 0;
+
+    void add(batch_result result) {
+        ++documents;
+        pages += result.pages;
+        document_ms += result.milliseconds;
+        slowest_ms = std::max(slowest_ms, result.milliseconds);
+        if (!result.ok) {
+            ++failed;
+            failures.push_back(result);
+            if (!keep_all && failures.size() > max_failures) {
+                failures.pop_front();
+                ++failures_dropped;
+            }
+        }
+        if (keep_all) {
+            results.push_back(std::move(result));
+        }
+    }
+};
+
+/*
+ * Converts documents on a pool of `jobs` workers. submit() blocks while
+ * `jobs` documents are already queued or running, so memory stays bounded
+ * by the documents being converted, not by the length of the manifest.
+ */
+class batch_runner
+{
+public:
+    batch_runner(const batch_settings& settings, size_t jobs, bool keep_results)
+        : m_settings(settings), m_jobs(jobs), m_pool(jobs) {
+        m_summary.keep_all = keep_results;
+    }
+
+    void submit(const std::string& pdf_path) {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_slot_free.wait(lock, [this] { return m_in_flight < m_jobs; });
+            ++m_in_flight;
+        }
+        m_pool.submit([this, pdf_path] {
+            batch_result result = convert_document(pdf_path, m_settings);
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (result.ok) {
+                std::cout << "[batch] ok " << result.milliseconds << " ms, " << result.pages << " page(s): " << result.path << std::endl;
+            } else {
+                std::cerr << "[batch] FAILED after " << result.milliseconds << " ms: " << result.path << ": " << result.error << std::endl;
+            }
+            m_summary.add(std::move(result));
+            --m_in_flight;
+            m_slot_free.notify_one();
+        });
+    }
+
+    // Blocks until every submitted document is done
+    void wait() {
+        m_pool.wait_idle();
+    }
+
+    // Results in completion order; call after wait()
+    const batch_summary& summary() const { return m_summary; }
+
+private:
+    batch_settings m_settings;
+    size_t m_jobs;
+    flx_thread_pool m_pool;
+    std::mutex m_mutex;
+    std::condition_variable m_slot_free;
+    size_t m_in_flight = 0;  // guarded by m_mutex
+    batch_summary m_summary;  // guarded by m_mutex
+};
+
+// Paths of a manifest, one per line; blank lines and lines starting with '#'
+// are skipped, relative paths are relative to the manifest
+bool read_manifest(const std::string& manifest_path, std::vector<std::string>& paths) {
+    std::ifstream file;
+    std::filesystem::path base;
+    if (manifest_path != "-") {
+        file.open(manifest_path);
+        if (!file) {
+            return false;
+        }
+        base = std::filesystem::path(manifest_path).parent_path();
+    }
+    std::istream& in = manifest_path == "-" ? std::cin : file;
+
+    std::string line;
+    while (std::getline(in, line)) {
+        line.erase(line.find_last_not_of(" \t\r") + 1);
+        line.erase(0, line.find_first_not_of(" \t"));
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        std::filesystem::path path(line);
+        paths.push_back(path.is_relative() && !base.empty() ? (base / path).string() : line);
+    }
+    return true;
+}
+
+bool is_pdf_file(const std::filesystem::directory_entry& entry) {
+    if (!entry.is_regular_file()) {
+        return false;
+    }
+    std::string extension = entry.path().extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+    return extension == ".pdf";
+}
+
+// Converts the PDFs in directory whose layout is missing or older than the
+// PDF, scanning every poll_seconds until a stop signal arrives. Files changed
+// within the last poll interval are left for the next scan, they may still
+// be being written.
+void watch_directory(const std::string& directory, int poll_seconds, batch_runner& runner) {
+    using file_clock = std::filesystem::file_time_type::clock;
+    // Files of the last scan: removed files drop out on the next one
+    std::map<std::string, std::filesystem::file_time_type> submitted;
+
+    while (!stop_requested) {
+        std::error_code ec;
+        std::map<std::string, std::filesystem::file_time_type> seen;
+        auto settle_time = file_clock::now() - std::chrono::seconds(poll_seconds);
+        for (std::filesystem::directory_iterator it(directory, ec), end; !ec && it != end && !stop_requested; it.increment(ec)) {
+            if (!is_pdf_file(*it)) {
+                continue;
+            }
+            std::string path = it->path().string();
+            std::error_code time_error;
+            auto modified = std::filesystem::last_write_time(it->path(), time_error);
+            if (time_error || modified > settle_time) {
+                continue;
+            }
+            seen[path] = modified;
+            auto known = submitted.find(path);
+            if (known != submitted.end() && known->second == modified) {
+                continue;
+            }
+            auto output_time = std::filesystem::last_write_time(batch_output_path(path), time_error);
+            if (!time_error && output_time >= modified) {
+                continue;
+            }
+            runner.submit(path);
+        }
+        submitted.swap(seen);
+        if (ec) {
+            std::cerr << "[batch] Cannot scan " << directory << ": " << ec.message() << std::endl;
+        }
+        for (int slice = 0; slice < poll_seconds * 10 && !stop_requested; slice++) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+    }
+}
+
+// Prints the summary and optionally writes it as JSON; false if a document failed
+bool report_batch(const batch_summary& totals, double seconds, const std::string& summary_path) {
+    auto to_json = [](const batch_result& result) {
+        flxv_map entry;
+        entry["path"] = flx_string(result.path.c_str());
+        entry["ok"] = result.ok;
+        entry["pages"] = static_cast<long long>(result.pages);
+        entry["milliseconds"] = result.milliseconds;
+        if (result.ok) {
+            entry["output"] = flx_string(result.output.c_str());
+        } else {
+            entry["error"] = flx_string(result.error.c_str());
+        }
+        return flx_variant(entry);
+    };
+
+    std::cout << "📊 Batch summary" << std::endl;
+    std::cout << "   Documents: " << totals.documents << " (" << (totals.documents - totals.failed) << " ok, " << totals.failed << " failed)" << std::endl;
+    std::cout << "   Pages:     " << totals.pages << std::endl;
+    std::cout << "   Wall time: " << seconds << " s";
+    if (seconds > 0.0) {
+        std::cout << " (" << (totals.documents / seconds) << " documents/s)";
+    }
+    std::cout << std::endl;
+    if (totals.documents > 0) {
+        std::cout << "   Per document: " << (totals.document_ms / totals.documents) << " ms average, " << totals.slowest_ms << " ms slowest" << std::endl;
+    }
+    if (totals.failures_dropped > 0) {
+        std::cout << "   (" << totals.failures_dropped << " earlier failures not listed)" << std::endl;
+    }
+    for (const auto& result : totals.failures) {
+        std::cout << "   ❌ " << result.path << ": " << result.error << std::endl;
+    }
+
+    if (!summary_path.empty()) {
+        flxv_map summary;
+        if (totals.keep_all) {
+            flxv_vector documents;
+            for (const auto& result : totals.results) {
+                documents.push_back(to_json(result));
+            }
+            summary["documents"] = documents;
+        } else {
+            flxv_vector failures;
+            for (const auto& result : totals.failures) {
+                failures.push_back(to_json(result));
+            }
+            summary["failures"] = failures;
+            summary["failures_dropped"] = static_cast<long long>(totals.failures_dropped);
+        }
+        summary["ok"] = static_cast<long long>(totals.documents - totals.failed);
+        summary["failed"] = static_cast<long long>(totals.failed);
+        summary["pages"] = static_cast<long long>(totals.pages);
+        summary["seconds"] = seconds;
+        std::string error;
+        if (!flx_write_file_atomic(summary_path, flx_json(&summary).create().to_std_const(), &error)) {
+            std::cerr << "Error: " << error << std::endl;
+            return false;
+        }
+        std::cout << "📝 Summary written to: " << summary_path << std::endl;
+    }
+    return totals.failed == 0;
+}
+
+int run_batch(const batch_settings& settings, size_t jobs, const std::string& manifest_path,
+              const std::string& watch_dir, int poll_seconds, const std::string& summary_path) {
+    std::vector<std::string> paths;
+    if (!manifest_path.empty() && !read_manifest(manifest_path, paths)) {
+        std::cerr << "Error: Cannot read manifest: " << manifest_path << std::endl;
+        return 1;
+    }
+    if (!watch_dir.empty() && !std::filesystem::is_directory(watch_dir)) {
+        std::cerr << "Error: Not a directory: " << watch_dir << std::endl;
+        return 1;
+    }
+
+    std::signal(SIGINT, request_stop);
+    std::signal(SIGTERM, request_stop);
+
+    auto start = std::chrono::steady_clock::now();
+    // A manifest bounds the number of results, a watched directory does not
+    batch_runner runner(settings, jobs, watch_dir.empty());
+    std::cout << "🚀 Batch conversion with " << jobs << " job(s)" << std::endl;
+    for (const auto& path : paths) {
+        if (stop_requested) {
+            break;
+        }
+        runner.submit(path);
+    }
+    if (!watch_dir.empty()) {
+        std::cout << "👀 Watching " << watch_dir << " (Ctrl+C to stop)" << std::endl;
+        watch_directory(watch_dir, poll_seconds, runner);
+    }
+    runner.wait();
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return report_batch(runner.summary(), seconds, summary_path) ? 0 : 1;
+}
+
 // Main function for command-line usage
 int main(int argc, char* argv[]) {
-    if (argc < 2) {
-        std::cout << "Usage: " << argv[0] << " <pdf_file> [output_context.txt]" << std::endl;
-        std::cout << "Converts PDF to layout structure for AI context." << std::endl;
+    flx_pdf_sio::extract_options extract;
+    flx_pdf_sio::parse_options parse_options;
+    std::string until_text;
+    std::string cache_dir;
+    size_t cache_entries = 1000;
+    std::string manifest_path;
+    std::string watch_dir;
+    std::string summary_path;
+    int poll_seconds = 2;
+    size_t jobs = 0;
+    bool page_threads_set = false;
+    std::vector<std::string> positional;
+    
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--pages" && has_value) {
+            if (!flx_pdf_sio::extract_options::parse_page_list(argv[++i], extract.pages)) {
+                std::cerr << "Error: Invalid page list: " << argv[i] << std::endl;
+                return 1;
+            }
+        } else if (arg == "--no-text") {
+            extract.texts = false;
+        } else if (arg == "--images") {
+            extract.images = true;
+        } else if (arg == "--geometry") {
+            extract.geometry = true;
+        } else if (arg == "--hierarchy") {
+            extract.hierarchy = true;
+        } else if (arg == "--dpi" && has_value) {
+            extract.dpi = std::atoi(argv[++i]);
+            if (extract.dpi <= 0) {
+                std::cerr << "Error: Invalid DPI: " << argv[i] << std::endl;
+                return 1;
+            }
+        } else if (arg == "--threads" && has_value) {
+            parse_options.threads = static_cast<size_t>(std::max(0, std::atoi(argv[++i])));
+            page_threads_set = true;
+        } else if (arg == "--until" && has_value) {
+            until_text = argv[++i];
+        } else if (arg == "--cache" && has_value) {
+            cache_dir = argv[++i];
+        } else if (arg == "--cache-entries" && has_value) {
+            cache_entries = static_cast<size_t>(std::max(0, std::atoi(argv[++i])));
+        } else if (arg == "--batch" && has_value) {
+            manifest_path = argv[++i];
+        } else if (arg == "--watch" && has_value) {
+            watch_dir = argv[++i];
+        } else if (arg == "--poll" && has_value) {
+            poll_seconds = std::atoi(argv[++i]);
+            if (poll_seconds <= 0) {
+                std::cerr << "Error: Invalid poll interval: " << argv[i] << std::endl;
+                return 1;
+            }
+        } else if (arg == "--jobs" && has_value) {
+            jobs = static_cast<size_t>(std::max(0, std::atoi(argv[++i])));
+        } else if (arg == "--summary" && has_value) {
+            summary_path = argv[++i];
+        } else if (arg == "--help" || arg == "-h") {
+            print_usage(argv[0]);
+            return 0;
+        } else if (arg.rfind("--", 0) == 0) {
+            std::cerr << "Error: Unknown or incomplete option: " << arg << std::endl;
+            print_usage(argv[0]);
+            return 1;
+        } else {
+            positional.push_back(arg);
+        }
+    }
+    
+    bool batch = !manifest_path.empty() || !watch_dir.empty();
+    if (batch ? !positional.empty() : (positional.empty() || positional.size() > 2)) {
+        print_usage(argv[0]);
         return 1;
     }
     
-    std::string pdf_path = argv[1];
-    std::string output_path = (argc >= 3) ? argv[2] : "";
+    if (!until_text.empty()) {
+        extract.on_page = [until_text](int page_number, flx_layout_geometry& page) {
+            if (page_contains_text(page, until_text)) {
+                std::cout << "🔎 Found \"" << until_text << "\" on page " << page_number << std::endl;
+                return false;
+            }
+            return true;
+        };
+    }
+    
+    std::unique_ptr<flx_pdf_page_cache> page_cache;
+    if (!cache_dir.empty()) {
+        page_cache = std::make_unique<flx_pdf_page_cache>(cache_dir, cache_entries);
+    }
+    
+    if (batch) {
+        batch_settings settings;
+        settings.extract = extract;
+        settings.parse = parse_options;
+        settings.cache = page_cache.get();
+        // Parallel documents instead of parallel pages: one page pipeline
+        // per document keeps memory proportional to --jobs
+        if (!page_threads_set) {
+            settings.parse.threads = 1;
+        }
+        // Inputs are read, not mapped: a file truncated during its parse
+        // would otherwise end the whole run with SIGBUS
+        settings.parse.copy_input = true;
+        if (jobs == 0) {
+            jobs = std::max(1u, std::thread::hardware_concurrency());
+        }
+        return run_batch(settings, jobs, manifest_path, watch_dir, poll_seconds, summary_path);
+    }
+    
+    std::string pdf_path = positional[0];
+    std::string output_path = positional.size() == 2 ? positional[1] : "";
     
     std::cout << "🚀 Flucture PDF → Layout Converter" << std::endl;
     std::cout << "===================================" << std::endl;
     
     // Parse PDF directly with our parser (no intermediate step needed)
     flx_pdf_sio parser;
+    parser.set_extract_options(extract);
+    parser.set_parse_options(parse_options);
+    parser.set_page_cache(page_cache.get());
     
-    // Read PDF file
-    std::ifstream pdf_file(pdf_path, std::ios::binary);
-    if (!pdf_file) {
+    // Parse PDF to Layout; the file is memory mapped, so even large scans
+    // are never copied into memory as a whole
+    std::error_code size_error;
+    auto file_size = std::filesystem::file_size(pdf_path, size_error);
+    if (size_error) {
         std::cerr << "Error: Cannot open PDF file: " << pdf_path << std::endl;
         return 1;
     }
+    std::cout << "📄 Loading PDF: " << pdf_path << " (" << file_size << " bytes)" << std::endl;
     
-    // Read file content
-    pdf_file.seekg(0, std::ios::end);
-    size_t file_size = pdf_file.tellg();
-    pdf_file.seekg(0, std::ios::beg);
-    
-    std::string pdf_data_str;
-    pdf_data_str.resize(file_size);
-    pdf_file.read(&pdf_data_str[0], file_size);
-    
-    flx_string pdf_data(pdf_data_str.data(), pdf_data_str.size());
-    pdf_file.close();
-    
-    std::cout << "📄 Loaded PDF: " << pdf_path << " (" << file_size << " bytes)" << std::endl;
-    
-    // Parse PDF to Layout
-    bool success = parser.parse(pdf_data);
+    bool success = parser.parse_file(pdf_path);
     if (!success) {
         std::cerr << "❌ Failed to parse PDF" << std::endl;
         return 1;
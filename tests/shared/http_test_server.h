@@ -0,0 +1,92 @@
+#ifndef HTTP_TEST_SERVER_H
+#define HTTP_TEST_SERVER_H
+
+#include "../../api/server/flx_httpdaemon.h"
+#include <functional>
+#include <openssl/evp.h>
+#include <openssl/pem.h>
+#include <openssl/rsa.h>
+#include <openssl/x509.h>
+
+// ============================================================================
+// LOCAL HTTP(S) STAND-IN SERVER - flx_http_daemon with a scripted handler
+// ============================================================================
+
+class http_test_server : public flx_http_daemon {
+public:
+  using handler_fn = std::function<response(const request&)>;
+
+  explicit http_test_server(handler_fn h) : handler(std::move(h)) {}
+
+  response handle(request req) override {
+    return handler(req);
+  }
+
+private:
+  handler_fn handler;
+};
+
+static inline flx_string read_bio(BIO* bio) {
+  char* data = nullptr;
+  long len = BIO_get_mem_data(bio, &data);
+  return flx_string(data, static_cast<size_t>(len));
+}
+
+// Self-signed localhost certificate for HTTPS stand-in servers
+static inline bool make_self_signed_certificate(flx_string& key_pem, flx_string& cert_pem) {
+  EVP_PKEY* pkey = nullptr;
+  EVP_PKEY_CTX* ctx = EVP_PKEY_CTX_new_id(EVP_PKEY_RSA, nullptr);
+  if (!ctx || EVP_PKEY_keygen_init(ctx) <= 0 ||
+      EVP_PKEY_CTX_set_rsa_keygen_bits(ctx, 2048) <= 0 ||
+      EVP_PKEY_keygen(ctx, &pkey) <= 0) {
+    EVP_PKEY_CTX_free(ctx);
+    return false;
+  }
+  EVP_PKEY_CTX_free(ctx);
+
+  X509* cert = X509_new();
+  ASN1_INTEGER_set(X509_get_serialNumber(cert), 1);
+  X509_gmtime_adj(X509_getm_notBefore(cert), 0);
+  X509_gmtime_adj(X509_getm_notAfter(cert), 3600);
+  X509_set_pubkey(cert, pkey);
+  X509_NAME* name = X509_get_subject_name(cert);
+  X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC,
+                             reinterpret_cast<const unsigned char*>("localhost"), -1, -1, 0);
+  X509_set_issuer_name(cert, name);
+  bool ok = X509_sign(cert, pkey, EVP_sha256()) > 0;
+
+  BIO* key_bio = BIO_new(BIO_s_mem());
+  BIO* cert_bio = BIO_new(BIO_s_mem());
+  ok = ok && PEM_write_bio_PrivateKey(key_bio, pkey, nullptr, nullptr, 0, nullptr, nullptr) > 0;
+  ok = ok && PEM_write_bio_X509(cert_bio, cert) > 0;
+  if (ok) {
+    key_pem = read_bio(key_bio);
+    cert_pem = read_bio(cert_bio);
+  }
+
+  BIO_free(key_bio);
+  BIO_free(cert_bio);
+  X509_free(cert);
+  EVP_PKEY_free(pkey);
+  return ok;
+}
+
+// Starts the server with TLS when libmicrohttpd supports it.
+// Returns the base URL ("https://127.0.0.1:port" or "http://..."), empty on failure.
+static inline flx_string start_test_server(http_test_server& server, int port, size_t threads = 4) {
+  bool tls = false;
+  if (server.check_ssl_supported()) {
+    flx_string key, cert;
+    if (make_self_signed_certificate(key, cert)) {
+      server.activate_ssl(key, cert);
+      tls = true;
+    }
+  }
+  server.activate_thread_pool(threads);
+  if (!server.exec(port)) {
+    return flx_string();
+  }
+  return flx_string(tls ? "https" : "http") + "://127.0.0.1:" + flx_string((long long)port);
+}
+
+#endif // HTTP_TEST_SERVER_H
@@ -0,0 +1,340 @@
+#ifndef LLM_STUB_SERVER_H
+#define LLM_STUB_SERVER_H
+
+#include "../../api/server/flx_httpdaemon.h"
+#include "../../api/json/json.hpp"
+#include "../../aiprocesses/chat/flx_llm_context_window.h"
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// ============================================================================
+// LOCAL OPENAI-COMPATIBLE STAND-IN - chat completions (plain and SSE) and
+// embeddings on flx_http_daemon, with scripted replies, injectable latency
+// and failures, and deterministic embeddings.
+//
+//   llm_stub_server stub;
+//   flx_string base_url = start_llm_stub(stub, 18436);
+//   openai_api api("test-key", base_url);
+// ============================================================================
+
+class llm_stub_server : public flx_http_daemon {
+public:
+  struct tool_call {
+    flx_string name;
+    flx_string arguments;
+  };
+
+  struct reply {
+    flx_string content;
+    std::vector<tool_call> tool_calls;
+  };
+
+  // Decides the assistant reply for a parsed chat request. Called from
+  // daemon threads concurrently - must be thread-safe.
+  using responder_fn = std::function<reply(const nlohmann::json& request)>;
+
+  std::atomic<int> chat_requests{0};
+  std::atomic<int> stream_requests{0};
+  std::atomic<int> embedding_requests{0};
+  std::atomic<int> failed_requests{0};
+  std::atomic<size_t> embedded_inputs{0};
+
+  llm_stub_server() : responder(&echo_responder) {}
+
+  // Configure before exec()
+  void set_responder(responder_fn fn) { responder = std::move(fn); }
+  void set_latency(std::chrono::milliseconds per_request, std::chrono::milliseconds per_chunk = std::chrono::milliseconds(0)) {
+    request_latency = per_request;
+    chunk_latency = per_chunk;
+  }
+  void set_embedding_dimensions(size_t dims) { embedding_dims = dims; }
+
+  // The next count requests fail with status
+  void fail_next(int count, int status = 503) {
+    std::lock_guard<std::mutex> lock(failure_mutex);
+    fail_next_count = count;
+    failure_status = status;
+  }
+
+  // Every nth request fails with status (0 disables)
+  void fail_every(int n, int status = 503) {
+    std::lock_guard<std::mutex> lock(failure_mutex);
+    fail_every_n = n;
+    failure_status = status;
+  }
+
+  // Unit-length vector seeded by the text: same text, same embedding
+  static std::vector<float> deterministic_embedding(const std::string& text, size_t dims) {
+    uint64_t state = 1469598103934665603ULL;
+    for (unsigned char c : text) {
+      state = (state ^ c) * 1099511628211ULL;
+    }
+    std::vector<float> values(dims);
+    double norm = 0;
+    for (size_t i = 0; i < dims; ++i) {
+      state ^= state >> 12;
+      state ^= state << 25;
+      state ^= state >> 27;
+      uint64_t r = state * 2685821657736338717ULL;
+      values[i] = static_cast<float>(static_cast<double>(r >> 11) / 9007199254740992.0 * 2.0 - 1.0);
+      norm += static_cast<double>(values[i]) * values[i];
+    }
+    norm = std::sqrt(norm);
+    for (auto& v : values) {
+      v = static_cast<float>(v / norm);
+    }
+    return values;
+  }
+
+  // Default: echo the last user message, summarize tool results after a tool turn
+  static reply echo_responder(const nlohmann::json& request) {
+    reply r;
+    const auto& messages = request["messages"];
+    if (messages.empty()) {
+      return r;
+    }
+    if (messages.back().value("role", "") == "tool") {
+      r.content = "tool results:";
+      for (size_t i = messages.size(); i > 0 && messages[i - 1].value("role", "") == "tool"; --i) {
+        r.content += " " + messages[i - 1].value("content", "");
+      }
+      return r;
+    }
+    const auto& content = messages.back()["content"];
+    r.content = "stub reply: " + (content.is_string() ? content.get<std::string>() : content.dump());
+    return r;
+  }
+
+  response handle(request req) override {
+    if (request_latency.count() > 0) {
+      std::this_thread::sleep_for(request_latency);
+    }
+
+    response res;
+    res.headers["Content-Type"] = "application/json";
+    if (should_fail()) {
+      ++failed_requests;
+      res.statuscode = failure_status;
+      res.body = "{\"error\":{\"message\":\"injected failure\",\"type\":\"server_error\"}}";
+      return res;
+    }
+
+    nlohmann::json body = nlohmann::json::parse(req.body.to_std_const(), nullptr, false);
+    if (req.method != "POST" || !body.is_object()) {
+      res.statuscode = 400;
+      res.body = "{\"error\":{\"message\":\"expected a JSON POST body\",\"type\":\"invalid_request_error\"}}";
+      return res;
+    }
+
+    if (req.path == "/v1/chat/completions") {
+      return chat_completion(body);
+    }
+    if (req.path == "/v1/embeddings") {
+      return embeddings(body);
+    }
+    res.statuscode = 404;
+    res.body = "{\"error\":{\"message\":\"unknown endpoint\",\"type\":\"invalid_request_error\"}}";
+    return res;
+  }
+
+private:
+  responder_fn responder;
+  std::chrono::milliseconds request_latency{0};
+  std::chrono::milliseconds chunk_latency{0};
+  size_t embedding_dims = 256;
+
+  std::mutex failure_mutex;
+  int fail_next_count = 0;
+  int fail_every_n = 0;
+  int failure_status = 503;
+  long request_count = 0;
+
+  std::atomic<long> call_ids{0};
+
+  bool should_fail() {
+    std::lock_guard<std::mutex> lock(failure_mutex);
+    ++request_count;
+    if (fail_next_count > 0) {
+      --fail_next_count;
+      return true;
+    }
+    return fail_every_n > 0 && request_count % fail_every_n == 0;
+  }
+
+  static size_t prompt_tokens(const nlohmann::json& messages) {
+    size_t tokens = 0;
+    for (const auto& m : messages) {
+      const auto& content = m.contains("content") ? m["content"] : nlohmann::json();
+      tokens += flx::llm::context_window::message_overhead_tokens;
+      if (content.is_string()) {
+        tokens += flx::llm::estimate_tokens(flx_string(content.get<std::string>()));
+      }
+    }
+    return tokens;
+  }
+
+  response chat_completion(const nlohmann::json& body) {
+    ++chat_requests;
+    reply r = responder(body);
+    std::string model = body.value("model", "stub-model");
+
+    nlohmann::json tool_calls = nlohmann::json::array();
+    for (const auto& call : r.tool_calls) {
+      tool_calls.push_back({
+        {"id", "call_" + std::to_string(++call_ids)},
+        {"type", "function"},
+        {"function", {{"name", call.name.to_std_const()}, {"arguments", call.arguments.to_std_const()}}}
+      });
+    }
+    const char* finish_reason = r.tool_calls.empty() ? "stop" : "tool_calls";
+
+    response res;
+    res.statuscode = 200;
+
+    if (body.value("stream", false)) {
+      ++stream_requests;
+      res.headers["Content-Type"] = "text/event-stream";
+      res.headers["Cache-Control"] = "no-cache";
+      std::chrono::milliseconds delay = chunk_latency;
+      std::string content = r.content.to_std_const();
+      res.stream = [model, content, tool_calls, finish_reason, delay](flx_http_daemon::stream_writer& out) {
+        auto send = [&out, &model, delay](const nlohmann::json& delta, const char* reason) {
+          if (delay.count() > 0) {
+            std::this_thread::sleep_for(delay);
+          }
+          nlohmann::json chunk = {
+            {"object", "chat.completion.chunk"},
+            {"model", model},
+            {"choices", {{{"index", 0}, {"delta", delta}, {"finish_reason", reason ? nlohmann::json(reason) : nlohmann::json()}}}}
+          };
+          return out.write(flx_string("data: " + chunk.dump() + "\n\n"));
+        };
+        if (!send({{"role", "assistant"}, {"content", ""}}, nullptr)) return;
+        // One chunk per word, like a token stream
+        size_t pos = 0;
+        while (pos < content.size()) {
+          size_t next = content.find(' ', pos + 1);
+          if (next == std::string::npos) next = content.size();
+          if (!send({{"content", content.substr(pos, next - pos)}}, nullptr)) return;
+          pos = next;
+        }
+        for (size_t i = 0; i < tool_calls.size(); ++i) {
+          const auto& call = tool_calls[i];
+          std::string args = call["function"]["arguments"];
+          size_t half = args.size() / 2;
+          nlohmann::json head = {{"index", i}, {"id", call["id"]}, {"type", "function"},
+                                 {"function", {{"name", call["function"]["name"]}, {"arguments", args.substr(0, half)}}}};
+          nlohmann::json tail = {{"index", i}, {"function", {{"arguments", args.substr(half)}}}};
+          if (!send({{"tool_calls", {head}}}, nullptr)) return;
+          if (!send({{"tool_calls", {tail}}}, nullptr)) return;
+        }
+        if (!send(nlohmann::json::object(), finish_reason)) return;
+        out.write("data: [DONE]\n\n");
+      };
+      return res;
+    }
+
+    nlohmann::json message = {{"role", "assistant"}};
+    message["content"] = r.tool_calls.empty() ? nlohmann::json(r.content.to_std_const()) : nlohmann::json();
+    if (!tool_calls.empty()) {
+      message["tool_calls"] = tool_calls;
+    }
+    size_t prompt = prompt_tokens(body["messages"]);
+    size_t completion = flx::llm::estimate_tokens(r.content);
+    nlohmann::json result = {
+      {"id", "chatcmpl-stub-" + std::to_string(chat_requests.load())},
+      {"object", "chat.completion"},
+      {"model", model},
+      {"choices", {{{"index", 0}, {"message", message}, {"finish_reason", finish_reason}}}},
+      {"usage", {{"prompt_tokens", prompt}, {"completion_tokens", completion}, {"total_tokens", prompt + completion}}}
+    };
+    res.headers["Content-Type"] = "application/json";
+    res.body = result.dump();
+    return res;
+  }
+
+  static std::string base64_floats(const std::vector<float>& values) {
+    static const char* alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::vector<unsigned char> bytes(values.size() * sizeof(float));
+    std::memcpy(bytes.data(), values.data(), bytes.size());  // little endian hosts only
+    std::string out;
+    out.reserve((bytes.size() + 2) / 3 * 4);
+    for (size_t i = 0; i < bytes.size(); i += 3) {
+      uint32_t n = static_cast<uint32_t>(bytes[i]) << 16;
+      if (i + 1 < bytes.size()) n |= static_cast<uint32_t>(bytes[i + 1]) << 8;
+      if (i + 2 < bytes.size()) n |= bytes[i + 2];
+      out += alphabet[(n >> 18) & 63];
+      out += alphabet[(n >> 12) & 63];
+      out += i + 1 < bytes.size() ? alphabet[(n >> 6) & 63] : '=';
+      out += i + 2 < bytes.size() ? alphabet[n & 63] : '=';
+    }
+    return out;
+  }
+
+  response embeddings(const nlohmann::json& body) {
+    ++embedding_requests;
+    std::vector<std::string> inputs;
+    const auto& input = body.contains("input") ? body["input"] : nlohmann::json();
+    if (input.is_string()) {
+      inputs.push_back(input.get<std::string>());
+    } else if (input.is_array()) {
+      for (const auto& item : input) {
+        if (item.is_string()) inputs.push_back(item.get<std::string>());
+      }
+    }
+
+    response res;
+    res.headers["Content-Type"] = "application/json";
+    if (inputs.empty()) {
+      res.statuscode = 400;
+      res.body = "{\"error\":{\"message\":\"input is required\",\"type\":\"invalid_request_error\"}}";
+      return res;
+    }
+
+    size_t dims = body.value("dimensions", embedding_dims);
+    bool base64 = body.value("encoding_format", "float") == "base64";
+    nlohmann::json data = nlohmann::json::array();
+    size_t tokens = 0;
+    for (size_t i = 0; i < inputs.size(); ++i) {
+      std::vector<float> values = deterministic_embedding(inputs[i], dims);
+      nlohmann::json item = {{"object", "embedding"}, {"index", i}};
+      if (base64) {
+        item["embedding"] = base64_floats(values);
+      } else {
+        item["embedding"] = values;
+      }
+      data.push_back(std::move(item));
+      tokens += flx::llm::estimate_tokens(flx_string(inputs[i]));
+    }
+    embedded_inputs += inputs.size();
+
+    nlohmann::json result = {
+      {"object", "list"},
+      {"data", data},
+      {"model", body.value("model", "stub-embedding")},
+      {"usage", {{"prompt_tokens", tokens}, {"total_tokens", tokens}}}
+    };
+    res.statuscode = 200;
+    res.body = result.dump();
+    return res;
+  }
+};
+
+// Plain HTTP (no certificate setup needed for the API client).
+// Returns the API base URL ("http://127.0.0.1:port/v1"), empty on failure.
+static inline flx_string start_llm_stub(llm_stub_server& server, int port, size_t threads = 8) {
+  server.activate_thread_pool(threads);
+  if (!server.exec(port)) {
+    return flx_string();
+  }
+  return "http://127.0.0.1:" + flx_string((long long)port) + "/v1";
+}
+
+#endif // LLM_STUB_SERVER_H
@@ -0,0 +1,27 @@
+#ifndef PDF_TEST_HELPERS_H
+#define PDF_TEST_HELPERS_H
+
+#include "../../utils/flx_string.h"
+#include <main/PdfMemDocument.h>
+#include <string>
+#include <vector>
+
+// Decoded content stream, page dictionary and resources of every page.
+// Unlike the whole file these do not depend on the time of the save (Info
+// dates and the trailer /ID derived from them).
+inline std::vector<std::string> page_contents(const flx_string& pdf) {
+  PoDoFo::PdfMemDocument doc;
+  doc.LoadFromBuffer(PoDoFo::bufferview(pdf.c_str(), pdf.size()));
+  std::vector<std::string> pages;
+  for (unsigned i = 0; i < doc.GetPages().GetCount(); ++i) {
+    auto& page = doc.GetPages().GetPageAt(i);
+    PoDoFo::charbuff content = page.MustGetContents().GetCopy();
+    pages.push_back(std::string(content.data(), content.size()) + "\n" +
+                    page.GetObject().ToString() + "\n" +
+                    page.GetResources().GetObject().ToString());
+  }
+  pages.push_back(std::to_string(doc.GetObjects().GetSize()) + " objects");
+  return pages;
+}
+
+#endif // PDF_TEST_HELPERS_H
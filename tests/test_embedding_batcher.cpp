@@ -0,0 +1,196 @@
+#include <catch2/catch_all.hpp>
+#include "../api/aimodels/flx_embedding_batcher.h"
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// ============================================================================
+// embedding_batcher - request coalescing against a mock API (no network)
+// ============================================================================
+
+namespace {
+
+  // Returns [length, first char] for every text and records the batch sizes
+  class mock_embedding_api : public flx::llm::i_llm_api {
+  public:
+    std::mutex mutex;
+    std::vector<size_t> batch_sizes;
+    std::atomic<int> single_calls{0};
+    bool fail = false;
+    flx_string rejected;  // a batch containing this text fails as a whole
+
+    std::unique_ptr<flx::llm::i_llm_chat_context> create_chat_context() override { return nullptr; }
+    std::unique_ptr<flx::llm::i_llm_message> create_message(flx::llm::message_role, flx_variant) override { return nullptr; }
+    std::unique_ptr<flx::llm::i_llm_message> create_message(flxv_map&) override { return nullptr; }
+    std::unique_ptr<flx::llm::i_llm_message> generate_response(
+      flx::llm::i_llm_chat_context&, const std::vector<flx::llm::i_llm_function*>*) override { return nullptr; }
+
+    bool embedding(const flx_string& text, flxv_vector& embedding) override {
+      ++single_calls;
+      embedding = { flx_variant(static_cast<double>(text.length())), flx_variant(static_cast<double>(text.c_str()[0])) };
+      return !fail;
+    }
+
+    bool embedding_batch(const std::vector<flx_string>& texts, std::vector<std::vector<float>>& embeddings) override {
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        batch_sizes.push_back(texts.size());
+      }
+      if (fail) return false;
+      for (const auto& text : texts) {
+        if (!rejected.empty() && text == rejected) return false;
+      }
+      embeddings.clear();
+      for (const auto& text : texts) {
+        embeddings.push_back({ static_cast<float>(text.length()), static_cast<float>(text.c_str()[0]) });
+      }
+      return true;
+    }
+  };
+
+  // Uses the default embedding_batch() of i_llm_api
+  class single_only_api : public mock_embedding_api {
+  public:
+    bool embedding_batch(const std::vector<flx_string>& texts, std::vector<std::vector<float>>& embeddings) override {
+      return flx::llm::i_llm_api::embedding_batch(texts, embeddings);
+    }
+  };
+
+}
+
+SCENARIO("embedding_batcher coalesces concurrent requests", "[unit][pure]") {
+  GIVEN("A batcher with a 20ms window over a mock API") {
+    mock_embedding_api api;
+    flx::llm::embedding_batcher::options opts;
+    opts.max_wait = std::chrono::milliseconds(20);
+    opts.max_inputs = 64;
+    flx::llm::embedding_batcher batcher(api, opts);
+
+    WHEN("32 threads embed different texts at the same time") {
+      const int count = 32;
+      std::vector<std::vector<float>> results(count);
+      std::vector<int> ok(count, 0);
+      std::vector<std::thread> threads;
+      for (int i = 0; i < count; ++i) {
+        threads.emplace_back([&, i] {
+          flx_string text = flx_string(static_cast<char>('a' + i % 26)).repeat(i + 1);
+          ok[i] = batcher.embed(text, results[i]) ? 1 : 0;
+        });
+      }
+      for (auto& t : threads) t.join();
+
+      THEN("Every caller gets its own result from fewer API calls") {
+        size_t total = 0;
+        for (size_t size : api.batch_sizes) total += size;
+        REQUIRE(total == count);
+        REQUIRE(api.batch_sizes.size() < count);
+        for (int i = 0; i < count; ++i) {
+          REQUIRE(ok[i] == 1);
+          REQUIRE(results[i].size() == 2);
+          REQUIRE(results[i][0] == static_cast<float>(i + 1));
+          REQUIRE(results[i][1] == static_cast<float>('a' + i % 26));
+        }
+      }
+    }
+  }
+
+  GIVEN("A batcher limited to 4 inputs per batch") {
+    mock_embedding_api api;
+    flx::llm::embedding_batcher::options opts;
+    opts.max_wait = std::chrono::milliseconds(50);
+    opts.max_inputs = 4;
+    flx::llm::embedding_batcher batcher(api, opts);
+
+    WHEN("10 threads embed at once") {
+      std::vector<std::thread> threads;
+      std::vector<std::vector<float>> results(10);
+      for (int i = 0; i < 10; ++i) {
+        threads.emplace_back([&, i] { batcher.embed("text", results[i]); });
+      }
+      for (auto& t : threads) t.join();
+
+      THEN("No batch exceeds the limit") {
+        for (size_t size : api.batch_sizes) {
+          REQUIRE(size <= 4);
+        }
+      }
+    }
+  }
+
+  GIVEN("A batcher receiving all chunks of a document at once") {
+    mock_embedding_api api;
+    flx::llm::embedding_batcher batcher(api);
+
+    WHEN("Embedding them with embed_all") {
+      std::vector<std::vector<float>> results;
+      bool ok = batcher.embed_all({"a", "bb", "ccc", "dddd"}, results);
+
+      THEN("They go out in one batch and come back in order") {
+        REQUIRE(ok);
+        REQUIRE(api.batch_sizes.size() == 1);
+        REQUIRE(api.batch_sizes[0] == 4);
+        REQUIRE(results.size() == 4);
+        REQUIRE(results[3][0] == 4.0f);
+        REQUIRE(results[1][1] == static_cast<float>('b'));
+      }
+    }
+  }
+
+  GIVEN("An API that rejects one of the texts") {
+    mock_embedding_api api;
+    api.rejected = "bad";
+    flx::llm::embedding_batcher batcher(api);
+
+    WHEN("It arrives in one batch with seven good texts") {
+      std::vector<flx_string> texts = {"a", "bb", "ccc", "bad", "eeeee", "ffffff", "g", "hh"};
+      std::vector<std::vector<float>> results;
+      bool all = batcher.embed_all(texts, results);
+
+      THEN("The batch is split until only the bad text fails") {
+        REQUIRE_FALSE(all);
+        REQUIRE(api.batch_sizes.front() == 8);
+        REQUIRE(api.batch_sizes.size() == 7);
+        for (size_t i = 0; i < texts.size(); ++i) {
+          if (texts[i] == "bad") {
+            REQUIRE(results[i].empty());
+          } else {
+            REQUIRE(results[i].size() == 2);
+            REQUIRE(results[i][0] == static_cast<float>(texts[i].length()));
+          }
+        }
+      }
+    }
+  }
+
+  GIVEN("An API that fails") {
+    mock_embedding_api api;
+    api.fail = true;
+    flx::llm::embedding_batcher batcher(api);
+
+    THEN("embed() reports the failure and empty texts are rejected") {
+      std::vector<float> result;
+      REQUIRE_FALSE(batcher.embed("text", result));
+      REQUIRE_FALSE(batcher.embed("", result));
+    }
+  }
+}
+
+SCENARIO("i_llm_api default embedding_batch falls back to single requests", "[unit][pure]") {
+  GIVEN("An API without a native batch endpoint") {
+    single_only_api api;
+
+    WHEN("Embedding three texts as a batch") {
+      std::vector<std::vector<float>> embeddings;
+      bool ok = api.embedding_batch({"a", "bb", "ccc"}, embeddings);
+
+      THEN("Each text is embedded once, in input order, as floats") {
+        REQUIRE(ok);
+        REQUIRE(api.single_calls == 3);
+        REQUIRE(embeddings.size() == 3);
+        REQUIRE(embeddings[2][0] == 3.0f);
+        REQUIRE(embeddings[1][1] == static_cast<float>('b'));
+      }
+    }
+  }
+}
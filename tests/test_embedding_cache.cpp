@@ -0,0 +1,113 @@
+#include <catch2/catch_all.hpp>
+#include "../api/db/flx_embedding_cache.h"
+#include "../api/server/flx_metrics.h"
+#include <cmath>
+#include <filesystem>
+#include <limits>
+
+// ============================================================================
+// flx_embedding_cache - float16 payload, LRU front, file backing store
+// ============================================================================
+
+SCENARIO("float16 conversion round-trips embedding values", "[unit][pure]") {
+  GIVEN("Typical embedding components and edge cases") {
+    THEN("Exact half values survive unchanged") {
+      for (float v : {0.0f, 1.0f, -2.0f, 0.5f, 65504.0f, -0.125f}) {
+        REQUIRE(flx_embedding_cache::half_to_float(flx_embedding_cache::float_to_half(v)) == v);
+      }
+    }
+
+    THEN("Values in the embedding range keep ~3 significant digits") {
+      for (float v : {0.0123456f, -0.0456789f, 0.3333333f, 0.00012345f}) {
+        float back = flx_embedding_cache::half_to_float(flx_embedding_cache::float_to_half(v));
+        REQUIRE(std::fabs(back - v) <= std::fabs(v) * 0.001f + 1e-7f);
+      }
+    }
+
+    THEN("Overflow becomes infinity and NaN stays NaN") {
+      REQUIRE(std::isinf(flx_embedding_cache::half_to_float(flx_embedding_cache::float_to_half(1e6f))));
+      REQUIRE(std::isnan(flx_embedding_cache::half_to_float(
+        flx_embedding_cache::float_to_half(std::numeric_limits<float>::quiet_NaN()))));
+    }
+  }
+}
+
+SCENARIO("flx_embedding_cache keys and LRU eviction", "[unit][pure]") {
+  GIVEN("A cache with room for two entries") {
+    flx_embedding_cache cache(2);
+
+    THEN("Keys depend on model name and text") {
+      flx_string a = flx_embedding_cache::make_key("text-embedding-3-large", "Hello");
+      REQUIRE(a.length() == 64);
+      REQUIRE(a == flx_embedding_cache::make_key("text-embedding-3-large", "Hello"));
+      REQUIRE(a != flx_embedding_cache::make_key("text-embedding-3-small", "Hello"));
+      REQUIRE(a != flx_embedding_cache::make_key("text-embedding-3-large", "Hello!"));
+    }
+
+    WHEN("Three entries are inserted and the first is touched before the third") {
+      cache.put("k1", {1.0f, 2.0f});
+      cache.put("k2", {3.0f});
+      std::vector<float> out;
+      REQUIRE(cache.get("k1", out));
+      cache.put("k3", {4.0f});
+
+      THEN("The least recently used entry is evicted") {
+        REQUIRE(cache.size() == 2);
+        REQUIRE(cache.get("k1", out));
+        REQUIRE(out == std::vector<float>{1.0f, 2.0f});
+        REQUIRE_FALSE(cache.get("k2", out));
+        REQUIRE(cache.get("k3", out));
+
+        auto stats = cache.get_stats();
+        REQUIRE(stats.memory_hits == 3);
+        REQUIRE(stats.misses == 1);
+        REQUIRE(stats.hit_rate() == 0.75);
+      }
+    }
+  }
+}
+
+SCENARIO("flx_embedding_cache persists through a file store", "[unit][pure]") {
+  GIVEN("A temporary cache directory") {
+    std::filesystem::path dir = std::filesystem::temp_directory_path() / "flx_embedding_cache_test";
+    std::filesystem::remove_all(dir);
+    flx_embedding_file_store store(dir.string());
+
+    std::vector<float> embedding(3072);
+    for (size_t i = 0; i < embedding.size(); ++i) {
+      embedding[i] = std::sin(static_cast<float>(i)) * 0.05f;
+    }
+    flx_string key = flx_embedding_cache::make_key("text-embedding-3-large", "Ausschreibung Los 1");
+
+    WHEN("One cache instance stores an embedding and a fresh one reads it") {
+      {
+        flx_embedding_cache writer(16, &store);
+        writer.put(key, embedding);
+      }
+
+      flx_metrics::instance().reset();
+      flx_embedding_cache reader(16, &store);
+      std::vector<float> out;
+      bool hit = reader.get(key, out);
+      bool second = reader.get(key, out);
+
+      THEN("It is served from disk first and from memory after that") {
+        REQUIRE(hit);
+        REQUIRE(second);
+        REQUIRE(out.size() == embedding.size());
+        for (size_t i = 0; i < out.size(); ++i) {
+          REQUIRE(std::fabs(out[i] - embedding[i]) < 1e-4f);
+        }
+        REQUIRE(std::filesystem::file_size(dir / key.substr(0, 2).to_std() / (key + ".f16").to_std()) ==
+                8 + embedding.size() * 2);
+
+        auto stats = reader.get_stats();
+        REQUIRE(stats.store_hits == 1);
+        REQUIRE(stats.memory_hits == 1);
+        REQUIRE(flx_metrics::instance().to_prometheus().contains("flx_counter_total{name=\"embedding_cache.hit_store\"} 1"));
+      }
+    }
+
+    std::filesystem::remove_all(dir);
+  }
+}
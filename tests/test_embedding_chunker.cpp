@@ -0,0 +1,111 @@
+#include <catch2/catch_all.hpp>
+#include "../api/aimodels/flx_embedding_chunker.h"
+#include "../aiprocesses/chat/flx_llm_api.h"
+#include <cmath>
+
+// ============================================================================
+// Chunking and pooling of long texts for embeddings (no network)
+// ============================================================================
+
+using namespace flx::llm;
+
+namespace {
+
+  flx_string long_document(int sentences) {
+    flx_string text;
+    for (int i = 0; i < sentences; ++i) {
+      text += "Position " + flx_string(static_cast<long long>(i)) + " der Ausschreibung umfasst Lieferung und Montage. ";
+      if (i % 10 == 9) text += "\n\n";
+    }
+    return text;
+  }
+
+}
+
+SCENARIO("split_into_chunks cuts long texts into overlapping chunks", "[unit][pure]") {
+  long_text_options options;
+  options.chunk_tokens = 200;
+  options.overlap_tokens = 20;
+
+  GIVEN("A short text") {
+    flx_string text = "Kurzer Text.";
+    auto chunks = split_into_chunks(text, options);
+
+    THEN("It stays one chunk") {
+      REQUIRE(chunks.size() == 1);
+      REQUIRE(chunks[0].offset == 0);
+      REQUIRE(chunks[0].length == text.length());
+    }
+  }
+
+  GIVEN("A document of about 3000 tokens") {
+    flx_string text = long_document(120);
+    auto chunks = split_into_chunks(text, options);
+
+    THEN("Chunks respect the token limit, cover the text, overlap and end at sentence boundaries") {
+      REQUIRE(chunks.size() > 10);
+      REQUIRE(chunks.front().offset == 0);
+      REQUIRE(chunks.back().offset + chunks.back().length == text.length());
+      for (size_t i = 0; i < chunks.size(); ++i) {
+        REQUIRE(estimate_embedding_tokens(text.substr(chunks[i].offset, chunks[i].length)) <= options.chunk_tokens + 1);
+        if (i + 1 < chunks.size()) {
+          REQUIRE(chunks[i + 1].offset < chunks[i].offset + chunks[i].length);  // overlap
+          REQUIRE(chunks[i + 1].offset > chunks[i].offset);
+          char last = text.c_str()[chunks[i].offset + chunks[i].length - 1];
+          REQUIRE((last == ' ' || last == '\n'));
+        }
+      }
+    }
+  }
+
+  GIVEN("Text without spaces and with multi-byte characters") {
+    flx_string text = flx_string("ä").repeat(1000);
+    auto chunks = split_into_chunks(text, options);
+
+    THEN("No chunk splits a character") {
+      REQUIRE(chunks.size() > 1);
+      for (const auto& chunk : chunks) {
+        REQUIRE(chunk.offset % 2 == 0);
+        REQUIRE(chunk.length % 2 == 0);
+      }
+    }
+  }
+}
+
+SCENARIO("pool_embeddings combines chunk vectors", "[unit][pure]") {
+  std::vector<std::vector<float>> vectors = {{1.0f, 0.0f}, {0.0f, 1.0f}};
+  std::vector<text_chunk> chunks = {{0, 300, 300}, {300, 100, 100}};
+
+  THEN("Mean pooling weights chunks equally, weighted pooling by tokens, both normalized") {
+    auto mean = pool_embeddings(vectors, chunks, pooling_mode::mean);
+    REQUIRE(std::fabs(mean[0] - mean[1]) < 1e-6f);
+    REQUIRE(std::fabs(mean[0] * mean[0] + mean[1] * mean[1] - 1.0f) < 1e-5f);
+
+    auto weighted = pool_embeddings(vectors, chunks, pooling_mode::weighted);
+    REQUIRE(std::fabs(weighted[0] - 3 * weighted[1]) < 1e-6f);
+    REQUIRE(std::fabs(weighted[0] * weighted[0] + weighted[1] * weighted[1] - 1.0f) < 1e-5f);
+  }
+
+  THEN("A single chunk is returned unchanged and mismatched dimensions fail") {
+    REQUIRE(pool_embeddings({{0.5f, 0.5f}}, {chunks[0]}, pooling_mode::weighted) == std::vector<float>{0.5f, 0.5f});
+    REQUIRE(pool_embeddings({{1.0f}, {1.0f, 0.0f}}, chunks, pooling_mode::mean).empty());
+  }
+}
+
+SCENARIO("long_text_options are read from property metadata", "[unit][pure]") {
+  flxv_map meta;
+  meta["column"] = "semantic_embedding";
+  meta["embedding_strategy"] = "summarize";
+  meta["chunk_tokens"] = 512;
+  meta["pooling"] = "mean";
+
+  long_text_options defaults;
+  defaults.overlap_tokens = 32;
+  long_text_options options = long_text_options::from_meta(meta, defaults);
+
+  REQUIRE(options.strategy == long_text_strategy::summarize);
+  REQUIRE(options.chunk_tokens == 512);
+  REQUIRE(options.overlap_tokens == 32);
+  REQUIRE(options.pooling == pooling_mode::mean);
+  REQUIRE(long_text_options::from_meta(flxv_map()).strategy == long_text_strategy::chunk);
+}
@@ -0,0 +1,135 @@
+#include <catch2/catch_all.hpp>
+#include "../api/server/flx_metrics.h"
+#include <thread>
+#include <vector>
+
+SCENARIO("flx_latency_histogram buckets values with bounded relative error", "[unit][pure][metrics]") {
+
+  GIVEN("The bucket index mapping") {
+    THEN("Small values are exact") {
+      for (uint64_t v = 0; v < 16; ++v) {
+        int idx = flx_latency_histogram::bucket_index(v);
+        REQUIRE(flx_latency_histogram::bucket_lower_bound(idx) == v);
+        REQUIRE(flx_latency_histogram::bucket_upper_bound(idx) == v);
+      }
+    }
+
+    THEN("Every value lies within its bucket bounds") {
+      for (uint64_t v : {16ull, 17ull, 31ull, 32ull, 100ull, 1000ull, 123456ull, 987654321ull}) {
+        int idx = flx_latency_histogram::bucket_index(v);
+        REQUIRE(flx_latency_histogram::bucket_lower_bound(idx) <= v);
+        REQUIRE(flx_latency_histogram::bucket_upper_bound(idx) >= v);
+        double width = double(flx_latency_histogram::bucket_upper_bound(idx) - flx_latency_histogram::bucket_lower_bound(idx));
+        REQUIRE(width / double(v) < 0.07);
+      }
+    }
+
+    THEN("Huge values are clamped into the last bucket") {
+      REQUIRE(flx_latency_histogram::bucket_index(~0ull) == flx_latency_histogram::bucket_count - 1);
+    }
+  }
+
+  GIVEN("A histogram with 1000 samples from 1ms to 1000ms") {
+    flx_latency_histogram h;
+    for (uint64_t ms = 1; ms <= 1000; ++ms) {
+      h.record(ms * 1000);
+    }
+
+    THEN("Count, sum and max are exact") {
+      REQUIRE(h.count() == 1000);
+      REQUIRE(h.sum() == 500500ull * 1000);
+      REQUIRE(h.max() == 1000000);
+    }
+
+    THEN("Percentiles are within bucket precision") {
+      REQUIRE(h.percentile(0.5) >= 500000);
+      REQUIRE(h.percentile(0.5) < 500000 * 1.07);
+      REQUIRE(h.percentile(0.99) >= 990000);
+      REQUIRE(h.percentile(0.999) == 1000000);
+    }
+  }
+
+  GIVEN("An empty histogram") {
+    flx_latency_histogram h;
+    THEN("Percentiles are zero") {
+      REQUIRE(h.percentile(0.99) == 0);
+    }
+  }
+}
+
+SCENARIO("flx_metrics registry records timers and renders Prometheus text", "[unit][pure][metrics]") {
+
+  GIVEN("A clean registry") {
+    flx_metrics& metrics = flx_metrics::instance();
+    metrics.reset();
+
+    WHEN("Timers are recorded from several threads") {
+      std::vector<std::thread> workers;
+      for (int t = 0; t < 4; ++t) {
+        workers.emplace_back([&metrics]() {
+          for (int i = 0; i < 250; ++i) {
+            flx_scoped_timer timer(metrics.timer("test.op"));
+          }
+        });
+      }
+      for (auto& w : workers) {
+        w.join();
+      }
+
+      THEN("No call is lost and nothing is left in flight") {
+        flx_metric& m = metrics.timer("test.op");
+        REQUIRE(m.calls.load() == 1000);
+        REQUIRE(m.in_flight.load() == 0);
+        REQUIRE(m.latency.count() == 1000);
+      }
+    }
+
+    WHEN("A route is recorded and rendered") {
+      flx_metric& route = metrics.route("GET /api/\"x\"");
+      route.begin();
+      route.add_bytes(10, 200);
+      route.end(std::chrono::milliseconds(5), true);
+
+      flx_string text = metrics.to_prometheus();
+
+      THEN("The exposition contains quantiles, counters and escaped labels") {
+        REQUIRE(text.contains("# TYPE flx_http_request_duration_seconds summary"));
+        REQUIRE(text.contains("route=\"GET /api/\\\"x\\\"\",quantile=\"0.99\""));
+        REQUIRE(text.contains("flx_http_request_calls_total{route=\"GET /api/\\\"x\\\"\"} 1"));
+        REQUIRE(text.contains("flx_http_request_errors_total{route=\"GET /api/\\\"x\\\"\"} 1"));
+        REQUIRE(text.contains("flx_http_request_response_bytes_total{route=\"GET /api/\\\"x\\\"\"} 200"));
+      }
+    }
+
+    WHEN("A request begins under its method and is handed to its route") {
+      flx_metric& method = metrics.route("GET");
+      flx_metric& route = metrics.route("GET /api/docs/:id");
+      method.begin();
+      REQUIRE(method.in_flight.load() == 1);
+      method.move_to(route);
+
+      THEN("It stays in flight under the route only and ends there") {
+        REQUIRE(method.in_flight.load() == 0);
+        REQUIRE(route.in_flight.load() == 1);
+        route.end(std::chrono::milliseconds(1));
+        REQUIRE(route.in_flight.load() == 0);
+        REQUIRE(route.calls.load() == 1);
+        REQUIRE(method.calls.load() == 0);
+      }
+    }
+
+    WHEN("More routes than the cardinality limit are registered") {
+      for (size_t i = 0; i < flx_metrics::max_routes + 10; ++i) {
+        metrics.route(flx_string("GET /item/") + flx_string((long long)i));
+      }
+
+      THEN("Overflow routes are folded into 'other'") {
+        flx_metric& a = metrics.route("GET /item/999999");
+        flx_metric& b = metrics.route("GET /item/888888");
+        REQUIRE(&a == &b);
+      }
+    }
+
+    metrics.reset();
+  }
+}
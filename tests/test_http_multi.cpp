@@ -0,0 +1,121 @@
+#include <catch2/catch_all.hpp>
+#include "../api/client/flx_http_multi.h"
+#include "shared/http_test_server.h"
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// ============================================================================
+// flx_http_multi - concurrent requests against a local stand-in server
+// ============================================================================
+
+static std::vector<std::unique_ptr<flx_http_request>> make_requests(const flx_string& base_url, const flx_string& path, int count) {
+  std::vector<std::unique_ptr<flx_http_request>> requests;
+  for (int i = 0; i < count; ++i) {
+    auto request = std::make_unique<flx_http_request>(base_url + path + flx_string((long long)i));
+    request->set_verify_peer(false);
+    request->set_timeout_ms(10000);
+    request->set_retry(3, 10);
+    requests.push_back(std::move(request));
+  }
+  return requests;
+}
+
+static std::vector<flx_http_request*> as_pointers(const std::vector<std::unique_ptr<flx_http_request>>& requests) {
+  std::vector<flx_http_request*> pointers;
+  for (const auto& r : requests) {
+    pointers.push_back(r.get());
+  }
+  return pointers;
+}
+
+SCENARIO("flx_http_multi runs requests concurrently", "[http][benchmark]") {
+  GIVEN("A local server with 50ms latency per request") {
+    http_test_server server([](const flx_http_daemon::request& req) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(50));
+      flx_http_daemon::response r;
+      r.statuscode = 200;
+      r.body = req.path;
+      return r;
+    });
+    flx_string base_url = start_test_server(server, 18433, 16);
+    REQUIRE_FALSE(base_url.empty());
+
+    const int count = 40;
+
+    WHEN("Sending the batch sequentially and through flx_http_multi") {
+      auto sequential = make_requests(base_url, "/item/", count);
+      auto start = std::chrono::steady_clock::now();
+      for (auto& request : sequential) {
+        REQUIRE(request->send());
+      }
+      auto mid = std::chrono::steady_clock::now();
+
+      auto concurrent = make_requests(base_url, "/item/", count);
+      std::atomic<int> callbacks{0};
+      flx_http_multi multi(8, 8);
+      size_t succeeded = multi.execute(as_pointers(concurrent), [&callbacks](flx_http_request&, bool) {
+        ++callbacks;
+      });
+      auto end = std::chrono::steady_clock::now();
+
+      double sequential_ms = std::chrono::duration<double, std::milli>(mid - start).count();
+      double concurrent_ms = std::chrono::duration<double, std::milli>(end - mid).count();
+      std::cout << "[http multi benchmark] " << count << " requests" << std::endl;
+      std::cout << "  sequential: " << sequential_ms << " ms (" << count * 1000.0 / sequential_ms << " req/s)" << std::endl;
+      std::cout << "  concurrent(8): " << concurrent_ms << " ms (" << count * 1000.0 / concurrent_ms << " req/s)" << std::endl;
+
+      THEN("Every request gets its own response and the batch is faster") {
+        REQUIRE(succeeded == count);
+        REQUIRE(callbacks == count);
+        for (int i = 0; i < count; ++i) {
+          REQUIRE(concurrent[i]->get_status_code() == 200);
+          REQUIRE(concurrent[i]->get_response_body() == flx_string("/item/") + flx_string((long long)i));
+        }
+        REQUIRE(concurrent_ms * 2 < sequential_ms);
+      }
+    }
+
+    server.stop();
+  }
+}
+
+SCENARIO("flx_http_multi retries transient failures per request", "[http][retry]") {
+  GIVEN("A local server that answers the first five requests with 503") {
+    std::atomic<int> hits{0};
+    http_test_server server([&hits](const flx_http_daemon::request& req) {
+      flx_http_daemon::response r;
+      if (req.path.contains("/flaky/") && hits.fetch_add(1) < 5) {
+        r.statuscode = 503;
+        r.headers["Retry-After"] = "0";
+      } else {
+        r.statuscode = 200;
+        r.body = "ok";
+      }
+      return r;
+    });
+    flx_string base_url = start_test_server(server, 18434);
+    REQUIRE_FALSE(base_url.empty());
+
+    WHEN("Executing asynchronously") {
+      auto requests = make_requests(base_url, "/flaky/", 5);
+      flx_http_multi multi(4);
+      size_t succeeded = multi.execute_async(as_pointers(requests)).get();
+
+      THEN("All requests eventually succeed after retrying") {
+        REQUIRE(succeeded == 5);
+        int attempts = 0;
+        for (auto& request : requests) {
+          REQUIRE(request->get_status_code() == 200);
+          attempts += request->get_attempts();
+        }
+        REQUIRE(attempts == 10);
+      }
+    }
+
+    server.stop();
+  }
+}
@@ -0,0 +1,195 @@
+#include <catch2/catch_all.hpp>
+#include "../api/client/flx_http_request.h"
+#include "shared/http_test_server.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+// ============================================================================
+// flx_http_request against a local stand-in server (no external network)
+// ============================================================================
+
+static double median_ms(std::vector<double> samples) {
+  std::sort(samples.begin(), samples.end());
+  return samples.empty() ? 0.0 : samples[samples.size() / 2];
+}
+
+SCENARIO("flx_http_request retries transient failures with backoff", "[http][retry]") {
+  GIVEN("A local server that fails twice with 503 before answering") {
+    std::atomic<int> hits{0};
+    http_test_server server([&hits](const flx_http_daemon::request&) {
+      flx_http_daemon::response r;
+      if (hits.fetch_add(1) < 2) {
+        r.statuscode = 503;
+        r.headers["Retry-After"] = "0";
+        r.body = "busy";
+      } else {
+        r.statuscode = 200;
+        r.body = "{\"ok\":true}";
+      }
+      return r;
+    });
+    flx_string base_url = start_test_server(server, 18431);
+    REQUIRE_FALSE(base_url.empty());
+
+    WHEN("Sending without retries") {
+      flx_http_request request(base_url + "/ping");
+      request.set_verify_peer(false);
+      bool ok = request.send();
+
+      THEN("The first 503 is returned as failure") {
+        REQUIRE_FALSE(ok);
+        REQUIRE(request.get_status_code() == 503);
+        REQUIRE(request.get_attempts() == 1);
+      }
+    }
+
+    WHEN("Sending with three retries") {
+      flx_http_request request(base_url + "/ping");
+      request.set_verify_peer(false);
+      request.set_retry(3, 10);
+      bool ok = request.send();
+
+      THEN("The third attempt succeeds") {
+        REQUIRE(ok);
+        REQUIRE(request.get_status_code() == 200);
+        REQUIRE(request.get_attempts() == 3);
+        REQUIRE(request.get_response_body() == "{\"ok\":true}");
+      }
+    }
+
+    server.stop();
+  }
+
+  GIVEN("No server listening on the target port") {
+    flx_http_request request("http://127.0.0.1:18439/nothing");
+    request.set_connect_timeout_ms(200);
+    request.set_retry(1, 10);
+
+    THEN("Connection errors are retried and reported") {
+      REQUIRE_FALSE(request.send());
+      REQUIRE(request.get_attempts() == 2);
+      REQUIRE(request.get_error_message().contains("libcurl error"));
+    }
+  }
+}
+
+SCENARIO("flx_http_request retries POST only when it was not processed", "[http][retry]") {
+  GIVEN("A local server that answers /slow after 300ms and /error with 500, /busy with 503") {
+    std::atomic<int> hits{0};
+    http_test_server server([&hits](const flx_http_daemon::request& req) {
+      ++hits;
+      flx_http_daemon::response r;
+      r.statuscode = 200;
+      if (req.path == "/slow") {
+        std::this_thread::sleep_for(std::chrono::milliseconds(300));
+      } else if (req.path == "/error") {
+        r.statuscode = 500;
+      } else if (req.path == "/busy") {
+        r.statuscode = 503;
+        r.headers["Retry-After"] = "0";
+      }
+      r.body = "{}";
+      return r;
+    });
+    flx_string base_url = start_test_server(server, 18440);
+    REQUIRE_FALSE(base_url.empty());
+
+    auto post = [&](const char* path) {
+      flx_http_request request(base_url + path);
+      request.set_verify_peer(false);
+      request.set_method("POST");
+      request.set_body("{\"n\":1}");
+      request.set_timeout_ms(100);
+      request.set_retry(2, 10);
+      return request;
+    };
+
+    THEN("A timed out or failed POST is sent once") {
+      flx_http_request slow = post("/slow");
+      REQUIRE_FALSE(slow.send());
+      REQUIRE(slow.get_attempts() == 1);
+      flx_http_request error = post("/error");
+      REQUIRE_FALSE(error.send());
+      REQUIRE(error.get_attempts() == 1);
+    }
+
+    THEN("A POST the server turned away is retried") {
+      flx_http_request busy = post("/busy");
+      REQUIRE_FALSE(busy.send());
+      REQUIRE(busy.get_attempts() == 3);
+    }
+
+    THEN("An idempotent POST is retried after a timeout") {
+      flx_http_request slow = post("/slow");
+      slow.set_idempotent(true);
+      REQUIRE_FALSE(slow.send());
+      REQUIRE(slow.get_attempts() == 3);
+    }
+
+    server.stop();
+  }
+}
+
+SCENARIO("flx_http_request connection reuse benchmark", "[http][benchmark]") {
+  GIVEN("A local HTTPS stand-in server") {
+    http_test_server server([](const flx_http_daemon::request& req) {
+      flx_http_daemon::response r;
+      r.statuscode = 200;
+      r.headers["Content-Type"] = "application/json";
+      r.body = flx_string("{\"echo\":") + flx_string((long long)req.body.size()) + "}";
+      return r;
+    });
+    flx_string base_url = start_test_server(server, 18432);
+    REQUIRE_FALSE(base_url.empty());
+
+    const int iterations = 50;
+    flx_string payload = flx_string("x").repeat(2048);
+
+    auto run = [&](bool reuse) {
+      std::vector<double> samples;
+      for (int i = 0; i < iterations; ++i) {
+        flx_http_request request(base_url + "/v1/embeddings");
+        request.set_method("POST");
+        request.set_header("Content-Type", "application/json");
+        request.set_body(payload);
+        request.set_verify_peer(false);
+        request.set_reuse_connection(reuse);
+        request.set_timeout_ms(5000);
+
+        auto start = std::chrono::steady_clock::now();
+        bool ok = request.send();
+        auto end = std::chrono::steady_clock::now();
+        REQUIRE(ok);
+        samples.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+      }
+      return samples;
+    };
+
+    WHEN("Sending sequential requests with and without reuse") {
+      // Warm-up establishes the pooled connection
+      run(true);
+      auto fresh = run(false);
+      auto reused = run(true);
+
+      double fresh_median = median_ms(fresh);
+      double reused_median = median_ms(reused);
+      std::cout << "[http benchmark] " << base_url.c_str() << " " << iterations << " requests" << std::endl;
+      std::cout << "  fresh connection: median " << fresh_median << " ms" << std::endl;
+      std::cout << "  reused connection: median " << reused_median << " ms" << std::endl;
+
+      THEN("All requests succeed and reuse is not slower") {
+        REQUIRE(fresh.size() == iterations);
+        REQUIRE(reused.size() == iterations);
+        if (reused_median > fresh_median) {
+          WARN("Connection reuse was not faster on this machine");
+        }
+      }
+    }
+
+    server.stop();
+  }
+}
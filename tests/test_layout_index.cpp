@@ -0,0 +1,198 @@
+#include <catch2/catch_all.hpp>
+#include "../documents/layout/flx_layout_index.h"
+#include "../documents/layout/flx_layout_geometry.h"
+#include "../documents/flx_layout_to_html.h"
+#include <chrono>
+#include <iostream>
+#include <random>
+
+namespace {
+
+  using box = flx_layout_index::box;
+
+  std::vector<box> random_boxes(size_t count, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> position(0.0, 1000.0);
+    std::uniform_real_distribution<double> extent(0.0, 120.0);
+    std::vector<box> boxes;
+    for (size_t i = 0; i < count; ++i) {
+      double x = position(rng);
+      double y = position(rng);
+      boxes.push_back({x, y, x + extent(rng), y + extent(rng)});
+    }
+    return boxes;
+  }
+
+  bool inside(const box& inner, const box& outer, double tolerance) {
+    return inner.left >= outer.left - tolerance && inner.top >= outer.top - tolerance &&
+           inner.right <= outer.right + tolerance && inner.bottom <= outer.bottom + tolerance;
+  }
+
+  // Page of rows, each row a container of cells: the nesting the region
+  // detection produces for tables
+  flx_layout_geometry table_page(int rows, int columns) {
+    flx_layout_geometry page;
+    page.x = 0.0;
+    page.y = 0.0;
+    page.width = columns * 20.0;
+    page.height = rows * 10.0;
+    for (int r = 0; r < rows; ++r) {
+      flx_layout_geometry row;
+      row.x = 0.0;
+      row.y = r * 10.0;
+      row.width = columns * 20.0;
+      row.height = 10.0;
+      page.sub_geometries.push_back(row);
+      for (int c = 0; c < columns; ++c) {
+        flx_layout_geometry cell;
+        cell.x = c * 20.0 + 1.0;
+        cell.y = r * 10.0 + 1.0;
+        cell.width = 18.0;
+        cell.height = 8.0;
+        page.sub_geometries.push_back(cell);
+      }
+    }
+    return page;
+  }
+
+}
+
+SCENARIO("Layout index answers rectangle and point queries", "[unit][layout][index]") {
+  GIVEN("An index over random boxes") {
+    auto boxes = random_boxes(3000, 7);
+    flx_layout_index index(boxes, 8);
+
+    WHEN("Querying the same areas with the index and by brute force") {
+      auto areas = random_boxes(50, 11);
+      areas.push_back({-10.0, -10.0, 2000.0, 2000.0});
+
+      THEN("Both find the same ids in ascending order") {
+        std::vector<size_t> found;
+        for (const auto& area : areas) {
+          std::vector<size_t> intersecting, contained, containing;
+          for (size_t i = 0; i < boxes.size(); ++i) {
+            const auto& b = boxes[i];
+            if (!(b.right < area.left || b.left > area.right || b.bottom < area.top || b.top > area.bottom)) {
+              intersecting.push_back(i);
+            }
+            if (inside(b, area, 0.5)) contained.push_back(i);
+            if (inside(area, b, 0.5)) containing.push_back(i);
+          }
+          index.query_intersects(area, found);
+          REQUIRE(found == intersecting);
+          index.query_contained_in(area, found, 0.5);
+          REQUIRE(found == contained);
+          index.query_containing(area, found, 0.5);
+          REQUIRE(found == containing);
+        }
+
+        std::vector<size_t> expected;
+        for (size_t i = 0; i < boxes.size(); ++i) {
+          if (inside({500.0, 500.0, 500.0, 500.0}, boxes[i], 0.0)) expected.push_back(i);
+        }
+        index.query_point(500.0, 500.0, found);
+        REQUIRE(found == expected);
+      }
+    }
+  }
+
+  GIVEN("An empty index") {
+    flx_layout_index index;
+
+    THEN("Queries find nothing") {
+      std::vector<size_t> found{1, 2};
+      index.query_point(0.0, 0.0, found);
+      REQUIRE(index.empty());
+      REQUIRE(found.empty());
+    }
+  }
+
+  GIVEN("A list of layout models") {
+    flx_model_list<flx_layout_geometry> geometries;
+    flx_layout_geometry outer;
+    outer.x = 10.0;
+    outer.y = 10.0;
+    outer.width = 100.0;
+    outer.height = 50.0;
+    geometries.push_back(outer);
+
+    THEN("Their bounds are indexed by position in the list") {
+      auto index = flx_layout_index::from_list(geometries);
+      std::vector<size_t> found;
+      index.query_point(110.0, 60.0, found);
+      REQUIRE(found == std::vector<size_t>{0});
+      index.query_point(111.0, 60.0, found);
+      REQUIRE(found.empty());
+    }
+  }
+}
+
+SCENARIO("HTML conversion nests geometries found through the index", "[unit][layout][html]") {
+  GIVEN("A page with two rows of two cells") {
+    auto page = table_page(2, 2);
+
+    WHEN("Converting it to HTML") {
+      std::string html = flx_layout_to_html().convert_page_to_html(page).c_str();
+
+      THEN("Every cell is rendered inside its row") {
+        size_t first_row = html.find("left: 0px; top: 0px;");
+        size_t first_cell = html.find("left: 1px; top: 1px;");
+        size_t second_cell = html.find("left: 21px; top: 1px;");
+        size_t second_row = html.find("left: 0px; top: 10px;");
+        REQUIRE(first_row < first_cell);
+        REQUIRE(first_cell < second_cell);
+        REQUIRE(second_cell < second_row);
+        // Both cells and the first row close before the second row opens
+        std::string between = html.substr(second_cell, second_row - second_cell);
+        size_t closed = 0;
+        for (size_t pos = between.find("</div>"); pos != std::string::npos; pos = between.find("</div>", pos + 1)) {
+          ++closed;
+        }
+        REQUIRE(closed == 2);
+      }
+    }
+  }
+}
+
+SCENARIO("Containment scales with the number of regions", "[benchmark][layout][index]") {
+  for (int rows : {25, 50, 100, 200}) {
+    const int columns = 20;
+    auto page = table_page(rows, columns);
+    size_t count = page.sub_geometries.size();
+
+    std::vector<box> boxes;
+    for (size_t i = 0; i < count; ++i) {
+      boxes.push_back(flx_layout_index::bounds_of(page.sub_geometries[i]));
+    }
+
+    // Containers of every region: all pairs against the index
+    auto start = std::chrono::steady_clock::now();
+    size_t pairs = 0;
+    for (size_t i = 0; i < count; ++i) {
+      for (size_t j = 0; j < count; ++j) {
+        if (i != j && inside(boxes[i], boxes[j], 0.1)) ++pairs;
+      }
+    }
+    double brute_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    start = std::chrono::steady_clock::now();
+    flx_layout_index index(boxes);
+    size_t indexed_pairs = 0;
+    std::vector<size_t> found;
+    for (size_t i = 0; i < count; ++i) {
+      index.query_containing(boxes[i], found, 0.1);
+      indexed_pairs += found.size() - 1;
+    }
+    double index_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    start = std::chrono::steady_clock::now();
+    flx_string html = flx_layout_to_html().convert_page_to_html(page);
+    double html_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "⏱️  " << count << " regions: all pairs " << brute_ms << " ms, index " << index_ms
+              << " ms, HTML tree " << html_ms << " ms" << std::endl;
+
+    REQUIRE(indexed_pairs == pairs);
+    REQUIRE(html.size() > 0);
+  }
+}
@@ -0,0 +1,171 @@
+#include <catch2/catch_all.hpp>
+#include "../api/aimodels/flx_openai_api.h"
+#include "../aiprocesses/chat/flx_llm_chat.h"
+#include "../api/db/flx_embedding_cache.h"
+#include "shared/llm_stub_server.h"
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <thread>
+
+// ============================================================================
+// Offline throughput of LLM flows against the local stand-in server
+// (fixed server latency, so numbers measure our client-side overhead and
+// concurrency, not the model)
+// ============================================================================
+
+using namespace flx::llm;
+
+namespace {
+
+  class field_lookup_tool : public i_llm_function {
+  public:
+    flx_string get_name() const override { return "lookup_field"; }
+    flx_string get_description() const override { return "Returns the stored value of a document field"; }
+    flxv_map get_parameters() const override {
+      flxv_map field;
+      field["type"] = "string";
+      flxv_map properties;
+      properties["field"] = field;
+      flxv_map params;
+      params["type"] = "object";
+      params["properties"] = properties;
+      return params;
+    }
+    flx_string call(const flxv_map& in) override {
+      flxv_map args = in;
+      return args["field"].to_string() + "=4711";
+    }
+  };
+
+  llm_stub_server::reply tool_then_answer(const nlohmann::json& request) {
+    llm_stub_server::reply r;
+    if (request["messages"].back().value("role", "") == "tool") {
+      r.content = "The invoice number is 4711 and the document is complete.";
+    } else {
+      r.tool_calls.push_back({"lookup_field", "{\"field\":\"invoice_number\"}"});
+      r.tool_calls.push_back({"lookup_field", "{\"field\":\"total\"}"});
+    }
+    return r;
+  }
+
+  bool run_conversation(const std::shared_ptr<openai_api>& api, int index, bool stream) {
+    flx_llm_chat chat(api);
+    flxv_map settings;
+    settings["model"] = "stub-model";
+    chat.create_context(settings);
+    chat.register_function(std::make_shared<field_lookup_tool>());
+    flx_string answer;
+    flx_string question = "Check document " + flx_string(static_cast<long long>(index));
+    if (stream) {
+      return chat.chat(question, answer, [](const flx_string&) { return true; }) && !answer.empty();
+    }
+    return chat.chat(question, answer) && !answer.empty();
+  }
+
+  double run_conversations(const std::shared_ptr<openai_api>& api, int count, int threads, bool stream, int& succeeded) {
+    std::atomic<int> next{0};
+    std::atomic<int> ok{0};
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+      workers.emplace_back([&] {
+        for (int i = next++; i < count; i = next++) {
+          if (run_conversation(api, i, stream)) ++ok;
+        }
+      });
+    }
+    for (auto& w : workers) w.join();
+    succeeded = ok;
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  }
+
+}
+
+SCENARIO("Chat-with-tools throughput against the stand-in server", "[http][benchmark]") {
+  GIVEN("A stub with 20ms latency per request") {
+    llm_stub_server stub;
+    stub.set_responder(&tool_then_answer);
+    stub.set_latency(std::chrono::milliseconds(20), std::chrono::milliseconds(2));
+    flx_string base_url = start_llm_stub(stub, 18437, 16);
+    REQUIRE_FALSE(base_url.empty());
+    auto api = std::make_shared<openai_api>("test-key", base_url);
+    const int conversations = 24;
+
+    WHEN("Running conversations sequentially, concurrently and streamed") {
+      int ok_sequential = 0, ok_parallel = 0, ok_stream = 0;
+      double sequential = run_conversations(api, conversations, 1, false, ok_sequential);
+      double parallel = run_conversations(api, conversations, 8, false, ok_parallel);
+      double streamed = run_conversations(api, conversations, 8, true, ok_stream);
+
+      std::cout << "[llm benchmark] chat with 2 tool calls: "
+                << conversations / sequential << " conv/s sequential, "
+                << conversations / parallel << " conv/s with 8 threads, "
+                << conversations / streamed << " conv/s streamed" << std::endl;
+
+      THEN("All conversations complete and concurrency scales") {
+        REQUIRE(ok_sequential == conversations);
+        REQUIRE(ok_parallel == conversations);
+        REQUIRE(ok_stream == conversations);
+        REQUIRE(stub.chat_requests == 3 * 2 * conversations);
+        REQUIRE(parallel < sequential / 2);
+      }
+    }
+  }
+}
+
+SCENARIO("Embed-then-save throughput against the stand-in server", "[http][benchmark]") {
+  GIVEN("A stub with 20ms latency and a file-backed embedding cache") {
+    llm_stub_server stub;
+    stub.set_latency(std::chrono::milliseconds(20));
+    stub.set_embedding_dimensions(1536);
+    flx_string base_url = start_llm_stub(stub, 18438, 8);
+    REQUIRE_FALSE(base_url.empty());
+    auto api = std::make_shared<openai_api>("test-key", base_url);
+
+    std::filesystem::path dir = std::filesystem::temp_directory_path() / "flx_llm_benchmark_cache";
+    std::filesystem::remove_all(dir);
+    flx_embedding_file_store store(dir.string());
+    flx_embedding_cache cache(4096, &store);
+
+    std::vector<flx_string> texts;
+    for (int i = 0; i < 1000; ++i) {
+      texts.push_back("Rechnung " + flx_string(static_cast<long long>(i)) + " Position Menge Einzelpreis Gesamtpreis");
+    }
+
+    WHEN("Embedding all texts in batches and saving them, then repeating through the cache") {
+      auto start = std::chrono::steady_clock::now();
+      size_t saved = 0;
+      for (size_t offset = 0; offset < texts.size(); offset += 250) {
+        std::vector<flx_string> batch(texts.begin() + offset, texts.begin() + std::min(texts.size(), offset + 250));
+        std::vector<std::vector<float>> embeddings;
+        REQUIRE(api->embedding_batch(batch, embeddings));
+        for (size_t i = 0; i < batch.size(); ++i) {
+          cache.put(flx_embedding_cache::make_key(api->get_embedding_model(), batch[i]), embeddings[i]);
+          ++saved;
+        }
+      }
+      double cold = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+      flx_embedding_cache warm_cache(4096, &store);
+      start = std::chrono::steady_clock::now();
+      size_t hits = 0;
+      for (const auto& text : texts) {
+        std::vector<float> embedding;
+        if (warm_cache.get(flx_embedding_cache::make_key(api->get_embedding_model(), text), embedding)) ++hits;
+      }
+      double warm = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+      std::cout << "[llm benchmark] embed-then-save: " << texts.size() / cold << " texts/s via API, "
+                << texts.size() / warm << " texts/s from the store" << std::endl;
+
+      THEN("Four API requests cover all texts and every embedding is found again") {
+        REQUIRE(saved == texts.size());
+        REQUIRE(stub.embedding_requests == 4);
+        REQUIRE(stub.embedded_inputs == texts.size());
+        REQUIRE(hits == texts.size());
+      }
+    }
+    std::filesystem::remove_all(dir);
+  }
+}
@@ -0,0 +1,258 @@
+#include <catch2/catch_all.hpp>
+#include "../aiprocesses/chat/flx_llm_context_window.h"
+#include <api/json/flx_json.h>
+#include <chrono>
+#include <iostream>
+
+// ============================================================================
+// context_window - token budget, truncation policies, cached message JSON
+// ============================================================================
+
+using namespace flx::llm;
+
+namespace {
+
+  class plain_message : public i_llm_message {
+    message_role role;
+    flxv_map data;
+  public:
+    plain_message(message_role r, flxv_map d) : role(r), data(std::move(d)) {}
+    message_role get_role() const noexcept override { return role; }
+    const flx_string& get_content() const override { return data.at("content").string_value(); }
+    void set_role(message_role r) override { role = r; }
+    void set_content(const flx_string& content) override { data["content"] = content; }
+    const flxv_map& get_data() const noexcept override { return data; }
+    std::unique_ptr<i_llm_message> clone() const override { return std::make_unique<plain_message>(role, data); }
+  };
+
+  const char* role_name(message_role role) {
+    switch (role) {
+      case message_role::SYSTEM: return "system";
+      case message_role::USER: return "user";
+      case message_role::ASSISTANT: return "assistant";
+      default: return "tool";
+    }
+  }
+
+  std::unique_ptr<i_llm_message> make_message(message_role role, const flx_string& content) {
+    flxv_map data;
+    data["role"] = role_name(role);
+    data["content"] = content;
+    return std::make_unique<plain_message>(role, data);
+  }
+
+  std::unique_ptr<i_llm_message> make_tool_call(const flx_string& id) {
+    flxv_map function;
+    function["name"] = "search";
+    function["arguments"] = "{\"query\":\"invoice totals\"}";
+    flxv_map call;
+    call["id"] = id;
+    call["type"] = "function";
+    call["function"] = function;
+    flxv_vector calls;
+    calls.push_back(call);
+    flxv_map data;
+    data["role"] = "assistant";
+    data["tool_calls"] = calls;
+    return std::make_unique<plain_message>(message_role::ASSISTANT, data);
+  }
+
+  std::unique_ptr<i_llm_message> make_tool_result(const flx_string& id, const flx_string& content) {
+    flxv_map data;
+    data["role"] = "tool";
+    data["tool_call_id"] = id;
+    data["content"] = content;
+    return std::make_unique<plain_message>(message_role::TOOL, data);
+  }
+
+  flx_string filler(int words) {
+    flx_string text;
+    for (int i = 0; i < words; ++i) {
+      text += i ? " lorem" : "lorem";
+    }
+    return text;
+  }
+
+  // Reference: serialize the whole history the way requests used to
+  flx_string full_json(const context_window& window) {
+    flxv_vector messages;
+    for (const auto& m : window.get_messages()) {
+      messages.push_back(m->get_data());
+    }
+    flxv_map body;
+    body["messages"] = messages;
+    flx_json json(&body);
+    flx_string s = json.create();
+    return s.substr(12, s.length() - 13);  // strip {"messages": ... }
+  }
+
+  flx_string window_json(const context_window& window) {
+    flx_string out;
+    window.append_messages_json(out);
+    return out;
+  }
+
+}
+
+SCENARIO("estimate_tokens approximates BPE token counts", "[unit][pure]") {
+  REQUIRE(estimate_tokens("") == 0);
+  REQUIRE(estimate_tokens("hello world") == 2);
+  REQUIRE(estimate_tokens("2024") == 2);
+  REQUIRE(estimate_tokens("a, b.") == 4);
+  // English prose: roughly 1.1-1.4 tokens per word
+  size_t tokens = estimate_tokens("The quick brown fox jumps over the lazy dog and keeps running through the field.");
+  REQUIRE(tokens >= 16);
+  REQUIRE(tokens <= 20);
+}
+
+SCENARIO("context_window keeps message JSON cached", "[unit][pure]") {
+  GIVEN("A window with a system prompt and a few turns") {
+    context_window window(make_message);
+    window.add(make_message(message_role::SYSTEM, "You are helpful."));
+    window.add(make_message(message_role::USER, "Find invoices"));
+    window.add(make_tool_call("call_1"));
+    window.add(make_tool_result("call_1", "3 invoices"));
+
+    THEN("The joined JSON equals a full serialization, also after appending and removing") {
+      REQUIRE(window_json(window) == full_json(window));
+      window.add(make_message(message_role::ASSISTANT, "Found 3 \"invoices\"."));
+      REQUIRE(window_json(window) == full_json(window));
+      window.erase(1, 2);
+      REQUIRE(window_json(window) == full_json(window));
+      window.replace(0, make_message(message_role::SYSTEM, "New prompt"));
+      REQUIRE(window_json(window) == full_json(window));
+      REQUIRE(window.size() == 4);
+    }
+
+    THEN("Token totals follow the messages") {
+      size_t sum = 0;
+      for (size_t i = 0; i < window.size(); ++i) sum += window.get_tokens(i);
+      REQUIRE(window.total_tokens() == sum);
+      window.erase(2, 4);
+      REQUIRE(window.total_tokens() == window.get_tokens(0) + window.get_tokens(1));
+    }
+
+    THEN("Message ids stay with their message and replacements get new ones") {
+      unsigned long long tool_result = window.get_id(3);
+      window.erase(1, 3);
+      REQUIRE(window.get_id(1) == tool_result);
+      window.replace(0, make_message(message_role::SYSTEM, "New prompt"));
+      REQUIRE(window.get_id(0) > tool_result);
+      window.add(make_message(message_role::USER, "More"));
+      REQUIRE(window.get_id(2) > window.get_id(0));
+    }
+
+    THEN("Clones share nothing but content") {
+      context_window copy;
+      copy.assign_clone(window);
+      REQUIRE(copy.total_tokens() == window.total_tokens());
+      REQUIRE(window_json(copy) == window_json(window));
+      copy.erase(1, 2);
+      REQUIRE(window.size() == 4);
+    }
+  }
+}
+
+SCENARIO("context_window enforces its token budget", "[unit][pure]") {
+  auto build = [](context_window& window) {
+    window.add(make_message(message_role::SYSTEM, "System prompt"));
+    for (int turn = 0; turn < 10; ++turn) {
+      flx_string id = flx_string("call_") + flx_string(static_cast<long long>(turn));
+      window.add(make_message(message_role::USER, filler(40)));
+      window.add(make_tool_call(id));
+      window.add(make_tool_result(id, filler(40)));
+      window.add(make_message(message_role::ASSISTANT, filler(40)));
+    }
+    window.add(make_message(message_role::USER, "Current question"));
+  };
+
+  GIVEN("Ten turns with tool calls and a budget of a quarter of that") {
+    context_window window(make_message);
+    build(window);
+    size_t full = window.total_tokens();
+    window.set_budget(full / 4);
+
+    WHEN("Fitting with the default drop-oldest policy") {
+      REQUIRE(window.fit());
+
+      THEN("Old groups are gone, system prompt and current turn stay, no orphaned tool results") {
+        REQUIRE(window.total_tokens() <= full / 4);
+        REQUIRE(window.get_messages().front()->get_role() == message_role::SYSTEM);
+        REQUIRE(window.get_messages().back()->get_content() == "Current question");
+        for (size_t i = 0; i < window.size(); ++i) {
+          if (window.get_messages()[i]->get_role() == message_role::TOOL) {
+            REQUIRE(window.get_messages()[i - 1]->get_data().count("tool_calls") == 1);
+          }
+        }
+        REQUIRE(window_json(window) == full_json(window));
+      }
+    }
+
+    WHEN("Extra tokens (tool schemas) exceed the budget") {
+      bool fits = window.fit(full);
+
+      THEN("Only the protected messages remain and fit reports failure") {
+        REQUIRE_FALSE(fits);
+        REQUIRE(window.size() == 2);
+      }
+    }
+  }
+
+  GIVEN("The same history with a summarizing policy") {
+    context_window window(make_message);
+    build(window);
+    size_t full = window.total_tokens();
+    window.set_budget(full / 2);
+    size_t summarized = 0;
+    window.set_policy(std::make_shared<summarize_policy>([&summarized](const std::vector<const i_llm_message*>& messages) {
+      summarized = messages.size();
+      return flx_string("The user asked about lorem several times.");
+    }));
+
+    WHEN("Fitting") {
+      REQUIRE(window.fit());
+
+      THEN("The oldest messages are replaced by one summary with room to spare") {
+        REQUIRE(summarized > 0);
+        REQUIRE(window.get_messages()[2]->get_role() != message_role::TOOL);
+        REQUIRE(window.get_messages()[1]->get_role() == message_role::SYSTEM);
+        REQUIRE(window.get_messages()[1]->get_content().contains("several times"));
+        REQUIRE(window.total_tokens() <= full / 2 - full / 8);
+        REQUIRE(window.get_messages().back()->get_content() == "Current question");
+      }
+    }
+  }
+}
+
+SCENARIO("context_window makes request building incremental", "[unit][benchmark]") {
+  GIVEN("A growing conversation of 300 turns") {
+    context_window window(make_message);
+    window.add(make_message(message_role::SYSTEM, "System prompt"));
+    double cached_ms = 0;
+    double full_ms = 0;
+    size_t cached_bytes = 0;
+    size_t full_bytes = 0;
+
+    WHEN("Building the messages JSON on every turn") {
+      for (int turn = 0; turn < 300; ++turn) {
+        window.add(make_message(message_role::USER, filler(30)));
+        window.add(make_message(message_role::ASSISTANT, filler(60)));
+
+        auto start = std::chrono::steady_clock::now();
+        cached_bytes += window_json(window).length();
+        auto mid = std::chrono::steady_clock::now();
+        full_bytes += full_json(window).length();
+        auto end = std::chrono::steady_clock::now();
+        cached_ms += std::chrono::duration<double, std::milli>(mid - start).count();
+        full_ms += std::chrono::duration<double, std::milli>(end - mid).count();
+      }
+      std::cout << "[context window] 300 turns: full serialization " << full_ms
+                << " ms, cached fragments " << cached_ms << " ms" << std::endl;
+
+      THEN("The cached path produces the same bytes much faster") {
+        REQUIRE(cached_bytes == full_bytes);
+        REQUIRE(cached_ms * 5 < full_ms);
+      }
+    }
+  }
+}
@@ -0,0 +1,199 @@
+#include <catch2/catch_all.hpp>
+#include "../api/client/flx_http_request.h"
+#include "../api/client/flx_sse_parser.h"
+#include "../api/aimodels/flx_openai_api.h"
+#include "shared/http_test_server.h"
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+// ============================================================================
+// SSE streaming of chat completions (parser, chunk assembly, local stream server)
+// ============================================================================
+
+using namespace flx::llm;
+
+SCENARIO("flx_sse_parser handles arbitrarily split streams", "[unit][pure]") {
+  GIVEN("A stream with CRLF line endings, comments and multi-line data") {
+    const std::string stream =
+      ": keep-alive\r\n"
+      "data: {\"a\":1}\r\n"
+      "\r\n"
+      "event: update\n"
+      "id: 7\n"
+      "data: line one\n"
+      "data: line two\n"
+      "\n"
+      "data: [DONE]\r\r";
+
+    WHEN("Feeding it split at every possible position") {
+      THEN("The same three events come out every time") {
+        for (size_t split = 0; split <= stream.size(); ++split) {
+          std::vector<flx_sse_parser::event> events;
+          flx_sse_parser parser([&events](const flx_sse_parser::event& ev) {
+            events.push_back(ev);
+            return true;
+          });
+          REQUIRE(parser.feed(stream.data(), split));
+          REQUIRE(parser.feed(stream.data() + split, stream.size() - split));
+
+          REQUIRE(events.size() == 3);
+          REQUIRE(events[0].type == "message");
+          REQUIRE(events[0].data == "{\"a\":1}");
+          REQUIRE(events[1].type == "update");
+          REQUIRE(events[1].id == "7");
+          REQUIRE(events[1].data == "line one\nline two");
+          REQUIRE(events[2].data == "[DONE]");
+        }
+      }
+    }
+
+    WHEN("The callback stops after the first event") {
+      int count = 0;
+      flx_sse_parser parser([&count](const flx_sse_parser::event&) {
+        ++count;
+        return false;
+      });
+      bool result = parser.feed(stream.data(), stream.size());
+
+      THEN("Parsing ends and further input is rejected") {
+        REQUIRE_FALSE(result);
+        REQUIRE(count == 1);
+        REQUIRE_FALSE(parser.feed("data: x\n\n", 9));
+      }
+    }
+  }
+}
+
+SCENARIO("openai_stream_assembler rebuilds messages from chunks", "[unit][pure]") {
+  GIVEN("Content deltas") {
+    openai_stream_assembler assembler;
+    std::vector<flx_string> deltas;
+    auto on_delta = [&deltas](const flx_string& d) { deltas.push_back(d); return true; };
+
+    REQUIRE(assembler.add_chunk("{\"choices\":[{\"index\":0,\"delta\":{\"role\":\"assistant\",\"content\":\"\"}}]}", on_delta));
+    REQUIRE(assembler.add_chunk("{\"choices\":[{\"index\":0,\"delta\":{\"content\":\"Hel\"}}]}", on_delta));
+    REQUIRE(assembler.add_chunk("{\"choices\":[{\"index\":0,\"delta\":{\"content\":\"lo\"}}]}", on_delta));
+    REQUIRE(assembler.add_chunk("{\"choices\":[{\"index\":0,\"delta\":{},\"finish_reason\":\"stop\"}]}", on_delta));
+    REQUIRE(assembler.add_chunk("[DONE]", on_delta));
+
+    THEN("Deltas are forwarded and the message holds the full text") {
+      REQUIRE(deltas.size() == 2);
+      REQUIRE(deltas[0] == "Hel");
+      REQUIRE(assembler.is_done());
+      REQUIRE(assembler.get_finish_reason() == "stop");
+      flxv_map message = assembler.get_message();
+      REQUIRE(message["role"].to_string() == "assistant");
+      REQUIRE(message["content"].to_string() == "Hello");
+      REQUIRE(message.count("tool_calls") == 0);
+    }
+  }
+
+  GIVEN("Two tool calls whose arguments arrive in pieces") {
+    openai_stream_assembler assembler;
+    i_llm_api::delta_callback none;
+    REQUIRE(assembler.add_chunk("{\"choices\":[{\"delta\":{\"tool_calls\":[{\"index\":0,\"id\":\"call_a\",\"type\":\"function\",\"function\":{\"name\":\"search\",\"arguments\":\"\"}}]}}]}", none));
+    REQUIRE(assembler.add_chunk("{\"choices\":[{\"delta\":{\"tool_calls\":[{\"index\":0,\"function\":{\"arguments\":\"{\\\"q\\\":\"}}]}}]}", none));
+    REQUIRE(assembler.add_chunk("{\"choices\":[{\"delta\":{\"tool_calls\":[{\"index\":1,\"id\":\"call_b\",\"type\":\"function\",\"function\":{\"name\":\"extract\",\"arguments\":\"{}\"}}]}}]}", none));
+    REQUIRE(assembler.add_chunk("{\"choices\":[{\"delta\":{\"tool_calls\":[{\"index\":0,\"function\":{\"arguments\":\"\\\"pdf\\\"}\"}}]}}]}", none));
+    REQUIRE(assembler.add_chunk("[DONE]", none));
+
+    THEN("The calls are assembled in index order") {
+      flxv_map message = assembler.get_message();
+      REQUIRE(message["content"].is_null());
+      REQUIRE(message["tool_calls"].is_vector());
+      flxv_vector& calls = message["tool_calls"].to_vector();
+      REQUIRE(calls.size() == 2);
+      REQUIRE(calls[0].to_map()["id"].to_string() == "call_a");
+      REQUIRE(calls[0].to_map()["function"].to_map()["name"].to_string() == "search");
+      REQUIRE(calls[0].to_map()["function"].to_map()["arguments"].to_string() == "{\"q\":\"pdf\"}");
+      REQUIRE(calls[1].to_map()["function"].to_map()["name"].to_string() == "extract");
+    }
+  }
+
+  GIVEN("An error chunk") {
+    openai_stream_assembler assembler;
+    REQUIRE(assembler.add_chunk("{\"error\":{\"message\":\"rate limited\"}}", nullptr));
+
+    THEN("The error is recorded and the stream is finished") {
+      REQUIRE(assembler.has_error());
+      REQUIRE(assembler.get_error() == "rate limited");
+      REQUIRE(assembler.is_done());
+    }
+  }
+}
+
+SCENARIO("Streamed completions arrive token by token", "[http][benchmark]") {
+  GIVEN("A local stand-in server streaming ten chunks 30ms apart") {
+    http_test_server server([](const flx_http_daemon::request&) {
+      flx_http_daemon::response r;
+      r.statuscode = 200;
+      r.headers["Content-Type"] = "text/event-stream";
+      r.stream = [](flx_http_daemon::stream_writer& out) {
+        for (int i = 0; i < 10; ++i) {
+          std::this_thread::sleep_for(std::chrono::milliseconds(30));
+          flx_string chunk = flx_string("data: {\"choices\":[{\"index\":0,\"delta\":{\"content\":\"t")
+            + flx_string(static_cast<long long>(i)) + " \"}}]}\n\n";
+          if (!out.write(chunk)) return;
+        }
+        out.write("data: [DONE]\n\n");
+      };
+      return r;
+    });
+    flx_string base_url = start_test_server(server, 18435, 4);
+    REQUIRE_FALSE(base_url.empty());
+
+    WHEN("Reading the stream through flx_http_request and flx_sse_parser") {
+      openai_stream_assembler assembler;
+      std::vector<double> arrivals;
+      auto start = std::chrono::steady_clock::now();
+      auto on_delta = [&](const flx_string&) {
+        arrivals.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+        return true;
+      };
+      flx_sse_parser parser([&](const flx_sse_parser::event& ev) {
+        return assembler.add_chunk(ev.data, on_delta);
+      });
+
+      flx_http_request request(base_url + "/v1/chat/completions");
+      request.set_verify_peer(false);
+      request.set_timeout_ms(10000);
+      request.set_stream_callback([&parser](const char* data, size_t size) {
+        return parser.feed(data, size);
+      });
+      bool sent = request.send();
+      double total = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+      std::cout << "[streaming] first token " << (arrivals.empty() ? -1.0 : arrivals.front())
+                << " ms, complete " << total << " ms" << std::endl;
+
+      THEN("The first token arrives long before the response is complete") {
+        REQUIRE(sent);
+        REQUIRE(request.get_status_code() == 200);
+        REQUIRE(assembler.is_done());
+        REQUIRE(arrivals.size() == 10);
+        REQUIRE(arrivals.front() < total / 2);
+        REQUIRE(assembler.get_message()["content"].to_string() == "t0 t1 t2 t3 t4 t5 t6 t7 t8 t9 ");
+      }
+    }
+
+    WHEN("The consumer stops after the third token") {
+      int received = 0;
+      flx_sse_parser parser([&](const flx_sse_parser::event&) {
+        return ++received < 3;
+      });
+      flx_http_request request(base_url + "/v1/chat/completions");
+      request.set_verify_peer(false);
+      request.set_stream_callback([&parser](const char* data, size_t size) {
+        return parser.feed(data, size);
+      });
+      bool sent = request.send();
+
+      THEN("The transfer is aborted without retries") {
+        REQUIRE_FALSE(sent);
+        REQUIRE(received == 3);
+        REQUIRE(request.get_error_message().contains("aborted"));
+      }
+    }
+  }
+}
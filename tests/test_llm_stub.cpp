@@ -0,0 +1,160 @@
+#include <catch2/catch_all.hpp>
+#include "../api/aimodels/flx_openai_api.h"
+#include "../aiprocesses/chat/flx_llm_chat.h"
+#include "shared/llm_stub_server.h"
+#include <cmath>
+
+// ============================================================================
+// openai_api against the local stand-in server (no network, no API key)
+// ============================================================================
+
+using namespace flx::llm;
+
+namespace {
+
+  class lookup_tool : public i_llm_function {
+  public:
+    flx_string get_name() const override { return "lookup_invoice"; }
+    flx_string get_description() const override { return "Looks up an invoice by number"; }
+    flxv_map get_parameters() const override {
+      flxv_map number;
+      number["type"] = "string";
+      flxv_map properties;
+      properties["number"] = number;
+      flxv_map params;
+      params["type"] = "object";
+      params["properties"] = properties;
+      return params;
+    }
+    flx_string call(const flxv_map& in) override {
+      flxv_map args = in;
+      return "invoice " + args["number"].to_string() + " total 42.00";
+    }
+  };
+
+  // First turn: call lookup_invoice, after the tool result: answer
+  llm_stub_server::reply tool_then_answer(const nlohmann::json& request) {
+    llm_stub_server::reply r;
+    if (request["messages"].back().value("role", "") == "tool") {
+      r.content = "The total is 42.00.";
+    } else {
+      r.tool_calls.push_back({"lookup_invoice", "{\"number\":\"R-1001\"}"});
+    }
+    return r;
+  }
+
+  flxv_map chat_settings() {
+    flxv_map settings;
+    settings["model"] = "stub-model";
+    return settings;
+  }
+
+}
+
+SCENARIO("openai_api talks to the local stand-in server", "[http]") {
+  GIVEN("A stub server and an API pointed at it") {
+    llm_stub_server stub;
+    stub.set_responder(&tool_then_answer);
+    flx_string base_url = start_llm_stub(stub, 18436);
+    REQUIRE_FALSE(base_url.empty());
+    auto api = std::make_shared<openai_api>("test-key", base_url);
+    REQUIRE(api->get_base_url() == base_url);
+
+    WHEN("Running a chat with a tool") {
+      flx_llm_chat chat(api);
+      chat.create_context(chat_settings());
+      chat.register_function(std::make_shared<lookup_tool>());
+      flx_string answer;
+      REQUIRE(chat.chat("What is the total of R-1001?", answer));
+
+      THEN("The tool round trip and the final answer go through the stub") {
+        REQUIRE(answer == "The total is 42.00.");
+        REQUIRE(stub.chat_requests == 2);
+      }
+    }
+
+    WHEN("Running the same chat streamed") {
+      flx_llm_chat chat(api);
+      chat.create_context(chat_settings());
+      chat.register_function(std::make_shared<lookup_tool>());
+      std::vector<flx_string> deltas;
+      flx_string answer;
+      REQUIRE(chat.chat("What is the total of R-1001?", answer, [&deltas](const flx_string& delta) {
+        deltas.push_back(delta);
+        return true;
+      }));
+
+      THEN("Tool calls are assembled from chunks and the answer arrives word by word") {
+        REQUIRE(answer == "The total is 42.00.");
+        REQUIRE(stub.stream_requests == 2);
+        REQUIRE(deltas.size() == 4);
+        REQUIRE(deltas[0] == "The");
+      }
+    }
+
+    WHEN("Embedding texts") {
+      std::vector<flx_string> texts = {"Rechnung R-1001", "Lieferschein L-7", "Rechnung R-1001"};
+      std::vector<std::vector<float>> embeddings;
+      REQUIRE(api->embedding_batch(texts, embeddings));
+
+      THEN("Embeddings are deterministic unit vectors") {
+        REQUIRE(embeddings.size() == 3);
+        REQUIRE(embeddings[0].size() == 256);
+        REQUIRE(embeddings[0] == embeddings[2]);
+        REQUIRE(embeddings[0] != embeddings[1]);
+        REQUIRE(embeddings[1] == llm_stub_server::deterministic_embedding("Lieferschein L-7", 256));
+        double norm = 0;
+        for (float v : embeddings[0]) norm += static_cast<double>(v) * v;
+        REQUIRE(std::fabs(norm - 1.0) < 1e-4);
+      }
+    }
+
+    WHEN("Embedding a text above the chunk limit") {
+      long_text_options options;
+      options.chunk_tokens = 100;
+      options.overlap_tokens = 10;
+      api->set_long_text_options(options);
+      flx_string long_text = flx_string("Leistungsverzeichnis Position Menge Einheit. ").repeat(40);
+      std::vector<std::vector<float>> embeddings;
+      REQUIRE(api->embedding_batch({"kurz", long_text}, embeddings));
+
+      THEN("Its chunks are embedded in the same request and pooled into one unit vector") {
+        REQUIRE(embeddings.size() == 2);
+        REQUIRE(stub.embedding_requests == 1);
+        REQUIRE(stub.embedded_inputs == 1 + split_into_chunks(long_text, options).size());
+        REQUIRE(embeddings[0] == llm_stub_server::deterministic_embedding("kurz", 256));
+        double norm = 0;
+        for (float v : embeddings[1]) norm += static_cast<double>(v) * v;
+        REQUIRE(std::fabs(norm - 1.0) < 1e-4);
+      }
+    }
+
+    WHEN("The server fails once") {
+      stub.set_responder(&llm_stub_server::echo_responder);
+      stub.fail_next(1);
+      auto context = api->create_chat_context();
+      context->set_settings(chat_settings());
+      context->add_message(api->create_message(message_role::USER, flx_string("ping")));
+      auto reply = api->generate_response(*context);
+
+      THEN("The request is retried") {
+        REQUIRE(reply != nullptr);
+        REQUIRE(reply->get_content() == "stub reply: ping");
+        REQUIRE(stub.failed_requests == 1);
+      }
+    }
+
+    WHEN("The server keeps failing") {
+      stub.fail_next(10, 500);
+      auto context = api->create_chat_context();
+      context->set_settings(chat_settings());
+      context->add_message(api->create_message(message_role::USER, flx_string("ping")));
+      auto reply = api->generate_response(*context);
+
+      THEN("The error is reported after the retries") {
+        REQUIRE(reply == nullptr);
+        REQUIRE(stub.failed_requests == 3);
+      }
+    }
+  }
+}
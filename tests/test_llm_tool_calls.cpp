@@ -0,0 +1,306 @@
+#include <catch2/catch_all.hpp>
+#include "../aiprocesses/chat/flx_llm_chat.h"
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <iostream>
+#include <thread>
+
+// ============================================================================
+// flx_llm_chat tool-call execution against a mock API (no network)
+// ============================================================================
+
+using namespace flx::llm;
+
+namespace {
+
+  class mock_message : public i_llm_message {
+    message_role role;
+    flxv_map data;
+  public:
+    mock_message(message_role r, flxv_map d) : role(r), data(std::move(d)) {}
+    message_role get_role() const noexcept override { return role; }
+    const flx_string& get_content() const override { return data.at("content").string_value(); }
+    void set_role(message_role r) override { role = r; }
+    void set_content(const flx_string& content) override { data["content"] = content; }
+    const flxv_map& get_data() const noexcept override { return data; }
+    std::unique_ptr<i_llm_message> clone() const override { return std::make_unique<mock_message>(role, data); }
+  };
+
+  class mock_context : public i_llm_chat_context {
+  public:
+    std::vector<std::unique_ptr<i_llm_message>> messages;
+    void replace_system_message(const flx_string&) override {}
+    void set_settings(const flxv_map&) override {}
+    void add_message(std::unique_ptr<i_llm_message> message) override { messages.push_back(std::move(message)); }
+    const std::vector<std::unique_ptr<i_llm_message>>& get_messages() const noexcept override { return messages; }
+    std::unique_ptr<i_llm_chat_context> clone() const override { return std::make_unique<mock_context>(); }
+  };
+
+  // One tool call per name in each tool turn, then the final answer
+  class mock_tool_api : public i_llm_api {
+    std::vector<std::vector<flx_string>> tool_turns;
+    size_t turn = 0;
+  public:
+    explicit mock_tool_api(std::vector<flx_string> tool_names) : tool_turns{std::move(tool_names)} {}
+    explicit mock_tool_api(std::vector<std::vector<flx_string>> turns) : tool_turns(std::move(turns)) {}
+
+    std::unique_ptr<i_llm_chat_context> create_chat_context() override { return std::make_unique<mock_context>(); }
+    std::unique_ptr<i_llm_message> create_message(message_role role, flx_variant content) override {
+      flxv_map data;
+      data["content"] = content;
+      return std::make_unique<mock_message>(role, data);
+    }
+    std::unique_ptr<i_llm_message> create_message(flxv_map& data) override {
+      return std::make_unique<mock_message>(message_role::TOOL, data);
+    }
+
+    std::unique_ptr<i_llm_message> generate_response(i_llm_chat_context&, const std::vector<i_llm_function*>*) override {
+      flxv_map data;
+      data["role"] = "assistant";
+      if (turn < tool_turns.size()) {
+        const std::vector<flx_string>& tools = tool_turns[turn++];
+        flxv_vector calls;
+        for (size_t i = 0; i < tools.size(); ++i) {
+          flxv_map function;
+          function["name"] = tools[i];
+          function["arguments"] = flx_string("{\"n\":") + flx_string(static_cast<long long>(i)) + "}";
+          flxv_map call;
+          call["id"] = flx_string("call_") + flx_string(static_cast<long long>(i));
+          call["type"] = "function";
+          call["function"] = function;
+          calls.push_back(call);
+        }
+        data["tool_calls"] = calls;
+      } else {
+        data["content"] = "done";
+      }
+      return std::make_unique<mock_message>(message_role::ASSISTANT, data);
+    }
+
+    bool embedding(const flx_string&, flxv_vector&) override { return false; }
+  };
+
+  // Sleeps for a fixed time (checking for cancellation) and echoes its argument
+  class sleeping_tool : public i_llm_function {
+    flx_string name;
+    std::chrono::milliseconds duration;
+  public:
+    std::atomic<bool> saw_cancel{false};
+    bool parallel = true;
+    // Shared by the tools of one test: how many of them run right now
+    std::atomic<int>* running = nullptr;
+    std::atomic<bool> overlapped{false};
+
+    sleeping_tool(flx_string n, std::chrono::milliseconds d) : name(std::move(n)), duration(d) {}
+    flx_string get_name() const override { return name; }
+    flx_string get_description() const override { return "sleeps"; }
+    flxv_map get_parameters() const override { return flxv_map(); }
+    bool allows_parallel() const override { return parallel; }
+    flx_string call(const flxv_map& in) override {
+      return call_cancellable(in, cancellation_token());
+    }
+    flx_string call_cancellable(const flxv_map& in, const cancellation_token& token) override {
+      if (running) ++*running;
+      auto end = std::chrono::steady_clock::now() + duration;
+      while (std::chrono::steady_clock::now() < end) {
+        // Counted before the token: a cancelled call may overlap the next ones
+        if (!parallel && running && *running > 1 && !token.is_cancelled()) overlapped = true;
+        if (token.is_cancelled()) {
+          saw_cancel = true;
+          if (running) --*running;
+          return "cancelled";
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+      }
+      if (running) --*running;
+      flxv_map args = in;
+      return name + ":" + flx_string(static_cast<long long>(args["n"].to_int()));
+    }
+  };
+
+  // Blocks until the gate opens and ignores cancellation, like a tool stuck in I/O
+  class hanging_tool : public i_llm_function {
+    flx_string name;
+    std::shared_future<void> gate;
+  public:
+    std::atomic<int> calls{0};
+
+    hanging_tool(flx_string n, std::shared_future<void> g) : name(std::move(n)), gate(std::move(g)) {}
+    flx_string get_name() const override { return name; }
+    flx_string get_description() const override { return "hangs"; }
+    flxv_map get_parameters() const override { return flxv_map(); }
+    flx_string call(const flxv_map&) override {
+      ++calls;
+      gate.wait();
+      return name;
+    }
+  };
+
+  struct chat_run {
+    double ms = 0;
+    std::vector<flxv_map> tool_messages;
+  };
+
+  chat_run run_chat(std::vector<std::shared_ptr<sleeping_tool>> tools, size_t max_parallel,
+                    std::chrono::milliseconds timeout) {
+    std::vector<flx_string> names;
+    for (auto& t : tools) names.push_back(t->get_name());
+
+    auto api = std::make_shared<mock_tool_api>(names);
+    flx_llm_chat chat(api);
+    chat.create_context(flxv_map());
+    auto context = std::make_unique<mock_context>();
+    mock_context* raw = context.get();
+    chat.set_context(std::move(context));
+    for (auto& t : tools) chat.register_function(t);
+    chat.set_tool_execution(max_parallel, timeout);
+
+    flx_string response;
+    auto start = std::chrono::steady_clock::now();
+    REQUIRE(chat.chat("go", response));
+    auto end = std::chrono::steady_clock::now();
+    REQUIRE(response == "done");
+
+    chat_run run;
+    run.ms = std::chrono::duration<double, std::milli>(end - start).count();
+    for (auto& m : raw->messages) {
+      if (m->get_data().count("tool_call_id")) run.tool_messages.push_back(m->get_data());
+    }
+    return run;
+  }
+
+}
+
+SCENARIO("flx_llm_chat runs the tool calls of one turn concurrently", "[unit][llm]") {
+  GIVEN("Four tools that take 150ms each") {
+    auto make_tools = [] {
+      std::vector<std::shared_ptr<sleeping_tool>> tools;
+      for (const char* n : {"search_a", "search_b", "extract_c", "extract_d"}) {
+        tools.push_back(std::make_shared<sleeping_tool>(n, std::chrono::milliseconds(150)));
+      }
+      return tools;
+    };
+
+    WHEN("Running sequentially and with four workers") {
+      auto sequential = run_chat(make_tools(), 1, std::chrono::milliseconds(0));
+      auto parallel = run_chat(make_tools(), 4, std::chrono::milliseconds(5000));
+      std::cout << "[tool calls] sequential " << sequential.ms << " ms, parallel " << parallel.ms << " ms" << std::endl;
+
+      THEN("Results keep the call order and wall-clock time drops") {
+        for (auto* run : {&sequential, &parallel}) {
+          REQUIRE(run->tool_messages.size() == 4);
+          const char* expected[] = {"search_a:0", "search_b:1", "extract_c:2", "extract_d:3"};
+          for (size_t i = 0; i < 4; ++i) {
+            REQUIRE(run->tool_messages[i]["tool_call_id"].to_string() == flx_string("call_") + flx_string(static_cast<long long>(i)));
+            REQUIRE(run->tool_messages[i]["content"].to_string() == expected[i]);
+          }
+        }
+        REQUIRE(sequential.ms >= 600);
+        REQUIRE(parallel.ms < sequential.ms / 2);
+      }
+    }
+  }
+
+  GIVEN("A tool that exceeds the timeout next to a fast one") {
+    auto slow = std::make_shared<sleeping_tool>("slow", std::chrono::milliseconds(2000));
+    auto fast = std::make_shared<sleeping_tool>("fast", std::chrono::milliseconds(10));
+
+    WHEN("Running with a 100ms per-tool timeout") {
+      auto run = run_chat({slow, fast}, 4, std::chrono::milliseconds(100));
+
+      THEN("The slow tool is reported as timed out and cancelled") {
+        REQUIRE(run.ms < 1000);
+        REQUIRE(run.tool_messages.size() == 2);
+        REQUIRE(run.tool_messages[0]["content"].to_string().contains("timed out"));
+        REQUIRE(run.tool_messages[1]["content"].to_string() == "fast:1");
+        // The abandoned worker is not joined; it sees the cancellation shortly after
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+        while (!slow->saw_cancel && std::chrono::steady_clock::now() < deadline) {
+          std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        REQUIRE(slow->saw_cancel);
+      }
+    }
+  }
+
+  GIVEN("Two tools that do not allow parallel calls between two that do") {
+    std::atomic<int> running{0};
+    auto make = [&running](const char* n, int ms, bool parallel) {
+      auto t = std::make_shared<sleeping_tool>(n, std::chrono::milliseconds(ms));
+      t->parallel = parallel;
+      t->running = &running;
+      return t;
+    };
+    auto a = make("a", 100, true);
+    auto serial_b = make("serial_b", 100, false);
+    auto serial_c = make("serial_c", 2000, false);
+    auto d = make("d", 100, true);
+
+    WHEN("Running with four workers and a 300ms timeout") {
+      auto run = run_chat({a, serial_b, serial_c, d}, 4, std::chrono::milliseconds(300));
+
+      THEN("They run alone, each with its own timeout") {
+        REQUIRE_FALSE(serial_b->overlapped);
+        REQUIRE_FALSE(serial_c->overlapped);
+        REQUIRE(run.ms < 1500);
+        REQUIRE(run.tool_messages.size() == 4);
+        REQUIRE(run.tool_messages[0]["content"].to_string() == "a:0");
+        REQUIRE(run.tool_messages[1]["content"].to_string() == "serial_b:1");
+        REQUIRE(run.tool_messages[2]["content"].to_string().contains("timed out"));
+        REQUIRE(run.tool_messages[3]["content"].to_string() == "d:3");
+      }
+    }
+  }
+
+  GIVEN("Six tools that never return and a fast tool in the next turn") {
+    std::promise<void> release;
+    std::shared_future<void> gate = release.get_future().share();
+    std::vector<std::shared_ptr<hanging_tool>> hung;
+    std::vector<flx_string> first_turn;
+    for (int i = 0; i < 6; ++i) {
+      hung.push_back(std::make_shared<hanging_tool>(flx_string("hang_") + flx_string(static_cast<long long>(i)), gate));
+      first_turn.push_back(hung.back()->get_name());
+    }
+    auto fast = std::make_shared<sleeping_tool>("fast", std::chrono::milliseconds(10));
+
+    WHEN("Running them with four workers and a 100ms timeout") {
+      auto start = std::chrono::steady_clock::now();
+      size_t tool_messages = 0;
+      flx_string last_result;
+      {
+        auto api = std::make_shared<mock_tool_api>(std::vector<std::vector<flx_string>>{first_turn, {"fast"}});
+        flx_llm_chat chat(api);
+        chat.create_context(flxv_map());
+        auto context = std::make_unique<mock_context>();
+        mock_context* raw = context.get();
+        chat.set_context(std::move(context));
+        for (auto& t : hung) chat.register_function(t);
+        chat.register_function(fast);
+        chat.set_tool_execution(4, std::chrono::milliseconds(100));
+
+        flx_string response;
+        REQUIRE(chat.chat("go", response, 5));
+        REQUIRE(response == "done");
+        for (auto& m : raw->messages) {
+          if (m->get_data().count("tool_call_id")) {
+            ++tool_messages;
+            flxv_map data = m->get_data();
+            last_result = data["content"].to_string();
+          }
+        }
+      }
+      double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+      int started = 0;
+      for (auto& t : hung) started += t->calls;
+      release.set_value();
+
+      THEN("Queued calls time out too, later calls get a worker and teardown does not wait") {
+        REQUIRE(ms < 1000);
+        REQUIRE(tool_messages == 7);
+        REQUIRE(started == 4);
+        REQUIRE(last_result == "fast:0");
+      }
+    }
+  }
+}
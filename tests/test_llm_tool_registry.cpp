@@ -0,0 +1,265 @@
+#include <catch2/catch_all.hpp>
+#include "../aiprocesses/chat/flx_llm_tool_registry.h"
+#include <api/json/flx_json.h>
+#include <chrono>
+#include <iostream>
+
+// ============================================================================
+// tool_registry - name index and cached schemas across chat turns
+// ============================================================================
+
+using namespace flx::llm;
+
+namespace {
+
+  class counting_tool : public i_llm_function {
+    flx_string name;
+  public:
+    mutable int parameter_reads = 0;
+
+    explicit counting_tool(flx_string n) : name(std::move(n)) {}
+    flx_string get_name() const override { return name; }
+    flx_string get_description() const override { return "Looks up " + name; }
+    flxv_map get_parameters() const override {
+      ++parameter_reads;
+      flxv_map query;
+      query["type"] = "string";
+      flxv_map properties;
+      properties["query"] = query;
+      flxv_map params;
+      params["type"] = "object";
+      params["properties"] = properties;
+      return params;
+    }
+    flx_string call(const flxv_map&) override { return name; }
+  };
+
+  class counting_provider : public i_llm_tool_provider {
+  public:
+    std::vector<std::unique_ptr<counting_tool>> tools;
+    uint64_t version;
+    int list_calls = 0;
+
+    counting_provider(size_t count, uint64_t initial_version) : version(initial_version) {
+      for (size_t i = 0; i < count; ++i) {
+        tools.push_back(std::make_unique<counting_tool>(flx_string("tool_") + flx_string(static_cast<long long>(i))));
+      }
+    }
+
+    std::vector<i_llm_function*> get_available_tools() override {
+      ++list_calls;
+      std::vector<i_llm_function*> result;
+      for (auto& t : tools) result.push_back(t.get());
+      return result;
+    }
+    bool refresh_tools() override { return true; }
+    flx_string get_provider_name() const override { return "counting"; }
+    bool is_available() const override { return true; }
+    uint64_t get_tools_version() const override { return version; }
+
+    int total_parameter_reads() const {
+      int total = 0;
+      for (auto& t : tools) total += t->parameter_reads;
+      return total;
+    }
+  };
+
+  // Replaces its tools on every refresh, like mcp_tool_provider after a server change
+  class replacing_provider : public i_llm_tool_provider {
+  public:
+    std::vector<std::shared_ptr<counting_tool>> tools;
+    uint64_t version = 1;
+
+    replacing_provider() { refresh_tools(); }
+
+    std::vector<i_llm_function*> get_available_tools() override {
+      std::vector<i_llm_function*> result;
+      for (auto& t : tools) result.push_back(t.get());
+      return result;
+    }
+    bool get_shared_tools(std::vector<std::shared_ptr<i_llm_function>>& result) override {
+      result.assign(tools.begin(), tools.end());
+      return true;
+    }
+    bool refresh_tools() override {
+      tools.clear();
+      tools.push_back(std::make_shared<counting_tool>("search"));
+      ++version;
+      return true;
+    }
+    flx_string get_provider_name() const override { return "replacing"; }
+    bool is_available() const override { return true; }
+    uint64_t get_tools_version() const override { return version; }
+  };
+
+}
+
+SCENARIO("tool_registry caches the tool list between turns", "[unit][pure]") {
+  GIVEN("A versioned provider with 200 tools") {
+    auto provider = std::make_shared<counting_provider>(200, 1);
+    tool_registry registry;
+    registry.add_provider(provider);
+
+    WHEN("Simulating 50 turns of listing and looking up tools") {
+      for (int turn = 0; turn < 50; ++turn) {
+        REQUIRE(registry.get_tools().size() == 200);
+        REQUIRE(registry.find("tool_199") != nullptr);
+      }
+
+      THEN("The provider was read and every schema serialized only once") {
+        REQUIRE(provider->list_calls == 1);
+        REQUIRE(provider->total_parameter_reads() == 200);
+        REQUIRE(registry.get_version() == 1);
+        REQUIRE(registry.find("missing") == nullptr);
+      }
+
+      AND_WHEN("The provider reports a new version") {
+        provider->tools.pop_back();
+        provider->version = 2;
+        const auto& tools = registry.get_tools();
+
+        THEN("The registry rebuilds once") {
+          REQUIRE(tools.size() == 199);
+          REQUIRE(provider->list_calls == 2);
+          REQUIRE(registry.get_version() == 2);
+          REQUIRE(registry.find("tool_199") == nullptr);
+        }
+      }
+    }
+
+    WHEN("Reading the cached schema of a tool") {
+      std::shared_ptr<i_llm_function> tool = registry.find("tool_7");
+      REQUIRE(tool != nullptr);
+      const flx_string* schema = tool->get_schema_json();
+
+      THEN("It is the JSON declaration of the tool and calls are forwarded") {
+        REQUIRE(schema != nullptr);
+        flxv_map parsed;
+        flx_json json(&parsed);
+        REQUIRE(json.parse(*schema));
+        REQUIRE(parsed["name"].to_string() == "tool_7");
+        REQUIRE(parsed["description"].to_string() == "Looks up tool_7");
+        REQUIRE(parsed["parameters"].to_map()["type"].to_string() == "object");
+        REQUIRE(tool->call(flxv_map()) == "tool_7");
+      }
+    }
+  }
+
+  GIVEN("An unversioned provider") {
+    auto provider = std::make_shared<counting_provider>(3, 0);
+    tool_registry registry;
+    registry.add_provider(provider);
+
+    WHEN("Listing tools on three turns") {
+      for (int turn = 0; turn < 3; ++turn) {
+        registry.get_tools();
+        registry.find("tool_0");
+      }
+
+      THEN("It is re-read every turn, but not on lookups") {
+        REQUIRE(provider->list_calls == 3);
+      }
+    }
+  }
+
+  GIVEN("A direct function and a provider tool with the same name") {
+    auto provider = std::make_shared<counting_provider>(2, 1);
+    auto direct = std::make_shared<counting_tool>("tool_0");
+    tool_registry registry;
+    registry.add_provider(provider);
+    registry.add_function(direct);
+
+    THEN("The direct function wins and the name is listed once") {
+      REQUIRE(registry.get_tools().size() == 2);
+      REQUIRE(registry.get_tools()[0]->get_name() == "tool_0");
+      REQUIRE(direct->parameter_reads == 1);
+      REQUIRE(provider->tools[0]->parameter_reads == 1);
+      registry.find("tool_0")->get_parameters();
+      REQUIRE(direct->parameter_reads == 1);
+    }
+  }
+
+  GIVEN("A tool looked up before the registry is rebuilt") {
+    auto provider = std::make_shared<counting_provider>(2, 1);
+    auto registry = std::make_unique<tool_registry>();
+    registry->add_provider(provider);
+    registry->add_function(std::make_shared<counting_tool>("direct"));
+    std::shared_ptr<i_llm_function> direct = registry->find("direct");
+    std::shared_ptr<i_llm_function> from_provider = registry->find("tool_1");
+
+    WHEN("The function is replaced and the registry is destroyed") {
+      registry->add_function(std::make_shared<counting_tool>("direct"));
+      REQUIRE(registry->get_tools().size() == 3);
+      registry.reset();
+      provider.reset();
+
+      THEN("The looked-up tools can still be called") {
+        REQUIRE(direct->call(flxv_map()) == "direct");
+        REQUIRE(from_provider->call(flxv_map()) == "tool_1");
+      }
+    }
+  }
+
+  GIVEN("A provider tool looked up before the provider replaces its tools") {
+    auto provider = std::make_shared<replacing_provider>();
+    tool_registry registry;
+    registry.add_provider(provider);
+    std::shared_ptr<i_llm_function> running = registry.find("search");
+    std::weak_ptr<counting_tool> original = provider->tools[0];
+
+    WHEN("A refresh drops the provider's old tool objects") {
+      REQUIRE(registry.refresh());
+      REQUIRE(registry.get_tools().size() == 1);
+
+      THEN("The looked-up tool still owns the old object") {
+        REQUIRE_FALSE(original.expired());
+        REQUIRE(running->call(flxv_map()) == "search");
+        REQUIRE(registry.find("search") != running);
+        running.reset();
+        REQUIRE(original.expired());
+      }
+    }
+  }
+}
+
+SCENARIO("tool_registry reduces per-turn tool overhead", "[unit][benchmark]") {
+  GIVEN("200 provider tools") {
+    auto provider = std::make_shared<counting_provider>(200, 1);
+    tool_registry registry;
+    registry.add_provider(provider);
+    const int turns = 100;
+
+    WHEN("Serializing the tool declarations every turn vs. using the cache") {
+      auto start = std::chrono::steady_clock::now();
+      size_t uncached_bytes = 0;
+      for (int turn = 0; turn < turns; ++turn) {
+        for (auto* tool : provider->get_available_tools()) {
+          flxv_map declaration;
+          declaration["name"] = tool->get_name();
+          declaration["description"] = tool->get_description();
+          declaration["parameters"] = tool->get_parameters();
+          flx_json json(&declaration);
+          uncached_bytes += json.create().length();
+        }
+      }
+      auto mid = std::chrono::steady_clock::now();
+      size_t cached_bytes = 0;
+      for (int turn = 0; turn < turns; ++turn) {
+        for (auto* tool : registry.get_tools()) {
+          cached_bytes += tool->get_schema_json()->length();
+        }
+      }
+      auto end = std::chrono::steady_clock::now();
+
+      double uncached_ms = std::chrono::duration<double, std::milli>(mid - start).count();
+      double cached_ms = std::chrono::duration<double, std::milli>(end - mid).count();
+      std::cout << "[tool registry] " << turns << " turns x 200 tools: uncached " << uncached_ms
+                << " ms, cached " << cached_ms << " ms" << std::endl;
+
+      THEN("Both produce the same JSON and the cache is faster") {
+        REQUIRE(cached_bytes == uncached_bytes);
+        REQUIRE(cached_ms < uncached_ms);
+      }
+    }
+  }
+}
@@ -0,0 +1,182 @@
+#include <catch2/catch_all.hpp>
+#include "../documents/pdf/flx_pdf_content.h"
+#include <main/PdfMemDocument.h>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+
+using token_type = flx_pdf_content_lexer::token_type;
+
+SCENARIO("Content stream lexer splits tokens without copying", "[unit][pure][content]") {
+  GIVEN("A stream with every token kind") {
+    std::string stream = "% comment\n/F1 12.5 Tf -.5 +3 [(a\\)b (nested)) <41 42> 7] TJ << /K true >> BDC";
+    flx_pdf_content_lexer lexer(stream);
+    std::vector<flx_pdf_content_lexer::token> tokens;
+    flx_pdf_content_lexer::token t;
+    while (lexer.next(t)) tokens.push_back(t);
+
+    THEN("Types, texts and numbers are right") {
+      REQUIRE(tokens.size() == 16);
+      REQUIRE(tokens[0].type == token_type::name);
+      REQUIRE(tokens[0].text == "F1");
+      REQUIRE(tokens[1].type == token_type::number);
+      REQUIRE(tokens[1].number == 12.5);
+      REQUIRE(tokens[2].type == token_type::op);
+      REQUIRE(tokens[2].text == "Tf");
+      REQUIRE(tokens[3].number == -0.5);
+      REQUIRE(tokens[4].number == 3.0);
+      REQUIRE(tokens[5].type == token_type::array_begin);
+      REQUIRE(tokens[6].type == token_type::string);
+      REQUIRE(tokens[6].text == "(a\\)b (nested))");
+      REQUIRE(tokens[7].type == token_type::hex_string);
+      REQUIRE(tokens[7].text == "<41 42>");
+      REQUIRE(tokens[8].number == 7.0);
+      REQUIRE(tokens[9].type == token_type::array_end);
+      REQUIRE(tokens[10].text == "TJ");
+      REQUIRE(tokens[11].type == token_type::dict_begin);
+      REQUIRE(tokens[13].type == token_type::keyword);
+      REQUIRE(tokens[14].type == token_type::dict_end);
+      REQUIRE(tokens[15].text == "BDC");
+      // Views point into the stream
+      REQUIRE(tokens[2].text.data() == stream.data() + tokens[2].offset);
+    }
+  }
+}
+
+SCENARIO("Single-pass content processing", "[unit][pure][content]") {
+  GIVEN("Several operators on one line") {
+    std::string stream = "0 0 1 rg 10 20 100 50 re f 1 0 0 RG 0 0 m 50 0 l 50 50 l S";
+    flx_model_list<flx_layout_geometry> geometries;
+    flx_content::process_page_content(stream, &geometries, nullptr);
+
+    THEN("Every instruction is seen") {
+      REQUIRE(geometries.size() == 2);
+      REQUIRE(*geometries[0].fill_color == "#0000ff");
+      REQUIRE(geometries[0].vertices.size() == 5);
+      REQUIRE(geometries[0].vertices[2].x == 110.0);
+      REQUIRE(geometries[0].vertices[2].y == 70.0);
+      REQUIRE(*geometries[1].stroke_color == "#ff0000");
+      REQUIRE(geometries[1].vertices.size() == 3);
+    }
+  }
+
+  GIVEN("Colours changed inside q/Q") {
+    std::string stream = "0 1 0 rg q 1 0 0 rg 0 0 10 10 re f Q 20 20 10 10 re f";
+    flx_model_list<flx_layout_geometry> geometries;
+    flx_content::process_page_content(stream, &geometries, nullptr);
+
+    THEN("Q restores the colour saved by q") {
+      REQUIRE(geometries.size() == 2);
+      REQUIRE(*geometries[0].fill_color == "#ff0000");
+      REQUIRE(*geometries[1].fill_color == "#00ff00");
+    }
+  }
+
+  GIVEN("Rectangles and lines collected into one path before painting") {
+    std::string stream =
+      "0 0 1 rg 10 10 5 5 re 20 20 5 5 re f "
+      "0 0 m 10 0 l 30 30 5 5 re S "
+      "0 0 1 1 re n 50 50 5 5 re W n";
+    flx_model_list<flx_layout_geometry> geometries;
+    flx_content::process_page_content(stream, &geometries, nullptr);
+
+    THEN("Every subpath is painted, n and painting end the path") {
+      REQUIRE(geometries.size() == 4);
+      REQUIRE(*geometries[0].fill_color == "#0000ff");
+      REQUIRE(geometries[0].vertices[0].x == 10.0);
+      REQUIRE(*geometries[1].fill_color == "#0000ff");
+      REQUIRE(geometries[1].vertices[0].x == 20.0);
+      REQUIRE(geometries[2].vertices.size() == 2);
+      REQUIRE(geometries[3].vertices.size() == 5);
+      REQUIRE(geometries[3].vertices[0].x == 30.0);
+    }
+  }
+
+  GIVEN("A page with text, an XObject and an inline image between paths") {
+    std::string stream =
+      "q 0.5 g\n"
+      "BT /F1 12 Tf 100 700 Td (10 10 5 5 re f) Tj ET\n"
+      "0 0 200 100 re f /Im1 Do\n"
+      "BI /W 2 /H 1 /BPC 8 /CS /G ID \x01\x45I EI\n"
+      "1 0 0 0 k 0 0 m 10 0 l 10 10 l h f Q";
+    flx_model_list<flx_layout_geometry> geometries;
+    std::string filtered;
+    flx_content::process_page_content(stream, &geometries, &filtered);
+
+    THEN("Geometry and filtered stream come from the same pass") {
+      REQUIRE(geometries.size() == 2);
+      REQUIRE(*geometries[0].fill_color == "#7f7f7f");
+      REQUIRE(*geometries[1].fill_color == "#00ffff");
+      REQUIRE(geometries[1].vertices.size() == 4);
+
+      REQUIRE(filtered == "q\n0.5 g\n0 0 200 100 re\nf\n1 0 0 0 k\n0 0 m\n10 0 l\n10 10 l\nh\nf\nQ\n");
+    }
+  }
+}
+
+SCENARIO("Content stream throughput on tender PDFs", "[benchmark][content]") {
+  std::filesystem::path dataset = std::filesystem::path(__FILE__).parent_path().parent_path() / "datasets" / "tender-offers";
+  if (!std::filesystem::exists(dataset)) {
+    WARN("No tender dataset at " << dataset.string() << " - skipping");
+    return;
+  }
+
+  GIVEN("All decoded page content streams of the dataset") {
+    std::vector<std::string> streams;
+    size_t total_bytes = 0;
+    for (const auto& entry : std::filesystem::recursive_directory_iterator(dataset)) {
+      if (entry.path().extension() != ".pdf") continue;
+      try {
+        PoDoFo::PdfMemDocument doc;
+        doc.Load(entry.path().string());
+        auto& pages = doc.GetPages();
+        for (unsigned i = 0; i < pages.GetCount(); ++i) {
+          auto contents = pages.GetPageAt(i).GetContents();
+          if (contents == nullptr) continue;
+          auto buffer = contents->GetCopy();
+          streams.emplace_back(buffer.data(), buffer.size());
+          total_bytes += buffer.size();
+        }
+      } catch (const std::exception&) {
+        // Encrypted or broken files are not part of the measurement
+      }
+    }
+    REQUIRE(total_bytes > 0);
+
+    WHEN("Extracting geometry and filtering in one pass") {
+      size_t geometry_count = 0;
+      size_t filtered_bytes = 0;
+      auto start = std::chrono::steady_clock::now();
+      for (const auto& stream : streams) {
+        flx_model_list<flx_layout_geometry> geometries;
+        std::string filtered;
+        flx_content::process_page_content(stream, &geometries, &filtered);
+        geometry_count += geometries.size();
+        filtered_bytes += filtered.size();
+      }
+      double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+      // Tokenizing alone, for comparison
+      auto lex_start = std::chrono::steady_clock::now();
+      size_t instructions = 0;
+      for (const auto& stream : streams) {
+        flx_pdf_content_scanner scanner(stream);
+        flx_pdf_content_scanner::instruction ins;
+        while (scanner.next(ins)) ++instructions;
+      }
+      double lex_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - lex_start).count();
+      double mb = total_bytes / (1024.0 * 1024.0);
+
+      std::cout << "⏱️  Content streams: " << streams.size() << " pages, " << mb << " MB, "
+                << instructions << " instructions" << std::endl;
+      std::cout << "   scanner: " << mb / lex_seconds << " MB/s, geometry + filter: "
+                << mb / seconds << " MB/s (" << geometry_count << " geometries, "
+                << filtered_bytes << " bytes kept)" << std::endl;
+
+      THEN("Every stream was processed") {
+        REQUIRE(instructions > 0);
+        REQUIRE(filtered_bytes <= total_bytes + instructions);
+      }
+    }
+  }
+}
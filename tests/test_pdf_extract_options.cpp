@@ -0,0 +1,275 @@
+#include <catch2/catch_all.hpp>
+#include "../documents/pdf/flx_pdf_sio.h"
+#include "../documents/pdf/flx_pdf_page_cache.h"
+#include "../api/json/flx_json.h"
+#include <filesystem>
+#include <fstream>
+
+namespace {
+
+  using page_range = flx_pdf_sio::extract_options::page_range;
+
+  // Pages "Seite 1".."Seite n", each with a line of text and a 4x2 PNG logo
+  flx_string build_document(int page_count, const std::filesystem::path& dir) {
+    std::filesystem::create_directories(dir);
+    std::string logo = (dir / "logo.png").string();
+    static const char png[] =
+      "\x89\x50\x4e\x47\x0d\x0a\x1a\x0a\x00\x00\x00\x0d\x49\x48\x44\x52\x00\x00\x00\x04"
+      "\x00\x00\x00\x02\x08\x02\x00\x00\x00\xf0\xca\xea\x34\x00\x00\x00\x10\x49\x44\x41"
+      "\x54\x78\x9c\x63\xf8\xcf\xc0\x00\x47\x0c\xc8\x1c\x00\x6f\xaa\x07\xf9\x80\xdc\x00"
+      "\x28\x00\x00\x00\x00\x49\x45\x4e\x44\xae\x42\x60\x82";
+    std::ofstream(logo, std::ios::binary).write(png, sizeof(png) - 1);
+
+    flx_pdf_sio source;
+    for (int p = 0; p < page_count; ++p) {
+      auto& page = source.add_page();
+      flx_layout_text title;
+      title.x = 100.0;
+      title.y = 60.0;
+      title.text = "Seite " + std::to_string(p + 1);
+      title.font_size = 14.0;
+      page.add_text(title);
+
+      flx_layout_text line;
+      line.x = 100.0;
+      line.y = 400.0;
+      line.text = "Inhalt";
+      line.font_size = 10.0;
+      page.add_text(line);
+
+      flx_layout_image image;
+      image.x = 400.0;
+      image.y = 50.0;
+      image.width = 80.0;
+      image.height = 40.0;
+      image.image_path = logo;
+      page.add_image(image);
+    }
+    flx_string data;
+    source.serialize(data);
+    return data;
+  }
+
+  size_t count_texts(flx_layout_geometry& geometry) {
+    size_t count = geometry.texts.size();
+    for (size_t i = 0; i < geometry.sub_geometries.size(); ++i) {
+      count += count_texts(geometry.sub_geometries[i]);
+    }
+    return count;
+  }
+
+  bool has_stage(const flx_pdf_sio& reader, const std::string& name) {
+    for (const auto& timing : reader.get_stage_timings()) {
+      if (timing.name == name) return timing.count > 0;
+    }
+    return false;
+  }
+
+  // Stand-in for pdftoppm: logs its arguments and prints that many white pages
+  std::string write_fake_pdftoppm(const std::filesystem::path& dir, int pages = 1) {
+    std::string ppm = "P6\n20 10\n255\n" + std::string(20 * 10 * 3, '\xff');
+    std::ofstream(dir / "page.ppm", std::ios::binary) << ppm;
+    std::filesystem::path script = dir / "fake_pdftoppm";
+    std::ofstream out(script);
+    out << "#!/bin/sh\n"
+        << "cat > /dev/null\n"
+        << "echo \"$@\" >> '" << (dir / "args.txt").string() << "'\n"
+        << "for i in $(seq " << pages << "); do cat '" << (dir / "page.ppm").string() << "'; done\n";
+    out.close();
+    std::filesystem::permissions(script, std::filesystem::perms::owner_all);
+    return script.string();
+  }
+
+}
+
+SCENARIO("Page lists parse into ranges", "[unit][pdf][extract]") {
+  std::vector<page_range> ranges;
+
+  THEN("Single pages, closed and open ranges are accepted") {
+    REQUIRE(flx_pdf_sio::extract_options::parse_page_list("1-3,7,10-", ranges));
+    REQUIRE(ranges.size() == 3);
+    REQUIRE(ranges[0].first == 1);
+    REQUIRE(ranges[0].last == 3);
+    REQUIRE(ranges[1].first == 7);
+    REQUIRE(ranges[1].last == 7);
+    REQUIRE(ranges[2].first == 10);
+    REQUIRE(ranges[2].last == 0);
+  }
+
+  THEN("Malformed lists are rejected") {
+    for (const char* list : {"", "0", "3-2", "1,", ",1", "a", "1-2-3", "1;2"}) {
+      REQUIRE_FALSE(flx_pdf_sio::extract_options::parse_page_list(list, ranges));
+    }
+  }
+}
+
+SCENARIO("Extract options select pages and stages", "[pdf][extract]") {
+  std::filesystem::path dir = std::filesystem::temp_directory_path() / "flx_extract_options_test";
+  flx_string data = build_document(5, dir);
+
+  GIVEN("Pages 2-3 and 5 of five") {
+    flx_pdf_sio reader;
+    flx_pdf_sio::extract_options options;
+    options.pages = {{5, 0}, {2, 3}};
+    reader.set_extract_options(options);
+    REQUIRE(reader.parse(data));
+
+    THEN("Only those pages come out, in document order") {
+      REQUIRE(reader.pages.size() == 3);
+      flx_string first = reader.pages[0].texts[0].text;
+      flx_string last = reader.pages[2].texts[0].text;
+      REQUIRE(first == "Seite 2");
+      REQUIRE(last == "Seite 5");
+      REQUIRE(reader.get_stage_timings().back().count == 3);
+    }
+
+    THEN("The pages are part of the model and its JSON") {
+      std::string json = flx_json(&*reader).create().c_str();
+      REQUIRE(json.find("Seite 2") != std::string::npos);
+      REQUIRE(json.find("Seite 5") != std::string::npos);
+      REQUIRE(json.find("Seite 1") == std::string::npos);
+    }
+  }
+
+  GIVEN("Images without texts") {
+    flx_pdf_sio reader;
+    flx_pdf_sio::extract_options options;
+    options.texts = false;
+    options.images = true;
+    options.pages = {{1, 1}};
+    reader.set_extract_options(options);
+    REQUIRE(reader.parse(data));
+
+    THEN("The text stage is skipped and the image placement is read") {
+      REQUIRE_FALSE(has_stage(reader, "extract_text"));
+      REQUIRE(has_stage(reader, "extract_images"));
+      REQUIRE(reader.pages[0].texts.size() == 0);
+      REQUIRE(reader.pages[0].images.size() == 1);
+      auto& image = reader.pages[0].images[0];
+      REQUIRE(image.x.value() == Catch::Approx(400.0).margin(0.5));
+      REQUIRE(image.y.value() == Catch::Approx(50.0).margin(0.5));
+      REQUIRE(image.width.value() == Catch::Approx(80.0).margin(0.5));
+      REQUIRE(image.height.value() == Catch::Approx(40.0).margin(0.5));
+      REQUIRE(image.original_width.value() == 4);
+      REQUIRE(image.original_height.value() == 2);
+    }
+  }
+
+  GIVEN("A predicate that stops after the second page") {
+    flx_pdf_sio reader;
+    flx_pdf_sio::parse_options parse_options;
+    parse_options.threads = 4;
+    reader.set_parse_options(parse_options);
+    flx_pdf_sio::extract_options options;
+    std::vector<int> seen;
+    options.on_page = [&seen](int page_number, flx_layout_geometry& page) {
+      seen.push_back(page_number);
+      return page.texts.size() > 0 && page_number < 2;
+    };
+    reader.set_extract_options(options);
+    REQUIRE(reader.parse(data));
+
+    THEN("parse() ends with the pages seen so far") {
+      REQUIRE(seen == std::vector<int>{1, 2});
+      REQUIRE(reader.pages.size() == 2);
+    }
+  }
+
+  GIVEN("A page cache shared by text-only and image parses") {
+    flx_pdf_page_cache cache;
+    flx_pdf_sio texts_only;
+    texts_only.set_page_cache(&cache);
+    REQUIRE(texts_only.parse(data));
+
+    flx_pdf_sio with_images;
+    flx_pdf_sio::extract_options options;
+    options.images = true;
+    with_images.set_extract_options(options);
+    with_images.set_page_cache(&cache);
+    REQUIRE(with_images.parse(data));
+
+    THEN("Each set of stages has its own entries") {
+      REQUIRE(cache.get_stats().hits == 0);
+      REQUIRE(cache.size() == 10);
+      REQUIRE(with_images.pages[4].images.size() == 1);
+    }
+  }
+
+  GIVEN("Geometry with hierarchy on page 4, rendered by a pdftoppm stand-in") {
+    flx_pdf_sio reader;
+    flx_pdf_rasterizer::options render_options;
+    render_options.engine = flx_pdf_rasterizer::backend::pdftoppm;
+    render_options.pdftoppm_path = write_fake_pdftoppm(dir);
+    reader.set_render_options(render_options);
+    flx_pdf_sio::extract_options options;
+    options.pages = {{4, 4}};
+    options.hierarchy = true;
+    options.dpi = 72;
+    reader.set_extract_options(options);
+    REQUIRE(reader.parse(data));
+
+    THEN("The single page of the cleaned copy is rendered at the requested DPI") {
+      std::ifstream args(dir / "args.txt");
+      std::string line;
+      REQUIRE(std::getline(args, line));
+      REQUIRE(line == "-r 72 -f 1 -l 1 -");
+      REQUIRE_FALSE(std::getline(args, line));
+      REQUIRE(has_stage(reader, "geometry"));
+      REQUIRE(has_stage(reader, "hierarchy"));
+      REQUIRE(reader.pages.size() == 1);
+      REQUIRE(count_texts(reader.pages[0]) == 2);
+    }
+  }
+
+#ifdef FLX_ENABLE_PDF_TRACE
+  GIVEN("Geometry of pages 1-2 parsed once into a page cache") {
+    flx_pdf_page_cache cache;
+    flx_pdf_rasterizer::options render_options;
+    render_options.engine = flx_pdf_rasterizer::backend::pdftoppm;
+    render_options.pdftoppm_path = write_fake_pdftoppm(dir, 2);
+    flx_pdf_sio::extract_options options;
+    options.pages = {{1, 2}};
+    options.geometry = true;
+    options.dpi = 72;
+    flx_pdf_trace::options trace_options;
+    trace_options.detail = flx_pdf_trace::level::spans;
+    auto parse = [&](flx_pdf_sio& reader) {
+      reader.set_render_options(render_options);
+      reader.set_extract_options(options);
+      reader.set_trace_options(trace_options);
+      reader.set_page_cache(&cache);
+      return reader.parse(data);
+    };
+    auto built_source = [](const flx_pdf_sio& reader) {
+      for (const auto& stage : reader.get_trace().stages()) {
+        if (stage.name == "geometry_source") return stage.count > 0;
+      }
+      return false;
+    };
+    std::filesystem::remove(dir / "args.txt");
+    flx_pdf_sio first;
+    REQUIRE(parse(first));
+    REQUIRE(built_source(first));
+    // Both pages come from one render of the source
+    std::ifstream args(dir / "args.txt");
+    std::string line;
+    REQUIRE(std::getline(args, line));
+    REQUIRE(line == "-r 72 -f 1 -l 2 -");
+    REQUIRE_FALSE(std::getline(args, line));
+    REQUIRE(first.pages.size() == 2);
+
+    WHEN("The document is parsed again") {
+      flx_pdf_sio second;
+      REQUIRE(parse(second));
+
+      THEN("All pages are hits and no geometry source is built") {
+        REQUIRE(cache.get_stats().hits == 2);
+        REQUIRE_FALSE(built_source(second));
+        REQUIRE_FALSE(has_stage(second, "geometry"));
+      }
+    }
+  }
+#endif
+
+  std::filesystem::remove_all(dir);
+}
@@ -0,0 +1,281 @@
+#include <catch2/catch_all.hpp>
+#include "../documents/pdf/flx_pdf_font_cache.h"
+#include "../documents/pdf/flx_pdf_text_extractor.h"
+#include "../documents/pdf/flx_pdf_sio.h"
+#include <main/PdfMemDocument.h>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <thread>
+
+namespace {
+
+  // Decodes every shown string of the page with the cache and with PdfFont
+  // directly; returns the number of strings compared, -1 on the first mismatch
+  int compare_page_decoding(const PoDoFo::PdfPage& page, flx_pdf_font_cache& fonts) {
+    PoDoFo::PdfContentStreamReader reader(page);
+    PoDoFo::PdfContent content;
+    PoDoFo::PdfTextState state;
+    const flx_pdf_font_cache::font_entry* entry = nullptr;
+    int compared = 0;
+
+    auto compare = [&](const PoDoFo::PdfString& str) {
+      if (entry == nullptr) return true;
+      std::string expected_text, text;
+      std::vector<double> expected_lengths, lengths;
+      std::vector<unsigned> expected_positions, positions;
+      bool expected_ok = entry->font().TryScanEncodedString(str, state, expected_text, expected_lengths, expected_positions);
+      bool ok = entry->decode(str, state, text, lengths, positions);
+      ++compared;
+      if (ok != expected_ok || text != expected_text || positions != expected_positions
+          || lengths.size() != expected_lengths.size()) {
+        return false;
+      }
+      for (size_t i = 0; i < lengths.size(); ++i) {
+        if (std::abs(lengths[i] - expected_lengths[i]) > 1e-9) return false;
+      }
+      return true;
+    };
+
+    while (reader.TryReadNext(content)) {
+      if (content.Type != PoDoFo::PdfContentType::Operator || content.Warnings != PoDoFo::PdfContentWarnings::None) {
+        continue;
+      }
+      switch (content.Operator) {
+        case PoDoFo::PdfOperator::Tf:
+          state.FontSize = content.Stack[0].GetReal();
+          entry = fonts.get(page.GetResources(), content.Stack[1].GetName().GetString());
+          state.Font = entry ? &entry->font() : nullptr;
+          break;
+        case PoDoFo::PdfOperator::Tc:
+          state.CharSpacing = content.Stack[0].GetReal();
+          break;
+        case PoDoFo::PdfOperator::Tj:
+        case PoDoFo::PdfOperator::Quote:
+          if (!compare(content.Stack[0].GetString())) return -1;
+          break;
+        case PoDoFo::PdfOperator::TJ:
+          for (const auto& item : content.Stack[0].GetArray()) {
+            if (item.IsString() && !compare(item.GetString())) return -1;
+          }
+          break;
+        default:
+          break;
+      }
+    }
+    return compared;
+  }
+
+  std::filesystem::path tender_dataset() {
+    return std::filesystem::path(__FILE__).parent_path().parent_path() / "datasets" / "tender-offers";
+  }
+
+}
+
+SCENARIO("Font cache is scoped to the document and keyed by font object", "[unit][pdf][fonts]") {
+  GIVEN("A serialized three page PDF using the same font on every page") {
+    flx_pdf_sio writer;
+    for (int p = 0; p < 3; ++p) {
+      flx_layout_geometry page;
+      page.x = 0;
+      page.y = 0;
+      page.width = 595;
+      page.height = 842;
+      flx_layout_text text;
+      text.x = 100;
+      text.y = 100 + 50 * p;
+      text.text = "Seite " + std::to_string(p + 1) + " Ärger";
+      text.font_family = "Arial";
+      text.font_size = 12;
+      text.color = "#000000";
+      page.texts.push_back(text);
+      writer.pages.push_back(page);
+    }
+    flx_string pdf_data;
+    REQUIRE(writer.serialize(pdf_data));
+
+    PoDoFo::PdfMemDocument doc;
+    doc.LoadFromBuffer(PoDoFo::bufferview(pdf_data.c_str(), pdf_data.size()));
+    REQUIRE(doc.GetPages().GetCount() == 3);
+
+    WHEN("All pages are extracted with one cache") {
+      flx_pdf_font_cache fonts;
+      flx_pdf_text_extractor extractor(&fonts);
+      flx_model_list<flx_layout_text> texts;
+      for (unsigned i = 0; i < doc.GetPages().GetCount(); ++i) {
+        REQUIRE(extractor.extract_text_with_fonts(doc.GetPages().GetPageAt(i), texts));
+      }
+
+      THEN("The font is loaded once and the texts decode as before") {
+        REQUIRE(fonts.size() == 1);
+        REQUIRE(texts.size() == 3);
+        REQUIRE(*texts[2].text == "Seite 3 Ärger");
+        REQUIRE(*texts[0].font_family != "");
+        for (unsigned i = 0; i < doc.GetPages().GetCount(); ++i) {
+          REQUIRE(compare_page_decoding(doc.GetPages().GetPageAt(i), fonts) > 0);
+        }
+      }
+    }
+
+    WHEN("Several threads look up the font of their page at once") {
+      flx_pdf_font_cache fonts;
+      // Load the page resources up front: the document itself is not thread safe
+      std::vector<const PoDoFo::PdfResources*> resources;
+      for (unsigned i = 0; i < doc.GetPages().GetCount(); ++i) {
+        resources.push_back(&doc.GetPages().GetPageAt(i).GetResources());
+      }
+      std::vector<std::string> names;
+      for (const auto* res : resources) {
+        for (const auto& pair : res->GetResourceIterator(PoDoFo::PdfResourceType::Font)) {
+          names.push_back(std::string(pair.first.GetString()));
+          break;
+        }
+      }
+      REQUIRE(names.size() == resources.size());
+
+      std::vector<const flx_pdf_font_cache::font_entry*> found(resources.size() * 4);
+      std::vector<std::thread> threads;
+      for (size_t t = 0; t < found.size(); ++t) {
+        threads.emplace_back([&, t] {
+          found[t] = fonts.get(*resources[t % resources.size()], names[t % resources.size()]);
+        });
+      }
+      for (auto& thread : threads) thread.join();
+
+      THEN("Everyone gets the same entry") {
+        REQUIRE(found[0] != nullptr);
+        for (const auto* entry : found) {
+          REQUIRE(entry == found[0]);
+        }
+        REQUIRE(fonts.size() == 1);
+      }
+    }
+  }
+}
+
+SCENARIO("Multi-page text extraction with a document font cache", "[benchmark][pdf][fonts]") {
+  std::filesystem::path dataset = tender_dataset();
+  if (!std::filesystem::exists(dataset)) {
+    WARN("No tender dataset at " << dataset.string() << " - skipping");
+    return;
+  }
+
+  GIVEN("The PDFs of the tender dataset") {
+    std::vector<std::unique_ptr<PoDoFo::PdfMemDocument>> documents;
+    size_t page_count = 0;
+    for (const auto& entry : std::filesystem::recursive_directory_iterator(dataset)) {
+      if (entry.path().extension() != ".pdf") continue;
+      try {
+        auto doc = std::make_unique<PoDoFo::PdfMemDocument>();
+        doc->Load(entry.path().string());
+        page_count += doc->GetPages().GetCount();
+        documents.push_back(std::move(doc));
+      } catch (const std::exception&) {
+        // Encrypted or broken files are not part of the measurement
+      }
+    }
+    REQUIRE(page_count > 0);
+
+    WHEN("Comparing every shown string against PdfFont") {
+      int compared = 0;
+      for (auto& doc : documents) {
+        flx_pdf_font_cache fonts;
+        for (unsigned i = 0; i < doc->GetPages().GetCount(); ++i) {
+          int n = compare_page_decoding(doc->GetPages().GetPageAt(i), fonts);
+          REQUIRE(n >= 0);
+          compared += n;
+        }
+      }
+
+      THEN("The results are identical") {
+        std::cout << "🔤 Compared " << compared << " shown strings" << std::endl;
+        REQUIRE(compared > 0);
+      }
+    }
+
+    WHEN("Decoding the shown strings with the cache and with PdfFont") {
+      // Shown strings with their font, collected once so only decoding is timed
+      std::vector<std::unique_ptr<flx_pdf_font_cache>> caches;
+      std::vector<std::pair<const flx_pdf_font_cache::font_entry*, PoDoFo::PdfString>> shown;
+      for (auto& doc : documents) {
+        caches.push_back(std::make_unique<flx_pdf_font_cache>());
+        for (unsigned i = 0; i < doc->GetPages().GetCount(); ++i) {
+          const auto& page = doc->GetPages().GetPageAt(i);
+          PoDoFo::PdfContentStreamReader reader(page);
+          PoDoFo::PdfContent content;
+          const flx_pdf_font_cache::font_entry* entry = nullptr;
+          while (reader.TryReadNext(content)) {
+            if (content.Type != PoDoFo::PdfContentType::Operator || content.Warnings != PoDoFo::PdfContentWarnings::None) {
+              continue;
+            }
+            if (content.Operator == PoDoFo::PdfOperator::Tf) {
+              entry = caches.back()->get(page.GetResources(), content.Stack[1].GetName().GetString());
+            } else if (entry != nullptr && content.Operator == PoDoFo::PdfOperator::Tj) {
+              shown.emplace_back(entry, content.Stack[0].GetString());
+            } else if (entry != nullptr && content.Operator == PoDoFo::PdfOperator::TJ) {
+              for (const auto& item : content.Stack[0].GetArray()) {
+                if (item.IsString()) shown.emplace_back(entry, item.GetString());
+              }
+            }
+          }
+        }
+      }
+      REQUIRE(!shown.empty());
+
+      PoDoFo::PdfTextState state;
+      state.FontSize = 10;
+      std::string decoded;
+      std::vector<double> lengths;
+      std::vector<unsigned> positions;
+      size_t cached_bytes = 0;
+      size_t direct_bytes = 0;
+
+      auto start = std::chrono::steady_clock::now();
+      for (const auto& item : shown) {
+        state.Font = &item.first->font();
+        item.first->decode(item.second, state, decoded, lengths, positions);
+        cached_bytes += decoded.size();
+      }
+      double cached_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+      start = std::chrono::steady_clock::now();
+      for (const auto& item : shown) {
+        state.Font = &item.first->font();
+        item.first->font().TryScanEncodedString(item.second, state, decoded, lengths, positions);
+        direct_bytes += decoded.size();
+      }
+      double direct_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+      std::cout << "⏱️  Decoding " << shown.size() << " strings of " << page_count << " pages: cache "
+                << cached_seconds * 1000.0 << " ms, PdfFont " << direct_seconds * 1000.0 << " ms ("
+                << direct_seconds / cached_seconds << "x)" << std::endl;
+
+      THEN("Both decode the same text") {
+        REQUIRE(cached_bytes == direct_bytes);
+      }
+    }
+
+    WHEN("Extracting all pages with one cache per document") {
+      // The extractor's progress output is not what is measured
+      std::streambuf* previous = std::cout.rdbuf(nullptr);
+      size_t text_count = 0;
+      auto start = std::chrono::steady_clock::now();
+      for (auto& doc : documents) {
+        flx_pdf_font_cache fonts;
+        flx_pdf_text_extractor extractor(&fonts);
+        for (unsigned i = 0; i < doc->GetPages().GetCount(); ++i) {
+          flx_model_list<flx_layout_text> texts;
+          extractor.extract_text_with_fonts(doc->GetPages().GetPageAt(i), texts);
+          text_count += texts.size();
+        }
+      }
+      double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+      std::cout.rdbuf(previous);
+      std::cout << "⏱️  Text extraction: " << page_count / seconds << " pages/s (" << text_count << " texts)" << std::endl;
+
+      THEN("Texts were found") {
+        REQUIRE(text_count > 0);
+      }
+    }
+  }
+}
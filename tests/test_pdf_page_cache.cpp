@@ -0,0 +1,243 @@
+#include <catch2/catch_all.hpp>
+#include "../documents/pdf/flx_pdf_page_cache.h"
+#include "../documents/pdf/flx_pdf_sio.h"
+#include <main/PdfMemDocument.h>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <thread>
+
+namespace {
+
+  // Pages "Seite 1".."Seite n" with rows of filler text; the text of
+  // moved_page starts at moved_x. Moving a text keeps the glyphs, so the
+  // shared font subset stays the same and only that page changes.
+  flx_string build_document(int page_count, int rows, int moved_page = -1, double moved_x = 100.0) {
+    flx_pdf_sio source;
+    for (int p = 0; p < page_count; ++p) {
+      auto& page = source.add_page();
+      flx_layout_text title;
+      title.x = p == moved_page ? moved_x : 100.0;
+      title.y = 60.0;
+      title.text = "Seite " + std::to_string(p + 1);
+      title.font_size = 14.0;
+      page.add_text(title);
+      for (int r = 0; r < rows; ++r) {
+        flx_layout_text row;
+        row.x = 60.0;
+        row.y = 100.0 + r * 3.0;
+        row.text = "Position " + std::to_string(r + 1);
+        row.font_size = 8.0;
+        page.add_text(row);
+      }
+    }
+    flx_string data;
+    source.serialize(data);
+    return data;
+  }
+
+  std::vector<std::string> fingerprints(const flx_string& data) {
+    PoDoFo::PdfMemDocument doc;
+    doc.LoadFromBuffer(PoDoFo::bufferview(data.c_str(), data.size()));
+    std::vector<std::string> keys;
+    for (unsigned i = 0; i < doc.GetPages().GetCount(); ++i) {
+      keys.push_back(flx_pdf_page_cache::fingerprint(doc.GetPages().GetPageAt(i)));
+    }
+    return keys;
+  }
+
+  flx_string first_text(flx_pdf_sio& reader, size_t page) {
+    return reader.pages[page].texts[0].text;
+  }
+
+}
+
+SCENARIO("Page fingerprints follow the page content", "[unit][pdf][page_cache]") {
+  GIVEN("A document and a copy with the title of page 2 moved") {
+    flx_string original = build_document(3, 2);
+    flx_string edited = build_document(3, 2, 1, 300.0);
+
+    THEN("Loading the same data twice gives the same keys") {
+      auto keys = fingerprints(original);
+      REQUIRE(keys.size() == 3);
+      REQUIRE(keys == fingerprints(original));
+      REQUIRE(keys[0].size() == 64);
+      REQUIRE(keys[0] != keys[1]);
+      REQUIRE(keys[1] != keys[2]);
+    }
+
+    THEN("Only the edited page gets a new key") {
+      auto before = fingerprints(original);
+      auto after = fingerprints(edited);
+      REQUIRE(before[0] == after[0]);
+      REQUIRE(before[1] != after[1]);
+      REQUIRE(before[2] == after[2]);
+    }
+  }
+}
+
+SCENARIO("Re-parsing restores unchanged pages from the page cache", "[pdf][page_cache]") {
+  GIVEN("A parsed document and a cache") {
+    flx_string original = build_document(3, 2);
+    flx_string edited = build_document(3, 2, 1, 300.0);
+    flx_pdf_page_cache cache;
+
+    flx_pdf_sio first;
+    first.set_page_cache(&cache);
+    REQUIRE(first.parse(original));
+    REQUIRE(cache.size() == 3);
+    REQUIRE(cache.get_stats().misses == 3);
+
+    WHEN("The edited document is parsed") {
+      flx_pdf_sio second;
+      second.set_page_cache(&cache);
+      REQUIRE(second.parse(edited));
+
+      THEN("Two pages come from the cache and the moved title is read again") {
+        REQUIRE(cache.get_stats().hits == 2);
+        REQUIRE(cache.get_stats().misses == 4);
+        REQUIRE(second.pages.size() == 3);
+        REQUIRE(first_text(second, 0) == "Seite 1");
+        REQUIRE(first_text(second, 2) == "Seite 3");
+        REQUIRE(second.pages[2].texts.size() == 3);
+        REQUIRE(second.pages[1].texts[0].x.value() == Catch::Approx(300.0).margin(1.0));
+        REQUIRE(second.pages[0].width.value() == Catch::Approx(595.0));
+      }
+    }
+
+    WHEN("The same document is parsed on four threads") {
+      flx_pdf_sio second;
+      flx_pdf_sio::parse_options options;
+      options.threads = 4;
+      second.set_parse_options(options);
+      second.set_page_cache(&cache);
+      REQUIRE(second.parse(original));
+
+      THEN("Every page is a hit with the same texts") {
+        REQUIRE(cache.get_stats().hits == 3);
+        for (size_t p = 0; p < 3; ++p) {
+          REQUIRE(second.pages[p].texts.size() == first.pages[p].texts.size());
+          REQUIRE(first_text(second, p) == first_text(first, p));
+          REQUIRE(second.pages[p].texts[1].y.value() == Catch::Approx(first.pages[p].texts[1].y.value()));
+        }
+      }
+    }
+  }
+
+  GIVEN("A cache directory") {
+    std::filesystem::path dir = std::filesystem::temp_directory_path() / "flx_pdf_page_cache_test";
+    std::filesystem::remove_all(dir);
+    flx_string original = build_document(2, 1);
+
+    {
+      flx_pdf_page_cache cache(dir.string());
+      flx_pdf_sio reader;
+      reader.set_page_cache(&cache);
+      REQUIRE(reader.parse(original));
+    }
+
+    WHEN("A new cache opens the same directory") {
+      flx_pdf_page_cache cache(dir.string());
+      flx_pdf_sio reader;
+      reader.set_page_cache(&cache);
+      REQUIRE(reader.parse(original));
+
+      THEN("The pages are read from disk") {
+        REQUIRE(cache.get_stats().hits == 2);
+        REQUIRE(cache.get_stats().misses == 0);
+        REQUIRE(first_text(reader, 1) == "Seite 2");
+      }
+    }
+
+    WHEN("Caches on several threads store the same pages into the directory") {
+      std::filesystem::remove_all(dir);
+      std::vector<std::thread> writers;
+      std::atomic<int> parsed{0};
+      for (int t = 0; t < 4; ++t) {
+        writers.emplace_back([&] {
+          flx_pdf_page_cache cache(dir.string());
+          flx_pdf_sio reader;
+          reader.set_page_cache(&cache);
+          if (reader.parse(original)) ++parsed;
+        });
+      }
+      for (auto& writer : writers) writer.join();
+
+      THEN("Every entry is complete and no temp file is left") {
+        REQUIRE(parsed == 4);
+        size_t entries = 0;
+        for (const auto& file : std::filesystem::recursive_directory_iterator(dir)) {
+          if (!file.is_regular_file()) continue;
+          REQUIRE(file.path().extension() != ".tmp");
+          ++entries;
+        }
+        REQUIRE(entries == 2);
+        flx_pdf_page_cache cache(dir.string());
+        flx_pdf_sio reader;
+        reader.set_page_cache(&cache);
+        REQUIRE(reader.parse(original));
+        REQUIRE(cache.get_stats().hits == 2);
+      }
+    }
+    std::filesystem::remove_all(dir);
+  }
+
+  GIVEN("A cache with room for two pages") {
+    flx_pdf_page_cache cache(std::string(), 2);
+    auto page = [](double width) {
+      flx_layout_geometry geometry;
+      geometry.width = width;
+      return geometry;
+    };
+    auto a = page(1.0);
+    auto b = page(2.0);
+    cache.store("a", a);
+    cache.store("b", b);
+
+    WHEN("a is read and c is stored") {
+      flx_layout_geometry restored;
+      REQUIRE(cache.load("a", restored));
+      auto c = page(3.0);
+      cache.store("c", c);
+
+      THEN("The least recently used page b was dropped") {
+        REQUIRE(cache.size() == 2);
+        REQUIRE(cache.get_stats().evictions == 1);
+        REQUIRE_FALSE(cache.load("b", restored));
+        REQUIRE(cache.load("a", restored));
+        REQUIRE(restored.width.value() == Catch::Approx(1.0));
+        REQUIRE(cache.load("c", restored));
+      }
+    }
+  }
+}
+
+SCENARIO("Page cache speeds up re-parsing an edited document", "[benchmark][pdf][page_cache]") {
+  const int page_count = 30;
+  flx_string original = build_document(page_count, 200);
+  flx_string edited = build_document(page_count, 200, 7, 250.0);
+  flx_pdf_sio::parse_options options;
+  options.threads = 1;
+
+  auto parse_ms = [&](const flx_string& data, flx_pdf_page_cache* cache) {
+    flx_pdf_sio reader;
+    reader.set_parse_options(options);
+    reader.set_page_cache(cache);
+    flx_string copy = data;
+    auto start = std::chrono::steady_clock::now();
+    REQUIRE(reader.parse(copy));
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  };
+
+  flx_pdf_page_cache cache;
+  double uncached_ms = parse_ms(edited, nullptr);
+  double cold_ms = parse_ms(original, &cache);
+  double warm_ms = parse_ms(edited, &cache);
+
+  std::cout << "⏱️  " << page_count << " pages: parse " << uncached_ms << " ms, filling the cache "
+            << cold_ms << " ms, edited re-parse " << warm_ms << " ms" << std::endl;
+
+  REQUIRE(cache.get_stats().hits == page_count - 1);
+  REQUIRE(cache.get_stats().misses == page_count + 1);
+}
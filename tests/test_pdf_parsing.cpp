@@ -95,4 +95,154 @@ SCENARIO("Round-trip testing framework") {
             }
         }
     }
-}
\ No newline at end of file
+}
+SCENARIO("Parallel page pipeline produces the same layout as sequential parsing") {
+    GIVEN("A serialized document with several text pages") {
+        flx_pdf_sio source;
+        for (int p = 0; p < 6; ++p) {
+            auto& page = source.add_page();
+            page.width = 595.0;
+            page.height = 842.0;
+
+            flx_layout_geometry box;
+            box.vertices.push_back(flx_layout_vertex(50.0, 50.0));
+            box.vertices.push_back(flx_layout_vertex(545.0, 50.0));
+            box.vertices.push_back(flx_layout_vertex(545.0, 792.0));
+            box.vertices.push_back(flx_layout_vertex(50.0, 792.0));
+            for (int line = 0; line < 4; ++line) {
+                flx_layout_text text;
+                text.x = 60.0;
+                text.y = 100.0 + line * 40.0;
+                text.text = "Page " + std::to_string(p + 1) + " line " + std::to_string(line + 1);
+                text.font_size = 12.0;
+                box.add_text(text);
+            }
+            page.add_sub_geometry(box);
+        }
+        flx_string pdf_data;
+        REQUIRE(source.serialize(pdf_data));
+
+        WHEN("Parsing it with one thread and with four threads") {
+            flx_pdf_sio sequential;
+            flx_pdf_sio::parse_options one;
+            one.threads = 1;
+            sequential.set_parse_options(one);
+            REQUIRE(sequential.parse(pdf_data));
+
+            flx_pdf_sio parallel;
+            flx_pdf_sio::parse_options four;
+            four.threads = 4;
+            four.max_pages_in_flight = 3;
+            parallel.set_parse_options(four);
+            REQUIRE(parallel.parse(pdf_data));
+
+            THEN("Pages and texts are identical and in page order") {
+                REQUIRE(parallel.pages.size() == 6);
+                REQUIRE(sequential.pages.size() == parallel.pages.size());
+                for (size_t p = 0; p < parallel.pages.size(); ++p) {
+                    auto& a = sequential.pages[p];
+                    auto& b = parallel.pages[p];
+                    REQUIRE(a.texts.size() == b.texts.size());
+                    REQUIRE(b.texts.size() > 0);
+                    for (size_t t = 0; t < b.texts.size(); ++t) {
+                        REQUIRE(*a.texts[t].text == *b.texts[t].text);
+                        REQUIRE(a.texts[t].x == b.texts[t].x);
+                        REQUIRE(a.texts[t].y == b.texts[t].y);
+                    }
+                    REQUIRE(b.texts[0].text->contains("Page " + std::to_string(p + 1)));
+                }
+            }
+
+            THEN("Per-stage timings are reported") {
+                auto& timings = parallel.get_stage_timings();
+                bool has_extract = false;
+                for (auto& stage : timings) {
+                    if (stage.name == "extract_text") {
+                        has_extract = true;
+                        REQUIRE(stage.count == 6);
+                    }
+                }
+                REQUIRE(has_extract);
+                REQUIRE(timings.back().name == "total");
+            }
+        }
+    }
+}
+
+SCENARIO("Parsing a memory-mapped file gives the same layout as parsing its bytes") {
+    GIVEN("A serialized document written to a file") {
+        flx_pdf_sio source;
+        for (int p = 0; p < 3; ++p) {
+            auto& page = source.add_page();
+            flx_layout_text text;
+            text.x = 80.0;
+            text.y = 120.0;
+            text.text = "Mapped page " + std::to_string(p + 1);
+            text.font_size = 12.0;
+            page.add_text(text);
+        }
+        flx_string pdf_data;
+        REQUIRE(source.serialize(pdf_data));
+
+        std::filesystem::path path = std::filesystem::temp_directory_path() / "flx_pdf_parse_file_test.pdf";
+        {
+            std::ofstream file(path, std::ios::binary);
+            file.write(pdf_data.c_str(), pdf_data.size());
+        }
+
+        WHEN("Parsing the file on four threads and the bytes sequentially") {
+            flx_pdf_sio from_file;
+            flx_pdf_sio::parse_options four;
+            four.threads = 4;
+            from_file.set_parse_options(four);
+            REQUIRE(from_file.parse_file(path.string()));
+
+            flx_pdf_sio from_bytes;
+            REQUIRE(from_bytes.parse(pdf_data));
+
+            THEN("Both find the same texts") {
+                REQUIRE(from_file.pages.size() == 3);
+                for (size_t p = 0; p < 3; ++p) {
+                    REQUIRE(from_file.pages[p].texts.size() == from_bytes.pages[p].texts.size());
+                    REQUIRE(*from_file.pages[p].texts[0].text == *from_bytes.pages[p].texts[0].text);
+                    REQUIRE(from_file.pages[p].texts[0].x == from_bytes.pages[p].texts[0].x);
+                }
+            }
+
+            THEN("The parser can switch back to parsing bytes") {
+                REQUIRE(from_file.parse(pdf_data));
+                REQUIRE(from_file.pages.size() == 3);
+                REQUIRE(from_file.pages[2].texts[0].text->contains("Mapped page 3"));
+            }
+        }
+
+        WHEN("The file is copied into memory and then truncated") {
+            flx_pdf_sio from_copy;
+            flx_pdf_sio::parse_options copy;
+            copy.copy_input = true;
+            from_copy.set_parse_options(copy);
+            REQUIRE(from_copy.parse_file(path.string()));
+
+            flx_mapped_file input(path.string(), flx_mapped_file::mode::copy);
+            REQUIRE(input.is_open());
+            std::filesystem::resize_file(path, 0);
+
+            THEN("The copy keeps every byte, where a mapping would fault") {
+                REQUIRE(from_copy.pages.size() == 3);
+                REQUIRE(from_copy.pages[1].texts[0].text->contains("Mapped page 2"));
+                REQUIRE(input.size() == pdf_data.size());
+                REQUIRE(input.view() == std::string_view(pdf_data.c_str(), pdf_data.size()));
+            }
+        }
+
+        WHEN("The file does not exist") {
+            flx_pdf_sio parser;
+
+            THEN("parse_file fails") {
+                REQUIRE_FALSE(parser.parse_file((path.string() + ".missing")));
+            }
+        }
+
+        std::filesystem::remove(path);
+    }
+}
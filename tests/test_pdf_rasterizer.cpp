@@ -0,0 +1,214 @@
+#include <catch2/catch_all.hpp>
+#include "../documents/pdf/flx_pdf_rasterizer.h"
+#include "../documents/pdf/flx_pdf_sio.h"
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+namespace {
+  std::string ppm_image(int width, int height, unsigned char r, unsigned char g, unsigned char b,
+                        const std::string& comment = "") {
+    std::string ppm = "P6\n";
+    if (!comment.empty()) ppm += "# " + comment + "\n";
+    ppm += std::to_string(width) + " " + std::to_string(height) + "\n255\n";
+    for (int i = 0; i < width * height; ++i) {
+      ppm.push_back(static_cast<char>(r));
+      ppm.push_back(static_cast<char>(g));
+      ppm.push_back(static_cast<char>(b));
+    }
+    return ppm;
+  }
+
+  // Stand-in for pdftoppm: swallows stdin, logs its arguments, prints two pages
+  std::string write_fake_pdftoppm(const std::filesystem::path& dir, const std::string& ppm) {
+    std::filesystem::create_directories(dir);
+    std::ofstream(dir / "pages.ppm", std::ios::binary) << ppm;
+    std::filesystem::path script = dir / "fake_pdftoppm";
+    std::ofstream out(script);
+    out << "#!/bin/sh\n"
+        << "cat > '" << (dir / "stdin.pdf").string() << "'\n"
+        << "echo \"$@\" > '" << (dir / "args.txt").string() << "'\n"
+        << "cat '" << (dir / "pages.ppm").string() << "'\n";
+    out.close();
+    std::filesystem::permissions(script, std::filesystem::perms::owner_all);
+    return script.string();
+  }
+
+  std::string read_file(const std::filesystem::path& path) {
+    std::ifstream in(path, std::ios::binary);
+    return std::string((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+  }
+}
+
+SCENARIO("ppm_stream decodes concatenated PPM images from arbitrary pieces", "[unit][pure][rasterizer]") {
+  GIVEN("Two images, the first with a header comment") {
+    std::string stream = ppm_image(3, 2, 255, 0, 0, "page 1") + ppm_image(2, 2, 10, 20, 30);
+
+    WHEN("The stream arrives one byte at a time") {
+      flx_pdf_rasterizer::ppm_stream reader;
+      std::vector<cv::Mat> images;
+      for (char c : stream) {
+        REQUIRE(reader.feed(&c, 1));
+        cv::Mat image;
+        while (reader.pop(image)) images.push_back(image);
+      }
+
+      THEN("Both images come out complete, in order and as BGR") {
+        REQUIRE(images.size() == 2);
+        REQUIRE(images[0].cols == 3);
+        REQUIRE(images[0].rows == 2);
+        REQUIRE(images[0].at<cv::Vec3b>(1, 2)[0] == 0);
+        REQUIRE(images[0].at<cv::Vec3b>(1, 2)[2] == 255);
+        REQUIRE(images[1].cols == 2);
+        REQUIRE(images[1].at<cv::Vec3b>(0, 0)[0] == 30);
+        REQUIRE(images[1].at<cv::Vec3b>(0, 0)[1] == 20);
+        REQUIRE(images[1].at<cv::Vec3b>(0, 0)[2] == 10);
+        REQUIRE_FALSE(reader.incomplete());
+      }
+    }
+
+    WHEN("The stream is cut in the middle of the second raster") {
+      flx_pdf_rasterizer::ppm_stream reader;
+      REQUIRE(reader.feed(stream.data(), stream.size() - 4));
+      cv::Mat image;
+      int count = 0;
+      while (reader.pop(image)) ++count;
+
+      THEN("Only the first image is ready and the reader reports the rest as incomplete") {
+        REQUIRE(count == 1);
+        REQUIRE(reader.incomplete());
+      }
+    }
+  }
+
+  GIVEN("Data that is not a binary PPM") {
+    flx_pdf_rasterizer::ppm_stream reader;
+    std::string png_magic = "\x89PNG\r\n";
+    THEN("feed fails and keeps failing") {
+      REQUIRE_FALSE(reader.feed(png_magic.data(), png_magic.size()));
+      REQUIRE(reader.failed());
+      REQUIRE_FALSE(reader.feed("P6", 2));
+    }
+  }
+
+  GIVEN("A 16-bit PPM") {
+    flx_pdf_rasterizer::ppm_stream reader;
+    std::string header = "P6 1 1 65535 ";
+    THEN("It is rejected") {
+      REQUIRE_FALSE(reader.feed(header.data(), header.size()));
+    }
+  }
+}
+
+SCENARIO("pdftoppm backend streams pages through pipes", "[unit][rasterizer]") {
+  std::filesystem::path dir = std::filesystem::temp_directory_path() / "flx_rasterizer_test";
+  std::string pdf = "%PDF-1.4 fake document";
+
+  GIVEN("A pdftoppm stand-in that prints two pages") {
+    std::string script = write_fake_pdftoppm(dir, ppm_image(4, 3, 0, 255, 0) + ppm_image(4, 3, 0, 0, 255));
+
+    flx_pdf_rasterizer::options options;
+    options.engine = flx_pdf_rasterizer::backend::pdftoppm;
+    options.pdftoppm_path = script;
+    options.dpi = 96;
+    options.first_page = 2;
+    options.last_page = 3;
+
+    WHEN("Rendering into a vector") {
+      flx_pdf_rasterizer rasterizer(options);
+      std::vector<cv::Mat> pages;
+      bool ok = rasterizer.render(pdf.data(), pdf.size(), pages);
+
+      THEN("The PDF went in on stdin, DPI and range on the command line, pages came out in memory") {
+        REQUIRE(ok);
+        REQUIRE(rasterizer.last_error().empty());
+        REQUIRE(pages.size() == 2);
+        REQUIRE(pages[0].at<cv::Vec3b>(0, 0)[1] == 255);
+        REQUIRE(pages[1].at<cv::Vec3b>(2, 3)[0] == 255);
+        REQUIRE(read_file(dir / "stdin.pdf") == pdf);
+        REQUIRE(read_file(dir / "args.txt") == "-r 96 -f 2 -l 3 -\n");
+      }
+    }
+
+    WHEN("The callback stops after the first page") {
+      flx_pdf_rasterizer rasterizer(options);
+      std::vector<int> numbers;
+      bool ok = rasterizer.render(pdf.data(), pdf.size(), [&](int number, cv::Mat&) {
+        numbers.push_back(number);
+        return false;
+      });
+
+      THEN("Rendering ends early without an error") {
+        REQUIRE(ok);
+        REQUIRE(numbers == std::vector<int>{2});
+      }
+    }
+  }
+
+  GIVEN("A pdftoppm that cannot be found") {
+    flx_pdf_rasterizer::options options;
+    options.engine = flx_pdf_rasterizer::backend::pdftoppm;
+    options.pdftoppm_path = (dir / "missing_pdftoppm").string();
+    flx_pdf_rasterizer rasterizer(options);
+    std::vector<cv::Mat> pages;
+
+    THEN("render fails with a message") {
+      REQUIRE_FALSE(rasterizer.render(pdf.data(), pdf.size(), pages));
+      REQUIRE_FALSE(rasterizer.last_error().empty());
+    }
+  }
+
+  GIVEN("An invalid page range") {
+    flx_pdf_rasterizer::options options;
+    options.first_page = 3;
+    options.last_page = 2;
+    flx_pdf_rasterizer rasterizer(options);
+    std::vector<cv::Mat> pages;
+
+    THEN("render refuses before starting anything") {
+      REQUIRE_FALSE(rasterizer.render(pdf.data(), pdf.size(), pages));
+      REQUIRE(rasterizer.last_error().find("page range") != std::string::npos);
+    }
+  }
+
+  std::filesystem::remove_all(dir);
+}
+
+SCENARIO("flx_pdf_sio renders a serialized document without temp files", "[rasterizer]") {
+  bool backend_available = flx_pdf_rasterizer::poppler_available() ||
+                           std::system("pdftoppm -v > /dev/null 2>&1") == 0;
+  if (!backend_available) {
+    WARN("Neither poppler-cpp nor pdftoppm available - skipping");
+    return;
+  }
+
+  GIVEN("A three page A4 document") {
+    flx_pdf_sio pdf_doc;
+    for (int p = 0; p < 3; ++p) {
+      auto& page = pdf_doc.add_page();
+      page.width = 595.0;
+      page.height = 842.0;
+    }
+    flx_string pdf_data;
+    REQUIRE(pdf_doc.serialize(pdf_data));
+    REQUIRE(pdf_doc.parse(pdf_data));
+
+    WHEN("Rendering pages 2-3 at 72 DPI") {
+      flx_pdf_rasterizer::options options;
+      options.dpi = 72;
+      options.first_page = 2;
+      options.last_page = 3;
+      std::vector<cv::Mat> images;
+      bool ok = pdf_doc.render(images, options);
+
+      THEN("Two page-sized BGR images are returned") {
+        REQUIRE(ok);
+        REQUIRE(images.size() == 2);
+        REQUIRE(std::abs(images[0].cols - 595) <= 1);
+        REQUIRE(std::abs(images[0].rows - 842) <= 1);
+        REQUIRE(images[0].type() == CV_8UC3);
+      }
+    }
+  }
+}
@@ -0,0 +1,345 @@
+#include <catch2/catch_all.hpp>
+#include "../documents/pdf/flx_pdf_regions.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <stack>
+
+namespace {
+
+  // The per-seed flood fill detect_color_regions used before (reference)
+  struct reference_region {
+    int pixel_count = 0;
+    cv::Rect bounding_box;
+    double sum[3] = {0, 0, 0};
+    cv::Mat mask;
+  };
+
+  std::vector<reference_region> flood_fill_regions(const cv::Mat& image, int tolerance, int min_area) {
+    std::vector<reference_region> regions;
+    cv::Mat processed = cv::Mat::zeros(image.size(), CV_8UC1);
+    const int dx[] = {0, 0, -1, 1};
+    const int dy[] = {-1, 1, 0, 0};
+    for (int y = 0; y < image.rows; y++) {
+      for (int x = 0; x < image.cols; x++) {
+        if (processed.at<uchar>(y, x) > 0) continue;
+        reference_region region;
+        region.mask = cv::Mat::zeros(image.size(), CV_8UC1);
+        int min_x = x, max_x = x, min_y = y, max_y = y;
+        std::stack<cv::Point> stack;
+        stack.push(cv::Point(x, y));
+        while (!stack.empty()) {
+          cv::Point p = stack.top();
+          stack.pop();
+          if (processed.at<uchar>(p.y, p.x) > 0) continue;
+          processed.at<uchar>(p.y, p.x) = 255;
+          region.mask.at<uchar>(p.y, p.x) = 255;
+          region.pixel_count++;
+          min_x = std::min(min_x, p.x); max_x = std::max(max_x, p.x);
+          min_y = std::min(min_y, p.y); max_y = std::max(max_y, p.y);
+          cv::Vec3b c = image.at<cv::Vec3b>(p.y, p.x);
+          for (int k = 0; k < 3; ++k) region.sum[k] += c[k];
+          for (int i = 0; i < 4; i++) {
+            int nx = p.x + dx[i], ny = p.y + dy[i];
+            if (nx < 0 || ny < 0 || nx >= image.cols || ny >= image.rows) continue;
+            if (processed.at<uchar>(ny, nx) > 0) continue;
+            cv::Vec3b n = image.at<cv::Vec3b>(ny, nx);
+            int diff = std::abs(c[0] - n[0]) + std::abs(c[1] - n[1]) + std::abs(c[2] - n[2]);
+            if (diff <= tolerance) stack.push(cv::Point(nx, ny));
+          }
+        }
+        if (region.pixel_count >= min_area) {
+          region.bounding_box = cv::Rect(min_x, min_y, max_x - min_x + 1, max_y - min_y + 1);
+          regions.push_back(region);
+        }
+      }
+    }
+    return regions;
+  }
+
+  void fill_rect(cv::Mat& image, int x0, int y0, int x1, int y1, cv::Vec3b color) {
+    for (int y = y0; y < y1; ++y)
+      for (int x = x0; x < x1; ++x)
+        image.at<cv::Vec3b>(y, x) = color;
+  }
+
+  // Page-like test image: background, boxes, a nested box, a gradient band,
+  // a U shape that only joins at its bottom, and sprinkled specks
+  cv::Mat synthetic_page(int width, int height, unsigned seed) {
+    cv::Mat image(height, width, CV_8UC3);
+    fill_rect(image, 0, 0, width, height, cv::Vec3b(246, 244, 247));
+    fill_rect(image, width / 10, height / 10, width / 2, height / 3, cv::Vec3b(200, 60, 30));
+    fill_rect(image, width / 6, height / 6, width / 3, height / 4, cv::Vec3b(20, 180, 40));
+    for (int x = width / 2 + 10; x < width - 10; ++x) {
+      uchar v = static_cast<uchar>(40 + (x * 150) / width);  // neighbours differ by at most a few steps
+      fill_rect(image, x, height / 2, x + 1, height / 2 + height / 8, cv::Vec3b(v, v, 90));
+    }
+    int ux = width / 8, uy = height * 2 / 3, u = std::min(width, height) / 4;
+    fill_rect(image, ux, uy, ux + u / 5, uy + u, cv::Vec3b(0, 0, 200));
+    fill_rect(image, ux + u - u / 5, uy, ux + u, uy + u, cv::Vec3b(0, 0, 200));
+    fill_rect(image, ux, uy + u - u / 5, ux + u, uy + u, cv::Vec3b(0, 0, 200));
+    std::mt19937 rng(seed);
+    for (int i = 0; i < width * height / 400; ++i) {
+      int x = static_cast<int>(rng() % static_cast<unsigned>(width - 3));
+      int y = static_cast<int>(rng() % static_cast<unsigned>(height - 3));
+      fill_rect(image, x, y, x + 1 + static_cast<int>(rng() % 3), y + 1 + static_cast<int>(rng() % 3), cv::Vec3b(30, 30, 30));
+    }
+    return image;
+  }
+
+  bool same_regions(const std::vector<flx_color_region>& actual, const std::vector<reference_region>& expected, cv::Size size) {
+    if (actual.size() != expected.size()) return false;
+    for (size_t i = 0; i < actual.size(); ++i) {
+      const auto& a = actual[i];
+      const auto& e = expected[i];
+      if (a.pixel_count != e.pixel_count) return false;
+      if (a.bounding_box.x != e.bounding_box.x || a.bounding_box.y != e.bounding_box.y ||
+          a.bounding_box.width != e.bounding_box.width || a.bounding_box.height != e.bounding_box.height) return false;
+      for (int k = 0; k < 3; ++k) {
+        if (std::fabs(a.mean_color[k] - e.sum[k] / e.pixel_count) > 1e-6) return false;
+      }
+      cv::Mat mask = a.to_mask(size);
+      for (int y = 0; y < size.height; ++y)
+        for (int x = 0; x < size.width; ++x)
+          if (mask.at<uchar>(y, x) != e.mask.at<uchar>(y, x)) return false;
+    }
+    return true;
+  }
+
+}
+
+SCENARIO("Run-based labeling finds the same regions as the flood fill", "[unit][pure][regions]") {
+  GIVEN("Synthetic pages") {
+    for (unsigned seed : {1u, 2u, 3u}) {
+      cv::Mat page = synthetic_page(240, 320, seed);
+
+      WHEN("Labeling page " + std::to_string(seed)) {
+        auto regions = flx_regions::label_color_regions(page, 20, 100);
+        auto expected = flood_fill_regions(page, 20, 100);
+
+        THEN("Regions, order, pixels, boxes and mean colors match") {
+          REQUIRE(regions.size() >= 5);
+          REQUIRE(same_regions(regions, expected, page.size()));
+        }
+      }
+    }
+  }
+
+  GIVEN("A U shape whose arms only join at the bottom") {
+    cv::Mat image(60, 60, CV_8UC3);
+    fill_rect(image, 0, 0, 60, 60, cv::Vec3b(255, 255, 255));
+    fill_rect(image, 10, 10, 20, 50, cv::Vec3b(0, 0, 0));
+    fill_rect(image, 40, 10, 50, 50, cv::Vec3b(0, 0, 0));
+    fill_rect(image, 10, 40, 50, 50, cv::Vec3b(0, 0, 0));
+
+    WHEN("Labeling it") {
+      auto regions = flx_regions::label_color_regions(image, 20, 1);
+
+      THEN("Background and U are one region each, stored as runs") {
+        REQUIRE(regions.size() == 2);
+        REQUIRE(regions[0].pixel_count == 3600 - 1000);
+        REQUIRE(regions[1].pixel_count == 1000);
+        REQUIRE(regions[1].bounding_box.x == 10);
+        REQUIRE(regions[1].bounding_box.width == 40);
+        REQUIRE(regions[1].runs.size() == 30 * 2 + 10);
+
+        cv::Mat local = regions[1].to_local_mask(1);
+        REQUIRE(local.cols == 42);
+        REQUIRE(local.rows == 42);
+        REQUIRE(local.at<uchar>(0, 0) == 0);
+        REQUIRE(local.at<uchar>(1, 1) == 255);
+        REQUIRE(local.at<uchar>(1, 15) == 0);
+      }
+    }
+  }
+
+  GIVEN("A gradient whose ends differ far more than the tolerance") {
+    cv::Mat image(4, 100, CV_8UC3);
+    for (int x = 0; x < 100; ++x) fill_rect(image, x, 0, x + 1, 4, cv::Vec3b(static_cast<uchar>(x * 2), 0, 0));
+
+    THEN("Neighbour-to-neighbour similarity keeps it in one region") {
+      auto regions = flx_regions::label_color_regions(image, 20, 1);
+      REQUIRE(regions.size() == 1);
+      REQUIRE(regions[0].pixel_count == 400);
+    }
+  }
+
+  GIVEN("Invalid input") {
+    THEN("Empty or non-BGR images give no regions") {
+      REQUIRE(flx_regions::label_color_regions(cv::Mat(), 20, 1).empty());
+      REQUIRE(flx_regions::label_color_regions(cv::Mat::zeros(10, 10, CV_8UC1), 20, 1).empty());
+    }
+  }
+}
+
+SCENARIO("Labeling an A4 page at 150 DPI", "[benchmark][regions]") {
+  GIVEN("A 1240x1754 synthetic page") {
+    cv::Mat page = synthetic_page(1240, 1754, 7);
+
+    WHEN("Comparing flood fill and run-based labeling") {
+      auto t0 = std::chrono::steady_clock::now();
+      auto expected = flood_fill_regions(page, 20, 100);
+      auto t1 = std::chrono::steady_clock::now();
+      std::vector<flx_color_region> regions;
+      const int rounds = 5;
+      for (int i = 0; i < rounds; ++i) {
+        regions = flx_regions::label_color_regions(page, 20, 100);
+      }
+      auto t2 = std::chrono::steady_clock::now();
+
+      double flood_ms = std::chrono::duration<double, std::milli>(t1 - t0).count();
+      double label_ms = std::chrono::duration<double, std::milli>(t2 - t1).count() / rounds;
+      std::cout << "⏱️  Color regions per page: flood fill " << flood_ms << " ms, labeling "
+                << label_ms << " ms (" << regions.size() << " regions)" << std::endl;
+
+      THEN("Results match and labeling is faster") {
+        REQUIRE(regions.size() == expected.size());
+        for (size_t i = 0; i < regions.size(); ++i) {
+          REQUIRE(regions[i].pixel_count == expected[i].pixel_count);
+        }
+        REQUIRE(label_ms < flood_ms);
+      }
+    }
+  }
+}
+
+namespace {
+
+  std::vector<flx_regions::simd_level> available_levels() {
+    std::vector<flx_regions::simd_level> levels{flx_regions::simd_level::scalar};
+    if (flx_regions::supported_simd_level() >= flx_regions::simd_level::ssse3) levels.push_back(flx_regions::simd_level::ssse3);
+    if (flx_regions::supported_simd_level() >= flx_regions::simd_level::avx2) levels.push_back(flx_regions::simd_level::avx2);
+    return levels;
+  }
+
+  // Random BGR bytes with runs of repeated pixels, so rows have both long
+  // similar stretches and breaks
+  std::vector<uchar> random_pixels(int count, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::vector<uchar> bytes(static_cast<size_t>(count) * 3);
+    for (int i = 0; i < count; ++i) {
+      bool repeat = i > 0 && rng() % 4 != 0;
+      for (int c = 0; c < 3; ++c) {
+        bytes[3 * i + c] = repeat ? static_cast<uchar>(bytes[3 * (i - 1) + c] + rng() % 5) : static_cast<uchar>(rng());
+      }
+    }
+    return bytes;
+  }
+
+  template <typename F>
+  double time_ms(int rounds, F&& body) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < rounds; ++i) body();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / rounds;
+  }
+
+}
+
+SCENARIO("SIMD pixel kernels match the scalar kernels", "[unit][pure][regions][simd]") {
+  flx_regions::simd_level original = flx_regions::active_simd_level();
+
+  GIVEN("Rows of every length up to 100 pixels and beyond the vector widths") {
+    for (flx_regions::simd_level level : available_levels()) {
+      WHEN(std::string("Running the ") + flx_regions::simd_level_name(level) + " kernels") {
+        THEN("Distance map, runs and sums equal the scalar results") {
+          for (int count : {0, 1, 2, 15, 16, 17, 31, 32, 33, 47, 64, 100, 1240}) {
+            auto a = random_pixels(count + 1, static_cast<unsigned>(count));
+            auto b = random_pixels(count + 1, static_cast<unsigned>(count) + 99);
+            for (int tolerance : {-1, 0, 20, 254, 255, 300, 765}) {
+              std::vector<uchar> expected(static_cast<size_t>(count) + 1), actual(static_cast<size_t>(count) + 1);
+              flx_regions::set_simd_level(flx_regions::simd_level::scalar);
+              flx_regions::similar_pixels(a.data(), b.data(), count, tolerance, expected.data());
+              flx_regions::set_simd_level(level);
+              flx_regions::similar_pixels(a.data(), b.data(), count, tolerance, actual.data());
+              REQUIRE(actual == expected);
+            }
+
+            std::vector<uchar> joined(static_cast<size_t>(count) + 1);
+            flx_regions::similar_pixels(a.data(), a.data() + 3, count, 6, joined.data());
+            std::vector<int> expected_ends(static_cast<size_t>(count) + 2), actual_ends(static_cast<size_t>(count) + 2);
+            flx_regions::set_simd_level(flx_regions::simd_level::scalar);
+            int expected_runs = flx_regions::encode_runs(joined.data(), count, expected_ends.data());
+            uint64_t expected_sums[3];
+            flx_regions::sum_pixels(a.data(), count, expected_sums);
+            flx_regions::set_simd_level(level);
+            int actual_runs = flx_regions::encode_runs(joined.data(), count, actual_ends.data());
+            uint64_t actual_sums[3];
+            flx_regions::sum_pixels(a.data(), count, actual_sums);
+
+            REQUIRE(actual_runs == expected_runs);
+            REQUIRE(actual_ends == expected_ends);
+            long breaks = std::count(joined.begin(), joined.begin() + std::max(0, count - 1), 0);
+            REQUIRE(actual_runs == breaks + (count > 0 ? 1 : 0));
+            for (int c = 0; c < 3; ++c) {
+              REQUIRE(actual_sums[c] == expected_sums[c]);
+            }
+          }
+        }
+
+        THEN("Labeling a page gives the same regions") {
+          cv::Mat page = synthetic_page(240, 320, 5);
+          flx_regions::set_simd_level(level);
+          auto regions = flx_regions::label_color_regions(page, 20, 100);
+          REQUIRE(same_regions(regions, flood_fill_regions(page, 20, 100), page.size()));
+        }
+      }
+    }
+  }
+
+  THEN("Levels above the supported one are clamped") {
+    flx_regions::set_simd_level(flx_regions::simd_level::avx2);
+    REQUIRE(flx_regions::active_simd_level() == flx_regions::supported_simd_level());
+  }
+
+  flx_regions::set_simd_level(original);
+}
+
+SCENARIO("Pixel kernels per instruction set on A4 rows at 150 DPI", "[benchmark][regions][simd]") {
+  flx_regions::simd_level original = flx_regions::active_simd_level();
+  const int width = 1240;
+  const int rows = 1754;
+  cv::Mat page = synthetic_page(width, rows, 7);
+  std::vector<uchar> joined(width);
+  std::vector<int> run_ends(width);
+  std::vector<size_t> run_counts;
+  uint64_t checksum = 0;
+
+  for (flx_regions::simd_level level : available_levels()) {
+    flx_regions::set_simd_level(level);
+
+    double distance_ms = time_ms(5, [&] {
+      for (int y = 1; y < rows; ++y) {
+        flx_regions::similar_pixels(page.ptr<uchar>(y - 1), page.ptr<uchar>(y), width, 20, joined.data());
+      }
+    });
+    size_t runs = 0;
+    double runs_ms = time_ms(5, [&] {
+      runs = 0;
+      for (int y = 0; y < rows; ++y) {
+        flx_regions::similar_pixels(page.ptr<uchar>(y), page.ptr<uchar>(y) + 3, width - 1, 20, joined.data());
+        runs += flx_regions::encode_runs(joined.data(), width, run_ends.data());
+      }
+    });
+    double sums_ms = time_ms(5, [&] {
+      for (int y = 0; y < rows; ++y) {
+        uint64_t sums[3];
+        flx_regions::sum_pixels(page.ptr<uchar>(y), width, sums);
+        checksum += sums[0] + sums[1] + sums[2];
+      }
+    });
+    double label_ms = time_ms(3, [&] { flx_regions::label_color_regions(page, 20, 100); });
+    run_counts.push_back(runs);
+
+    std::cout << "⏱️  " << flx_regions::simd_level_name(level) << ": distance map " << distance_ms
+              << " ms, rows to runs " << runs_ms << " ms, pixel sums " << sums_ms
+              << " ms, labeling " << label_ms << " ms per page" << std::endl;
+  }
+  flx_regions::set_simd_level(original);
+
+  REQUIRE(checksum > 0);
+  for (size_t runs : run_counts) {
+    REQUIRE(runs == run_counts.front());
+  }
+}
@@ -1,8 +1,10 @@
 #include <catch2/catch_all.hpp>
 #include "../documents/pdf/flx_pdf_sio.h"
 #include "../documents/layout/flx_layout_vertex.h"
+#include "shared/pdf_test_helpers.h"
 #include <filesystem>
 #include <fstream>
+#include <set>
 
 SCENARIO("PDF rendering with complete layout system") {
     GIVEN("A PDF document with pages property") {
@@ -303,6 +305,98 @@ SCENARIO("PDF rendering with complete layout system") {
     }
 }
 
+SCENARIO("Serialization shares fonts and images between pages", "[pdf][serialize]") {
+    GIVEN("Four pages showing the same logo from two file paths") {
+        std::filesystem::path dir = std::filesystem::temp_directory_path() / "flx_serialize_test";
+        std::filesystem::create_directories(dir);
+        std::string logo_a = (dir / "logo_a.png").string();
+        std::string logo_b = (dir / "logo_b.png").string();
+        // 4x2 red PNG, written twice
+        static const char png[] =
+            "\x89\x50\x4e\x47\x0d\x0a\x1a\x0a\x00\x00\x00\x0d\x49\x48\x44\x52\x00\x00\x00\x04"
+            "\x00\x00\x00\x02\x08\x02\x00\x00\x00\xf0\xca\xea\x34\x00\x00\x00\x10\x49\x44\x41"
+            "\x54\x78\x9c\x63\xf8\xcf\xc0\x00\x47\x0c\xc8\x1c\x00\x6f\xaa\x07\xf9\x80\xdc\x00"
+            "\x28\x00\x00\x00\x00\x49\x45\x4e\x44\xae\x42\x60\x82";
+        for (const auto& path : {logo_a, logo_b}) {
+            std::ofstream file(path, std::ios::binary);
+            file.write(png, sizeof(png) - 1);
+        }
+        
+        flx_pdf_sio pdf_doc;
+        for (int p = 0; p < 4; p++) {
+            auto& page = pdf_doc.add_page();
+            
+            flx_layout_geometry box;
+            box.fill_color = "#CCCCCC";
+            box.vertices.push_back(flx_layout_vertex(100.0, 100.0));
+            box.vertices.push_back(flx_layout_vertex(200.0, 100.0));
+            box.vertices.push_back(flx_layout_vertex(200.0, 150.0));
+            page.add_sub_geometry(box);
+            
+            flx_layout_text text;
+            text.x = 100.0;
+            text.y = 400.0;
+            text.text = "Seite " + std::to_string(p + 1);
+            text.font_size = 12.0;
+            page.add_text(text);
+            
+            flx_layout_image logo;
+            logo.x = 400.0;
+            logo.y = 50.0;
+            logo.width = 80.0;
+            logo.height = 40.0;
+            logo.image_path = p % 2 == 0 ? logo_a : logo_b;
+            page.add_image(logo);
+        }
+        
+        WHEN("Serializing with one and with four threads") {
+            flx_pdf_sio::serialize_options options;
+            options.threads = 1;
+            pdf_doc.set_serialize_options(options);
+            flx_string sequential;
+            REQUIRE(pdf_doc.serialize(sequential));
+            
+            options.threads = 4;
+            pdf_doc.set_serialize_options(options);
+            flx_string parallel;
+            REQUIRE(pdf_doc.serialize(parallel));
+            
+            THEN("The output is identical and holds one image object") {
+                REQUIRE(page_contents(parallel) == page_contents(sequential));
+                
+                PoDoFo::PdfMemDocument doc;
+                doc.LoadFromBuffer(PoDoFo::bufferview(parallel.c_str(), parallel.size()));
+                REQUIRE(doc.GetPages().GetCount() == 4);
+                
+                std::set<PoDoFo::PdfReference> images;
+                std::set<PoDoFo::PdfReference> fonts;
+                for (unsigned i = 0; i < doc.GetPages().GetCount(); i++) {
+                    auto& resources = doc.GetPages().GetPageAt(i).GetResources();
+                    for (const auto& entry : resources.GetResourceIterator(PoDoFo::PdfResourceType::XObject)) {
+                        images.insert(entry.second->GetIndirectReference());
+                    }
+                    for (const auto& entry : resources.GetResourceIterator(PoDoFo::PdfResourceType::Font)) {
+                        fonts.insert(entry.second->GetIndirectReference());
+                    }
+                }
+                REQUIRE(images.size() == 1);
+                REQUIRE(fonts.size() == 1);
+                REQUIRE(pdf_doc.pages[1].images[0].original_width == 4);
+            }
+            
+            THEN("The texts read back") {
+                flx_pdf_sio reader;
+                REQUIRE(reader.parse(parallel));
+                REQUIRE(reader.pages.size() == 4);
+                flx_string text = reader.pages[3].texts[0].text;
+                REQUIRE(text == "Seite 4");
+            }
+        }
+        
+        std::filesystem::remove_all(dir);
+    }
+}
+
 SCENARIO("Vertex class functionality") {
     GIVEN("Vertex creation") {
         WHEN("Creating with coordinates") {
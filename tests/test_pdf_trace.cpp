@@ -0,0 +1,152 @@
+#include <catch2/catch_all.hpp>
+#include "../documents/pdf/flx_pdf_trace.h"
+#include "../documents/pdf/flx_pdf_sio.h"
+#include "../api/json/flx_json.h"
+#include <opencv2/opencv.hpp>
+#include <filesystem>
+#include <thread>
+
+SCENARIO("PDF trace records spans, counters and artifacts", "[unit][pdf][trace]") {
+  GIVEN("A trace that is switched off") {
+    flx_pdf_trace trace;
+    {
+      flx_pdf_trace::span span(trace, "render");
+    }
+
+    THEN("Nothing is recorded") {
+      REQUIRE_FALSE(trace.spans_enabled());
+      REQUIRE(trace.stages().empty());
+    }
+  }
+
+  GIVEN("A trace with spans enabled") {
+    flx_pdf_trace::options options;
+    options.detail = flx_pdf_trace::level::spans;
+    flx_pdf_trace trace(options);
+
+    WHEN("Several threads record the same stages") {
+      std::vector<std::thread> threads;
+      for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&trace] {
+          for (int i = 0; i < 25; ++i) {
+            flx_pdf_trace::span span(trace, "extract_text");
+            trace.count("texts", 2);
+          }
+        });
+      }
+      for (auto& thread : threads) thread.join();
+      {
+        flx_pdf_trace::span span(trace, "merge");
+      }
+
+      THEN("Stages are summed in order of first appearance") {
+        auto stages = trace.stages();
+        REQUIRE(stages.size() == 2);
+        REQUIRE(stages[0].name == "extract_text");
+        REQUIRE(stages[0].count == 100);
+        REQUIRE(stages[0].min_ms <= stages[0].max_ms);
+        REQUIRE(stages[1].name == "merge");
+        REQUIRE(trace.counters().at("texts") == 200);
+      }
+
+      THEN("The JSON report can be read back") {
+        flxv_map report;
+        flx_json json(&report);
+        REQUIRE(json.parse(trace.to_json()));
+        auto& stages = report["stages"].to_vector();
+        REQUIRE(stages.size() == 2);
+        REQUIRE(stages[0].to_map()["name"].to_string() == "extract_text");
+        REQUIRE(stages[0].to_map()["count"].to_int() == 100);
+        REQUIRE(report["counters"].to_map()["texts"].to_int() == 200);
+      }
+
+      THEN("reset() keeps the options") {
+        trace.reset();
+        REQUIRE(trace.stages().empty());
+        REQUIRE(trace.counters().empty());
+        REQUIRE(trace.spans_enabled());
+      }
+    }
+
+    THEN("Artifacts are not written") {
+      trace.write_artifact(0, "image.png", cv::Mat::zeros(4, 4, CV_8UC3));
+      REQUIRE(trace.artifacts().empty());
+    }
+  }
+
+  GIVEN("A trace capturing artifacts") {
+    std::filesystem::path dir = std::filesystem::temp_directory_path() / "flx_pdf_trace_test";
+    std::filesystem::remove_all(dir);
+    flx_pdf_trace::options options;
+    options.detail = flx_pdf_trace::level::artifacts;
+    options.artifact_dir = dir.string();
+    flx_pdf_trace trace(options);
+
+    WHEN("An image of page 2 is captured") {
+      trace.write_artifact(1, "02_regions.png", cv::Mat::zeros(4, 4, CV_8UC3));
+
+      THEN("It lands in the page directory and is listed") {
+        REQUIRE(trace.artifacts().size() == 1);
+        REQUIRE(trace.artifacts()[0] == (dir / "page_2" / "02_regions.png").string());
+        REQUIRE(std::filesystem::exists(dir / "page_2"));
+      }
+    }
+    std::filesystem::remove_all(dir);
+  }
+}
+
+#ifdef FLX_ENABLE_PDF_TRACE
+SCENARIO("flx_pdf_sio reports pipeline stages through the trace", "[pdf][trace]") {
+  GIVEN("A serialized three page document") {
+    flx_pdf_sio source;
+    for (int p = 0; p < 3; ++p) {
+      auto& page = source.add_page();
+      page.width = 595.0;
+      page.height = 842.0;
+      flx_layout_text text;
+      text.x = 60.0;
+      text.y = 100.0;
+      text.text = "Page " + std::to_string(p + 1);
+      text.font_size = 12.0;
+      page.add_text(text);
+    }
+    flx_string pdf_data;
+    REQUIRE(source.serialize(pdf_data));
+
+    WHEN("Parsing without tracing") {
+      flx_pdf_sio quiet;
+      REQUIRE(quiet.parse(pdf_data));
+
+      THEN("The report is empty") {
+        REQUIRE(quiet.get_trace().stages().empty());
+        REQUIRE(quiet.get_trace().artifacts().empty());
+      }
+    }
+
+    WHEN("Parsing with spans enabled") {
+      flx_pdf_sio traced;
+      flx_pdf_trace::options options;
+      options.detail = flx_pdf_trace::level::spans;
+      traced.set_trace_options(options);
+      REQUIRE(traced.parse(pdf_data));
+
+      THEN("Every pipeline stage shows up once per page") {
+        auto stages = traced.get_trace().stages();
+        auto find = [&stages](const std::string& name) -> const flx_pdf_trace::stage_report* {
+          for (const auto& stage : stages) {
+            if (stage.name == name) return &stage;
+          }
+          return nullptr;
+        };
+        REQUIRE(find("parse") != nullptr);
+        REQUIRE(find("parse")->count == 1);
+        REQUIRE(find("extract_text") != nullptr);
+        REQUIRE(find("extract_text")->count == 3);
+        REQUIRE(find("merge")->count == 3);
+        REQUIRE(traced.get_trace().counters().at("pages") == 3);
+        REQUIRE(traced.get_trace_report().contains("extract_text"));
+      }
+    }
+  }
+}
+#endif
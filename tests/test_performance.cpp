@@ -1,8 +1,10 @@
 #include <catch2/catch_all.hpp>
 #include "../documents/pdf/flx_pdf_sio.h"
 #include "../documents/layout/flx_layout_vertex.h"
+#include "shared/pdf_test_helpers.h"
 #include <chrono>
 #include <iostream>
+#include <thread>
 
 SCENARIO("PDF text extraction performance benchmarks") {
     GIVEN("Complex PDFs with multiple pages and text elements") {
@@ -35,18 +37,33 @@ SCENARIO("PDF text extraction performance benchmarks") {
                 std::cout << "Created page " << (page_num + 1) << " with 200 text elements" << std::endl;
             }
             
-            // Generate PDF
+            // Generate PDF, content streams built on one thread for comparison
+            flx_pdf_sio::serialize_options sequential;
+            sequential.threads = 1;
+            pdf_doc.set_serialize_options(sequential);
+            flx_string sequential_data;
+            auto sequential_start = std::chrono::high_resolution_clock::now();
+            REQUIRE(pdf_doc.serialize(sequential_data));
+            auto sequential_end = std::chrono::high_resolution_clock::now();
+            double sequential_ms = std::chrono::duration<double, std::milli>(sequential_end - sequential_start).count();
+            std::cout << "📝 PDF serialization (1 thread) took: " << sequential_ms << " ms, "
+                      << sequential_data.size() << " bytes" << std::endl;
+            
+            pdf_doc.set_serialize_options(flx_pdf_sio::serialize_options());
             flx_string pdf_data;
             auto serialize_start = std::chrono::high_resolution_clock::now();
             bool serialize_success = pdf_doc.serialize(pdf_data);
             auto serialize_end = std::chrono::high_resolution_clock::now();
             
-            auto serialize_duration = std::chrono::duration_cast<std::chrono::milliseconds>(serialize_end - serialize_start);
-            std::cout << "📝 PDF serialization took: " << serialize_duration.count() << " ms" << std::endl;
+            double serialize_ms = std::chrono::duration<double, std::milli>(serialize_end - serialize_start).count();
+            std::cout << "📝 PDF serialization (" << std::thread::hardware_concurrency() << " threads) took: "
+                      << serialize_ms << " ms" << std::endl;
             
             REQUIRE(serialize_success == true);
             REQUIRE(pdf_data.size() > 0);
             std::cout << "Generated PDF size: " << pdf_data.size() << " bytes" << std::endl;
+            // Pages are attached in order: the thread count does not change the output
+            REQUIRE(page_contents(pdf_data) == page_contents(sequential_data));
             
             THEN("Text extraction should be fast") {
                 auto extraction_start = std::chrono::high_resolution_clock::now();
@@ -0,0 +1,200 @@
+#include <catch2/catch_all.hpp>
+#include "../aiprocesses/snippets/flx_text_segmenter.h"
+#include "../aiprocesses/chat/flx_chat_snippet_source.h"
+#include <chrono>
+#include <iostream>
+
+// ============================================================================
+// text_segmenter - local topic segmentation, chat_snippet_source without LLM
+// ============================================================================
+
+using namespace flx;
+using namespace flx::llm;
+
+namespace {
+
+  class plain_message : public i_llm_message {
+    message_role role;
+    flxv_map data;
+  public:
+    plain_message(message_role r, flxv_map d) : role(r), data(std::move(d)) {}
+    message_role get_role() const noexcept override { return role; }
+    const flx_string& get_content() const override { return data.at("content").string_value(); }
+    void set_role(message_role r) override { role = r; }
+    void set_content(const flx_string& content) override { data["content"] = content; }
+    const flxv_map& get_data() const noexcept override { return data; }
+    std::unique_ptr<i_llm_message> clone() const override { return std::make_unique<plain_message>(role, data); }
+  };
+
+  class plain_context : public i_llm_chat_context {
+    std::vector<std::unique_ptr<i_llm_message>> messages;
+    std::vector<unsigned long long> ids;
+    unsigned long long next_id = 1;
+  public:
+    void replace_system_message(const flx_string&) override {}
+    void set_settings(const flxv_map&) override {}
+    void add_message(std::unique_ptr<i_llm_message> message) override {
+      messages.push_back(std::move(message));
+      ids.push_back(next_id++);
+    }
+    const std::vector<std::unique_ptr<i_llm_message>>& get_messages() const noexcept override { return messages; }
+    unsigned long long get_message_id(size_t index) const override { return ids[index]; }
+    // Like a context window dropping old history
+    void erase(size_t first, size_t last) {
+      messages.erase(messages.begin() + first, messages.begin() + last);
+      ids.erase(ids.begin() + first, ids.begin() + last);
+    }
+    std::unique_ptr<i_llm_chat_context> clone() const override {
+      auto copy = std::make_unique<plain_context>();
+      for (const auto& m : messages) copy->add_message(m->clone());
+      return copy;
+    }
+  };
+
+  void add(plain_context& context, message_role role, const flx_string& content) {
+    flxv_map data;
+    data["role"] = role == message_role::SYSTEM ? "system" : role == message_role::USER ? "user" : "assistant";
+    data["content"] = content;
+    context.add_message(std::make_unique<plain_message>(role, data));
+  }
+
+  const char* invoice_text =
+    "The invoice from Mueller GmbH arrived yesterday. The invoice total is 1,250.00 EUR including tax. "
+    "Payment of the invoice is due within 30 days. The invoice number is R-2024-117 and the payment reference is printed below.";
+
+  const char* weather_text =
+    "The weather forecast for the weekend looks sunny. Temperatures will rise to 25 degrees on Saturday. "
+    "Rain is expected on Sunday evening with strong wind. The weather service warns about thunderstorms and wind gusts.";
+
+}
+
+SCENARIO("split_sentences finds sentence and paragraph boundaries", "[unit][pure]") {
+  GIVEN("Text with abbreviations, decimals and a blank line") {
+    std::string text = "Dr. Smith paid 3.50 EUR, e.g. by card. Then he left!\n\nA new paragraph starts here. It ends here";
+    auto sentences = text_segmenter::split_sentences(text);
+
+    THEN("Only real sentence ends split, the blank line marks a paragraph") {
+      REQUIRE(sentences.size() == 4);
+      REQUIRE(text.substr(sentences[0].begin, sentences[0].end - sentences[0].begin) == "Dr. Smith paid 3.50 EUR, e.g. by card.");
+      REQUIRE(text.substr(sentences[1].begin, sentences[1].end - sentences[1].begin) == "Then he left!");
+      REQUIRE_FALSE(sentences[1].paragraph_start);
+      REQUIRE(sentences[2].paragraph_start);
+      REQUIRE(text.substr(sentences[3].begin, sentences[3].end - sentences[3].begin) == "It ends here");
+    }
+  }
+}
+
+SCENARIO("text_segmenter splits a message at topic shifts", "[unit][pure]") {
+  GIVEN("A message about an invoice followed by one about the weather") {
+    text_segmenter segmenter;
+    auto segments = segmenter.segment_message(flx_string(invoice_text) + " " + weather_text);
+
+    THEN("Two segments with their own topic labels") {
+      REQUIRE(segments.size() == 2);
+      REQUIRE(segments[0].text == invoice_text);
+      REQUIRE(segments[1].text == weather_text);
+      REQUIRE(segments[0].topic.contains("invoice"));
+      REQUIRE(segments[1].topic.contains("weather"));
+      REQUIRE_FALSE(segments[0].continues_previous);
+    }
+  }
+
+  GIVEN("A single-topic message") {
+    text_segmenter segmenter;
+    auto segments = segmenter.segment_message(invoice_text);
+
+    THEN("It stays one segment") {
+      REQUIRE(segments.size() == 1);
+      REQUIRE(segments[0].text == invoice_text);
+    }
+  }
+
+  GIVEN("Messages fed one after another") {
+    text_segmenter segmenter;
+    auto first = segmenter.segment_message(invoice_text);
+    auto second = segmenter.segment_message("Can you check the invoice payment status? I think the invoice is already paid.");
+    auto third = segmenter.segment_message(weather_text);
+
+    THEN("A follow-up continues the topic, a new subject starts a new one") {
+      REQUIRE(second.size() == 1);
+      REQUIRE(second[0].continues_previous);
+      REQUIRE(second[0].topic == first[0].topic);
+      REQUIRE(third.size() == 1);
+      REQUIRE_FALSE(third[0].continues_previous);
+      segmenter.reset();
+      REQUIRE_FALSE(segmenter.segment_message(invoice_text)[0].continues_previous);
+    }
+  }
+}
+
+SCENARIO("chat_snippet_source segments chats without an LLM", "[unit][pure]") {
+  GIVEN("A chat context with a system prompt, two messages and a tool call") {
+    auto context = std::make_shared<plain_context>();
+    add(*context, message_role::SYSTEM, "You are helpful.");
+    add(*context, message_role::USER, flx_string(invoice_text) + "\n\n" + weather_text);
+    flxv_map tool_call;
+    tool_call["role"] = "assistant";
+    tool_call["tool_calls"] = flxv_vector();
+    context->add_message(std::make_unique<plain_message>(message_role::ASSISTANT, tool_call));
+    add(*context, message_role::ASSISTANT, "The weather on Sunday brings rain and wind, so stay inside.");
+
+    chat_snippet_source source(context);
+
+    WHEN("Processing the changes") {
+      source.process_changes();
+      std::vector<snippet> snippets;
+      while (!source.end_reached()) snippets.push_back(source.get_snippet());
+
+      THEN("Every topic becomes a snippet with its origin") {
+        REQUIRE(snippets.size() == 3);
+        REQUIRE(snippets[0].get_content() == invoice_text);
+        REQUIRE(snippets[0].get_metadata().at("message_index").int_value() == 1);
+        REQUIRE(snippets[0].get_metadata().at("segmenter").string_value() == "local");
+        REQUIRE(snippets[2].get_metadata().at("message_index").int_value() == 3);
+        REQUIRE(snippets[2].get_metadata().at("topic").string_value() == snippets[1].get_metadata().at("topic").string_value());
+      }
+
+      THEN("Processing again only looks at new messages") {
+        source.process_changes();
+        REQUIRE(source.end_reached());
+        add(*context, message_role::USER, "Thanks!");
+        source.process_changes();
+        REQUIRE(source.get_snippet().get_content() == "Thanks!");
+      }
+
+      THEN("Messages added after old history was dropped are still picked up") {
+        while (!source.end_reached()) source.get_snippet();
+        context->erase(1, 4);
+        add(*context, message_role::USER, "Thanks!");
+        add(*context, message_role::ASSISTANT, "You are welcome.");
+        source.process_changes();
+        snippet first = source.get_snippet();
+        REQUIRE(first.get_content() == "Thanks!");
+        REQUIRE(first.get_metadata().at("message_index").int_value() == 1);
+        REQUIRE(first.get_metadata().at("message_id").int_value() == 5);
+        REQUIRE(source.get_snippet().get_content() == "You are welcome.");
+        REQUIRE(source.end_reached());
+      }
+    }
+  }
+
+  GIVEN("An empty chat context") {
+    chat_snippet_source source(std::make_shared<plain_context>());
+    source.process_changes();
+    REQUIRE(source.end_reached());
+  }
+}
+
+SCENARIO("text_segmenter throughput", "[unit][benchmark]") {
+  text_segmenter segmenter;
+  flx_string message = flx_string(invoice_text) + " " + weather_text + "\n\n" + invoice_text;
+  const int messages = 2000;
+  size_t segments = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < messages; ++i) {
+    segments += segmenter.segment_message(message).size();
+  }
+  double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+  std::cout << "[text segmenter] " << us / messages << " us per message of " << message.length() << " bytes" << std::endl;
+  REQUIRE(segments == 3 * messages);
+}
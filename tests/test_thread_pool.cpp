@@ -0,0 +1,74 @@
+#include <catch2/catch_all.hpp>
+#include "../utils/flx_thread_pool.h"
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+SCENARIO("flx_thread_pool runs every task exactly once", "[unit][pure][threads]") {
+
+  GIVEN("A pool with four workers") {
+    flx_thread_pool pool(4);
+    REQUIRE(pool.size() == 4);
+
+    WHEN("Many independent tasks are submitted from outside") {
+      std::vector<std::atomic<int>> hits(1000);
+      for (size_t i = 0; i < hits.size(); ++i) {
+        pool.submit([&hits, i] { hits[i]++; });
+      }
+      pool.wait_idle();
+
+      THEN("Each task ran once") {
+        for (auto& h : hits) {
+          REQUIRE(h.load() == 1);
+        }
+      }
+    }
+
+    WHEN("Tasks submit follow-up tasks from inside a worker") {
+      std::atomic<int> leaves{0};
+      std::atomic<int> inside{0};
+      for (int i = 0; i < 50; ++i) {
+        pool.submit([&] {
+          if (pool.current_worker() >= 0) inside++;
+          for (int j = 0; j < 10; ++j) {
+            pool.submit([&] { leaves++; });
+          }
+        });
+      }
+      pool.wait_idle();
+
+      THEN("wait_idle covers the nested tasks too") {
+        REQUIRE(inside.load() == 50);
+        REQUIRE(leaves.load() == 500);
+        REQUIRE(pool.current_worker() == -1);
+      }
+    }
+
+    WHEN("A task throws") {
+      std::atomic<int> done{0};
+      pool.submit([] { throw std::runtime_error("boom"); });
+      for (int i = 0; i < 20; ++i) {
+        pool.submit([&] { done++; });
+      }
+
+      THEN("wait_idle rethrows once and the other tasks still ran") {
+        REQUIRE_THROWS_AS(pool.wait_idle(), std::runtime_error);
+        REQUIRE(done.load() == 20);
+        REQUIRE_NOTHROW(pool.wait_idle());
+      }
+    }
+  }
+
+  GIVEN("A pool that is destroyed with work still queued") {
+    std::atomic<int> count{0};
+    {
+      flx_thread_pool pool(2);
+      for (int i = 0; i < 100; ++i) {
+        pool.submit([&] { count++; });
+      }
+    }
+    THEN("The destructor drains the queues before joining") {
+      REQUIRE(count.load() == 100);
+    }
+  }
+}
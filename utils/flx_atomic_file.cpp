@@ -0,0 +1,32 @@
+#include "flx_atomic_file.h"
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <thread>
+#include <unistd.h>
+
+bool flx_write_file_atomic(const std::string& path, std::string_view content, std::string* error) {
+  std::string temp = path + "." + std::to_string(::getpid()) + "." +
+                     std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+  std::error_code ec;
+  {
+    std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+    if (!out || !out.write(content.data(), content.size()) || !out.flush()) {
+      if (error) {
+        *error = "Cannot write " + temp;
+      }
+      out.close();
+      std::filesystem::remove(temp, ec);
+      return false;
+    }
+  }
+  std::filesystem::rename(temp, path, ec);
+  if (ec) {
+    if (error) {
+      *error = "Cannot rename " + temp + ": " + ec.message();
+    }
+    std::filesystem::remove(temp, ec);
+    return false;
+  }
+  return true;
+}
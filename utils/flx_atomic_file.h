@@ -0,0 +1,19 @@
+#ifndef FLX_ATOMIC_FILE_H
+#define FLX_ATOMIC_FILE_H
+
+#include <string>
+#include <string_view>
+
+/*
+ * Replaces path with content through a temp file in the same directory and
+ * a rename, so readers see either the old file or the complete new one.
+ *
+ * The temp name carries process and thread id: writers of the same path in
+ * other threads or processes (a shared cache directory, two batch runs) each
+ * write their own temp file instead of truncating each other's. The last
+ * rename wins. Returns false with error set if writing or renaming failed;
+ * the temp file is removed then.
+ */
+bool flx_write_file_atomic(const std::string& path, std::string_view content, std::string* error = nullptr);
+
+#endif // FLX_ATOMIC_FILE_H
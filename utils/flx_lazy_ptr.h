@@ -2,6 +2,7 @@
 #define flx_LAZY_PTR_H
 
 #include <map>
+#include <mutex>
 #include <stdexcept>
 
 /*
@@ -9,6 +10,8 @@
  * Can hold a managed or unmanaged pointer.
  * Creates the object on first access if null.
  * Supports both const-correct and lazy-creation access patterns.
+ * The reference counters are shared process-wide and guarded by a mutex,
+ * so models may be built and destroyed on worker threads.
  */
 
 // Exception for null access in const context
@@ -23,6 +26,11 @@ template <typename object_type>
 class flx_lazy_ptr
 {
   static std::map<object_type*, size_t> *refcounters;
+  static std::mutex &refcount_mutex()
+  {
+    static std::mutex mutex;
+    return mutex;
+  }
   object_type *ptr;
   bool managed;
 public:
@@ -45,10 +53,19 @@ public:
   {
     if (managed)
     {
-      unmanage();
-      if ((*refcounters)[ptr] == 0)
+      bool last = false;
+      {
+        std::lock_guard<std::mutex> lock(refcount_mutex());
+        --(*refcounters)[ptr];
+        managed = false;
+        if ((*refcounters)[ptr] == 0)
+        {
+          refcounters->erase(ptr);
+          last = true;
+        }
+      }
+      if (last)
       {
-        refcounters->erase(ptr);
         delete ptr;
       }
     }
@@ -59,6 +76,7 @@ public:
     if (!managed)
     {
       managed = true;
+      std::lock_guard<std::mutex> lock(refcount_mutex());
       if (!refcounters)
       {
         refcounters = new std::map<object_type*, size_t>;
@@ -70,6 +88,7 @@ public:
   {
     if (managed)
     {
+      std::lock_guard<std::mutex> lock(refcount_mutex());
       if (!refcounters)
       {
         refcounters = new std::map<object_type*, size_t>;
@@ -0,0 +1,130 @@
+#include "flx_mapped_file.h"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+  // Anonymous memory is released by munmap() like a file mapping, so close()
+  // does not need to know which kind it holds
+  bool copy_file(int fd, const struct stat& info, const std::string& path, const char*& data, std::string& error) {
+    size_t size = static_cast<size_t>(info.st_size);
+    void* memory = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) {
+      error = "Cannot allocate " + std::to_string(size) + " bytes for " + path + ": " + std::strerror(errno);
+      ::close(fd);
+      return false;
+    }
+
+    char* target = static_cast<char*>(memory);
+    size_t done = 0;
+    while (done < size) {
+      ssize_t got = ::read(fd, target + done, size - done);
+      if (got < 0 && errno == EINTR) {
+        continue;
+      }
+      if (got <= 0) {
+        break;
+      }
+      done += static_cast<size_t>(got);
+    }
+
+    struct stat after;
+    bool unchanged = ::fstat(fd, &after) == 0
+      && after.st_size == info.st_size
+      && after.st_mtim.tv_sec == info.st_mtim.tv_sec
+      && after.st_mtim.tv_nsec == info.st_mtim.tv_nsec;
+    ::close(fd);
+    if (done != size || !unchanged) {
+      error = "File changed while it was read: " + path;
+      ::munmap(memory, size);
+      return false;
+    }
+
+    ::mprotect(memory, size, PROT_READ);
+    data = target;
+    return true;
+  }
+
+}
+
+flx_mapped_file::flx_mapped_file(const std::string& path, mode how) {
+  open(path, how);
+}
+
+flx_mapped_file::~flx_mapped_file() {
+  close();
+}
+
+flx_mapped_file::flx_mapped_file(flx_mapped_file&& other) noexcept
+  : data_(other.data_), size_(other.size_), error_(std::move(other.error_)) {
+  other.data_ = nullptr;
+  other.size_ = 0;
+}
+
+flx_mapped_file& flx_mapped_file::operator=(flx_mapped_file&& other) noexcept {
+  if (this != &other) {
+    close();
+    data_ = other.data_;
+    size_ = other.size_;
+    error_ = std::move(other.error_);
+    other.data_ = nullptr;
+    other.size_ = 0;
+  }
+  return *this;
+}
+
+bool flx_mapped_file::open(const std::string& path, mode how) {
+  close();
+  error_.clear();
+
+  int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    error_ = "Cannot open " + path + ": " + std::strerror(errno);
+    return false;
+  }
+
+  struct stat info;
+  if (::fstat(fd, &info) != 0) {
+    error_ = "Cannot stat " + path + ": " + std::strerror(errno);
+    ::close(fd);
+    return false;
+  }
+  if (info.st_size <= 0) {
+    error_ = "Empty file: " + path;
+    ::close(fd);
+    return false;
+  }
+
+  size_t size = static_cast<size_t>(info.st_size);
+  if (how == mode::copy) {
+    if (!copy_file(fd, info, path, data_, error_)) {
+      return false;
+    }
+    size_ = size;
+    return true;
+  }
+
+  void* mapping = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  // The mapping keeps its own reference to the file
+  ::close(fd);
+  if (mapping == MAP_FAILED) {
+    error_ = "Cannot map " + path + ": " + std::strerror(errno);
+    return false;
+  }
+
+  data_ = static_cast<const char*>(mapping);
+  size_ = size;
+  return true;
+}
+
+void flx_mapped_file::close() {
+  if (data_ != nullptr) {
+    ::munmap(const_cast<char*>(data_), size_);
+    data_ = nullptr;
+    size_ = 0;
+  }
+}
@@ -0,0 +1,56 @@
+#ifndef FLX_MAPPED_FILE_H
+#define FLX_MAPPED_FILE_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+/*
+ * Read-only memory mapping of a whole file.
+ * The kernel reads pages on first access and may drop them again under
+ * memory pressure (they are clean and file backed), so a large input costs
+ * address space instead of heap, and every reader of the mapping shares the
+ * same physical pages.
+ *
+ * The mapping follows the file: if another process truncates it while it is
+ * mapped, the next access to a page past the new end raises SIGBUS and kills
+ * the process; a rewrite in place changes the bytes under the reader. Files
+ * that may change while they are read (watched directories, shared drops)
+ * are opened with copy, which reads them into anonymous memory once and
+ * fails if the size or modification time changed during the read.
+ */
+class flx_mapped_file
+{
+public:
+  enum class mode {
+    map,   // file backed, pages loaded on access
+    copy   // read into anonymous memory, independent of the file afterwards
+  };
+
+  flx_mapped_file() = default;
+  explicit flx_mapped_file(const std::string& path, mode how = mode::map);
+  ~flx_mapped_file();
+
+  flx_mapped_file(const flx_mapped_file&) = delete;
+  flx_mapped_file& operator=(const flx_mapped_file&) = delete;
+  flx_mapped_file(flx_mapped_file&& other) noexcept;
+  flx_mapped_file& operator=(flx_mapped_file&& other) noexcept;
+
+  // Replaces the current mapping; false (and last_error()) if the file
+  // cannot be opened, is empty, cannot be mapped or changed while copied
+  bool open(const std::string& path, mode how = mode::map);
+  void close();
+
+  bool is_open() const { return data_ != nullptr; }
+  const char* data() const { return data_; }
+  size_t size() const { return size_; }
+  std::string_view view() const { return std::string_view(data_, size_); }
+  const std::string& last_error() const { return error_; }
+
+private:
+  const char* data_ = nullptr;
+  size_t size_ = 0;
+  std::string error_;
+};
+
+#endif // FLX_MAPPED_FILE_H
@@ -0,0 +1,122 @@
+#include "flx_thread_pool.h"
+#include <algorithm>
+
+namespace {
+  thread_local const flx_thread_pool* current_pool = nullptr;
+  thread_local int current_index = -1;
+}
+
+flx_thread_pool::flx_thread_pool(size_t threads) {
+  if (threads == 0) {
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  for (size_t i = 0; i < threads; ++i) {
+    queues_.push_back(std::make_unique<worker_queue>());
+  }
+  for (size_t i = 0; i < threads; ++i) {
+    workers_.emplace_back(&flx_thread_pool::run, this, i);
+  }
+}
+
+flx_thread_pool::~flx_thread_pool() {
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    idle_cv_.wait(lock, [this] { return pending_ == 0; });
+    stop_ = true;
+  }
+  work_cv_.notify_all();
+  for (auto& worker : workers_) {
+    worker.join();
+  }
+}
+
+int flx_thread_pool::current_worker() const {
+  return current_pool == this ? current_index : -1;
+}
+
+void flx_thread_pool::submit(std::function<void()> task) {
+  int self = current_worker();
+  size_t target = self >= 0 ? static_cast<size_t>(self) : next_queue_++ % queues_.size();
+  {
+    // pending before the push: a stolen task may finish before queued_ is raised
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++pending_;
+  }
+  {
+    std::lock_guard<std::mutex> lock(queues_[target]->mutex);
+    queues_[target]->tasks.push_back(std::move(task));
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++queued_;
+  }
+  work_cv_.notify_one();
+}
+
+void flx_thread_pool::wait_idle() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  idle_cv_.wait(lock, [this] { return pending_ == 0; });
+  if (error_) {
+    std::exception_ptr error = error_;
+    error_ = nullptr;
+    std::rethrow_exception(error);
+  }
+}
+
+bool flx_thread_pool::try_take(size_t self, std::function<void()>& task) {
+  {
+    worker_queue& own = *queues_[self];
+    std::lock_guard<std::mutex> lock(own.mutex);
+    if (!own.tasks.empty()) {
+      task = std::move(own.tasks.back());
+      own.tasks.pop_back();
+      return true;
+    }
+  }
+  for (size_t offset = 1; offset < queues_.size(); ++offset) {
+    worker_queue& victim = *queues_[(self + offset) % queues_.size()];
+    std::lock_guard<std::mutex> lock(victim.mutex);
+    if (!victim.tasks.empty()) {
+      task = std::move(victim.tasks.front());
+      victim.tasks.pop_front();
+      return true;
+    }
+  }
+  return false;
+}
+
+void flx_thread_pool::run(size_t index) {
+  current_pool = this;
+  current_index = static_cast<int>(index);
+
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      work_cv_.wait(lock, [this] { return stop_ || queued_ > 0; });
+      if (queued_ == 0) {
+        return;  // stop_ and nothing left
+      }
+      // Claim one task; submit pushes before counting, so it is in some deque
+      --queued_;
+    }
+
+    std::function<void()> task;
+    while (!try_take(index, task)) {
+      std::this_thread::yield();
+    }
+
+    try {
+      task();
+    } catch (...) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (!error_) {
+        error_ = std::current_exception();
+      }
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (--pending_ == 0) {
+      idle_cv_.notify_all();
+    }
+  }
+}
@@ -0,0 +1,67 @@
+#ifndef FLX_THREAD_POOL_H
+#define FLX_THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+ * Work-stealing thread pool.
+ * Every worker owns a deque: it takes its own tasks from the back (newest
+ * first, so a task graph finishes one item before starting the next) and
+ * steals from the front of the other deques when its own is empty.
+ * Tasks submitted from inside a worker go to that worker's deque, tasks from
+ * outside are spread round robin.
+ */
+class flx_thread_pool
+{
+public:
+  // 0 threads = std::thread::hardware_concurrency()
+  explicit flx_thread_pool(size_t threads = 0);
+  // Runs all queued tasks, then joins the workers
+  ~flx_thread_pool();
+
+  flx_thread_pool(const flx_thread_pool&) = delete;
+  flx_thread_pool& operator=(const flx_thread_pool&) = delete;
+
+  void submit(std::function<void()> task);
+
+  // Blocks until every submitted task has finished; rethrows the first
+  // exception a task threw since the last call
+  void wait_idle();
+
+  size_t size() const { return workers_.size(); }
+
+  // Index of the calling worker of this pool, -1 on other threads
+  int current_worker() const;
+
+private:
+  struct worker_queue
+  {
+    std::mutex mutex;
+    std::deque<std::function<void()>> tasks;
+  };
+
+  bool try_take(size_t self, std::function<void()>& task);
+  void run(size_t index);
+
+  std::vector<std::unique_ptr<worker_queue>> queues_;
+  std::vector<std::thread> workers_;
+
+  std::mutex mutex_;
+  std::condition_variable work_cv_;
+  std::condition_variable idle_cv_;
+  size_t queued_ = 0;    // guarded by mutex_
+  size_t pending_ = 0;   // queued + running, guarded by mutex_
+  bool stop_ = false;
+  std::exception_ptr error_;
+  std::atomic<size_t> next_queue_{0};
+};
+
+#endif // FLX_THREAD_POOL_H